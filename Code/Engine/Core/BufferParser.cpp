@@ -4,23 +4,16 @@
 #include "Engine/Math/IntVec2.hpp"
 #include "Engine/Core/Vertex_PCU.hpp"
 #include "ErrorWarningAssert.hpp"
+#include <cstdint>
+#include <cstring>
+#include <utility>
 
 BufferParser::BufferParser(const void* data, size_t size, eBufferEndian endian /*= eBufferEndian::NATIVE*/)
 	:m_data(data),m_dataLength(size),m_bufferEndian(endian)
 {
 	if (endian == eBufferEndian::NATIVE)
 	{
-		unsigned int value = 1;   
-		unsigned char* bytePtr = reinterpret_cast<unsigned char*>(&value);
-		
-		if (bytePtr[0] == 1)
-		{
-			m_bufferEndian = eBufferEndian::LITTLE;
-		}
-		else 
-		{
-			m_bufferEndian = eBufferEndian::BIG;
-		}
+		m_bufferEndian = GetPlatformEndian();
 	}
 }
 
@@ -30,235 +23,80 @@ BufferParser::BufferParser(const std::vector<unsigned char>& data, eBufferEndian
 
 }
 
+unsigned char const* BufferParser::ReadBytes(size_t numBytes)
+{
+	// Written so it can't overflow, the offset can be set past the end with SetBufferOffset
+	GUARANTEE_OR_DIE(m_currentOffset <= m_dataLength && numBytes <= m_dataLength - m_currentOffset,
+		Stringf("BufferParser read out of range (offset=%zu + read=%zu > length=%zu)", m_currentOffset, numBytes, m_dataLength));
+
+	unsigned char const* bytes = static_cast<unsigned char const*>(m_data) + m_currentOffset;
+	m_currentOffset += numBytes;
+	return bytes;
+}
+
+bool BufferParser::IsByteSwapNeeded() const
+{
+	static eBufferEndian const s_platformEndian = GetPlatformEndian();
+	return m_bufferEndian != s_platformEndian;
+}
+
 char BufferParser::ParseChar()
 {
-	if (m_currentOffset > m_dataLength)
-	{
-		ERROR_AND_DIE("Over take the offset from the beginning of the byte array");
-	}
-	const unsigned char* value = static_cast<const unsigned char*>(m_data);
-	char c = static_cast<char>(value[m_currentOffset]);
-	++m_currentOffset;
-	return c;
+	return static_cast<char>(*ReadBytes(1));
 }
 
 unsigned char BufferParser::ParseByte()
 {
-	if (m_currentOffset > m_dataLength)
-	{
-		ERROR_AND_DIE("Over take the offset from the beginning of the byte array");
-	}
-	const unsigned char* value = static_cast<const unsigned char*>(m_data);
-	unsigned char b = value[m_currentOffset];
-	++m_currentOffset;
-	return b;
+	return *ReadBytes(1);
 }
 
 unsigned short BufferParser::ParseUShort()
 {
-	unsigned char b[2];
-	b[0] = ParseByte();
-	b[1] = ParseByte();
-	unsigned short value = 0;
-	if (m_bufferEndian == eBufferEndian::LITTLE)
-	{
-		value = static_cast<unsigned short>(b[0]) | (static_cast<unsigned short>(b[1]) << 8);
-	}
-	else
-	{
-		value = (static_cast<unsigned short>(b[0]) << 8) | static_cast<unsigned short>(b[1]);
-	}
-	return value;
+	uint16_t value;
+	std::memcpy(&value, ReadBytes(sizeof(value)), sizeof(value));
+	return IsByteSwapNeeded() ? ByteSwap16(value) : value;
 }
 
 bool BufferParser::ParseBool()
 {
-	if (m_currentOffset > m_dataLength)
-	{
-		ERROR_AND_DIE("Over take the offset from the beginning of the byte array");
-	}
-
-	unsigned char c = ParseByte();
-
-	if (c == 0)
-	{
-		return false;
-	}
-
-	return true;
+	return ParseByte() != 0;
 }
 
 unsigned int BufferParser::ParseUint32()
 {
-	unsigned char b[4];
-
-	b[0] = ParseByte();
-	b[1] = ParseByte();
-	b[2] = ParseByte();
-	b[3] = ParseByte();
-
-	if (m_bufferEndian == eBufferEndian::LITTLE)
-	{
-		return  static_cast<unsigned int>(b[0])
-			| (static_cast<unsigned int>(b[1]) << 8)
-			| (static_cast<unsigned int>(b[2]) << 16)
-			| (static_cast<unsigned int>(b[3]) << 24);
-	}
-
-	return  (static_cast<unsigned int>(b[0]) << 24) | (static_cast<unsigned int>(b[1]) << 16) | (static_cast<unsigned int>(b[2]) << 8)| static_cast<unsigned int>(b[3]);
+	uint32_t value;
+	std::memcpy(&value, ReadBytes(sizeof(value)), sizeof(value));
+	return IsByteSwapNeeded() ? ByteSwap32(value) : value;
 }
 
 uint64_t BufferParser::ParseUint64()
 {
-	unsigned char b[8];
-	for (int i = 0; i < 8; ++i)
-	{
-		b[i] = ParseByte();
-	}
-	uint64_t value = 0;
-	if (m_bufferEndian == eBufferEndian::LITTLE)
-	{
-		value = static_cast<uint64_t>(b[0])
-			| (static_cast<uint64_t>(b[1]) << 8)
-			| (static_cast<uint64_t>(b[2]) << 16)
-			| (static_cast<uint64_t>(b[3]) << 24)
-			| (static_cast<uint64_t>(b[4]) << 32)
-			| (static_cast<uint64_t>(b[5]) << 40)
-			| (static_cast<uint64_t>(b[6]) << 48)
-			| (static_cast<uint64_t>(b[7]) << 56);
-	}
-	else
-	{
-		value = (static_cast<uint64_t>(b[0]) << 56)
-			| (static_cast<uint64_t>(b[1]) << 48)
-			| (static_cast<uint64_t>(b[2]) << 40)
-			| (static_cast<uint64_t>(b[3]) << 32)
-			| (static_cast<uint64_t>(b[4]) << 24)
-			| (static_cast<uint64_t>(b[5]) << 16)
-			| (static_cast<uint64_t>(b[6]) << 8)
-			| static_cast<uint64_t>(b[7]);
-	}
-	return value;
+	uint64_t value;
+	std::memcpy(&value, ReadBytes(sizeof(value)), sizeof(value));
+	return IsByteSwapNeeded() ? ByteSwap64(value) : value;
 }
 
 int64_t BufferParser::ParseInt64()
 {
-	unsigned char b[8];
-	for (int i = 0; i < 8; ++i)
-	{
-		b[i] = ParseByte();
-	}
-	uint64_t unsignedValue = 0;
-	if (m_bufferEndian == eBufferEndian::LITTLE)
-	{
-		unsignedValue = static_cast<uint64_t>(b[0])
-			| (static_cast<uint64_t>(b[1]) << 8)
-			| (static_cast<uint64_t>(b[2]) << 16)
-			| (static_cast<uint64_t>(b[3]) << 24)
-			| (static_cast<uint64_t>(b[4]) << 32)
-			| (static_cast<uint64_t>(b[5]) << 40)
-			| (static_cast<uint64_t>(b[6]) << 48)
-			| (static_cast<uint64_t>(b[7]) << 56);
-	}
-	else
-	{
-		unsignedValue = (static_cast<uint64_t>(b[0]) << 56)
-			| (static_cast<uint64_t>(b[1]) << 48)
-			| (static_cast<uint64_t>(b[2]) << 40)
-			| (static_cast<uint64_t>(b[3]) << 32)
-			| (static_cast<uint64_t>(b[4]) << 24)
-			| (static_cast<uint64_t>(b[5]) << 16)
-			| (static_cast<uint64_t>(b[6]) << 8)
-			| static_cast<uint64_t>(b[7]);
-	}
-	return static_cast<int64_t>(unsignedValue);
+	return static_cast<int64_t>(ParseUint64());
 }
 
 int BufferParser::ParseInt32()
 {
-	unsigned char b[4];
-
-	b[0] = ParseByte();
-	b[1] = ParseByte();
-	b[2] = ParseByte();
-	b[3] = ParseByte();
-
-	if (m_bufferEndian == eBufferEndian::LITTLE)
-	{
-		return  static_cast<int>(b[0])
-			| (static_cast<int>(b[1]) << 8)
-			| (static_cast<int>(b[2]) << 16)
-			| (static_cast<int>(b[3]) << 24);
-	}
-
-	return  (static_cast<int>(b[0]) << 24) | (static_cast<int>(b[1]) << 16) | (static_cast<int>(b[2]) << 8) | static_cast<int>(b[3]);
+	return static_cast<int>(ParseUint32());
 }
 
 float BufferParser::ParseFloat()
 {
-	unsigned char b[4];
-
-	b[0] = ParseByte();
-	b[1] = ParseByte();
-	b[2] = ParseByte();
-	b[3] = ParseByte();
-
-	unsigned int value = 0;
-	if (m_bufferEndian == eBufferEndian::LITTLE)
-	{
-		value = static_cast<unsigned int>(b[0])
-			| (static_cast<unsigned int>(b[1]) << 8)
-			| (static_cast<unsigned int>(b[2]) << 16)
-			| (static_cast<unsigned int>(b[3]) << 24);
-	}
-	else 
-	{
-		value = (static_cast<unsigned int>(b[0]) << 24)
-			| (static_cast<unsigned int>(b[1]) << 16)
-			| (static_cast<unsigned int>(b[2]) << 8)
-			| static_cast<unsigned int>(b[3]);
-	}
-
-	float result = *reinterpret_cast<float*>(&value);
+	uint32_t value = ParseUint32();
+	float result;
+	std::memcpy(&result, &value, sizeof(result));
 	return result;
 }
 
 double BufferParser::ParseDouble()
 {
-	unsigned char b[8];
-	b[0] = ParseByte();
-	b[1] = ParseByte();
-	b[2] = ParseByte();
-	b[3] = ParseByte();
-	b[4] = ParseByte();
-	b[5] = ParseByte();
-	b[6] = ParseByte();
-	b[7] = ParseByte();
-
-	unsigned long long value = 0;
-	if (m_bufferEndian == eBufferEndian::LITTLE)
-	{
-		value = static_cast<unsigned long long>(b[0])
-			| (static_cast<unsigned long long>(b[1]) << 8)
-			| (static_cast<unsigned long long>(b[2]) << 16)
-			| (static_cast<unsigned long long>(b[3]) << 24)
-			| (static_cast<unsigned long long>(b[4]) << 32)
-			| (static_cast<unsigned long long>(b[5]) << 40)
-			| (static_cast<unsigned long long>(b[6]) << 48)
-			| (static_cast<unsigned long long>(b[7]) << 56);
-	}
-	else  
-	{
-		value = (static_cast<unsigned long long>(b[0]) << 56)
-			| (static_cast<unsigned long long>(b[1]) << 48)
-			| (static_cast<unsigned long long>(b[2]) << 40)
-			| (static_cast<unsigned long long>(b[3]) << 32)
-			| (static_cast<unsigned long long>(b[4]) << 24)
-			| (static_cast<unsigned long long>(b[5]) << 16)
-			| (static_cast<unsigned long long>(b[6]) << 8)
-			| static_cast<unsigned long long>(b[7]);
-	}
-
+	uint64_t value = ParseUint64();
 	double result;
 	std::memcpy(&result, &value, sizeof(result));
 	return result;
@@ -266,57 +104,39 @@ double BufferParser::ParseDouble()
 
 void BufferParser::ParseStringZeroTerminated(std::string& out)
 {
-	char c = ParseChar();
+	GUARANTEE_OR_DIE(m_currentOffset <= m_dataLength, "BufferParser::ParseStringZeroTerminated offset is past the end of the buffer");
 
-	while (c != '\0')
-	{
-		out.push_back(c);
-		c = ParseChar();
-	}
+	char const* start = static_cast<char const*>(m_data) + m_currentOffset;
+	char const* terminator = static_cast<char const*>(std::memchr(start, '\0', m_dataLength - m_currentOffset));
+	GUARANTEE_OR_DIE(terminator != nullptr, "BufferParser::ParseStringZeroTerminated string is not terminated");
+
+	size_t length = (size_t)(terminator - start);
+	out.append(start, length);
+	m_currentOffset += length + 1;
 }
 
 void BufferParser::ParseStringAfter32BitLength(std::string& out)
 {
-	unsigned int l = ParseUint32();
-	
-	for (unsigned int i = 0; i < l; i++)
-	{
-		char c = ParseChar();
-		out.push_back(c);
-	}
+	unsigned int length = ParseUint32();
+	char const* start = reinterpret_cast<char const*>(ReadBytes(length));
+	out.append(start, length);
 }
 
 void BufferParser::SkipBytes(size_t numBytes)
 {
-	
-	GUARANTEE_OR_DIE(
-		m_currentOffset + numBytes <= m_dataLength,
-		Stringf("BufferParser::SkipBytes out of range (offset=%zu + skip=%zu > length=%zu)",
-			m_currentOffset, numBytes, m_dataLength)
-	);
-
-	m_currentOffset += numBytes;
-
-
+	ReadBytes(numBytes);
 }
 
 Rgba8 BufferParser::ParseRgba()
 {
-	unsigned char r = ParseByte();
-	unsigned char g = ParseByte();
-	unsigned char b = ParseByte();
-	unsigned char a = ParseByte();
-
-	return Rgba8(r,g,b,a);
+	unsigned char const* bytes = ReadBytes(4);
+	return Rgba8(bytes[0], bytes[1], bytes[2], bytes[3]);
 }
 
 Rgba8 BufferParser::ParseRgb()
 {
-	unsigned char r = ParseByte();
-	unsigned char g = ParseByte();
-	unsigned char b = ParseByte();
-
-	return Rgba8(r,g,b);
+	unsigned char const* bytes = ReadBytes(3);
+	return Rgba8(bytes[0], bytes[1], bytes[2]);
 }
 
 IntVec2 BufferParser::ParseIntVec2()
@@ -363,6 +183,67 @@ eBufferEndian BufferParser::ParseBufferMode()
 	return static_cast<eBufferEndian>(b);
 }
 
+void BufferParser::ParseElements(void* out, size_t elementSize, size_t count)
+{
+	GUARANTEE_OR_DIE(count <= SIZE_MAX / elementSize, "BufferParser array size overflows");
+
+	size_t numBytes = elementSize * count;
+	std::memcpy(out, ReadBytes(numBytes), numBytes);
+
+	if (elementSize > 1 && IsByteSwapNeeded())
+	{
+		ByteSwapArray(out, elementSize, count);
+	}
+}
+
+//-----------------------------------------------------------------------------------
+// The wire layout of a vertex is position, rgba, uv with no padding, the same as Vertex_PCU in
+// memory. Every 4 byte word is swapped in one pass, then the color word, which was written byte by
+// byte, is swapped back.
+//
+void BufferParser::ParseVertexPCUArray(Vertex_PCU* out, size_t count)
+{
+	static_assert(sizeof(Vertex_PCU) == 24, "Vertex_PCU is no longer laid out like its serialized form");
+	static_assert(sizeof(Rgba8) == 4, "Vertex_PCU is no longer laid out like its serialized form");
+
+	GUARANTEE_OR_DIE(count <= SIZE_MAX / sizeof(Vertex_PCU), "BufferParser array size overflows");
+
+	size_t numBytes = sizeof(Vertex_PCU) * count;
+	std::memcpy((void*)out, ReadBytes(numBytes), numBytes);
+
+	if (IsByteSwapNeeded())
+	{
+		ByteSwapArray((void*)out, sizeof(uint32_t), count * (sizeof(Vertex_PCU) / sizeof(uint32_t)));
+		for (size_t vertexIndex = 0; vertexIndex < count; ++vertexIndex)
+		{
+			Rgba8& color = out[vertexIndex].m_color;
+			std::swap(color.r, color.a);
+			std::swap(color.g, color.b);
+		}
+	}
+}
+
+void BufferParser::ParseVertexPCUArray(std::vector<Vertex_PCU>& out, size_t count)
+{
+	size_t firstVertex = out.size();
+	out.resize(firstVertex + count);
+	ParseVertexPCUArray(out.data() + firstVertex, count);
+}
+
+void BufferParser::ParseByteArray(void* out, size_t numBytes)
+{
+	unsigned char const* bytes = ReadBytes(numBytes);
+	if (numBytes > 0)
+	{
+		std::memcpy(out, bytes, numBytes);
+	}
+}
+
+size_t BufferParser::GetRemainingSize() const
+{
+	return m_currentOffset < m_dataLength ? m_dataLength - m_currentOffset : 0;
+}
+
 void BufferParser::SetBufferOffset(size_t bufferOffset)
 {
 	m_currentOffset = bufferOffset;
@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <type_traits>
 #include "Engine/Core/EngineCommon.hpp"
 
 class BufferParser
@@ -32,12 +33,45 @@ public:
 	Vertex_PCU		ParseVertexPCU();
 	eBufferEndian	ParseBufferMode();
 
+	// Bulk reads, one range check for the whole array then a memcpy, and a byte swap pass when the
+	// buffer endianness is not the platform's
+	template<typename T>
+	void			ParseArray(T* out, size_t count);
+	template<typename T>
+	std::vector<T>	ParseArray(size_t count);
+	void			ParseVertexPCUArray(Vertex_PCU* out, size_t count);
+	void			ParseVertexPCUArray(std::vector<Vertex_PCU>& out, size_t count);
+
+	void			ParseByteArray(void* out, size_t numBytes);		// Copied as is, the caller owns the layout and endianness
+
+	size_t			GetRemainingSize() const;
+	bool			IsByteSwapNeeded() const;
+
 	void			SetBufferOffset(size_t bufferOffset);
 	void			SetEndianMode(eBufferEndian endian);
 
+private:
+	unsigned char const* ReadBytes(size_t numBytes);		// Range checked, advances the offset
+	void			ParseElements(void* out, size_t elementSize, size_t count);
+
 public:
 	const void*		m_data;
 	size_t			m_dataLength;
 	eBufferEndian	m_bufferEndian;
 	size_t			m_currentOffset = 0;
 };
+
+template<typename T>
+void BufferParser::ParseArray(T* out, size_t count)
+{
+	static_assert(std::is_arithmetic<T>::value, "BufferParser::ParseArray only reads numbers, parse structs member by member or add a dedicated array function");
+	ParseElements(out, sizeof(T), count);
+}
+
+template<typename T>
+std::vector<T> BufferParser::ParseArray(size_t count)
+{
+	std::vector<T> values(count);
+	ParseArray(values.data(), count);
+	return values;
+}
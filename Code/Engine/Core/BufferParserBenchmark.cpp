@@ -0,0 +1,212 @@
+#include "Engine/Core/BufferParserBenchmark.hpp"
+#include "Engine/Core/BufferParser.hpp"
+#include "Engine/Core/BufferWriter.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Math/RandomNumberGenerator.hpp"
+#include <algorithm>
+#include <cstring>
+
+//-----------------------------------------------------------------------------------
+// How BufferParser used to read values, kept as the baseline: every byte is its own ParseByte call
+// with its own range check, and values are assembled with shifts
+//
+class PerByteBufferParser
+{
+public:
+	PerByteBufferParser(std::vector<unsigned char> const& data, eBufferEndian endian)
+		: m_parser(data, endian), m_bufferEndian(endian) {}
+
+	float ParseFloat()
+	{
+		unsigned char b[4];
+		b[0] = m_parser.ParseByte();
+		b[1] = m_parser.ParseByte();
+		b[2] = m_parser.ParseByte();
+		b[3] = m_parser.ParseByte();
+
+		unsigned int value = 0;
+		if (m_bufferEndian == eBufferEndian::LITTLE)
+		{
+			value = static_cast<unsigned int>(b[0]) | (static_cast<unsigned int>(b[1]) << 8) | (static_cast<unsigned int>(b[2]) << 16) | (static_cast<unsigned int>(b[3]) << 24);
+		}
+		else
+		{
+			value = (static_cast<unsigned int>(b[0]) << 24) | (static_cast<unsigned int>(b[1]) << 16) | (static_cast<unsigned int>(b[2]) << 8) | static_cast<unsigned int>(b[3]);
+		}
+
+		float result = 0.f;
+		memcpy(&result, &value, sizeof(result));
+		return result;
+	}
+
+	Vertex_PCU ParseVertexPCU()
+	{
+		float x = ParseFloat();
+		float y = ParseFloat();
+		float z = ParseFloat();
+		unsigned char r = m_parser.ParseByte();
+		unsigned char g = m_parser.ParseByte();
+		unsigned char b = m_parser.ParseByte();
+		unsigned char a = m_parser.ParseByte();
+		float u = ParseFloat();
+		float v = ParseFloat();
+		return Vertex_PCU(Vec3(x, y, z), Rgba8(r, g, b, a), Vec2(u, v));
+	}
+
+private:
+	BufferParser			m_parser;
+	eBufferEndian			m_bufferEndian = eBufferEndian::LITTLE;
+};
+
+template<typename Work>
+static double TimeMilliseconds(Work const& work)
+{
+	double startSeconds = GetCurrentTimeSeconds();
+	work();
+	return (GetCurrentTimeSeconds() - startSeconds) * 1000.0;
+}
+
+static bool AreVertexesEqual(std::vector<Vertex_PCU> const& lhs, std::vector<Vertex_PCU> const& rhs)
+{
+	for (size_t vertexIndex = 0; vertexIndex < lhs.size(); ++vertexIndex)
+	{
+		Vertex_PCU const& a = lhs[vertexIndex];
+		Vertex_PCU const& b = rhs[vertexIndex];
+		if (memcmp(&a.m_position, &b.m_position, sizeof(Vec3)) != 0 || memcmp(&a.m_color, &b.m_color, sizeof(Rgba8)) != 0 || memcmp(&a.m_uvTexCoords, &b.m_uvTexCoords, sizeof(Vec2)) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static BufferParserBenchmarkResult RunVertexBenchmark(std::vector<Vertex_PCU> const& sourceVertexes, eBufferEndian endian)
+{
+	size_t numVertexes = sourceVertexes.size();
+	std::vector<unsigned char> bytes;
+	BufferWriter writer(bytes, endian);
+	writer.Reserve(numVertexes * 24);
+	for (Vertex_PCU const& vertex : sourceVertexes)
+	{
+		writer.AppendPrimitive(vertex.m_position.x);
+		writer.AppendPrimitive(vertex.m_position.y);
+		writer.AppendPrimitive(vertex.m_position.z);
+		writer.AppendByteArray(&vertex.m_color, sizeof(Rgba8));
+		writer.AppendVec2(vertex.m_uvTexCoords);
+	}
+
+	BufferParserBenchmarkResult result;
+	result.m_name = Stringf("%i vertexes %s", (int)numVertexes, endian == eBufferEndian::BIG ? "BE" : "LE");
+	std::vector<Vertex_PCU> perByteVertexes(numVertexes);
+	std::vector<Vertex_PCU> scalarVertexes(numVertexes);
+	std::vector<Vertex_PCU> bulkVertexes;
+
+	result.m_perByteMs = TimeMilliseconds([&]()
+	{
+		PerByteBufferParser parser(bytes, endian);
+		for (Vertex_PCU& vertex : perByteVertexes)
+		{
+			vertex = parser.ParseVertexPCU();
+		}
+	});
+	result.m_scalarMs = TimeMilliseconds([&]()
+	{
+		BufferParser parser(bytes, endian);
+		for (Vertex_PCU& vertex : scalarVertexes)
+		{
+			vertex = parser.ParseVertexPCU();
+		}
+	});
+	result.m_bulkMs = TimeMilliseconds([&]()
+	{
+		BufferParser parser(bytes, endian);
+		parser.ParseVertexPCUArray(bulkVertexes, numVertexes);
+	});
+
+	result.m_isMatching = AreVertexesEqual(sourceVertexes, perByteVertexes) && AreVertexesEqual(sourceVertexes, scalarVertexes) && AreVertexesEqual(sourceVertexes, bulkVertexes);
+	return result;
+}
+
+static BufferParserBenchmarkResult RunFloatBenchmark(std::vector<float> const& sourceFloats, eBufferEndian endian)
+{
+	size_t numFloats = sourceFloats.size();
+	std::vector<unsigned char> bytes;
+	BufferWriter writer(bytes, endian);
+	writer.AppendArray(sourceFloats);
+
+	BufferParserBenchmarkResult result;
+	result.m_name = Stringf("%i floats %s", (int)numFloats, endian == eBufferEndian::BIG ? "BE" : "LE");
+	std::vector<float> perByteFloats(numFloats);
+	std::vector<float> scalarFloats(numFloats);
+	std::vector<float> bulkFloats;
+
+	result.m_perByteMs = TimeMilliseconds([&]()
+	{
+		PerByteBufferParser parser(bytes, endian);
+		for (float& value : perByteFloats)
+		{
+			value = parser.ParseFloat();
+		}
+	});
+	result.m_scalarMs = TimeMilliseconds([&]()
+	{
+		BufferParser parser(bytes, endian);
+		for (float& value : scalarFloats)
+		{
+			value = parser.ParseFloat();
+		}
+	});
+	result.m_bulkMs = TimeMilliseconds([&]()
+	{
+		BufferParser parser(bytes, endian);
+		bulkFloats = parser.ParseArray<float>(numFloats);
+	});
+
+	size_t numBytes = numFloats * sizeof(float);
+	result.m_isMatching = memcmp(sourceFloats.data(), perByteFloats.data(), numBytes) == 0 && memcmp(sourceFloats.data(), scalarFloats.data(), numBytes) == 0 && memcmp(sourceFloats.data(), bulkFloats.data(), numBytes) == 0;
+	return result;
+}
+
+std::vector<BufferParserBenchmarkResult> RunBufferParserBenchmark(int numElements)
+{
+	std::vector<BufferParserBenchmarkResult> results;
+	numElements = std::max(numElements, 1);
+
+	RandomNumberGenerator rng;
+	std::vector<Vertex_PCU> sourceVertexes((size_t)numElements);
+	for (Vertex_PCU& vertex : sourceVertexes)
+	{
+		vertex.m_position = Vec3(rng.RollRandomFloatInRange(-100.f, 100.f), rng.RollRandomFloatInRange(-100.f, 100.f), rng.RollRandomFloatInRange(-100.f, 100.f));
+		vertex.m_color = rng.RollRandomColor(true);
+		vertex.m_uvTexCoords = Vec2(rng.RollRandomFloatZeroToOne(), rng.RollRandomFloatZeroToOne());
+	}
+	std::vector<float> sourceFloats((size_t)numElements);
+	for (float& value : sourceFloats)
+	{
+		value = rng.RollRandomFloatInRange(-1000.f, 1000.f);
+	}
+
+	results.push_back(RunVertexBenchmark(sourceVertexes, eBufferEndian::LITTLE));
+	results.push_back(RunVertexBenchmark(sourceVertexes, eBufferEndian::BIG));
+	results.push_back(RunFloatBenchmark(sourceFloats, eBufferEndian::LITTLE));
+	results.push_back(RunFloatBenchmark(sourceFloats, eBufferEndian::BIG));
+	return results;
+}
+
+bool Command_BufferParserBenchmark(EventArgs const& args)
+{
+	int numElements = args.GetValue(std::string("count"), 1000000);
+	std::vector<BufferParserBenchmarkResult> results = RunBufferParserBenchmark(numElements);
+	if (g_theConsole)
+	{
+		g_theConsole->AddLine(DevConsole::INFO_MAJOR, "BufferParserBenchmark, old per byte parser / scalar parse calls / bulk array parse");
+		for (BufferParserBenchmarkResult const& result : results)
+		{
+			g_theConsole->AddLine(result.m_isMatching ? DevConsole::INFO_MINOR : DevConsole::ERROR, Stringf("%-22s %8.2f ms  %8.2f ms  %8.2f ms  %s",
+				result.m_name.c_str(), result.m_perByteMs, result.m_scalarMs, result.m_bulkMs, result.m_isMatching ? "matches" : "MISMATCH"));
+		}
+	}
+	return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+#include <vector>
+
+class NamedProperties;
+typedef NamedProperties EventArgs;
+
+//-----------------------------------------------------------------------------------
+// Times BufferParser against the one byte at a time parser it replaced, on Vertex_PCU and float
+// arrays written in both endiannesses, and checks that both parsers read the same values.
+//
+struct BufferParserBenchmarkResult
+{
+	std::string		m_name;
+	double			m_perByteMs = 0.0;		// The old parser, a range checked ParseByte per byte
+	double			m_scalarMs = 0.0;		// ParseVertexPCU / ParseFloat in a loop
+	double			m_bulkMs = 0.0;			// ParseVertexPCUArray / ParseArray<float>
+	bool			m_isMatching = false;
+};
+
+std::vector<BufferParserBenchmarkResult>	RunBufferParserBenchmark(int numElements);
+bool										Command_BufferParserBenchmark(EventArgs const& args);
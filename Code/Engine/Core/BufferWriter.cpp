@@ -1,24 +1,94 @@
 #include "Engine/Core/BufferWriter.hpp"
+#include <algorithm>
 
 BufferWriter::BufferWriter(std::vector<unsigned char>& buffer, eBufferEndian endian)
-	:m_buffer(buffer),m_endian(endian)
+	:m_vector(&buffer)
 {
-	if (m_endian == eBufferEndian::NATIVE)
+	SetEndianMode(endian);
+}
+
+BufferWriter::BufferWriter(void* fixedBuffer, size_t capacity, eBufferEndian endian)
+	:m_fixedBuffer(static_cast<unsigned char*>(fixedBuffer)), m_fixedCapacity(capacity)
+{
+	SetEndianMode(endian);
+}
+
+void BufferWriter::Reserve(size_t numBytes)
+{
+	// Never reserve the exact size on growth, appending one value at a time would reallocate every time
+	if (m_vector && numBytes > m_vector->capacity())
 	{
-		unsigned int value = 1;
-		unsigned char* bytePtr = reinterpret_cast<unsigned char*>(&value);
+		m_vector->reserve(std::max(numBytes, m_vector->capacity() * 2));
+	}
+}
 
-		if (bytePtr[0] == 1)
-		{
-			m_endian = eBufferEndian::LITTLE;
-		}
-		else
+unsigned char* BufferWriter::Grow(size_t numBytes)
+{
+	if (m_vector)
+	{
+		size_t oldSize = m_vector->size();
+		if (oldSize + numBytes > m_vector->capacity())
 		{
-			m_endian = eBufferEndian::BIG;
+			Reserve(oldSize + numBytes);
 		}
+		m_vector->resize(oldSize + numBytes);
+		return m_vector->data() + oldSize;
+	}
+
+	if (m_hasOverflowed || numBytes > m_fixedCapacity - m_fixedSize)
+	{
+		m_hasOverflowed = true;
+		return nullptr;
+	}
+	unsigned char* destination = m_fixedBuffer + m_fixedSize;
+	m_fixedSize += numBytes;
+	return destination;
+}
+
+void BufferWriter::AppendElements(void const* data, size_t elementSize, size_t count)
+{
+	size_t numBytes = elementSize * count;
+	unsigned char* destination = Grow(numBytes);
+	if (destination == nullptr || numBytes == 0)
+	{
+		return;
+	}
+
+	std::memcpy(destination, data, numBytes);
+	if (elementSize > 1 && m_isByteSwapNeeded)
+	{
+		ByteSwapArray(destination, elementSize, count);
 	}
 }
 
+void BufferWriter::AppendByteArray(void const* data, size_t numBytes)
+{
+	unsigned char* destination = Grow(numBytes);
+	if (destination && numBytes > 0)
+	{
+		std::memcpy(destination, data, numBytes);
+	}
+}
+
+void BufferWriter::AppendZeroBytes(size_t numBytes)
+{
+	unsigned char* destination = Grow(numBytes);
+	if (destination && numBytes > 0)
+	{
+		std::memset(destination, 0, numBytes);
+	}
+}
+
+uint32_t BufferWriter::GetBufferSize() const
+{
+	return (uint32_t)(m_vector ? m_vector->size() : m_fixedSize);
+}
+
+unsigned char* BufferWriter::GetData()
+{
+	return m_vector ? m_vector->data() : m_fixedBuffer;
+}
+
 void BufferWriter::AppendVec2(Vec2 const& vct)
 {
 	AppendPrimitive(vct.x);
@@ -33,46 +103,29 @@ void BufferWriter::AppendAABB2(AABB2 const& box)
 
 void BufferWriter::AppendZeroTerminatedString(const std::string& str)
 {
-	std::string strWithZeroTerm = str;
-	strWithZeroTerm.push_back('\0');
-
-	m_buffer.insert(m_buffer.end(), strWithZeroTerm.data(), strWithZeroTerm.data() + strWithZeroTerm.size());
+	AppendByteArray(str.c_str(), str.size() + 1);
 }
 
 void BufferWriter::AppendLengthPrecededString(const std::string& str)
 {
 	AppendPrimitive<uint32_t>(static_cast<uint32_t>(str.size()));
-	m_buffer.insert(m_buffer.end(), str.begin(), str.end());
+	AppendByteArray(str.data(), str.size());
 }
 
 void BufferWriter::OverwriteUInt32(size_t offset, uint32_t value)
 {
-	if (offset + 4 > m_buffer.size())
+	if (offset + 4 > GetBufferSize())
 		return;
 
-	for (int i = 0; i < 4; i++)
+	if (m_isByteSwapNeeded)
 	{
-		int index = (m_endian == eBufferEndian::LITTLE) ? i : (3 - i);
-		m_buffer[offset + i] = static_cast<unsigned char>((value >> (8 * index)) & 0xFF);
+		value = ByteSwap32(value);
 	}
+	std::memcpy(GetData() + offset, &value, sizeof(value));
 }
 
 void BufferWriter::SetEndianMode(eBufferEndian endianMode)
 {
-	m_endian = endianMode;
-	if (m_endian == eBufferEndian::NATIVE)
-	{
-		unsigned int value = 1;
-		unsigned char* bytePtr = reinterpret_cast<unsigned char*>(&value);
-
-		if (bytePtr[0] == 1)
-		{
-			m_endian = eBufferEndian::LITTLE;
-		}
-		else
-		{
-			m_endian = eBufferEndian::BIG;
-		}
-	}
-
+	m_endian = endianMode == eBufferEndian::NATIVE ? GetPlatformEndian() : endianMode;
+	m_isByteSwapNeeded = m_endian != GetPlatformEndian();
 }
@@ -1,57 +1,45 @@
 #pragma once
 #include "Engine/Core/EngineCommon.hpp"
+#include <cstring>
+#include <type_traits>
 
 struct IntVec3;
 struct Plane2;
 
+//-----------------------------------------------------------------------------------
+// Appends to a std::vector that grows as needed, or to a fixed buffer owned by the caller (a network
+// packet for example) that is never reallocated. A write that doesn't fit in a fixed buffer is
+// dropped whole and marks the writer as overflowed, check HasOverflowed once everything is written.
+//
 class BufferWriter 
 {
 public:
 	BufferWriter(std::vector<unsigned char>& buffer, eBufferEndian endian = eBufferEndian::NATIVE);
+	BufferWriter(void* fixedBuffer, size_t capacity, eBufferEndian endian = eBufferEndian::NATIVE);
 
-	template<typename T>
-	void AppendPrimitive(T value)
-	{
-		unsigned char bytes[sizeof(T)];
+	void Reserve(size_t numBytes);													// Total size hint, nothing to do for a fixed buffer. Grows geometrically past the current capacity
 
-		if (m_endian == eBufferEndian::LITTLE)
-		{
-			for (size_t i = 0; i < sizeof(T); i++)
-			{
-				bytes[i] = static_cast<unsigned char>((value >> (8 * i)) & 0xFF);
-			}
-		}
-		else
-		{
-			for (size_t i = 0; i < sizeof(T); i++)
-			{
-				bytes[sizeof(T) - 1 - i] = static_cast<unsigned char>((value >> (8 * i)) & 0xFF);
-			}
-		}
+	template<typename T>
+	void AppendPrimitive(T value);
 
-		m_buffer.insert(m_buffer.end(), bytes, bytes + sizeof(T));
-	}
+	// Bulk appends of numbers, one copy for the whole array and a byte swap pass only when the
+	// writer endianness is not the platform's
+	template<typename T>
+	void AppendArray(T const* values, size_t count);
+	template<typename T>
+	void AppendArray(std::vector<T> const& values)		{ AppendArray(values.data(), values.size()); }
 
-	template<>
-	void AppendPrimitive<float>(float value)
-	{
-		uint32_t intValue;
-		std::memcpy(&intValue, &value, sizeof(float));
-		AppendPrimitive<uint32_t>(intValue);
-	}
-	
-	template<>
-	void AppendPrimitive<double>(double value)
-	{
-		uint64_t intValue;
-		std::memcpy(&intValue, &value, sizeof(double));
-		AppendPrimitive<uint64_t>(intValue);
-	}
-	
+	void AppendByteArray(void const* data, size_t numBytes);		// Written as is, the caller owns the layout and endianness
+	void AppendZeroBytes(size_t numBytes);
 	void AppendVec2(Vec2 const& vct);
 	void AppendAABB2(AABB2 const& box);
 
-	uint32_t GetBufferSize() { return (uint32_t)m_buffer.size(); }
+	uint32_t GetBufferSize() const;
+	unsigned char* GetData();
+	std::vector<unsigned char>* GetBuffer() const { return m_vector; }			// The vector being appended to, nullptr when writing to a fixed buffer
+	eBufferEndian GetEndianMode() const { return m_endian; }
+	bool HasOverflowed() const { return m_hasOverflowed; }
+	bool IsByteSwapNeeded() const { return m_isByteSwapNeeded; }
 
 	void AppendZeroTerminatedString(const std::string& str);
 	void AppendLengthPrecededString(const std::string& str);
@@ -59,7 +47,77 @@ public:
 	void OverwriteUInt32(size_t offset, uint32_t value);
 	void SetEndianMode( eBufferEndian endianMode );
 
-	std::vector<unsigned char>& m_buffer;
-	eBufferEndian m_endian;
+private:
+	unsigned char* Grow(size_t numBytes);					// Where to write the next numBytes, nullptr when a fixed buffer is full
+	void AppendElements(void const* data, size_t elementSize, size_t count);
+
+private:
+	std::vector<unsigned char>* m_vector = nullptr;
+	unsigned char*	m_fixedBuffer = nullptr;
+	size_t			m_fixedCapacity = 0;
+	size_t			m_fixedSize = 0;
+	bool			m_hasOverflowed = false;
+	eBufferEndian	m_endian = eBufferEndian::NATIVE;
+	bool			m_isByteSwapNeeded = false;
 };
 
+template<typename T>
+void BufferWriter::AppendPrimitive(T value)
+{
+	static_assert(std::is_arithmetic<T>::value, "BufferWriter::AppendPrimitive only writes numbers");
+
+	if constexpr (sizeof(T) == 2)
+	{
+		if (m_isByteSwapNeeded)
+		{
+			uint16_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			bits = ByteSwap16(bits);
+			std::memcpy(&value, &bits, sizeof(bits));
+		}
+	}
+	else if constexpr (sizeof(T) == 4)
+	{
+		if (m_isByteSwapNeeded)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			bits = ByteSwap32(bits);
+			std::memcpy(&value, &bits, sizeof(bits));
+		}
+	}
+	else if constexpr (sizeof(T) == 8)
+	{
+		if (m_isByteSwapNeeded)
+		{
+			uint64_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			bits = ByteSwap64(bits);
+			std::memcpy(&value, &bits, sizeof(bits));
+		}
+	}
+
+	// Stays inline, small values are written far too often to go through Grow
+	if (m_vector)
+	{
+		unsigned char bytes[sizeof(T)];
+		std::memcpy(bytes, &value, sizeof(T));
+		m_vector->insert(m_vector->end(), bytes, bytes + sizeof(T));
+	}
+	else if (!m_hasOverflowed && sizeof(T) <= m_fixedCapacity - m_fixedSize)
+	{
+		std::memcpy(m_fixedBuffer + m_fixedSize, &value, sizeof(T));
+		m_fixedSize += sizeof(T);
+	}
+	else
+	{
+		m_hasOverflowed = true;
+	}
+}
+
+template<typename T>
+void BufferWriter::AppendArray(T const* values, size_t count)
+{
+	static_assert(std::is_arithmetic<T>::value, "BufferWriter::AppendArray only writes numbers, write structs member by member");
+	AppendElements(values, sizeof(T), count);
+}
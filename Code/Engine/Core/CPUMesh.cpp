@@ -1,8 +1,14 @@
 #include "Engine/Core/CPUMesh.hpp"
 #include "Engine/Core/ObjLoader.hpp"
 #include "Engine/Core/VertexUtils.hpp"
-#include <windows.h>
-#include <chrono>
+#include "Engine/Core/BufferParser.hpp"
+#include "Engine/Core/BufferWriter.hpp"
+#include "Engine/Core/FileUtils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+constexpr size_t COOKED_MESH_HEADER_SIZE = 4 + 4 + 8 + 4 + 4 + 4 + 4 + 24 + 8 + 8 + 4;
 
 CPUMesh::CPUMesh(const std::string& objFileName, const Mat44& transform)
 {
@@ -16,15 +22,263 @@ CPUMesh::~CPUMesh()
 
 void CPUMesh::Load(const std::string& objFileName, const Mat44& transform)
 {
+	uint64_t sourceHash = GetSourceHash(objFileName, transform);
+	std::string cookedFileName = GetCookedFileName(objFileName);
+	if (sourceHash != 0 && LoadCooked(cookedFileName, sourceHash))
+	{
+		return;
+	}
+
 	m_vertexes.clear();
 	m_indexes.clear();
 	m_hasUv = false;
 	m_hasNormal = false;
+	m_materialLibraryFiles.clear();
 
-	ObjLoader::Load(objFileName, m_vertexes, m_indexes, m_hasNormal, m_hasUv, transform);
+	ObjLoader::Load(objFileName, m_vertexes, m_indexes, m_hasNormal, m_hasUv, transform, true, &m_materialLibraryFiles);
 
 	if (m_hasUv)
 	{
 		CalculateTangentSpaceBasisVectors(m_vertexes, m_indexes, !m_hasNormal);
 	}
+
+	m_bounds = AABB3(0.f, 0.f, 0.f, 0.f, 0.f, 0.f);
+	if (!m_vertexes.empty())
+	{
+		m_bounds = AABB3(m_vertexes[0].m_position, m_vertexes[0].m_position);
+		for (int vertexIndex = 1; vertexIndex < (int)m_vertexes.size(); ++vertexIndex)
+		{
+			Vec3 const& position = m_vertexes[vertexIndex].m_position;
+			m_bounds.m_mins.x = std::min(m_bounds.m_mins.x, position.x);
+			m_bounds.m_mins.y = std::min(m_bounds.m_mins.y, position.y);
+			m_bounds.m_mins.z = std::min(m_bounds.m_mins.z, position.z);
+			m_bounds.m_maxs.x = std::max(m_bounds.m_maxs.x, position.x);
+			m_bounds.m_maxs.y = std::max(m_bounds.m_maxs.y, position.y);
+			m_bounds.m_maxs.z = std::max(m_bounds.m_maxs.z, position.z);
+		}
+	}
+
+	if (sourceHash != 0 && !m_vertexes.empty())
+	{
+		SaveCooked(cookedFileName, AddMaterialLibrariesToSourceHash(sourceHash, m_materialLibraryFiles));
+	}
+}
+
+//-----------------------------------------------------------------------------------
+// The header is parsed field by field, the blobs are copied straight out of the mapping
+//
+bool CPUMesh::LoadCooked(const std::string& cookedFileName, uint64_t expectedSourceHash)
+{
+	MappedFile cookedFile;
+	if (!cookedFile.Open(cookedFileName) || cookedFile.GetSize() < COOKED_MESH_HEADER_SIZE)
+	{
+		return false;
+	}
+
+	BufferParser parser(cookedFile.GetData(), cookedFile.GetSize(), eBufferEndian::LITTLE);
+	uint32_t magic = parser.ParseUint32();
+	uint32_t version = parser.ParseUint32();
+	uint64_t sourceHash = parser.ParseUint64();
+	uint32_t vertexSize = parser.ParseUint32();
+	uint32_t flags = parser.ParseUint32();
+	uint32_t numVertexes = parser.ParseUint32();
+	uint32_t numIndexes = parser.ParseUint32();
+	AABB3 bounds;
+	bounds.m_mins.x = parser.ParseFloat();
+	bounds.m_mins.y = parser.ParseFloat();
+	bounds.m_mins.z = parser.ParseFloat();
+	bounds.m_maxs.x = parser.ParseFloat();
+	bounds.m_maxs.y = parser.ParseFloat();
+	bounds.m_maxs.z = parser.ParseFloat();
+	uint64_t vertexDataOffset = parser.ParseUint64();
+	uint64_t indexDataOffset = parser.ParseUint64();
+	uint32_t numMaterialLibraries = parser.ParseUint32();
+
+	if (magic != COOKED_MESH_MAGIC || version != COOKED_MESH_VERSION || vertexSize != sizeof(Vertex_PCUTBN))
+	{
+		return false;
+	}
+
+	// Every length is checked before it is read, a corrupt file only fails the load
+	std::vector<std::string> materialLibraryFiles;
+	if (numMaterialLibraries > parser.GetRemainingSize() / 4)
+	{
+		return false;
+	}
+	materialLibraryFiles.resize(numMaterialLibraries);
+	for (std::string& materialLibraryFile : materialLibraryFiles)
+	{
+		if (parser.GetRemainingSize() < 4)
+		{
+			return false;
+		}
+		uint32_t nameLength = parser.ParseUint32();
+		if (nameLength > parser.GetRemainingSize())
+		{
+			return false;
+		}
+		materialLibraryFile.resize(nameLength);
+		parser.ParseByteArray(materialLibraryFile.data(), nameLength);
+	}
+
+	if (sourceHash != AddMaterialLibrariesToSourceHash(expectedSourceHash, materialLibraryFiles))
+	{
+		return false;
+	}
+
+	uint64_t fileSize = cookedFile.GetSize();
+	uint64_t vertexDataSize = (uint64_t)numVertexes * sizeof(Vertex_PCUTBN);
+	uint64_t indexDataSize = (uint64_t)numIndexes * sizeof(unsigned int);
+	if (vertexDataOffset > fileSize || vertexDataSize > fileSize - vertexDataOffset || indexDataOffset > fileSize || indexDataSize > fileSize - indexDataOffset)
+	{
+		return false;
+	}
+
+	m_vertexes.resize(numVertexes);
+	m_indexes.resize(numIndexes);
+	if (numVertexes > 0)
+	{
+		memcpy((void*)m_vertexes.data(), cookedFile.GetData() + vertexDataOffset, (size_t)vertexDataSize);
+	}
+	if (numIndexes > 0)
+	{
+		memcpy(m_indexes.data(), cookedFile.GetData() + indexDataOffset, (size_t)indexDataSize);
+	}
+
+	m_hasNormal = (flags & 1) != 0;
+	m_hasUv = (flags & 2) != 0;
+	m_bounds = bounds;
+	m_materialLibraryFiles = std::move(materialLibraryFiles);
+	return true;
+}
+
+bool CPUMesh::SaveCooked(const std::string& cookedFileName, uint64_t sourceHash) const
+{
+	uint64_t materialLibrariesSize = 0;
+	for (std::string const& materialLibraryFile : m_materialLibraryFiles)
+	{
+		materialLibrariesSize += 4 + materialLibraryFile.size();
+	}
+
+	uint64_t vertexDataSize = (uint64_t)m_vertexes.size() * sizeof(Vertex_PCUTBN);
+	uint64_t vertexDataOffset = (COOKED_MESH_HEADER_SIZE + materialLibrariesSize + COOKED_MESH_BLOB_ALIGNMENT - 1) & ~(uint64_t)(COOKED_MESH_BLOB_ALIGNMENT - 1);
+	uint64_t indexDataOffset = (vertexDataOffset + vertexDataSize + COOKED_MESH_BLOB_ALIGNMENT - 1) & ~(uint64_t)(COOKED_MESH_BLOB_ALIGNMENT - 1);
+
+	std::vector<unsigned char> buffer;
+	BufferWriter writer(buffer, eBufferEndian::LITTLE);
+	writer.Reserve((size_t)(indexDataOffset + m_indexes.size() * sizeof(unsigned int)));
+
+	writer.AppendPrimitive<uint32_t>(COOKED_MESH_MAGIC);
+	writer.AppendPrimitive<uint32_t>(COOKED_MESH_VERSION);
+	writer.AppendPrimitive<uint64_t>(sourceHash);
+	writer.AppendPrimitive<uint32_t>((uint32_t)sizeof(Vertex_PCUTBN));
+	writer.AppendPrimitive<uint32_t>((m_hasNormal ? 1u : 0u) | (m_hasUv ? 2u : 0u));
+	writer.AppendPrimitive<uint32_t>((uint32_t)m_vertexes.size());
+	writer.AppendPrimitive<uint32_t>((uint32_t)m_indexes.size());
+	writer.AppendPrimitive<float>(m_bounds.m_mins.x);
+	writer.AppendPrimitive<float>(m_bounds.m_mins.y);
+	writer.AppendPrimitive<float>(m_bounds.m_mins.z);
+	writer.AppendPrimitive<float>(m_bounds.m_maxs.x);
+	writer.AppendPrimitive<float>(m_bounds.m_maxs.y);
+	writer.AppendPrimitive<float>(m_bounds.m_maxs.z);
+	writer.AppendPrimitive<uint64_t>(vertexDataOffset);
+	writer.AppendPrimitive<uint64_t>(indexDataOffset);
+	writer.AppendPrimitive<uint32_t>((uint32_t)m_materialLibraryFiles.size());
+	for (std::string const& materialLibraryFile : m_materialLibraryFiles)
+	{
+		writer.AppendLengthPrecededString(materialLibraryFile);
+	}
+
+	// The blobs are memory images of the vectors, only valid on little endian machines like the loader
+	writer.AppendZeroBytes((size_t)vertexDataOffset - writer.GetBufferSize());
+	writer.AppendByteArray(m_vertexes.data(), (size_t)vertexDataSize);
+	writer.AppendZeroBytes((size_t)indexDataOffset - writer.GetBufferSize());
+	writer.AppendArray(m_indexes);
+
+	// Write to a temporary and swap it in so a crash never leaves a truncated cache behind
+	std::string tempFileName = cookedFileName + ".tmp";
+	if (FileWriteBinary(tempFileName, buffer) < 0)
+	{
+		return false;
+	}
+
+	std::error_code errorCode;
+	std::filesystem::rename(tempFileName, cookedFileName, errorCode);
+	return !errorCode;
+}
+
+std::string CPUMesh::GetCookedFileName(const std::string& objFileName)
+{
+	return objFileName + ".cooked";
+}
+
+// FNV-1a, continuing from hash
+static uint64_t HashCookedSourceBytes(uint64_t hash, void const* data, size_t numBytes)
+{
+	unsigned char const* bytes = static_cast<unsigned char const*>(data);
+	for (size_t byteIndex = 0; byteIndex < numBytes; ++byteIndex)
+	{
+		hash ^= bytes[byteIndex];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// Size and write time, false when the file can't be found
+static bool GetFileStamp(const std::string& fileName, uint64_t& out_fileSize, uint64_t& out_writeTime)
+{
+	std::error_code errorCode;
+	out_fileSize = (uint64_t)std::filesystem::file_size(fileName, errorCode);
+	if (errorCode)
+	{
+		return false;
+	}
+	out_writeTime = (uint64_t)std::filesystem::last_write_time(fileName, errorCode).time_since_epoch().count();
+	return !errorCode;
+}
+
+//-----------------------------------------------------------------------------------
+// Hashes what the cooked data depends on: the obj size and write time, the transform and the
+// cooked version. Cheap enough to run on every load, unlike hashing the whole obj. Returns 0 when
+// the obj can't be found, which disables the cache.
+//
+uint64_t CPUMesh::GetSourceHash(const std::string& objFileName, const Mat44& transform)
+{
+	uint64_t fileSize = 0;
+	uint64_t writeTime = 0;
+	if (!GetFileStamp(objFileName, fileSize, writeTime))
+	{
+		return 0;
+	}
+
+	uint64_t hash = 14695981039346656037ull;
+	hash = HashCookedSourceBytes(hash, &COOKED_MESH_VERSION, sizeof(COOKED_MESH_VERSION));
+	hash = HashCookedSourceBytes(hash, &fileSize, sizeof(fileSize));
+	hash = HashCookedSourceBytes(hash, &writeTime, sizeof(writeTime));
+	hash = HashCookedSourceBytes(hash, transform.m_value, sizeof(transform.m_value));
+	return hash != 0 ? hash : 1;
+}
+
+//-----------------------------------------------------------------------------------
+// The mtl files are only known once the obj has been parsed, so the cooked file lists them and
+// their path, size and write time are folded in on top of the obj hash. A missing mtl hashes as
+// missing, creating it later rebuilds the cache too.
+//
+uint64_t CPUMesh::AddMaterialLibrariesToSourceHash(uint64_t sourceHash, const std::vector<std::string>& materialLibraryFiles)
+{
+	uint64_t hash = sourceHash;
+	for (std::string const& materialLibraryFile : materialLibraryFiles)
+	{
+		uint64_t fileSize = UINT64_MAX;
+		uint64_t writeTime = UINT64_MAX;
+		if (!GetFileStamp(materialLibraryFile, fileSize, writeTime))
+		{
+			fileSize = UINT64_MAX;
+			writeTime = UINT64_MAX;
+		}
+		hash = HashCookedSourceBytes(hash, materialLibraryFile.data(), materialLibraryFile.size());
+		hash = HashCookedSourceBytes(hash, &fileSize, sizeof(fileSize));
+		hash = HashCookedSourceBytes(hash, &writeTime, sizeof(writeTime));
+	}
+	return hash != 0 ? hash : 1;
 }
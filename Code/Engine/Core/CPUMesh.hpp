@@ -3,6 +3,20 @@
 #include <string>
 #include "Engine/Core/Vertex_PCU.hpp"
 #include "Engine/Math/Matrix44.hpp"
+#include "Engine/Math/AABB3.hpp"
+#include <cstdint>
+
+//-----------------------------------------------------------------------------------
+// Cooked meshes are the loaded, transformed and tangent space ready vertexes and indexes dumped as
+// is, next to the source as <objFileName>.cooked. Layout, all little endian:
+//   header (see CPUMesh::SaveCooked), material library paths (uint32 length + chars each),
+//   padding up to COOKED_MESH_BLOB_ALIGNMENT, Vertex_PCUTBN blob, index blob (uint32)
+// The version and the vertex size are in the header, bump COOKED_MESH_VERSION whenever the
+// layout or the way meshes are built changes so every stale cache gets rebuilt.
+//
+constexpr uint32_t	COOKED_MESH_MAGIC = 0x48534D43; // "CMSH"
+constexpr uint32_t	COOKED_MESH_VERSION = 2;
+constexpr size_t	COOKED_MESH_BLOB_ALIGNMENT = 16;
 
 class CPUMesh 
 {
@@ -12,12 +26,24 @@ public:
 	CPUMesh(const std::string& objFileName, const Mat44& transform);
 	virtual ~CPUMesh();
 
+	// Uses the cooked mesh next to the obj when it is up to date, parses the obj and cooks it otherwise
 	void Load(const std::string& objFileName, const Mat44& transform);
 
+	// expectedSourceHash comes from GetSourceHash, the material libraries listed in the cooked file are
+	// folded into it before comparing. sourceHash already has m_materialLibraryFiles folded in.
+	bool LoadCooked(const std::string& cookedFileName, uint64_t expectedSourceHash);
+	bool SaveCooked(const std::string& cookedFileName, uint64_t sourceHash) const;
+
+	static std::string	GetCookedFileName(const std::string& objFileName);
+	static uint64_t		GetSourceHash(const std::string& objFileName, const Mat44& transform);
+	static uint64_t		AddMaterialLibrariesToSourceHash(uint64_t sourceHash, const std::vector<std::string>& materialLibraryFiles);
+
 public:
 	std::vector<Vertex_PCUTBN>		m_vertexes;
 	std::vector<unsigned int>		m_indexes;
-	bool							m_hasNormal;
-	bool							m_hasUv;
+	AABB3							m_bounds = AABB3(0.f, 0.f, 0.f, 0.f, 0.f, 0.f);
+	bool							m_hasNormal = false;
+	bool							m_hasUv = false;
+	std::vector<std::string>		m_materialLibraryFiles;			// The .mtl files the obj referenced, their colors are baked into m_vertexes
 };
 	
\ No newline at end of file
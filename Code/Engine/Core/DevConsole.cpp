@@ -8,6 +8,7 @@
 #include "Engine/Renderer/Renderer.hpp"
 #include "Engine/Renderer/BitmapFont.hpp"
 #include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Core/EngineBenchmarks.hpp"
 
 DevConsole* g_theConsole = nullptr;
 
@@ -44,11 +45,13 @@ void DevConsole::Startup()
 	g_theEventSystem->SubscribeEventCallbackFunction("echo", DevConsole::Command_Echo);
 	g_theEventSystem->SubscribeEventCallbackFunction("CharInput", DevConsole::Event_CharInput);
 	g_theEventSystem->SubscribeEventCallbackFunction("KeyPressed",DevConsole::Event_KeyPressed);
+
+	RegisterEngineBenchmarkCommands();
 }
 
 void DevConsole::Shutdown()
 {
-
+	UnregisterEngineBenchmarkCommands();
 }
 
 void DevConsole::BeginFrame()
@@ -79,29 +82,24 @@ void DevConsole::EndFrame()
 
 void DevConsole::Execute(std::string const& consoleCommandText)
 {
-	Strings strings = SplitStringOnDelimiter(consoleCommandText, '\n');
-
-	for (int i = 0; i < (int)strings.size(); ++i)
+	for (std::string_view line : StringSplitter(consoleCommandText, '\n'))
 	{
-		Strings keyValueText = SplitStringOnDelimiter(strings[i],' ');
-
-		if (keyValueText.size() >=1)
-		{
-			std::string cmdName = keyValueText[0];
+		StringSplitter keyValueText(line, ' ');
+		std::string_view cmdName;
+		keyValueText.GetNext(cmdName);
 
-			EventArgs arguments = EventArgs();
+		EventArgs arguments = EventArgs();
 
-			for (int j = 1; j < (int)keyValueText.size(); ++j)
+		std::string_view keyValuePair;
+		while (keyValueText.GetNext(keyValuePair))
+		{
+			std::string_view keyValue[2];
+			if (SplitStringViewOnDelimiter(keyValuePair, '=', keyValue, 2) == 2)
 			{
-				Strings keyValue = SplitStringOnDelimiter(keyValueText[j], '=');
-
-				if (keyValue.size() == 2)
-				{
-					arguments.SetValue(keyValue[0], keyValue[1]);
-				}
+				arguments.SetValue(std::string(keyValue[0]), std::string(keyValue[1]));
 			}
-			g_theEventSystem->FireEvent(cmdName,arguments);
 		}
+		g_theEventSystem->FireEvent(std::string(cmdName),arguments);
 	}
 }
 
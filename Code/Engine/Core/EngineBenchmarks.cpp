@@ -0,0 +1,62 @@
+#include "Engine/Core/EngineBenchmarks.hpp"
+#include "Engine/Core/EventSystem.hpp"
+#include "Engine/Core/BufferParserBenchmark.hpp"
+#include "Engine/Core/EventSystemBenchmark.hpp"
+#include "Engine/Core/JobSystemBenchmark.hpp"
+#include "Engine/Core/NetChannel.hpp"
+#include "Engine/Core/NetSystemBenchmark.hpp"
+#include "Engine/Core/ObjLoaderBenchmark.hpp"
+#include "Engine/Core/SerializationSelfTest.hpp"
+#include "Engine/Core/StringUtilsBenchmark.hpp"
+#include "Engine/Math/Matrix44Benchmark.hpp"
+#include "Engine/Physics/Broadphase3D.hpp"
+#include "Engine/Physics/MeshBVH.hpp"
+#include "Engine/Physics/RaycastPacketUtils.hpp"
+
+struct EngineBenchmarkCommand
+{
+	char const*					m_name;
+	EventSystemCallbackFunction	m_function;
+};
+
+static EngineBenchmarkCommand const s_engineBenchmarkCommands[] =
+{
+	{ "StringBenchmark",		Command_StringBenchmark },
+	{ "EventBenchmark",			Command_EventBenchmark },
+	{ "JobLatencyBenchmark",	Command_JobLatencyBenchmark },
+	{ "JobThroughputBenchmark",	Command_JobThroughputBenchmark },
+	{ "ParallelBenchmark",		Command_ParallelBenchmark },
+	{ "ObjLoaderBenchmark",		Command_ObjLoaderBenchmark },
+	{ "BufferParserBenchmark",	Command_BufferParserBenchmark },
+	{ "SerializationSelfTest",	Command_SerializationSelfTest },
+	{ "NetBenchmark",			Command_NetBenchmark },
+	{ "NetChannelTest",			Command_NetChannelTest },
+	{ "Mat44Benchmark",			Command_Mat44Benchmark },
+	{ "RaycastBenchmark",		Command_RaycastBenchmark },
+	{ "MeshBVHBenchmark",		Command_MeshBVHBenchmark },
+	{ "BroadphaseBenchmark",	Command_BroadphaseBenchmark },
+};
+
+void RegisterEngineBenchmarkCommands()
+{
+	if (g_theEventSystem == nullptr)
+	{
+		return;
+	}
+	for (EngineBenchmarkCommand const& command : s_engineBenchmarkCommands)
+	{
+		g_theEventSystem->SubscribeEventCallbackFunction(command.m_name, command.m_function);
+	}
+}
+
+void UnregisterEngineBenchmarkCommands()
+{
+	if (g_theEventSystem == nullptr)
+	{
+		return;
+	}
+	for (EngineBenchmarkCommand const& command : s_engineBenchmarkCommands)
+	{
+		g_theEventSystem->UnsubscribeEventCallbackFunction(command.m_name, command.m_function);
+	}
+}
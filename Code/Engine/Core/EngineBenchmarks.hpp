@@ -0,0 +1,10 @@
+#pragma once
+
+//-----------------------------------------------------------------------------------
+// Every benchmark and self test console command of the engine, Core, Math and Physics alike,
+// subscribed by DevConsole::Startup and unsubscribed by DevConsole::Shutdown. Commands that need a
+// subsystem, like the job system benchmarks, check for it when they run. A new benchmark module
+// adds its command to the list in EngineBenchmarks.cpp.
+//
+void	RegisterEngineBenchmarkCommands();
+void	UnregisterEngineBenchmarkCommands();
@@ -1,5 +1,73 @@
 #include "Engine/Core/EngineCommon.hpp"
 #include "Engine/Core/NamedStrings.hpp"
 #include "Engine/Core/NamedProperties.hpp"
+#include <cstring>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ENGINE_COMMON_SSE2
+#endif
 
 NamedProperties g_gameConfigBlackboard = NamedProperties();
+
+eBufferEndian GetPlatformEndian()
+{
+	unsigned int value = 1;
+	unsigned char* bytePtr = reinterpret_cast<unsigned char*>(&value);
+	return bytePtr[0] == 1 ? eBufferEndian::LITTLE : eBufferEndian::BIG;
+}
+
+//-----------------------------------------------------------------------------------
+// Swaps every element of a packed array in place. With SSE2 16 bytes are swapped at a time: the
+// words of every element are reordered with shuffles, then the two bytes of every word are swapped
+// with shifts, the scalar loop only handles the tail.
+//
+void ByteSwapArray(void* data, size_t elementSize, size_t count)
+{
+	unsigned char* bytes = static_cast<unsigned char*>(data);
+	size_t numBytes = elementSize * count;
+	size_t byteIndex = 0;
+
+#if defined(ENGINE_COMMON_SSE2)
+	for (; byteIndex + 16 <= numBytes; byteIndex += 16)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(bytes + byteIndex));
+		if (elementSize == 8)
+		{
+			block = _mm_shuffle_epi32(block, _MM_SHUFFLE(2, 3, 0, 1));
+		}
+		if (elementSize >= 4)
+		{
+			block = _mm_shufflelo_epi16(block, _MM_SHUFFLE(2, 3, 0, 1));
+			block = _mm_shufflehi_epi16(block, _MM_SHUFFLE(2, 3, 0, 1));
+		}
+		block = _mm_or_si128(_mm_slli_epi16(block, 8), _mm_srli_epi16(block, 8));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + byteIndex), block);
+	}
+#endif
+
+	for (; byteIndex < numBytes; byteIndex += elementSize)
+	{
+		unsigned char* element = bytes + byteIndex;
+		if (elementSize == 2)
+		{
+			uint16_t value;
+			std::memcpy(&value, element, 2);
+			value = ByteSwap16(value);
+			std::memcpy(element, &value, 2);
+		}
+		else if (elementSize == 4)
+		{
+			uint32_t value;
+			std::memcpy(&value, element, 4);
+			value = ByteSwap32(value);
+			std::memcpy(element, &value, 4);
+		}
+		else
+		{
+			uint64_t value;
+			std::memcpy(&value, element, 8);
+			value = ByteSwap64(value);
+			std::memcpy(element, &value, 8);
+		}
+	}
+}
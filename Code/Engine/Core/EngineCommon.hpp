@@ -7,6 +7,7 @@
 #include "Engine/Math/AABB2.hpp"
 #include "Engine/Math/LineSegment2.hpp"
 #include "Engine/Math/FloatRange.hpp"
+#include <cstdint>
 #include <mutex>
 #define UNUSED(x) (void)(x)
 
@@ -15,6 +16,7 @@ class NamedProperties;
 class DevConsole;
 class EventSystem;
 class DebugRenderSystem;
+class JobSystem;
 
 typedef NamedProperties EventArgs;
 typedef bool(*EventSystemCallbackFunction)(EventArgs const&);
@@ -24,6 +26,7 @@ extern NamedProperties		g_gameConfigBlackboard;				// declared in EngineCommon.h
 extern DevConsole*			g_theConsole;						// declared in EngineCommon.hpp, defined in DevConsole.cpp
 extern EventSystem*			g_theEventSystem;					// declared in EngineCommon.hpp, defined in EventSystem.cpp
 extern DebugRenderSystem*	g_theRenderSystem;				// defined in DebugRenderSystem.cpp
+extern JobSystem*			g_theJobSystem;						// declared in EngineCommon.hpp, defined in JobSystem.cpp
 
 
 enum class eBufferEndian
@@ -32,3 +35,10 @@ enum class eBufferEndian
 	LITTLE,
 	BIG
 };
+
+eBufferEndian	GetPlatformEndian();												// LITTLE or BIG, never NATIVE
+
+inline uint16_t	ByteSwap16(uint16_t value) { return static_cast<uint16_t>((value << 8) | (value >> 8)); }
+inline uint32_t	ByteSwap32(uint32_t value) { return (value << 24) | ((value << 8) & 0x00FF0000u) | ((value >> 8) & 0x0000FF00u) | (value >> 24); }
+inline uint64_t	ByteSwap64(uint64_t value) { return (static_cast<uint64_t>(ByteSwap32(static_cast<uint32_t>(value))) << 32) | ByteSwap32(static_cast<uint32_t>(value >> 32)); }
+void			ByteSwapArray(void* data, size_t elementSize, size_t count);		// In place, elementSize is 2, 4 or 8
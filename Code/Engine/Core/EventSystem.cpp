@@ -2,34 +2,194 @@
 #include "Engine/Core/DevConsole.hpp"
 #include "Engine/Core/NamedStrings.hpp"
 #include "Engine/Core/NamedProperties.hpp"
+#include <algorithm>
 
 EventSystem* g_theEventSystem = nullptr;
 
+constexpr int DEFERRED_EVENTS_PER_BLOCK = 256;
+constexpr int MAX_THREAD_FREE_DEFERRED_EVENTS = 1024; // Past this a thread hands half of its free payloads back to the shared pool
+
+//-----------------------------------------------------------------------------------
+struct DeferredEvent
+{
+	EventHandle			m_eventHandle;
+	EventArgs			m_args;
+	DeferredEvent*		m_nextEvent = nullptr;
+};
+
+//-----------------------------------------------------------------------------------
+// Payloads are recycled by the thread that dispatches them and allocated by whoever fires, so
+// like LambdaJobs they go through per thread free lists and only touch this shared pool in batches.
+//
+class DeferredEventPool
+{
+public:
+	~DeferredEventPool()
+	{
+		for (int blockIndex = 0; blockIndex < (int)m_blocks.size(); ++blockIndex)
+		{
+			delete[] m_blocks[blockIndex];
+		}
+		m_blocks.clear();
+	}
+
+	DeferredEvent* TakeEvents(int& outNumEvents)
+	{
+		m_mutex.lock();
+
+		if (m_freeEvents == nullptr)
+		{
+			DeferredEvent* block = new DeferredEvent[DEFERRED_EVENTS_PER_BLOCK];
+			m_blocks.push_back(block);
+			for (int eventIndex = 0; eventIndex < DEFERRED_EVENTS_PER_BLOCK; ++eventIndex)
+			{
+				block[eventIndex].m_nextEvent = m_freeEvents;
+				m_freeEvents = &block[eventIndex];
+			}
+		}
+
+		DeferredEvent* events = m_freeEvents;
+		DeferredEvent* last = events;
+		outNumEvents = 1;
+		while (last->m_nextEvent && outNumEvents < DEFERRED_EVENTS_PER_BLOCK)
+		{
+			last = last->m_nextEvent;
+			outNumEvents++;
+		}
+		m_freeEvents = last->m_nextEvent;
+		last->m_nextEvent = nullptr;
+
+		m_mutex.unlock();
+		return events;
+	}
+
+	void GiveEvents(DeferredEvent* first, DeferredEvent* last)
+	{
+		m_mutex.lock();
+		last->m_nextEvent = m_freeEvents;
+		m_freeEvents = first;
+		m_mutex.unlock();
+	}
+
+private:
+	std::mutex						m_mutex;
+	DeferredEvent*					m_freeEvents = nullptr;
+	std::vector<DeferredEvent*>		m_blocks;
+};
+
+static DeferredEventPool s_deferredEventPool;
+
+struct DeferredEventFreeList
+{
+	~DeferredEventFreeList()
+	{
+		if (m_freeEvents)
+		{
+			DeferredEvent* last = m_freeEvents;
+			while (last->m_nextEvent)
+			{
+				last = last->m_nextEvent;
+			}
+			s_deferredEventPool.GiveEvents(m_freeEvents, last);
+		}
+	}
+
+	DeferredEvent*					m_freeEvents = nullptr;
+	int								m_numFreeEvents = 0;
+};
+
+static thread_local DeferredEventFreeList t_deferredEventFreeList;
+
+static DeferredEvent* AllocateDeferredEvent(EventHandle eventHandle)
+{
+	DeferredEventFreeList& freeList = t_deferredEventFreeList;
+	if (freeList.m_freeEvents == nullptr)
+	{
+		freeList.m_freeEvents = s_deferredEventPool.TakeEvents(freeList.m_numFreeEvents);
+	}
+
+	DeferredEvent* deferredEvent = freeList.m_freeEvents;
+	freeList.m_freeEvents = deferredEvent->m_nextEvent;
+	freeList.m_numFreeEvents -= 1;
+
+	deferredEvent->m_eventHandle = eventHandle;
+	deferredEvent->m_nextEvent = nullptr;
+	return deferredEvent;
+}
+
+static void RecycleDeferredEvent(DeferredEvent* deferredEvent)
+{
+	deferredEvent->m_args.Clear();
+
+	DeferredEventFreeList& freeList = t_deferredEventFreeList;
+	deferredEvent->m_nextEvent = freeList.m_freeEvents;
+	freeList.m_freeEvents = deferredEvent;
+	freeList.m_numFreeEvents += 1;
+
+	// The dispatching thread recycles everything, hand some back so producers can reuse it
+	if (freeList.m_numFreeEvents > MAX_THREAD_FREE_DEFERRED_EVENTS)
+	{
+		int numEventsToGive = freeList.m_numFreeEvents / 2;
+		DeferredEvent* first = freeList.m_freeEvents;
+		DeferredEvent* last = first;
+		for (int eventIndex = 1; eventIndex < numEventsToGive; ++eventIndex)
+		{
+			last = last->m_nextEvent;
+		}
+
+		freeList.m_freeEvents = last->m_nextEvent;
+		freeList.m_numFreeEvents -= numEventsToGive;
+		s_deferredEventPool.GiveEvents(first, last);
+	}
+}
+
 EventSystem::EventSystem(EventSystemConfig const& config)
 	:m_config(config)
 {
-
+	int tableSize = 16;
+	while (tableSize < m_config.m_initialEventTableSize)
+	{
+		tableSize <<= 1;
+	}
+	m_eventTable.resize(tableSize);
 }
 
 EventRecipient::~EventRecipient()
 {
-	g_theEventSystem->UnSubscribeEventRecipient(this);
+	if (g_theEventSystem)
+	{
+		g_theEventSystem->UnSubscribeEventRecipient(this);
+	}
 }
 
 EventSystem::~EventSystem()
 {
-	for (auto& pair : m_memberFunctionSubscriptionList)
+	// Whatever is still queued is dropped without being fired
+	DeferredEvent* deferredEvent = m_deferredEventsHead.exchange(nullptr, std::memory_order_acquire);
+	while (deferredEvent)
 	{
-		for (EventRecipient* recipient : pair.second)
-		{
-			delete recipient;
-		}
+		DeferredEvent* nextEvent = deferredEvent->m_nextEvent;
+		RecycleDeferredEvent(deferredEvent);
+		deferredEvent = nextEvent;
+	}
+
+	// Take the recipients out first, deleting one calls back into UnSubscribeEventRecipient
+	std::vector<EventRecipient*> recipients;
+	for (int eventIndex = 0; eventIndex < (int)m_events.size(); ++eventIndex)
+	{
+		std::vector<EventRecipient*>& eventRecipients = m_events[eventIndex].m_recipients;
+		recipients.insert(recipients.end(), eventRecipients.begin(), eventRecipients.end());
+		eventRecipients.clear();
+	}
+
+	for (int recipientIndex = 0; recipientIndex < (int)recipients.size(); ++recipientIndex)
+	{
+		delete recipients[recipientIndex];
 	}
 }
 
 void EventSystem::StartUp()
 {
-
 }
 
 void EventSystem::Shutdown()
@@ -38,37 +198,31 @@ void EventSystem::Shutdown()
 
 void EventSystem::BeginFrame()
 {
+	DispatchDeferredEvents();
 }
 
 void EventSystem::EndFrame()
 {
+	DispatchDeferredEvents();
 }
 
 void EventSystem::SubscribeEventCallbackFunction(std::string const& eventName, EventSystemCallbackFunction functionPtr)
 {
 	m_subscriptionListMutex.lock();
 
-	auto iter = m_subscriptionListByEventName.find(eventName);
+	int eventIndex = FindOrCreateEventIndex(HashedCaseInsensitiveString(eventName));
+	SubscriptionList& subscription = m_events[eventIndex].m_functionSubscribers;
 
-	if (iter != m_subscriptionListByEventName.end())
+	for (int i = 0; i < (int)subscription.size(); ++i)
 	{
-		SubscriptionList& subscription = iter->second;
-
-		for (int i = 0; i < subscription.size(); ++i)
+		if (subscription[i] == nullptr)
 		{
-			if (subscription[i] == nullptr)
-			{
-				subscription[i] = functionPtr;
-				m_subscriptionListMutex.unlock();
-				return;
-			}
+			subscription[i] = functionPtr;
+			m_subscriptionListMutex.unlock();
+			return;
 		}
-		subscription.push_back(functionPtr);
-	}
-	else 
-	{
-		m_subscriptionListByEventName[eventName].push_back(functionPtr);
 	}
+	subscription.push_back(functionPtr);
 
 	m_subscriptionListMutex.unlock();
 }
@@ -77,13 +231,13 @@ void EventSystem::UnsubscribeEventCallbackFunction(std::string const& eventName,
 {
 	m_subscriptionListMutex.lock();
 
-	auto iter = m_subscriptionListByEventName.find(eventName);
+	int eventIndex = FindEventIndex(HashedCaseInsensitiveString::GetHashCode(eventName), eventName.c_str());
 
-	if (iter != m_subscriptionListByEventName.end()) 
+	if (eventIndex >= 0)
 	{
-		SubscriptionList& subscription = iter->second;
+		SubscriptionList& subscription = m_events[eventIndex].m_functionSubscribers;
 
-		for (int i = 0; i < subscription.size(); ++i)
+		for (int i = 0; i < (int)subscription.size(); ++i)
 		{
 			if (functionPtr == subscription[i])
 			{
@@ -96,89 +250,270 @@ void EventSystem::UnsubscribeEventCallbackFunction(std::string const& eventName,
 
 void EventSystem::UnSubscribeEventRecipient(EventRecipient* event)
 {
-	for (auto& pair : m_memberFunctionSubscriptionList) {
-		auto& vec = pair.second;
-		vec.erase
+	m_subscriptionListMutex.lock();
+	for (int eventIndex = 0; eventIndex < (int)m_events.size(); ++eventIndex)
+	{
+		std::vector<EventRecipient*>& recipients = m_events[eventIndex].m_recipients;
+		recipients.erase
 		(
-			std::remove(vec.begin(), vec.end(), event),
-			vec.end()
+			std::remove(recipients.begin(), recipients.end(), event),
+			recipients.end()
 		);
 	}
+	m_subscriptionListMutex.unlock();
+}
+
+EventHandle EventSystem::GetEventHandle(std::string const& eventName)
+{
+	m_subscriptionListMutex.lock();
+	int eventIndex = FindOrCreateEventIndex(HashedCaseInsensitiveString(eventName));
+	m_subscriptionListMutex.unlock();
+
+	return EventHandle(eventIndex);
+}
+
+EventHandle EventSystem::FindEventHandle(std::string const& eventName)
+{
+	m_subscriptionListMutex.lock();
+	int eventIndex = FindEventIndex(HashedCaseInsensitiveString::GetHashCode(eventName), eventName.c_str());
+	m_subscriptionListMutex.unlock();
+
+	return EventHandle(eventIndex);
 }
 
 void EventSystem::FireEvent(std::string const& eventName, EventArgs& args)
 {
 	m_subscriptionListMutex.lock();
 
-	bool hasEvent = false;
+	int eventIndex = FindEventIndex(HashedCaseInsensitiveString::GetHashCode(eventName), eventName.c_str());
+	if (eventIndex >= 0)
+	{
+		FireEventEntry(m_events[eventIndex], args);
+	}
+	else if (g_theConsole != nullptr)
+	{
+		g_theConsole->AddLine(DevConsole::WARNING, eventName);
+		g_theConsole->AddLine(g_theConsole->ERROR, "NO SUCH COMMAND IN THE COMMAND LIST!");
+	}
+
+	m_subscriptionListMutex.unlock();
+}
 
-	for (auto it = m_subscriptionListByEventName.begin(); it != m_subscriptionListByEventName.end(); ++it) 
+void EventSystem::FireEvent(std::string const& eventName)
+{
+	EventArgs nullStrings;
+	FireEvent(eventName, nullStrings);
+}
+
+void EventSystem::FireEvent(EventHandle eventHandle, EventArgs& args)
+{
+	m_subscriptionListMutex.lock();
+
+	GUARANTEE_OR_DIE(eventHandle.m_eventIndex >= 0 && eventHandle.m_eventIndex < (int)m_events.size(), "Fired an event through an invalid EventHandle!");
+	FireEventEntry(m_events[eventHandle.m_eventIndex], args);
+
+	m_subscriptionListMutex.unlock();
+}
+
+void EventSystem::FireEvent(EventHandle eventHandle)
+{
+	EventArgs nullStrings;
+	FireEvent(eventHandle, nullStrings);
+}
+
+void EventSystem::FireEventDeferred(EventHandle eventHandle, EventArgs& args)
+{
+	DeferredEvent* deferredEvent = AllocateDeferredEvent(eventHandle);
+	deferredEvent->m_args.Swap(args);
+	PushDeferredEvent(deferredEvent);
+}
+
+void EventSystem::FireEventDeferred(EventHandle eventHandle)
+{
+	PushDeferredEvent(AllocateDeferredEvent(eventHandle));
+}
+
+void EventSystem::FireEventDeferred(std::string const& eventName, EventArgs& args)
+{
+	EventHandle eventHandle = FindEventHandle(eventName);
+	if (eventHandle.IsValid())
 	{
-		if (ToLower(it->first) == ToLower(eventName))
-		{
-			SubscriptionList& subscription = it->second;
+		FireEventDeferred(eventHandle, args);
+	}
+}
 
-			if ((subscription.size() == 0))
-			{
-				g_theConsole->AddLine(g_theConsole->ERROR, "NO REGISTERED SUBSCRIBERS!");
-				m_subscriptionListMutex.unlock();
-				return;
-			}
+void EventSystem::FireEventDeferred(std::string const& eventName)
+{
+	EventHandle eventHandle = FindEventHandle(eventName);
+	if (eventHandle.IsValid())
+	{
+		FireEventDeferred(eventHandle);
+	}
+}
 
-			hasEvent = true;
-			for (int i = 0; i < subscription.size(); ++i)
-			{
-				if (subscription[i] != nullptr)
-				{
-					subscription[i](args);
-				}
-			}
-		}
+void EventSystem::DispatchDeferredEvents()
+{
+	if (m_deferredEventsHead.load(std::memory_order_relaxed) == nullptr)
+	{
+		return;
 	}
 
-	HashedCaseInsensitiveString key(eventName);
-	auto it = m_memberFunctionSubscriptionList.find(key);
-	if (it != m_memberFunctionSubscriptionList.end())
+	// Take the whole batch in one go, events fired from the callbacks land in the next batch
+	DeferredEvent* newestEvent = m_deferredEventsHead.exchange(nullptr, std::memory_order_acquire);
+
+	DeferredEvent* oldestEvent = nullptr;
+	while (newestEvent)
 	{
-		for (EventRecipient* recipient : it->second)
-		{
-			if (recipient)
-				hasEvent = true;
-				recipient->Execute(args);
-		}
+		DeferredEvent* nextEvent = newestEvent->m_nextEvent;
+		newestEvent->m_nextEvent = oldestEvent;
+		oldestEvent = newestEvent;
+		newestEvent = nextEvent;
 	}
 
-	if (hasEvent == false)
+	m_subscriptionListMutex.lock();
+	while (oldestEvent)
 	{
-		if (g_theConsole!=nullptr)
+		DeferredEvent* nextEvent = oldestEvent->m_nextEvent;
+		int eventIndex = oldestEvent->m_eventHandle.m_eventIndex;
+		if (eventIndex >= 0 && eventIndex < (int)m_events.size())
 		{
-			g_theConsole->AddLine(DevConsole::WARNING, eventName);
-			g_theConsole->AddLine(g_theConsole->ERROR, "NO SUCH COMMAND IN THE COMMAND LIST!");
+			FireEventEntry(m_events[eventIndex], oldestEvent->m_args);
 		}
+		RecycleDeferredEvent(oldestEvent);
+		oldestEvent = nextEvent;
 	}
 	m_subscriptionListMutex.unlock();
 }
 
-void EventSystem::FireEvent(std::string const& eventName)
+void EventSystem::PushDeferredEvent(DeferredEvent* deferredEvent)
 {
-	EventArgs nullStrings;
-	FireEvent(eventName, nullStrings);
-}
+	GUARANTEE_OR_DIE(deferredEvent->m_eventHandle.IsValid(), "Deferred an event through an invalid EventHandle!");
 
+	DeferredEvent* head = m_deferredEventsHead.load(std::memory_order_relaxed);
+	do
+	{
+		deferredEvent->m_nextEvent = head;
+	} while (!m_deferredEventsHead.compare_exchange_weak(head, deferredEvent, std::memory_order_release, std::memory_order_relaxed));
+}
 
 std::vector<std::string> EventSystem::GetAllDevConsoleRegisteredCommands()
 {
 	std::vector<std::string> commandList;
-	commandList.reserve(m_subscriptionListByEventName.size());
 
-	for (const auto& keyPair : m_subscriptionListByEventName)
+	m_subscriptionListMutex.lock();
+	commandList.reserve(m_events.size());
+	for (int eventIndex = 0; eventIndex < (int)m_events.size(); ++eventIndex)
 	{
-		commandList.push_back(keyPair.first);
+		EventEntry const& entry = m_events[eventIndex];
+		if (!entry.m_functionSubscribers.empty())
+		{
+			commandList.push_back(entry.m_eventName.GetOriginalString());
+		}
 	}
+	m_subscriptionListMutex.unlock();
 
+	std::sort(commandList.begin(), commandList.end());
 	return commandList;
 }
 
+int EventSystem::FindEventIndex(unsigned int hash, char const* eventName) const
+{
+	size_t mask = m_eventTable.size() - 1;
+	for (size_t slotIndex = hash & mask; ; slotIndex = (slotIndex + 1) & mask)
+	{
+		EventTableSlot const& slot = m_eventTable[slotIndex];
+		if (slot.m_eventIndex < 0)
+		{
+			return -1;
+		}
+		if (slot.m_hash == hash && _stricmp(m_events[slot.m_eventIndex].m_eventName.c_str(), eventName) == 0)
+		{
+			return slot.m_eventIndex;
+		}
+	}
+}
+
+int EventSystem::FindOrCreateEventIndex(HashedCaseInsensitiveString const& eventName)
+{
+	int eventIndex = FindEventIndex(eventName.GetHash(), eventName.c_str());
+	if (eventIndex >= 0)
+	{
+		return eventIndex;
+	}
+
+	// Keep the table at most half full so probe sequences stay short
+	if ((m_events.size() + 1) * 2 > m_eventTable.size())
+	{
+		GrowEventTable();
+	}
+
+	eventIndex = (int)m_events.size();
+	m_events.emplace_back();
+	m_events.back().m_eventName = eventName;
+	InsertIntoEventTable(eventName.GetHash(), eventIndex);
+	return eventIndex;
+}
+
+void EventSystem::InsertIntoEventTable(unsigned int hash, int eventIndex)
+{
+	size_t mask = m_eventTable.size() - 1;
+	size_t slotIndex = hash & mask;
+	while (m_eventTable[slotIndex].m_eventIndex >= 0)
+	{
+		slotIndex = (slotIndex + 1) & mask;
+	}
+
+	m_eventTable[slotIndex].m_hash = hash;
+	m_eventTable[slotIndex].m_eventIndex = eventIndex;
+}
+
+void EventSystem::GrowEventTable()
+{
+	std::vector<EventTableSlot> oldTable;
+	oldTable.swap(m_eventTable);
+	m_eventTable.resize(oldTable.size() * 2);
+
+	for (int slotIndex = 0; slotIndex < (int)oldTable.size(); ++slotIndex)
+	{
+		if (oldTable[slotIndex].m_eventIndex >= 0)
+		{
+			InsertIntoEventTable(oldTable[slotIndex].m_hash, oldTable[slotIndex].m_eventIndex);
+		}
+	}
+}
+
+void EventSystem::FireEventEntry(EventEntry& entry, EventArgs& args)
+{
+	bool hasSubscriber = false;
+
+	// Index based loops on purpose, callbacks are allowed to subscribe and unsubscribe while we fire
+	SubscriptionList& subscription = entry.m_functionSubscribers;
+	for (int i = 0; i < (int)subscription.size(); ++i)
+	{
+		if (subscription[i] != nullptr)
+		{
+			hasSubscriber = true;
+			subscription[i](args);
+		}
+	}
+
+	std::vector<EventRecipient*>& recipients = entry.m_recipients;
+	for (int i = 0; i < (int)recipients.size(); ++i)
+	{
+		if (recipients[i] != nullptr)
+		{
+			hasSubscriber = true;
+			recipients[i]->Execute(args);
+		}
+	}
+
+	if (!hasSubscriber && g_theConsole != nullptr)
+	{
+		g_theConsole->AddLine(DevConsole::WARNING, entry.m_eventName.GetOriginalString());
+		g_theConsole->AddLine(g_theConsole->ERROR, "NO SUCH COMMAND IN THE COMMAND LIST!");
+	}
+}
+
 void SubscribeEventCallbackFunction(std::string const& eventName, EventSystemCallbackFunction functionPtr)
 {
 	g_theEventSystem->SubscribeEventCallbackFunction(eventName, functionPtr);
@@ -1,7 +1,8 @@
 #pragma once
 #include "Engine/Core/EngineCommon.hpp"
-#include <map>
 #include "Engine/Core/HashedCaseInsensitiveString.hpp"
+#include <atomic>
+#include <deque>
 
 class EventRecipient
 {
@@ -30,14 +31,42 @@ public:
 		return m_obj == rhs->m_obj && m_func == rhs->m_func;
 	}
 
+	bool Matches(T* obj, MemberEventCallback func) const
+	{
+		return m_obj == obj && m_func == func;
+	}
+
 private:
 	T* m_obj;
 	MemberEventCallback m_func;
 };
 
-struct EventSystemConfig
+//-----------------------------------------------------------------------------------
+// Cheap reference to an event, get it once with GetEventHandle and keep it around. Firing through
+// a handle skips the name lookup entirely. Handles stay valid for the lifetime of the event system
+// that gave them out, events are never removed once they are known.
+//
+class EventHandle
 {
+	friend class EventSystem;
+public:
+	EventHandle() = default;
+
+	bool IsValid() const { return m_eventIndex >= 0; }
+	bool operator==(EventHandle const& compare) const { return m_eventIndex == compare.m_eventIndex; }
+	bool operator!=(EventHandle const& compare) const { return m_eventIndex != compare.m_eventIndex; }
+
+private:
+	explicit EventHandle(int eventIndex) : m_eventIndex(eventIndex) {}
 
+	int m_eventIndex = -1;
+};
+
+struct DeferredEvent;
+
+struct EventSystemConfig
+{
+	int m_initialEventTableSize = 128;
 };
 
 class EventSystem
@@ -63,60 +92,108 @@ public:
 
 	void UnSubscribeEventRecipient(EventRecipient* event);
 
+	EventHandle GetEventHandle(std::string const& eventName);													// Registers the event if it is not known yet
+	EventHandle FindEventHandle(std::string const& eventName);													// Invalid handle if the event is not known, never registers it
+
 	void FireEvent(std::string const& eventName, EventArgs& args);													// For have parameters functions
 	void FireEvent(std::string const& eventName);																	// For no parameter functions
+	void FireEvent(EventHandle eventHandle, EventArgs& args);
+	void FireEvent(EventHandle eventHandle);
 
+	// Thread safe and lock free, the event is fired later on the thread that runs BeginFrame/EndFrame.
+	// args are swapped into a pooled payload and come back empty.
+	void FireEventDeferred(EventHandle eventHandle, EventArgs& args);
+	void FireEventDeferred(EventHandle eventHandle);
+	void FireEventDeferred(std::string const& eventName, EventArgs& args);									// Looks the name up under the mutex, prefer a handle. Unknown names are dropped.
+	void FireEventDeferred(std::string const& eventName);
+	void DispatchDeferredEvents();																					// Called by BeginFrame and EndFrame
 
 	std::vector<std::string> GetAllDevConsoleRegisteredCommands();
 
+protected:
+	struct EventEntry
+	{
+		HashedCaseInsensitiveString		m_eventName;
+		SubscriptionList				m_functionSubscribers;
+		std::vector<EventRecipient*>	m_recipients;
+	};
+
+	struct EventTableSlot
+	{
+		unsigned int					m_hash = 0;
+		int								m_eventIndex = -1;
+	};
+
+	int		FindEventIndex(unsigned int hash, char const* eventName) const;
+	int		FindOrCreateEventIndex(HashedCaseInsensitiveString const& eventName);
+	void	InsertIntoEventTable(unsigned int hash, int eventIndex);
+	void	GrowEventTable();
+	void	FireEventEntry(EventEntry& entry, EventArgs& args);
+	void	PushDeferredEvent(DeferredEvent* deferredEvent);
+
 protected:
 	EventSystemConfig									m_config;
 	std::recursive_mutex								m_subscriptionListMutex;
-	std::map<std::string, SubscriptionList>				m_subscriptionListByEventName;
-	std::map<HashedCaseInsensitiveString,std::vector<EventRecipient*>> m_memberFunctionSubscriptionList;
+
+	// Open addressing table (linear probing) from the case insensitive name hash to an index in m_events.
+	// Events are never removed so there are no tombstones, and entries live in a deque so references
+	// to them survive callbacks that subscribe to new events while an event is being fired.
+	std::vector<EventTableSlot>							m_eventTable;
+	std::deque<EventEntry>								m_events;
+
+	// Producers push onto this stack, the owning thread takes the whole stack at once and fires it in
+	// the order the events were pushed
+	std::atomic<DeferredEvent*>							m_deferredEventsHead = nullptr;
 private:
 };
 
 template<typename T>
 void EventSystem::SubscribeEventCallbackFunction(std::string const& eventName, T* object, bool (T::* callback)(const EventArgs&))
 {
-	HashedCaseInsensitiveString key(eventName);
-	EventRecipient* recipient = new EventReceiver<T>(object, callback);
-	m_memberFunctionSubscriptionList[key].push_back(recipient);
+	SubscribeEventCallbackFunction(HashedCaseInsensitiveString(eventName), object, callback);
 }
 
 template<typename T>
 void EventSystem::SubscribeEventCallbackFunction(HashedCaseInsensitiveString const& key, T* object, bool (T::* callback)(const EventArgs&))
 {
 	EventRecipient* recipient = new EventReceiver<T>(object, callback);
-	m_memberFunctionSubscriptionList[key].push_back(recipient);
+
+	m_subscriptionListMutex.lock();
+	int eventIndex = FindOrCreateEventIndex(key);
+	m_events[eventIndex].m_recipients.push_back(recipient);
+	m_subscriptionListMutex.unlock();
 }
 
 template<typename T>
 void EventSystem::UnsubscribeEventCallbackFunction(std::string const& eventName, T* object, bool (T::* callback)(const EventArgs&))
 {
-	HashedCaseInsensitiveString key(eventName);
-	auto it = m_memberFunctionSubscriptionList.find(key);
-	if (it != m_memberFunctionSubscriptionList.end())
+	std::vector<EventRecipient*> removedRecipients;
+
+	m_subscriptionListMutex.lock();
+	int eventIndex = FindEventIndex(HashedCaseInsensitiveString::GetHashCode(eventName), eventName.c_str());
+	if (eventIndex >= 0)
 	{
-		auto& vec = it->second;
-		for (auto iter = vec.begin(); iter != vec.end(); )
+		std::vector<EventRecipient*>& recipients = m_events[eventIndex].m_recipients;
+		for (auto iter = recipients.begin(); iter != recipients.end(); )
 		{
 			EventReceiver<T>* receiver = dynamic_cast<EventReceiver<T>*>(*iter);
 			if (receiver && receiver->Matches(object, callback))
 			{
-				iter = vec.erase(iter);
-				delete receiver;
+				iter = recipients.erase(iter);
+				removedRecipients.push_back(receiver);
 			}
 			else
 			{
 				++iter;
 			}
 		}
-		if (vec.empty())
-		{
-			m_memberFunctionSubscriptionList.erase(it);
-		}
+	}
+	m_subscriptionListMutex.unlock();
+
+	// Deleting a recipient unsubscribes it again, so only do it once it is out of the lists
+	for (int recipientIndex = 0; recipientIndex < (int)removedRecipients.size(); ++recipientIndex)
+	{
+		delete removedRecipients[recipientIndex];
 	}
 }
 
@@ -0,0 +1,97 @@
+#include "Engine/Core/EventSystemBenchmark.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EventSystem.hpp"
+#include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include <algorithm>
+#include <map>
+
+// Keeps the optimizer from dropping the callbacks being timed
+static volatile int s_numBenchmarkCallbacks = 0;
+
+static bool OnBenchmarkEvent(EventArgs const& args)
+{
+	UNUSED(args);
+	s_numBenchmarkCallbacks = s_numBenchmarkCallbacks + 1;
+	return false;
+}
+
+// What FireEvent did before the hash table: walk every event and lower case both names per entry
+static void FireEventByMapWalk(std::map<std::string, SubscriptionList> const& subscriptionListByEventName, std::string const& eventName, EventArgs& args)
+{
+	for (auto it = subscriptionListByEventName.begin(); it != subscriptionListByEventName.end(); ++it)
+	{
+		if (ToLower(it->first) == ToLower(eventName))
+		{
+			SubscriptionList const& subscription = it->second;
+			for (int i = 0; i < (int)subscription.size(); ++i)
+			{
+				if (subscription[i] != nullptr)
+				{
+					subscription[i](args);
+				}
+			}
+		}
+	}
+}
+
+template<typename Work>
+static EventBenchmarkResult TimeFires(char const* name, int numFires, Work const& work)
+{
+	EventBenchmarkResult result;
+	result.m_name = name;
+	result.m_numFires = numFires;
+
+	double startSeconds = GetCurrentTimeSeconds();
+	for (int fireIndex = 0; fireIndex < numFires; ++fireIndex)
+	{
+		work();
+	}
+	result.m_totalMs = (GetCurrentTimeSeconds() - startSeconds) * 1000.0;
+	result.m_nanosecondsPerFire = result.m_totalMs * 1000000.0 / (double)numFires;
+	return result;
+}
+
+std::vector<EventBenchmarkResult> RunEventSystemBenchmark(int numFires, int numEvents)
+{
+	std::vector<EventBenchmarkResult> results;
+	numFires = std::max(numFires, 100);
+	numEvents = std::max(numEvents, 0);
+
+	std::string const eventName = "BenchmarkEvent";
+	std::map<std::string, SubscriptionList> subscriptionListByEventName;
+	EventSystemConfig config;
+	EventSystem eventSystem(config);
+	for (int eventIndex = 0; eventIndex < numEvents; ++eventIndex)
+	{
+		std::string fillerName = Stringf("BenchmarkFillerEvent%i", eventIndex);
+		subscriptionListByEventName[fillerName].push_back(OnBenchmarkEvent);
+		eventSystem.SubscribeEventCallbackFunction(fillerName, OnBenchmarkEvent);
+	}
+	subscriptionListByEventName[eventName].push_back(OnBenchmarkEvent);
+	eventSystem.SubscribeEventCallbackFunction(eventName, OnBenchmarkEvent);
+	EventHandle eventHandle = eventSystem.GetEventHandle(eventName);
+
+	EventArgs args;
+	results.push_back(TimeFires("map walk", numFires / 100, [&]() { FireEventByMapWalk(subscriptionListByEventName, eventName, args); }));
+	results.push_back(TimeFires("by name", numFires, [&]() { eventSystem.FireEvent(eventName, args); }));
+	results.push_back(TimeFires("by handle", numFires, [&]() { eventSystem.FireEvent(eventHandle, args); }));
+	return results;
+}
+
+bool Command_EventBenchmark(EventArgs const& args)
+{
+	int numFires = args.GetValue(std::string("fires"), 1000000);
+	int numEvents = args.GetValue(std::string("events"), 64);
+	std::vector<EventBenchmarkResult> results = RunEventSystemBenchmark(numFires, numEvents);
+	if (g_theConsole)
+	{
+		g_theConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("EventBenchmark, %i other events registered", numEvents));
+		for (EventBenchmarkResult const& result : results)
+		{
+			g_theConsole->AddLine(DevConsole::INFO_MINOR, Stringf("%-10s %8i fires %9.2f ms  %9.1f ns per fire", result.m_name.c_str(), result.m_numFires, result.m_totalMs, result.m_nanosecondsPerFire));
+		}
+	}
+	return true;
+}
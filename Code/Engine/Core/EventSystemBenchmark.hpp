@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+#include <vector>
+
+class NamedProperties;
+typedef NamedProperties EventArgs;
+
+//-----------------------------------------------------------------------------------
+// Times firing one event by name and through a cached EventHandle against the map walk FireEvent
+// used to do. Runs on a private event system holding numEvents other events, so the console's
+// commands are untouched.
+//
+struct EventBenchmarkResult
+{
+	std::string		m_name;
+	int				m_numFires = 0;
+	double			m_totalMs = 0.0;
+	double			m_nanosecondsPerFire = 0.0;
+};
+
+// The map walk is too slow for a million fires, it only gets numFires / 100 of them
+std::vector<EventBenchmarkResult>	RunEventSystemBenchmark(int numFires, int numEvents);
+bool								Command_EventBenchmark(EventArgs const& args);
@@ -1,15 +1,40 @@
 #include "Engine/Core/FileUtils.hpp"
 #include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/LambdaJob.hpp"
 #include <stdio.h>
+#if defined(_WIN32)
 #include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
-int FileReadToBuffer(std::vector<uint8_t>& outBuffer, const std::string& fileName)
+// fopen_s only exists in the Microsoft CRT
+static FILE* OpenFileForReading(std::string const& fileName, char const* mode)
 {
-	FILE* fp;
- 	errno_t er = fopen_s(&fp, fileName.c_str(), "rt");
+#if defined(_WIN32)
+	FILE* fp = nullptr;
+	errno_t er = fopen_s(&fp, fileName.c_str(), mode);
 	UNUSED(er);
+	return fp;
+#else
+	return fopen(fileName.c_str(), mode);
+#endif
+}
+
+int FileReadToBuffer(std::vector<uint8_t>& outBuffer, const std::string& fileName)
+{
+	FILE* fp = OpenFileForReading(fileName, "rt");
 
 	if (fp != NULL)
 	{
@@ -48,9 +73,7 @@ int FileReadToString(std::string& outString, const std::string& fileName)
 
 int FileReadToBinary(std::vector<uint8_t>& outBuffer, const std::string& fileName)
 {
-	FILE* fp;
-	errno_t er = fopen_s(&fp, fileName.c_str(), "rb");
-	UNUSED(er);
+	FILE* fp = OpenFileForReading(fileName, "rb");
 
 	if (fp != NULL)
 	{
@@ -89,7 +112,295 @@ int FileWriteBinary(std::string const& fileName, std::vector<unsigned char>fileC
 
 bool CreateFolder(std::string filePath)
 {
+#if defined(_WIN32)
 	std::wstring wsr = std::wstring(filePath.begin(), filePath.end());
 
 	return CreateDirectory(wsr.c_str(), NULL);
+#else
+	return mkdir(filePath.c_str(), 0755) == 0;
+#endif
+}
+
+// -----------------------------MAPPED FILE----------------------------------
+MappedFile::MappedFile(std::string const& fileName)
+{
+	Open(fileName);
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#if defined(_WIN32)
+bool MappedFile::Open(std::string const& fileName)
+{
+	Close();
+
+	HANDLE fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize))
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	m_fileHandle = fileHandle;
+	m_size = (size_t)fileSize.QuadPart;
+	m_isOpen = true;
+
+	// Empty files can't be mapped, they are open with no data
+	if (m_size == 0)
+	{
+		return true;
+	}
+
+	m_mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mappingHandle != NULL)
+	{
+		m_data = (uint8_t const*)MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	}
+
+	if (m_data == nullptr)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mappingHandle)
+	{
+		CloseHandle(m_mappingHandle);
+	}
+	if (m_fileHandle)
+	{
+		CloseHandle(m_fileHandle);
+	}
+
+	m_data = nullptr;
+	m_size = 0;
+	m_isOpen = false;
+	m_mappingHandle = nullptr;
+	m_fileHandle = nullptr;
+}
+#else
+bool MappedFile::Open(std::string const& fileName)
+{
+	Close();
+
+	int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStatus;
+	if (fstat(fileDescriptor, &fileStatus) != 0)
+	{
+		close(fileDescriptor);
+		return false;
+	}
+
+	m_fileDescriptor = fileDescriptor;
+	m_size = (size_t)fileStatus.st_size;
+	m_isOpen = true;
+
+	// Empty files can't be mapped, they are open with no data
+	if (m_size == 0)
+	{
+		return true;
+	}
+
+	void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	madvise(data, m_size, MADV_SEQUENTIAL);
+	m_data = (uint8_t const*)data;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data)
+	{
+		munmap((void*)m_data, m_size);
+	}
+	if (m_fileDescriptor >= 0)
+	{
+		close(m_fileDescriptor);
+	}
+
+	m_data = nullptr;
+	m_size = 0;
+	m_isOpen = false;
+	m_fileDescriptor = -1;
+}
+#endif
+
+// -----------------------------ASYNC FILE READER----------------------------------
+struct AsyncFileReadRequest
+{
+	AsyncFileReadResult		m_result;
+	AsyncFileReadCallback	m_callback;
+	unsigned int			m_jobFlag = 0;
+};
+
+static JobSystem*							s_ioJobSystem = nullptr;
+static std::thread*							s_ioThread = nullptr;
+static std::mutex							s_ioRequestsMutex;
+static std::condition_variable				s_ioRequestsCondition;
+static std::deque<AsyncFileReadRequest*>	s_ioRequests;
+static bool									s_isIOQuitting = false;
+static std::atomic<int>						s_numPendingReads = 0;
+
+// Every non zero flag a callback was queued with, appended under s_ioRequestsMutex and read without it
+static unsigned int							s_ioJobFlags[MAX_JOB_FLAG_QUEUES] = {};
+static std::atomic<int>						s_numIOJobFlags = 0;
+
+static void CompleteAsyncFileRead(AsyncFileReadRequest* request)
+{
+	if (request->m_callback)
+	{
+		request->m_callback(request->m_result);
+	}
+	delete request;
+	s_numPendingReads.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+static void AsyncFileReaderThreadMain()
+{
+	for (;;)
+	{
+		AsyncFileReadRequest* request = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(s_ioRequestsMutex);
+			s_ioRequestsCondition.wait(lock, [] { return s_isIOQuitting || !s_ioRequests.empty(); });
+
+			// Quitting still drains the queue, nobody is left waiting on a callback that never comes
+			if (s_ioRequests.empty())
+			{
+				return;
+			}
+			request = s_ioRequests.front();
+			s_ioRequests.pop_front();
+		}
+
+		request->m_result.m_isSucceeded = FileReadToBinary(request->m_result.m_data, request->m_result.m_fileName) >= 0;
+
+		if (s_ioJobSystem)
+		{
+			AddFireAndForgetJob(s_ioJobSystem, [request]() { CompleteAsyncFileRead(request); }, request->m_jobFlag);
+		}
+		else
+		{
+			CompleteAsyncFileRead(request);
+		}
+	}
+}
+
+// Callbacks can sit in flag queues no worker serves, so a waiting thread runs those too
+static bool ExecuteOneAsyncFileReadJob()
+{
+	if (s_ioJobSystem->ExecuteOneJob())
+	{
+		return true;
+	}
+
+	int numIOJobFlags = s_numIOJobFlags.load(std::memory_order_acquire);
+	for (int flagIndex = 0; flagIndex < numIOJobFlags; ++flagIndex)
+	{
+		if (s_ioJobSystem->ExecuteOneJob(s_ioJobFlags[flagIndex]))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void AsyncFileReader::StartUp(JobSystem* jobSystem)
+{
+	GUARANTEE_OR_DIE(s_ioThread == nullptr, "AsyncFileReader is already started");
+
+	s_ioJobSystem = jobSystem;
+	s_isIOQuitting = false;
+	s_ioThread = new std::thread(AsyncFileReaderThreadMain);
+}
+
+void AsyncFileReader::ShutDown()
+{
+	if (s_ioThread == nullptr)
+	{
+		return;
+	}
+
+	s_ioRequestsMutex.lock();
+	s_isIOQuitting = true;
+	s_ioRequestsMutex.unlock();
+	s_ioRequestsCondition.notify_one();
+
+	s_ioThread->join();
+	delete s_ioThread;
+	s_ioThread = nullptr;
+
+	// The last callbacks may still be sitting in the job system
+	WaitForPendingReads();
+	s_ioJobSystem = nullptr;
+}
+
+void AsyncFileReader::ReadFileAsync(std::string const& fileName, AsyncFileReadCallback callback, unsigned int jobFlag)
+{
+	GUARANTEE_OR_DIE(s_ioThread != nullptr, "AsyncFileReader::ReadFileAsync called before StartUp");
+
+	AsyncFileReadRequest* request = new AsyncFileReadRequest();
+	request->m_result.m_fileName = fileName;
+	request->m_callback = std::move(callback);
+	request->m_jobFlag = jobFlag;
+
+	s_numPendingReads.fetch_add(1, std::memory_order_acq_rel);
+	s_ioRequestsMutex.lock();
+	if (jobFlag != 0)
+	{
+		int numIOJobFlags = s_numIOJobFlags.load(std::memory_order_relaxed);
+		if (std::find(s_ioJobFlags, s_ioJobFlags + numIOJobFlags, jobFlag) == s_ioJobFlags + numIOJobFlags)
+		{
+			GUARANTEE_OR_DIE(numIOJobFlags < MAX_JOB_FLAG_QUEUES, "Too many distinct job flags, raise MAX_JOB_FLAG_QUEUES");
+			s_ioJobFlags[numIOJobFlags] = jobFlag;
+			s_numIOJobFlags.store(numIOJobFlags + 1, std::memory_order_release);
+		}
+	}
+	s_ioRequests.push_back(request);
+	s_ioRequestsMutex.unlock();
+	s_ioRequestsCondition.notify_one();
+}
+
+int AsyncFileReader::GetNumPendingReads()
+{
+	return s_numPendingReads.load(std::memory_order_acquire);
+}
+
+void AsyncFileReader::WaitForPendingReads()
+{
+	while (s_numPendingReads.load(std::memory_order_acquire) > 0)
+	{
+		if (s_ioJobSystem == nullptr || !ExecuteOneAsyncFileReadJob())
+		{
+			std::this_thread::yield();
+		}
+	}
 }
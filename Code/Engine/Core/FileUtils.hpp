@@ -1,9 +1,97 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <functional>
+
+class JobSystem;
 
 int FileReadToBuffer(std::vector<uint8_t>& outBuffer, const std::string& fileName);
 int	FileReadToString(std::string& outString, const std::string& fileName);
 int	FileReadToBinary(std::vector<uint8_t>& outBuffer, const std::string& fileName);
 int	FileWriteBinary(std::string const& fileName, std::vector<unsigned char> fileContent);
-bool CreateFolder(std::string filePath);
\ No newline at end of file
+bool CreateFolder(std::string filePath);
+
+//-----------------------------------------------------------------------------------
+// Read only range of bytes owned by someone else, a stand in for std::span<uint8_t const> until the
+// engine moves to C++20
+//
+struct ByteSpan
+{
+	uint8_t const*	m_data = nullptr;
+	size_t			m_size = 0;
+
+	uint8_t const*	data() const							{ return m_data; }
+	size_t			size() const							{ return m_size; }
+	bool			empty() const							{ return m_size == 0; }
+	uint8_t const*	begin() const							{ return m_data; }
+	uint8_t const*	end() const								{ return m_data + m_size; }
+	uint8_t			operator[](size_t index) const			{ return m_data[index]; }
+	ByteSpan		SubSpan(size_t offset, size_t count) const { return ByteSpan{ m_data + offset, count }; }
+};
+
+//-----------------------------------------------------------------------------------
+// Read only view of a whole file mapped into memory. Nothing is copied, the OS pages the file in
+// as it is touched. The data stays valid until Close or destruction.
+//
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	explicit MappedFile(std::string const& fileName);
+	~MappedFile();
+
+	MappedFile(MappedFile const& copy) = delete;
+	MappedFile& operator=(MappedFile const& copy) = delete;
+
+	bool			Open(std::string const& fileName);
+	void			Close();
+
+	bool			IsOpen() const			{ return m_isOpen; }
+	uint8_t const*	GetData() const			{ return m_data; }		// nullptr for empty files
+	size_t			GetSize() const			{ return m_size; }
+	ByteSpan		GetSpan() const			{ return ByteSpan{ m_data, m_size }; }
+
+private:
+	uint8_t const*	m_data = nullptr;
+	size_t			m_size = 0;
+	bool			m_isOpen = false;
+#if defined(_WIN32)
+	void*			m_fileHandle = nullptr;
+	void*			m_mappingHandle = nullptr;
+#else
+	int				m_fileDescriptor = -1;
+#endif
+};
+
+//-----------------------------------------------------------------------------------
+// Reads whole files on a dedicated I/O thread so loads can overlap disk access with parsing.
+// Once a file is read its callback is queued as a job, so the parsing runs on the job workers
+// while the I/O thread is already reading the next file. Without a job system the callback runs
+// on the I/O thread. Shut it down before the job system, pending reads are finished first.
+//
+struct AsyncFileReadResult
+{
+	std::string				m_fileName;
+	std::vector<uint8_t>	m_data;
+	bool					m_isSucceeded = false;
+};
+
+typedef std::function<void(AsyncFileReadResult& result)> AsyncFileReadCallback;
+
+class AsyncFileReader
+{
+public:
+	static void		StartUp(JobSystem* jobSystem);
+	static void		ShutDown();
+
+	// Callbacks run with jobFlag, so a flagged worker can be dedicated to a kind of asset
+	static void		ReadFileAsync(std::string const& fileName, AsyncFileReadCallback callback, unsigned int jobFlag = 0);
+
+	// Reads queued or in flight, a read stops being pending once its callback returned
+	static int		GetNumPendingReads();
+
+	// Helps the job system while waiting, flagged callbacks included, so it can be called from the
+	// main thread during a load even when no worker carries a callback's flag
+	static void		WaitForPendingReads();
+};
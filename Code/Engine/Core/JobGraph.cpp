@@ -0,0 +1,148 @@
+#include "Engine/Core/JobGraph.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/LambdaJob.hpp"
+
+// -----------------------------JOBGRAPHNODE----------------------------------
+JobGraphNode::JobGraphNode(JobGraph* graph, Job* job)
+	:Job(job->m_jobFlag),
+	m_graph(graph),
+	m_job(job)
+{
+	m_needsRetrieval = false;
+}
+
+void JobGraphNode::Execute()
+{
+	m_job->m_status = JobStatus::EXECUTING;
+	m_job->Execute();
+	m_job->m_status = JobStatus::COMPLETED;
+}
+
+void JobGraphNode::OnCompleted()
+{
+	for (int successorIndex = 0; successorIndex < (int)m_successors.size(); ++successorIndex)
+	{
+		JobGraphNode* successor = m_successors[successorIndex];
+		if (successor->m_numPendingPredecessors.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			m_graph->m_system->AddJobIntoDeque(successor);
+		}
+	}
+
+	// Must be the last access to this node, a waiting thread may clear the graph right after
+	m_graph->m_numPendingNodes.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+// -----------------------------JOBGRAPH----------------------------------
+JobGraph::JobGraph(JobSystem* system)
+	:m_system(system)
+{
+}
+
+JobGraph::~JobGraph()
+{
+	Clear();
+}
+
+JobGraphNodeID JobGraph::AddJob(Job* job)
+{
+	GUARANTEE_OR_DIE(!m_isSubmitted || IsComplete(), "Can't add jobs to a JobGraph while it is running");
+	// Pooled jobs only go back to their pool when retrieved, which never happens to graph jobs
+	GUARANTEE_OR_DIE(dynamic_cast<LambdaJob*>(job) == nullptr, "LambdaJobs can't be added to a JobGraph, they would never be recycled");
+
+	m_nodes.push_back(new JobGraphNode(this, job));
+	job->m_status = JobStatus::NEW;
+	job->m_needsRetrieval = false;
+	return (JobGraphNodeID)m_nodes.size() - 1;
+}
+
+JobGraphNodeID JobGraph::AddJob(Job* job, std::vector<JobGraphNodeID> const& predecessors)
+{
+	JobGraphNodeID nodeID = AddJob(job);
+
+	for (int predecessorIndex = 0; predecessorIndex < (int)predecessors.size(); ++predecessorIndex)
+	{
+		AddDependency(predecessors[predecessorIndex], nodeID);
+	}
+
+	return nodeID;
+}
+
+void JobGraph::AddDependency(JobGraphNodeID predecessor, JobGraphNodeID successor)
+{
+	GUARANTEE_OR_DIE(!m_isSubmitted || IsComplete(), "Can't add dependencies to a JobGraph while it is running");
+	GUARANTEE_OR_DIE(predecessor >= 0 && predecessor < (int)m_nodes.size(), "Invalid JobGraph predecessor");
+	GUARANTEE_OR_DIE(successor >= 0 && successor < (int)m_nodes.size(), "Invalid JobGraph successor");
+	GUARANTEE_OR_DIE(predecessor != successor, "A job can't depend on itself");
+
+	m_nodes[predecessor]->m_successors.push_back(m_nodes[successor]);
+	m_nodes[successor]->m_numPredecessors += 1;
+}
+
+JobGraphNodeID JobGraph::AddContinuation(JobGraphNodeID predecessor, Job* continuation)
+{
+	JobGraphNodeID nodeID = AddJob(continuation);
+	AddDependency(predecessor, nodeID);
+	return nodeID;
+}
+
+void JobGraph::Submit()
+{
+	GUARANTEE_OR_DIE(!m_isSubmitted || IsComplete(), "JobGraph submitted again before it completed");
+
+	// Every counter has to be armed before the first root can finish and start decrementing them
+	std::vector<Job*> rootNodes;
+	for (int nodeIndex = 0; nodeIndex < (int)m_nodes.size(); ++nodeIndex)
+	{
+		JobGraphNode* node = m_nodes[nodeIndex];
+		node->m_numPendingPredecessors.store(node->m_numPredecessors, std::memory_order_relaxed);
+		node->m_job->m_status = JobStatus::QUEUED;
+
+		if (node->m_numPredecessors == 0)
+		{
+			rootNodes.push_back(node);
+		}
+	}
+
+	GUARANTEE_OR_DIE(m_nodes.empty() || !rootNodes.empty(), "JobGraph has no job without predecessors");
+
+	m_numPendingNodes.store((int)m_nodes.size(), std::memory_order_release);
+	m_isSubmitted = true;
+
+	m_system->AddJobsIntoDeque(rootNodes);
+}
+
+bool JobGraph::IsComplete() const
+{
+	return m_numPendingNodes.load(std::memory_order_acquire) == 0;
+}
+
+void JobGraph::WaitForCompletion()
+{
+	if (!m_isSubmitted)
+	{
+		return;
+	}
+
+	while (!IsComplete())
+	{
+		if (!m_system->ExecuteOneJob())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobGraph::Clear()
+{
+	WaitForCompletion();
+
+	for (int nodeIndex = 0; nodeIndex < (int)m_nodes.size(); ++nodeIndex)
+	{
+		delete m_nodes[nodeIndex];
+		m_nodes[nodeIndex] = nullptr;
+	}
+
+	m_nodes.clear();
+	m_isSubmitted = false;
+}
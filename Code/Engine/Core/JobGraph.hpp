@@ -0,0 +1,70 @@
+#pragma once
+#include "Engine/Core/JobSystem.hpp"
+#include <atomic>
+#include <vector>
+
+typedef int JobGraphNodeID;
+constexpr JobGraphNodeID INVALID_JOB_GRAPH_NODE = -1;
+
+class JobGraph;
+
+//-----------------------------------------------------------------------------------
+// Internal wrapper that the job system actually runs for every job added to a graph
+//
+class JobGraphNode : public Job
+{
+	friend class JobGraph;
+public:
+	JobGraphNode(JobGraph* graph, Job* job);
+
+	virtual void Execute() override;
+	virtual void OnCompleted() override;
+
+private:
+	JobGraph*						m_graph = nullptr;
+	Job*							m_job = nullptr;
+	int								m_numPredecessors = 0;
+	std::atomic<int>				m_numPendingPredecessors = 0;
+	std::vector<JobGraphNode*>		m_successors;
+};
+
+//-----------------------------------------------------------------------------------
+// A group of jobs with dependencies between them. Once submitted, jobs without predecessors are
+// queued right away and every other job is queued by the worker that finishes its last
+// predecessor, so a chain of stages never waits on the main thread. The graph does not own the
+// jobs added to it, and they never show up in RetrieveCompletedJob: AddJob clears their
+// m_needsRetrieval, so retrieving one returns right away. LambdaJobs are rejected for the same
+// reason, they would never go back to their pool.
+// The graph can be submitted again once it is complete. Cycles are not detected.
+//
+class JobGraph
+{
+	friend class JobGraphNode;
+public:
+	JobGraph() = delete;
+	explicit JobGraph(JobSystem* system);
+	~JobGraph();
+	JobGraph(const JobGraph& copy) = delete;
+
+	JobGraphNodeID					AddJob(Job* job);
+	JobGraphNodeID					AddJob(Job* job, std::vector<JobGraphNodeID> const& predecessors);
+	void							AddDependency(JobGraphNodeID predecessor, JobGraphNodeID successor);
+
+	// Run the job after the given node finished, shorthand for AddJob with a single predecessor
+	JobGraphNodeID					AddContinuation(JobGraphNodeID predecessor, Job* continuation);
+
+	void							Submit();
+	bool							IsComplete() const;
+
+	// Block until every job of the graph is done, running queued jobs on the calling thread meanwhile
+	void							WaitForCompletion();
+	void							Clear();
+
+	int								GetNumJobs() const { return (int)m_nodes.size(); }
+
+private:
+	JobSystem*						m_system = nullptr;
+	std::vector<JobGraphNode*>		m_nodes;
+	std::atomic<int>				m_numPendingNodes = 0;
+	bool							m_isSubmitted = false;
+};
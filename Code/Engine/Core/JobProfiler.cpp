@@ -0,0 +1,256 @@
+#include "Engine/Core/JobProfiler.hpp"
+
+#if defined(ENGINE_JOB_PROFILING)
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EventSystem.hpp"
+#include "Engine/Core/FileUtils.hpp"
+#include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include <typeinfo>
+
+//-----------------------------------------------------------------------------------
+// Buffers are never freed while the program runs, a thread that exits leaves its history behind
+// so it still shows up in the trace.
+//
+static std::mutex							s_threadBuffersMutex;
+static std::vector<JobProfileThreadBuffer*>	s_threadBuffers;
+static std::atomic<double>					s_windowStartSeconds = -1.0;
+static thread_local JobProfileThreadBuffer*	t_threadBuffer = nullptr;
+
+static JobProfileThreadBuffer* GetOrCreateThreadBuffer(int workerID)
+{
+	if (t_threadBuffer == nullptr)
+	{
+		t_threadBuffer = new JobProfileThreadBuffer();
+		t_threadBuffer->m_workerID = workerID;
+
+		s_threadBuffersMutex.lock();
+		s_threadBuffers.push_back(t_threadBuffer);
+		s_threadBuffersMutex.unlock();
+	}
+	return t_threadBuffer;
+}
+
+static int GetQueueDepthBucket(int queueDepth)
+{
+	int bucket = 0;
+	while (queueDepth > 0 && bucket < JOB_QUEUE_DEPTH_HISTOGRAM_BUCKETS - 1)
+	{
+		queueDepth >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+static std::string GetQueueDepthBucketLabel(int bucket)
+{
+	if (bucket == 0)
+	{
+		return "0";
+	}
+	if (bucket == JOB_QUEUE_DEPTH_HISTOGRAM_BUCKETS - 1)
+	{
+		return Stringf("%i+", 1 << (bucket - 1));
+	}
+	if (bucket == 1)
+	{
+		return "1";
+	}
+	return Stringf("%i-%i", 1 << (bucket - 1), (1 << bucket) - 1);
+}
+
+// Copy out whatever events of a buffer are still intact, oldest first
+static void CopyThreadBufferEvents(JobProfileThreadBuffer const& buffer, std::vector<JobProfileEvent>& outEvents)
+{
+	int64_t numWritten = buffer.m_numEventsWritten.load(std::memory_order_acquire);
+	int64_t firstEvent = numWritten > JOB_PROFILE_EVENTS_PER_THREAD ? numWritten - JOB_PROFILE_EVENTS_PER_THREAD : 0;
+
+	for (int64_t eventIndex = firstEvent; eventIndex < numWritten; ++eventIndex)
+	{
+		int slot = (int)(eventIndex % JOB_PROFILE_EVENTS_PER_THREAD);
+		if (buffer.m_eventSequences[slot].load(std::memory_order_acquire) != eventIndex)
+		{
+			continue;
+		}
+
+		JobProfileEvent profileEvent = buffer.m_events[slot];
+
+		// The owner lapped us and started rewriting the slot while we copied it
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (buffer.m_eventSequences[slot].load(std::memory_order_relaxed) == eventIndex)
+		{
+			outEvents.push_back(profileEvent);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------
+void JobProfiler::RecordJob(int workerID, Job const& job, double startSeconds, double finishSeconds, int queueDepth)
+{
+	JobProfileThreadBuffer* buffer = GetOrCreateThreadBuffer(workerID);
+
+	double expected = -1.0;
+	s_windowStartSeconds.compare_exchange_strong(expected, startSeconds, std::memory_order_relaxed);
+
+	int64_t eventIndex = buffer->m_numEventsWritten.load(std::memory_order_relaxed);
+	int slot = (int)(eventIndex % JOB_PROFILE_EVENTS_PER_THREAD);
+	buffer->m_eventSequences[slot].store(-1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	JobProfileEvent& profileEvent = buffer->m_events[slot];
+	profileEvent.m_jobName = typeid(job).name();
+	profileEvent.m_queuedSeconds = job.m_queuedSeconds;
+	profileEvent.m_startSeconds = startSeconds;
+	profileEvent.m_finishSeconds = finishSeconds;
+
+	buffer->m_eventSequences[slot].store(eventIndex, std::memory_order_release);
+	buffer->m_numEventsWritten.store(eventIndex + 1, std::memory_order_release);
+
+	double busySeconds = buffer->m_busySeconds.load(std::memory_order_relaxed);
+	buffer->m_busySeconds.store(busySeconds + (finishSeconds - startSeconds), std::memory_order_relaxed);
+	buffer->m_queueDepthHistogram[GetQueueDepthBucket(queueDepth)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void JobProfiler::Reset()
+{
+	s_threadBuffersMutex.lock();
+	for (int bufferIndex = 0; bufferIndex < (int)s_threadBuffers.size(); ++bufferIndex)
+	{
+		JobProfileThreadBuffer* buffer = s_threadBuffers[bufferIndex];
+		buffer->m_busySeconds.store(0.0, std::memory_order_relaxed);
+		for (int bucket = 0; bucket < JOB_QUEUE_DEPTH_HISTOGRAM_BUCKETS; ++bucket)
+		{
+			buffer->m_queueDepthHistogram[bucket].store(0, std::memory_order_relaxed);
+		}
+	}
+	s_windowStartSeconds.store(GetCurrentTimeSeconds(), std::memory_order_relaxed);
+	s_threadBuffersMutex.unlock();
+}
+
+std::string JobProfiler::GetChromeTraceJson()
+{
+	std::string json = "{\"traceEvents\":[\n";
+	bool isFirstEvent = true;
+
+	s_threadBuffersMutex.lock();
+	std::vector<JobProfileEvent> events;
+	for (int bufferIndex = 0; bufferIndex < (int)s_threadBuffers.size(); ++bufferIndex)
+	{
+		JobProfileThreadBuffer const& buffer = *s_threadBuffers[bufferIndex];
+		int threadID = buffer.m_workerID >= 0 ? buffer.m_workerID : 1000 + bufferIndex;
+
+		json += Stringf("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%i,\"args\":{\"name\":\"%s\"}}",
+			isFirstEvent ? "" : ",\n", threadID, buffer.m_workerID >= 0 ? Stringf("Job Worker %i", buffer.m_workerID).c_str() : "Helping Thread");
+		isFirstEvent = false;
+
+		events.clear();
+		CopyThreadBufferEvents(buffer, events);
+		for (int eventIndex = 0; eventIndex < (int)events.size(); ++eventIndex)
+		{
+			JobProfileEvent const& profileEvent = events[eventIndex];
+			double startMicroseconds = profileEvent.m_startSeconds * 1000000.0;
+			double durationMicroseconds = (profileEvent.m_finishSeconds - profileEvent.m_startSeconds) * 1000000.0;
+			double queueWaitMicroseconds = (profileEvent.m_startSeconds - profileEvent.m_queuedSeconds) * 1000000.0;
+
+			json += Stringf(",\n{\"name\":\"%s\",\"cat\":\"job\",\"ph\":\"X\",\"pid\":0,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"queueWaitUs\":%.3f}}",
+				profileEvent.m_jobName, threadID, startMicroseconds, durationMicroseconds, queueWaitMicroseconds);
+		}
+	}
+	s_threadBuffersMutex.unlock();
+
+	json += "\n]}\n";
+	return json;
+}
+
+bool JobProfiler::WriteChromeTrace(std::string const& fileName)
+{
+	std::string json = GetChromeTraceJson();
+	return FileWriteBinary(fileName, std::vector<unsigned char>(json.begin(), json.end())) >= 0;
+}
+
+void JobProfiler::PrintStatsToConsole()
+{
+	if (g_theConsole == nullptr)
+	{
+		return;
+	}
+
+	double windowStartSeconds = s_windowStartSeconds.load(std::memory_order_relaxed);
+	double windowSeconds = windowStartSeconds < 0.0 ? 0.0 : GetCurrentTimeSeconds() - windowStartSeconds;
+	g_theConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Job stats over the last %.2f seconds", windowSeconds));
+
+	s_threadBuffersMutex.lock();
+	std::vector<JobProfileEvent> events;
+	for (int bufferIndex = 0; bufferIndex < (int)s_threadBuffers.size(); ++bufferIndex)
+	{
+		JobProfileThreadBuffer const& buffer = *s_threadBuffers[bufferIndex];
+		double busySeconds = buffer.m_busySeconds.load(std::memory_order_relaxed);
+		double utilization = windowSeconds > 0.0 ? busySeconds / windowSeconds : 0.0;
+
+		events.clear();
+		CopyThreadBufferEvents(buffer, events);
+		double totalQueueWaitSeconds = 0.0;
+		for (int eventIndex = 0; eventIndex < (int)events.size(); ++eventIndex)
+		{
+			totalQueueWaitSeconds += events[eventIndex].m_startSeconds - events[eventIndex].m_queuedSeconds;
+		}
+		double averageQueueWaitMs = events.empty() ? 0.0 : 1000.0 * totalQueueWaitSeconds / (double)events.size();
+
+		std::string threadName = buffer.m_workerID >= 0 ? Stringf("Worker %i", buffer.m_workerID) : std::string("Helper");
+		g_theConsole->AddLine(DevConsole::INFO_MINOR, Stringf("%-10s busy %6.1f%%  idle %8.3fs  avg queue wait %.3fms",
+			threadName.c_str(), 100.0 * utilization, windowSeconds - busySeconds, averageQueueWaitMs));
+
+		std::string histogram = "    queue depth:";
+		for (int bucket = 0; bucket < JOB_QUEUE_DEPTH_HISTOGRAM_BUCKETS; ++bucket)
+		{
+			int count = buffer.m_queueDepthHistogram[bucket].load(std::memory_order_relaxed);
+			if (count > 0)
+			{
+				histogram += Stringf(" [%s]=%i", GetQueueDepthBucketLabel(bucket).c_str(), count);
+			}
+		}
+		g_theConsole->AddLine(DevConsole::INFO_MINOR, histogram);
+	}
+	s_threadBuffersMutex.unlock();
+}
+
+void JobProfiler::RegisterConsoleCommands()
+{
+	if (g_theEventSystem)
+	{
+		g_theEventSystem->SubscribeEventCallbackFunction("JobStats", JobProfiler::Command_JobStats);
+		g_theEventSystem->SubscribeEventCallbackFunction("JobTrace", JobProfiler::Command_JobTrace);
+	}
+}
+
+void JobProfiler::UnregisterConsoleCommands()
+{
+	if (g_theEventSystem)
+	{
+		g_theEventSystem->UnsubscribeEventCallbackFunction("JobStats", JobProfiler::Command_JobStats);
+		g_theEventSystem->UnsubscribeEventCallbackFunction("JobTrace", JobProfiler::Command_JobTrace);
+	}
+}
+
+bool JobProfiler::Command_JobStats(EventArgs const& args)
+{
+	UNUSED(args);
+	PrintStatsToConsole();
+	return true;
+}
+
+bool JobProfiler::Command_JobTrace(EventArgs const& args)
+{
+	std::string fileName = args.GetValue(std::string("file"), std::string("JobTrace.json"));
+	bool isWritten = WriteChromeTrace(fileName);
+
+	if (g_theConsole)
+	{
+		g_theConsole->AddLine(isWritten ? DevConsole::INFO_MAJOR : DevConsole::ERROR, Stringf("%s job trace %s", isWritten ? "Wrote" : "Failed to write", fileName.c_str()));
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+//-----------------------------------------------------------------------------------
+// Job profiling is off unless the project defines ENGINE_JOB_PROFILING, in any configuration.
+// When it is not defined none of this exists and the job system does no timing at all.
+//
+#if defined(ENGINE_JOB_PROFILING)
+
+class Job;
+class NamedProperties;
+typedef NamedProperties EventArgs;
+
+constexpr int JOB_PROFILE_EVENTS_PER_THREAD = 8192;
+constexpr int JOB_QUEUE_DEPTH_HISTOGRAM_BUCKETS = 12; // 0, 1, 2-3, 4-7, ... 512-1023, 1024+
+
+struct JobProfileEvent
+{
+	char const*			m_jobName = nullptr;
+	double				m_queuedSeconds = 0.0;
+	double				m_startSeconds = 0.0;
+	double				m_finishSeconds = 0.0;
+};
+
+//-----------------------------------------------------------------------------------
+// One per thread that executes jobs. Only the owning thread writes. Each slot has a sequence
+// number, the index of the event in it or -1 while it is being rewritten, and readers drop any
+// event whose sequence changed while they were copying it.
+//
+struct JobProfileThreadBuffer
+{
+	int					m_workerID = -1; // -1 for threads that are not job workers, like the main thread helping out
+	JobProfileEvent		m_events[JOB_PROFILE_EVENTS_PER_THREAD];
+	std::atomic<int64_t> m_eventSequences[JOB_PROFILE_EVENTS_PER_THREAD] = {};
+	std::atomic<int64_t> m_numEventsWritten = 0;
+	std::atomic<double>	m_busySeconds = 0.0;
+	std::atomic<int>	m_queueDepthHistogram[JOB_QUEUE_DEPTH_HISTOGRAM_BUCKETS] = {};
+};
+
+class JobProfiler
+{
+public:
+	static void			RecordJob(int workerID, Job const& job, double startSeconds, double finishSeconds, int queueDepth);
+	static void			Reset();
+
+	static std::string	GetChromeTraceJson();
+	static bool			WriteChromeTrace(std::string const& fileName);
+	static void			PrintStatsToConsole();
+
+	static void			RegisterConsoleCommands();
+	static void			UnregisterConsoleCommands();
+
+	// Print per worker utilization and queue depth histograms
+	static bool			Command_JobStats(EventArgs const& args);
+
+	// Write the recorded jobs as a chrome://tracing file, file=<path> (default JobTrace.json)
+	static bool			Command_JobTrace(EventArgs const& args);
+};
+
+#endif
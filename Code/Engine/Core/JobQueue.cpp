@@ -0,0 +1,274 @@
+#include "Engine/Core/JobQueue.hpp"
+
+static size_t RoundUpToPowerOfTwo(size_t value)
+{
+	size_t result = 1;
+	while (result < value)
+	{
+		result <<= 1;
+	}
+	return result;
+}
+
+// -----------------------------WORK STEALING DEQUE----------------------------------
+JobWorkStealingDeque::RingArray::RingArray(int64_t capacity)
+	:m_capacity(capacity),
+	m_mask(capacity - 1)
+{
+	m_jobs = new std::atomic<Job*>[(size_t)capacity];
+	for (int64_t index = 0; index < capacity; ++index)
+	{
+		m_jobs[index].store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+JobWorkStealingDeque::RingArray::~RingArray()
+{
+	delete[] m_jobs;
+	m_jobs = nullptr;
+}
+
+JobWorkStealingDeque::JobWorkStealingDeque(int64_t initialCapacity)
+{
+	m_top.store(0, std::memory_order_relaxed);
+	m_bottom.store(0, std::memory_order_relaxed);
+	m_array.store(new RingArray((int64_t)RoundUpToPowerOfTwo((size_t)initialCapacity)), std::memory_order_relaxed);
+}
+
+JobWorkStealingDeque::~JobWorkStealingDeque()
+{
+	delete m_array.load(std::memory_order_relaxed);
+
+	for (int arrayIndex = 0; arrayIndex < (int)m_retiredArrays.size(); ++arrayIndex)
+	{
+		delete m_retiredArrays[arrayIndex];
+	}
+	m_retiredArrays.clear();
+}
+
+void JobWorkStealingDeque::PushBottom(Job* job)
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	int64_t top = m_top.load(std::memory_order_acquire);
+	RingArray* array = m_array.load(std::memory_order_relaxed);
+
+	if (bottom - top > array->m_capacity - 1)
+	{
+		array = Grow(array, bottom, top);
+	}
+
+	array->Put(bottom, job);
+	m_bottom.store(bottom + 1, std::memory_order_release);
+}
+
+Job* JobWorkStealingDeque::PopBottom()
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	RingArray* array = m_array.load(std::memory_order_relaxed);
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = m_top.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		// Deque was already empty, restore bottom
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = array->Get(bottom);
+	if (top == bottom)
+	{
+		// Last job left, race against the thieves for it
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			job = nullptr;
+		}
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* JobWorkStealingDeque::Steal()
+{
+	int64_t top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+	if (top >= bottom)
+	{
+		return nullptr;
+	}
+
+	RingArray* array = m_array.load(std::memory_order_acquire);
+	Job* job = array->Get(top);
+	if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		// Lost the race to the owner or another thief
+		return nullptr;
+	}
+	return job;
+}
+
+bool JobWorkStealingDeque::IsEmpty() const
+{
+	return GetApproximateCount() <= 0;
+}
+
+int JobWorkStealingDeque::GetApproximateCount() const
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	int64_t top = m_top.load(std::memory_order_relaxed);
+	return bottom > top ? (int)(bottom - top) : 0;
+}
+
+JobWorkStealingDeque::RingArray* JobWorkStealingDeque::Grow(RingArray* oldArray, int64_t bottom, int64_t top)
+{
+	RingArray* newArray = new RingArray(oldArray->m_capacity * 2);
+	for (int64_t index = top; index < bottom; ++index)
+	{
+		newArray->Put(index, oldArray->Get(index));
+	}
+
+	m_retiredArrays.push_back(oldArray);
+	m_array.store(newArray, std::memory_order_release);
+	return newArray;
+}
+
+// -----------------------------SHARED QUEUE----------------------------------
+JobSharedQueue::JobSharedQueue(size_t capacity)
+{
+	size_t ringSize = RoundUpToPowerOfTwo(capacity < 2 ? 2 : capacity);
+	m_cells = new Cell[ringSize];
+	m_mask = ringSize - 1;
+
+	for (size_t cellIndex = 0; cellIndex < ringSize; ++cellIndex)
+	{
+		m_cells[cellIndex].m_sequence.store(cellIndex, std::memory_order_relaxed);
+		m_cells[cellIndex].m_job = nullptr;
+	}
+
+	m_enqueuePos.store(0, std::memory_order_relaxed);
+	m_dequeuePos.store(0, std::memory_order_relaxed);
+	m_overflowCount.store(0, std::memory_order_relaxed);
+}
+
+JobSharedQueue::~JobSharedQueue()
+{
+	delete[] m_cells;
+	m_cells = nullptr;
+}
+
+void JobSharedQueue::Push(Job* job)
+{
+	if (TryPushRing(job))
+	{
+		return;
+	}
+
+	m_overflowMutex.lock();
+	m_overflowJobs.push_back(job);
+	m_overflowCount.fetch_add(1, std::memory_order_release);
+	m_overflowMutex.unlock();
+}
+
+Job* JobSharedQueue::Pop()
+{
+	Job* job = TryPopRing();
+	if (job || m_overflowCount.load(std::memory_order_acquire) == 0)
+	{
+		return job;
+	}
+
+	m_overflowMutex.lock();
+	if (!m_overflowJobs.empty())
+	{
+		job = m_overflowJobs.front();
+		m_overflowJobs.pop_front();
+		m_overflowCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+	m_overflowMutex.unlock();
+
+	return job;
+}
+
+bool JobSharedQueue::IsEmpty() const
+{
+	return GetApproximateCount() <= 0;
+}
+
+int JobSharedQueue::GetApproximateCount() const
+{
+	size_t enqueuePos = m_enqueuePos.load(std::memory_order_relaxed);
+	size_t dequeuePos = m_dequeuePos.load(std::memory_order_relaxed);
+	int ringCount = enqueuePos > dequeuePos ? (int)(enqueuePos - dequeuePos) : 0;
+	return ringCount + m_overflowCount.load(std::memory_order_relaxed);
+}
+
+bool JobSharedQueue::TryPushRing(Job* job)
+{
+	size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+	Cell* cell = nullptr;
+
+	for (;;)
+	{
+		cell = &m_cells[pos & m_mask];
+		size_t sequence = cell->m_sequence.load(std::memory_order_acquire);
+		intptr_t difference = (intptr_t)sequence - (intptr_t)pos;
+
+		if (difference == 0)
+		{
+			if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			// Ring is full
+			return false;
+		}
+		else
+		{
+			pos = m_enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	cell->m_job = job;
+	cell->m_sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+Job* JobSharedQueue::TryPopRing()
+{
+	size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+	Cell* cell = nullptr;
+
+	for (;;)
+	{
+		cell = &m_cells[pos & m_mask];
+		size_t sequence = cell->m_sequence.load(std::memory_order_acquire);
+		intptr_t difference = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+		if (difference == 0)
+		{
+			if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			// Ring is empty
+			return nullptr;
+		}
+		else
+		{
+			pos = m_dequeuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	Job* job = cell->m_job;
+	cell->m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+	return job;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+class Job;
+
+//-----------------------------------------------------------------------------------
+// Chase-Lev work stealing deque. Only the owning worker may call PushBottom / PopBottom,
+// any other thread may call Steal. The owner works LIFO (cache friendly), thieves take the
+// oldest job from the top. The ring grows when full; retired rings are kept alive until the
+// deque is destroyed because a thief may still be reading from them.
+//
+class JobWorkStealingDeque
+{
+public:
+	explicit JobWorkStealingDeque(int64_t initialCapacity = 1024);
+	~JobWorkStealingDeque();
+	JobWorkStealingDeque(const JobWorkStealingDeque& copy) = delete;
+
+	void							PushBottom(Job* job);
+	Job*							PopBottom();
+	Job*							Steal();
+
+	bool							IsEmpty() const;
+	int								GetApproximateCount() const;
+
+private:
+	struct RingArray
+	{
+		explicit RingArray(int64_t capacity);
+		~RingArray();
+
+		Job*						Get(int64_t index) const { return m_jobs[index & m_mask].load(std::memory_order_relaxed); }
+		void						Put(int64_t index, Job* job) { m_jobs[index & m_mask].store(job, std::memory_order_relaxed); }
+
+		int64_t						m_capacity = 0;
+		int64_t						m_mask = 0;
+		std::atomic<Job*>*			m_jobs = nullptr;
+	};
+
+	RingArray*						Grow(RingArray* oldArray, int64_t bottom, int64_t top);
+
+private:
+	alignas(64) std::atomic<int64_t>	m_top;
+	alignas(64) std::atomic<int64_t>	m_bottom;
+	std::atomic<RingArray*>				m_array;
+	std::vector<RingArray*>				m_retiredArrays; // Only touched by the owner
+};
+
+//-----------------------------------------------------------------------------------
+// Multi producer / multi consumer queue used for jobs that do not come from a worker
+// (main thread submissions) and for flag affinity jobs. Bounded lock free ring, with a mutex
+// guarded overflow list that is only touched once the ring is full.
+//
+class JobSharedQueue
+{
+public:
+	explicit JobSharedQueue(size_t capacity = 4096);
+	~JobSharedQueue();
+	JobSharedQueue(const JobSharedQueue& copy) = delete;
+
+	void							Push(Job* job);
+	Job*							Pop();
+
+	bool							IsEmpty() const;
+	int								GetApproximateCount() const;
+
+private:
+	bool							TryPushRing(Job* job);
+	Job*							TryPopRing();
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t>			m_sequence;
+		Job*						m_job;
+	};
+
+	Cell*							m_cells = nullptr;
+	size_t							m_mask = 0;
+	alignas(64) std::atomic<size_t>	m_enqueuePos;
+	alignas(64) std::atomic<size_t>	m_dequeuePos;
+
+	alignas(64) std::atomic<int>	m_overflowCount;
+	std::mutex						m_overflowMutex;
+	std::deque<Job*>				m_overflowJobs;
+};
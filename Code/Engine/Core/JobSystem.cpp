@@ -1,8 +1,24 @@
 #include "Engine/Core/JobSystem.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/Time.hpp"
+#include <algorithm>
+
+JobSystem* g_theJobSystem = nullptr;
+
+static thread_local JobWorkerThread* t_currentWorker = nullptr;
 
 // -----------------------------JOBSYSTEM----------------------------------
 void JobSystem::StartUp()
 {	
+	m_submissionQueue = new JobSharedQueue((size_t)m_config.m_sharedQueueCapacity);
+
+	// Every deque has to exist before the first worker starts looking for victims
+	m_workerDeques.reserve(m_config.m_workerNumber);
+	for (unsigned int workerID = 0; workerID < (unsigned int)m_config.m_workerNumber; workerID++)
+	{
+		m_workerDeques.push_back(new JobWorkStealingDeque((int64_t)m_config.m_workerDequeCapacity));
+	}
+
 	m_workers.reserve(m_config.m_workerNumber);
 
 	for (unsigned int workerID = 0; workerID < (unsigned int)m_config.m_workerNumber; workerID++)
@@ -10,19 +26,33 @@ void JobSystem::StartUp()
 		JobWorkerThread* worker = new JobWorkerThread(this, workerID);
 		m_workers.push_back(worker);
 	}
+
+#if defined(ENGINE_JOB_PROFILING)
+	JobProfiler::Reset();
+	JobProfiler::RegisterConsoleCommands();
+#endif
 }
 
 void JobSystem::SetWorkerFlag(unsigned int workerID, unsigned int workerFlag)
 {
 	if (workerID >= 0 && workerID < (unsigned int)m_workers.size())
 	{
+		if (workerFlag != 0)
+		{
+			CreateOrGetFlagQueue(workerFlag);
+		}
 		m_workers[workerID]->SetWorkerFlag(workerFlag);
 	}
 }
 
 void JobSystem::ShutDown()
 {
-	m_isQuitting = true;
+#if defined(ENGINE_JOB_PROFILING)
+	JobProfiler::UnregisterConsoleCommands();
+#endif
+
+	m_isQuitting.store(true, std::memory_order_release);
+	WakeAllParkedWorkers();
 
 	for (int workerIndex = 0; workerIndex < (int)m_workers.size(); workerIndex++)
 	{
@@ -34,93 +64,477 @@ void JobSystem::ShutDown()
 	}
 
 	m_workers.clear();
+
+	for (int dequeIndex = 0; dequeIndex < (int)m_workerDeques.size(); dequeIndex++)
+	{
+		delete m_workerDeques[dequeIndex];
+		m_workerDeques[dequeIndex] = nullptr;
+	}
+
+	m_workerDeques.clear();
+
+	delete m_submissionQueue;
+	m_submissionQueue = nullptr;
+
+	int numFlagQueues = m_numFlagQueues.load(std::memory_order_acquire);
+	for (int queueIndex = 0; queueIndex < numFlagQueues; queueIndex++)
+	{
+		delete m_flagQueues[queueIndex];
+		m_flagQueues[queueIndex] = nullptr;
+	}
+	m_numFlagQueues.store(0, std::memory_order_release);
 }
 
 void JobSystem::AddJobIntoDeque(Job* job)
 {
-	m_queuedJobsMutex.lock();
-	m_queuedJobs.push_back(job);
-	job->m_status = JobStatus::QUEUED;
-	m_queuedJobsMutex.unlock();
+	PushJob(job);
+
+	// Pairs with the fence in ParkWorker, either the worker sees the job or we see the worker parked
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_numParkedWorkers.load(std::memory_order_relaxed) > 0)
+	{
+		WakeParkedWorkers(job->m_jobFlag, 1);
+	}
 }
 
-Job* JobSystem::GetAnAvaliableJob(unsigned int jobFlag)
+void JobSystem::AddJobsIntoDeque(std::vector<Job*> const& jobs)
 {
-	m_queuedJobsMutex.lock();
+	AddJobsIntoDeque(jobs.data(), (int)jobs.size());
+}
 
-	Job* jobNotClaimed = nullptr;
+void JobSystem::AddJobsIntoDeque(Job* const* jobs, int numJobs)
+{
+	for (int jobIndex = 0; jobIndex < numJobs; jobIndex++)
+	{
+		PushJob(jobs[jobIndex]);
+	}
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_numParkedWorkers.load(std::memory_order_relaxed) == 0)
+	{
+		return;
+	}
+
+	// Wake one worker per job, grouped by flag so flagged jobs wake the workers that can run them.
+	// Every job got a queue, so there are at most MAX_JOB_FLAG_QUEUES flags plus the generic one.
+	unsigned int flags[MAX_JOB_FLAG_QUEUES + 1];
+	int jobCountPerFlag[MAX_JOB_FLAG_QUEUES + 1];
+	int numFlags = 0;
+	for (int jobIndex = 0; jobIndex < numJobs; jobIndex++)
+	{
+		unsigned int jobFlag = jobs[jobIndex]->m_jobFlag;
+		int flagIndex = (int)(std::find(flags, flags + numFlags, jobFlag) - flags);
+		if (flagIndex == numFlags)
+		{
+			flags[numFlags] = jobFlag;
+			jobCountPerFlag[numFlags] = 0;
+			numFlags++;
+		}
+		jobCountPerFlag[flagIndex] += 1;
+	}
 
-	if (m_queuedJobs .empty())
+	for (int flagIndex = 0; flagIndex < numFlags; flagIndex++)
 	{
-		m_queuedJobsMutex.unlock();
-		return jobNotClaimed;
+		WakeParkedWorkers(flags[flagIndex], jobCountPerFlag[flagIndex]);
 	}
+}
 
-	m_jobsExecutingMutex.lock();
+Job* JobSystem::GetAnAvaliableJob(unsigned int jobFlag)
+{
+	Job* jobNotClaimed = nullptr;
 
-	for (auto it = m_queuedJobs.begin(); it != m_queuedJobs.end(); ++it)
+	if (jobFlag != 0)
+	{
+		JobSharedQueue* flagQueue = GetFlagQueue(jobFlag);
+		if (flagQueue)
+		{
+			jobNotClaimed = flagQueue->Pop();
+		}
+	}
+	else
 	{
-		if ((*it)->m_jobFlag == jobFlag)
+		int workerID = GetCurrentThreadWorkerID();
+		if (workerID >= 0)
+		{
+			jobNotClaimed = m_workerDeques[workerID]->PopBottom();
+		}
+
+		if (jobNotClaimed == nullptr)
+		{
+			jobNotClaimed = m_submissionQueue->Pop();
+		}
+
+		if (jobNotClaimed == nullptr)
 		{
-			jobNotClaimed = (*it);
-			m_queuedJobs.erase(it);
-			jobNotClaimed->m_status = JobStatus::EXECUTING;
-			m_jobsExecuting.push_back(jobNotClaimed);
-			break;
+			jobNotClaimed = StealJob(workerID);
 		}
 	}
 
-	m_jobsExecutingMutex.unlock();
-	m_queuedJobsMutex.unlock();
+	if (jobNotClaimed)
+	{
+		MarkJobExecuting(jobNotClaimed);
+	}
 
 	return jobNotClaimed;
 }
 
 void JobSystem::CompleteJob(Job* job)
 {
-	m_jobsExecutingMutex.lock();
-	
-	auto it = std::find(m_jobsExecuting.begin(), m_jobsExecuting.end(), job);
-
-	if (it != m_jobsExecuting.end())
+	if (!job->m_needsRetrieval)
 	{
-		m_jobsExecuting.erase(it);
-
-		m_jobsCompletedMutex.lock();
-		job->m_status = JobStatus::COMPLETED;
-		m_jobsCompleted.push_back(job);
-		m_jobsCompletedMutex.unlock();
+		job->m_status.store(JobStatus::COMPLETED, std::memory_order_release);
+		job->OnCompleted();
+		return;
 	}
 
-	m_jobsExecutingMutex.unlock();
+	job->OnCompleted();
+
+	// Status first, the retriever waits for the job to show up in the stack once it sees COMPLETED
+	job->m_status.store(JobStatus::COMPLETED, std::memory_order_release);
+
+	Job* head = m_newlyCompletedJobs.load(std::memory_order_relaxed);
+	do
+	{
+		job->m_nextCompletedJob = head;
+	} 
+	while (!m_newlyCompletedJobs.compare_exchange_weak(head, job, std::memory_order_release, std::memory_order_relaxed));
 }
 
 void JobSystem::RetrieveCompletedJob(Job* job)
 {
-	m_jobsCompletedMutex.lock();
-	auto it = std::find(m_jobsCompleted.begin(), m_jobsCompleted.end(), job);
+	// Jobs that skip the completed list (graph jobs, fire and forget jobs) would never show up in it
+	if (!job->m_needsRetrieval || job->m_status.load(std::memory_order_acquire) != JobStatus::COMPLETED)
+	{
+		return;
+	}
 
-	if (it != m_jobsCompleted.end())
+	// The worker may still be between its status store and its push
+	DrainNewlyCompletedJobs();
+	while (!job->m_isInCompletedList)
 	{
-		(*it)->m_status = JobStatus::RETRIEVED;
-		it = m_jobsCompleted.erase(it);
+		std::this_thread::yield();
+		DrainNewlyCompletedJobs();
 	}
 
-	m_jobsCompletedMutex.unlock();
+	UnlinkCompletedJob(job);
+	job->m_status.store(JobStatus::RETRIEVED, std::memory_order_release);
+	job->OnRetrieved();
 }
 
 void JobSystem::RetrieveAllCompletedJobs()
 {
-	m_jobsCompletedMutex.lock();
+	DrainNewlyCompletedJobs();
 
-	for (auto it = m_jobsCompleted.begin(); it != m_jobsCompleted.end(); ++it)
+	Job* job = m_completedJobsHead;
+	while (job)
 	{
-		(*it)->m_status = JobStatus::RETRIEVED;
+		Job* nextJob = job->m_nextCompletedJob;
+		job->m_nextCompletedJob = nullptr;
+		job->m_prevCompletedJob = nullptr;
+		job->m_isInCompletedList = false;
+		job->m_status.store(JobStatus::RETRIEVED, std::memory_order_release);
+		job->OnRetrieved();
+		job = nextJob;
 	}
 
-	m_jobsCompleted.clear();
+	m_completedJobsHead = nullptr;
+	m_completedJobsTail = nullptr;
+}
 
-	m_jobsCompletedMutex.unlock();
+bool JobSystem::ExecuteOneJob(unsigned int jobFlag)
+{
+	Job* job = GetAnAvaliableJob(jobFlag);
+	if (job == nullptr)
+	{
+		return false;
+	}
+
+	ExecuteJob(job);
+	return true;
+}
+
+int JobSystem::GetNumQueuedJobs() const
+{
+	int numQueuedJobs = m_submissionQueue ? m_submissionQueue->GetApproximateCount() : 0;
+
+	for (int dequeIndex = 0; dequeIndex < (int)m_workerDeques.size(); dequeIndex++)
+	{
+		numQueuedJobs += m_workerDeques[dequeIndex]->GetApproximateCount();
+	}
+
+	int numFlagQueues = m_numFlagQueues.load(std::memory_order_acquire);
+	for (int queueIndex = 0; queueIndex < numFlagQueues; queueIndex++)
+	{
+		numQueuedJobs += m_flagQueues[queueIndex]->GetApproximateCount();
+	}
+
+	return numQueuedJobs;
+}
+
+int JobSystem::GetCurrentThreadWorkerID() const
+{
+	if (t_currentWorker && t_currentWorker->m_system == this)
+	{
+		return (int)t_currentWorker->m_ID;
+	}
+	return -1;
+}
+
+Job* JobSystem::StealJob(int thiefWorkerID)
+{
+	int numDeques = (int)m_workerDeques.size();
+	if (numDeques == 0)
+	{
+		return nullptr;
+	}
+
+	// Workers start with their right hand neighbour, other threads rotate their first victim
+	static thread_local unsigned int s_victimRotation = 0;
+	int firstVictim = thiefWorkerID >= 0 ? thiefWorkerID + 1 : (int)(s_victimRotation++);
+
+	for (int attempt = 0; attempt < numDeques; attempt++)
+	{
+		int victimID = (firstVictim + attempt) % numDeques;
+		if (victimID == thiefWorkerID)
+		{
+			continue;
+		}
+
+		Job* stolenJob = m_workerDeques[victimID]->Steal();
+		if (stolenJob)
+		{
+			return stolenJob;
+		}
+	}
+
+	return nullptr;
+}
+
+JobSharedQueue* JobSystem::GetFlagQueue(unsigned int jobFlag) const
+{
+	int numFlagQueues = m_numFlagQueues.load(std::memory_order_acquire);
+	for (int queueIndex = 0; queueIndex < numFlagQueues; queueIndex++)
+	{
+		if (m_flagQueueFlags[queueIndex] == jobFlag)
+		{
+			return m_flagQueues[queueIndex];
+		}
+	}
+	return nullptr;
+}
+
+JobSharedQueue* JobSystem::CreateOrGetFlagQueue(unsigned int jobFlag)
+{
+	JobSharedQueue* flagQueue = GetFlagQueue(jobFlag);
+	if (flagQueue)
+	{
+		return flagQueue;
+	}
+
+	m_flagQueuesMutex.lock();
+
+	flagQueue = GetFlagQueue(jobFlag);
+	if (flagQueue == nullptr)
+	{
+		int numFlagQueues = m_numFlagQueues.load(std::memory_order_relaxed);
+		GUARANTEE_OR_DIE(numFlagQueues < MAX_JOB_FLAG_QUEUES, "Too many distinct job flags, raise MAX_JOB_FLAG_QUEUES");
+
+		flagQueue = new JobSharedQueue((size_t)m_config.m_sharedQueueCapacity);
+		m_flagQueueFlags[numFlagQueues] = jobFlag;
+		m_flagQueues[numFlagQueues] = flagQueue;
+		m_numFlagQueues.store(numFlagQueues + 1, std::memory_order_release);
+	}
+
+	m_flagQueuesMutex.unlock();
+
+	return flagQueue;
+}
+
+void JobSystem::MarkJobExecuting(Job* job)
+{
+	job->m_status.store(JobStatus::EXECUTING, std::memory_order_relaxed);
+}
+
+void JobSystem::DrainNewlyCompletedJobs()
+{
+	Job* stackTop = m_newlyCompletedJobs.exchange(nullptr, std::memory_order_acquire);
+	if (stackTop == nullptr)
+	{
+		return;
+	}
+
+	// The stack is newest first, reverse it so the list stays in completion order
+	Job* oldestNewJob = nullptr;
+	for (Job* job = stackTop; job != nullptr; )
+	{
+		Job* olderJob = job->m_nextCompletedJob;
+		job->m_nextCompletedJob = oldestNewJob;
+		job->m_prevCompletedJob = nullptr;
+		job->m_isInCompletedList = true;
+		if (oldestNewJob)
+		{
+			oldestNewJob->m_prevCompletedJob = job;
+		}
+		oldestNewJob = job;
+		job = olderJob;
+	}
+
+	if (m_completedJobsTail)
+	{
+		m_completedJobsTail->m_nextCompletedJob = oldestNewJob;
+		oldestNewJob->m_prevCompletedJob = m_completedJobsTail;
+	}
+	else
+	{
+		m_completedJobsHead = oldestNewJob;
+	}
+	m_completedJobsTail = stackTop;
+}
+
+void JobSystem::UnlinkCompletedJob(Job* job)
+{
+	if (job->m_prevCompletedJob)
+	{
+		job->m_prevCompletedJob->m_nextCompletedJob = job->m_nextCompletedJob;
+	}
+	else
+	{
+		m_completedJobsHead = job->m_nextCompletedJob;
+	}
+
+	if (job->m_nextCompletedJob)
+	{
+		job->m_nextCompletedJob->m_prevCompletedJob = job->m_prevCompletedJob;
+	}
+	else
+	{
+		m_completedJobsTail = job->m_prevCompletedJob;
+	}
+
+	job->m_nextCompletedJob = nullptr;
+	job->m_prevCompletedJob = nullptr;
+	job->m_isInCompletedList = false;
+}
+
+void JobSystem::ExecuteJob(Job* job)
+{
+#if defined(ENGINE_JOB_PROFILING)
+	int queueDepth = GetNumQueuedJobs();
+	double startSeconds = GetCurrentTimeSeconds();
+	job->Execute();
+	JobProfiler::RecordJob(GetCurrentThreadWorkerID(), *job, startSeconds, GetCurrentTimeSeconds(), queueDepth);
+#else
+	job->Execute();
+#endif
+
+	CompleteJob(job);
+}
+
+void JobSystem::PushJob(Job* job)
+{
+	job->m_status = JobStatus::QUEUED;
+#if defined(ENGINE_JOB_PROFILING)
+	job->m_queuedSeconds = GetCurrentTimeSeconds();
+#endif
+
+	if (job->m_jobFlag != 0)
+	{
+		CreateOrGetFlagQueue(job->m_jobFlag)->Push(job);
+		return;
+	}
+
+	int workerID = GetCurrentThreadWorkerID();
+	if (workerID >= 0 && m_workers[workerID]->GetWorkerFlag() == 0)
+	{
+		m_workerDeques[workerID]->PushBottom(job);
+		return;
+	}
+
+	m_submissionQueue->Push(job);
+}
+
+void JobSystem::ParkWorker(JobWorkerThread* worker)
+{
+	m_parkedWorkersMutex.lock();
+	m_parkedWorkers.push_back(worker);
+	m_numParkedWorkers.fetch_add(1, std::memory_order_relaxed);
+	m_parkedWorkersMutex.unlock();
+
+	// Last look at the queues now that submitters can see us, otherwise a job pushed just before
+	// we registered would sleep with us
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	Job* job = IsQuitting() ? nullptr : GetAnAvaliableJob(worker->GetWorkerFlag());
+
+	if (job == nullptr && !IsQuitting())
+	{
+		std::unique_lock<std::mutex> parkLock(worker->m_parkMutex);
+		worker->m_parkCondition.wait(parkLock, [this, worker]() { return worker->m_isWakeRequested || IsQuitting(); });
+	}
+
+	m_parkedWorkersMutex.lock();
+	auto it = std::find(m_parkedWorkers.begin(), m_parkedWorkers.end(), worker);
+	if (it != m_parkedWorkers.end())
+	{
+		m_parkedWorkers.erase(it);
+		m_numParkedWorkers.fetch_sub(1, std::memory_order_relaxed);
+	}
+	m_parkedWorkersMutex.unlock();
+
+	worker->m_parkMutex.lock();
+	worker->m_isWakeRequested = false;
+	worker->m_parkMutex.unlock();
+
+	if (job)
+	{
+		worker->m_currentJob = job;
+		ExecuteJob(job);
+		worker->m_currentJob = nullptr;
+	}
+}
+
+int JobSystem::WakeParkedWorkers(unsigned int jobFlag, int maxWorkersToWake)
+{
+	int numWorkersWoken = 0;
+
+	m_parkedWorkersMutex.lock();
+	for (auto it = m_parkedWorkers.begin(); it != m_parkedWorkers.end() && numWorkersWoken < maxWorkersToWake; )
+	{
+		JobWorkerThread* worker = *it;
+		if (worker->GetWorkerFlag() != jobFlag)
+		{
+			++it;
+			continue;
+		}
+
+		it = m_parkedWorkers.erase(it);
+		m_numParkedWorkers.fetch_sub(1, std::memory_order_relaxed);
+
+		worker->m_parkMutex.lock();
+		worker->m_isWakeRequested = true;
+		worker->m_parkMutex.unlock();
+		worker->m_parkCondition.notify_one();
+
+		numWorkersWoken++;
+	}
+	m_parkedWorkersMutex.unlock();
+
+	return numWorkersWoken;
+}
+
+void JobSystem::WakeAllParkedWorkers()
+{
+	m_parkedWorkersMutex.lock();
+	for (int workerIndex = 0; workerIndex < (int)m_parkedWorkers.size(); workerIndex++)
+	{
+		JobWorkerThread* worker = m_parkedWorkers[workerIndex];
+		worker->m_parkMutex.lock();
+		worker->m_isWakeRequested = true;
+		worker->m_parkMutex.unlock();
+		worker->m_parkCondition.notify_one();
+	}
+	m_parkedWorkers.clear();
+	m_numParkedWorkers.store(0, std::memory_order_relaxed);
+	m_parkedWorkersMutex.unlock();
 }
 
 // -----------------------------JOBWORKER----------------------------------
@@ -135,32 +549,46 @@ m_workerFlag(workerFlag)
 JobWorkerThread::~JobWorkerThread()
 {
 	m_thread->join();
+	delete m_thread;
+	m_thread = nullptr;
 }
 
 void JobWorkerThread::ThreadMain()
 {
+	t_currentWorker = this;
+	int idleSpinCount = 0;
+
 	while (!m_system->IsQuitting())
 	{
-		m_currentJob = m_system->GetAnAvaliableJob(m_workerFlag);
+		m_currentJob = m_system->GetAnAvaliableJob(GetWorkerFlag());
 
 		if (m_currentJob)
 		{
-			m_currentJob->Execute();
-			m_system->CompleteJob(m_currentJob);
+			m_system->ExecuteJob(m_currentJob);
+			m_currentJob = nullptr;
+			idleSpinCount = 0;
+		}
+		else if (idleSpinCount < m_system->m_config.m_spinCountBeforePark)
+		{
+			idleSpinCount++;
+			std::this_thread::yield();
 		}
 		else
 		{
-			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			m_system->ParkWorker(this);
+			idleSpinCount = 0;
 		}
 	}
+
+	t_currentWorker = nullptr;
 }
 
 void JobWorkerThread::SetWorkerFlag(unsigned int workerFlag)
 {
-	m_workerFlag = workerFlag;
+	m_workerFlag.store(workerFlag, std::memory_order_release);
 }
 
 unsigned int JobWorkerThread::GetWorkerFlag() const
 {
-	return m_workerFlag;
+	return m_workerFlag.load(std::memory_order_acquire);
 }
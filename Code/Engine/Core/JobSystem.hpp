@@ -1,8 +1,11 @@
 #pragma once
-#include <deque>
+#include "Engine/Core/JobQueue.hpp"
+#include "Engine/Core/JobProfiler.hpp"
+#include <atomic>
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 enum class JobStatus
 {
 	NEW,
@@ -21,18 +24,49 @@ public:
 	virtual ~Job() {};
 	virtual void Execute() = 0;
 
-	JobStatus					m_status = JobStatus::NEW;
+	// Called on the executing thread once the job is completed, right before it becomes retrievable.
+	// For jobs that don't need retrieval this is the last time the job system touches the job.
+	virtual void OnCompleted() {};
+
+	// Called on the retrieving thread once the job is RETRIEVED, the job system never touches it again
+	virtual void OnRetrieved() {};
+
+	std::atomic<JobStatus>		m_status = JobStatus::NEW;
 	unsigned int				m_jobFlag = 0; // 0 means this job can be done by any worker
+	bool						m_needsRetrieval = true; // false for jobs owned by helpers like JobGraph, they skip the completed list
+
+	// Intrusive links of the job system's completed list, owned by the job system
+	Job*						m_nextCompletedJob = nullptr;
+	Job*						m_prevCompletedJob = nullptr;
+	bool						m_isInCompletedList = false;
+
+#if defined(ENGINE_JOB_PROFILING)
+	double						m_queuedSeconds = 0.0;
+#endif
 };
 
+constexpr int MAX_JOB_FLAG_QUEUES = 32;
+
 struct JobSystemConfig
 {
 	unsigned int m_workerNumber = 0; // 0 means only 1 thread
+	int m_workerDequeCapacity = 1024; // Initial capacity of every worker's work stealing deque, grows on demand
+	int m_sharedQueueCapacity = 4096; // Lock free capacity of the submission queue and of every flag queue
+	int m_spinCountBeforePark = 64; // Failed polls (each followed by a yield) before an idle worker goes to sleep
 };
 
+//-----------------------------------------------------------------------------------
+// Generic jobs (flag 0) pushed from a worker go to that worker's own deque, jobs pushed from
+// any other thread go to the shared submission queue. Idle generic workers drain their own deque,
+// then the submission queue, then steal from their peers. Flagged jobs go to one queue per flag
+// and are only ever taken by workers that carry the same flag.
+// Workers that stay idle past their spin budget park on their own condition variable, and every
+// submission wakes at most one parked worker able to run the job.
+//
 class JobWorkerThread;
 class JobSystem
 {
+	friend class JobWorkerThread;
 public:
 	JobSystem() = delete;
 	JobSystem(JobSystemConfig config) : m_config(config){};
@@ -43,28 +77,62 @@ public:
 	void							ShutDown();
 
 	void							AddJobIntoDeque(Job* job);
+	void							AddJobsIntoDeque(std::vector<Job*> const& jobs);
+	void							AddJobsIntoDeque(Job* const* jobs, int numJobs);
 	Job*							GetAnAvaliableJob(unsigned int jobFlag = 0);
 	void							CompleteJob(Job* job);
+
+	// Retrieval is single consumer, only call these from one thread (usually the main thread)
 	void							RetrieveCompletedJob(Job* job);
 	void							RetrieveAllCompletedJobs();
 
-	bool							IsQuitting() { return m_isQuitting; }
+	// Run one queued job on the calling thread if there is one, used by threads that wait on work
+	bool							ExecuteOneJob(unsigned int jobFlag = 0);
+
+	bool							IsQuitting() const { return m_isQuitting.load(std::memory_order_acquire); }
+	int								GetNumQueuedJobs() const;
+	int								GetNumWorkers() const { return (int)m_workers.size(); }
+private:
+	int								GetCurrentThreadWorkerID() const;
+	Job*							StealJob(int thiefWorkerID);
+	JobSharedQueue*					GetFlagQueue(unsigned int jobFlag) const;
+	JobSharedQueue*					CreateOrGetFlagQueue(unsigned int jobFlag);
+	void							MarkJobExecuting(Job* job);
+	void							PushJob(Job* job);
+	void							ExecuteJob(Job* job);
+	void							ParkWorker(JobWorkerThread* worker);
+	int								WakeParkedWorkers(unsigned int jobFlag, int maxWorkersToWake);
+	void							WakeAllParkedWorkers();
+	void							DrainNewlyCompletedJobs();
+	void							UnlinkCompletedJob(Job* job);
+
 private:
 	JobSystemConfig					m_config;
-	bool							m_isQuitting = false;
+	std::atomic<bool>				m_isQuitting = false;
 	std::vector<JobWorkerThread*>	m_workers;
 
-	std::mutex						m_queuedJobsMutex;
-	std::mutex						m_jobsExecutingMutex;
-	std::mutex						m_jobsCompletedMutex;
+	std::vector<JobWorkStealingDeque*> m_workerDeques;
+	JobSharedQueue*					m_submissionQueue = nullptr;
+
+	std::mutex						m_flagQueuesMutex; // Only taken when a new flag queue is created
+	std::atomic<int>				m_numFlagQueues = 0;
+	unsigned int					m_flagQueueFlags[MAX_JOB_FLAG_QUEUES] = {};
+	JobSharedQueue*					m_flagQueues[MAX_JOB_FLAG_QUEUES] = {};
 
-	std::deque<Job*>				m_queuedJobs;
-	std::deque<Job*>				m_jobsExecuting;
-	std::deque<Job*>				m_jobsCompleted;
+	std::mutex						m_parkedWorkersMutex;
+	std::atomic<int>				m_numParkedWorkers = 0;
+	std::vector<JobWorkerThread*>	m_parkedWorkers;
+
+	// Workers push completed jobs onto a lock free stack, the retrieving thread moves them into its
+	// own doubly linked list so retrieving a single job is an O(1) unlink
+	std::atomic<Job*>				m_newlyCompletedJobs = nullptr;
+	Job*							m_completedJobsHead = nullptr;
+	Job*							m_completedJobsTail = nullptr;
 };
 
 class JobWorkerThread 
 {
+	friend class JobSystem;
 public:
 	JobWorkerThread() = delete;
 	JobWorkerThread(JobSystem* systemPtr, unsigned int workerID, unsigned int workerFlag = 0);
@@ -74,10 +142,15 @@ public:
 
 	void							SetWorkerFlag(unsigned int workerFlag);
 	unsigned int					GetWorkerFlag() const;
+	unsigned int					GetWorkerID() const { return m_ID; }
 private:
-	unsigned int					m_workerFlag = 0;	// 0 means can be used for all kinds of job
+	std::atomic<unsigned int>		m_workerFlag = 0;	// 0 means can be used for all kinds of job
 	JobSystem*						m_system;
 	unsigned int					m_ID;
 	std::thread*					m_thread;
 	Job*							m_currentJob = nullptr;
-};
\ No newline at end of file
+
+	std::mutex						m_parkMutex;
+	std::condition_variable			m_parkCondition;
+	bool							m_isWakeRequested = false;
+};
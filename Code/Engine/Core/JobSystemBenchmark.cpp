@@ -0,0 +1,343 @@
+#include "Engine/Core/JobSystemBenchmark.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Core/ParallelAlgorithms.hpp"
+#include "Engine/Math/RandomNumberGenerator.hpp"
+#include "Engine/Core/Time.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+constexpr int PARKED_LATENCY_PAUSE_MILLISECONDS = 2;	// Way past the spin budget of any sane config
+
+// Keeps the optimizer from dropping the work being timed
+static volatile float s_benchmarkSink = 0.f;
+
+template<typename Work>
+static double TimeMilliseconds(Work const& work)
+{
+	double startSeconds = GetCurrentTimeSeconds();
+	work();
+	return (GetCurrentTimeSeconds() - startSeconds) * 1000.0;
+}
+
+static bool ReportMissingWorkers(char const* commandName)
+{
+	if (g_theJobSystem && g_theJobSystem->GetNumWorkers() > 0)
+	{
+		return false;
+	}
+	if (g_theConsole)
+	{
+		g_theConsole->AddLine(DevConsole::ERROR, Stringf("%s needs a job system with workers", commandName));
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------------
+// Latency
+//
+class LatencyProbeJob : public Job
+{
+public:
+	virtual void Execute() override
+	{
+		m_executeSeconds = GetCurrentTimeSeconds();
+	}
+
+	double	m_executeSeconds = 0.0;
+};
+
+static JobLatencyBenchmarkResult MeasureJobLatency(JobSystem& system, char const* name, int numSamples, bool waitForParkedWorkers)
+{
+	JobLatencyBenchmarkResult result;
+	result.m_name = name;
+	result.m_numSamples = numSamples;
+	if (numSamples <= 0)
+	{
+		return result;
+	}
+
+	std::vector<double> latencies;
+	latencies.reserve((size_t)numSamples);
+	LatencyProbeJob probeJob;
+	for (int sampleIndex = 0; sampleIndex < numSamples; ++sampleIndex)
+	{
+		if (waitForParkedWorkers)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(PARKED_LATENCY_PAUSE_MILLISECONDS));
+		}
+
+		double submitSeconds = GetCurrentTimeSeconds();
+		system.AddJobIntoDeque(&probeJob);
+		while (probeJob.m_status.load(std::memory_order_acquire) != JobStatus::COMPLETED)
+		{
+			std::this_thread::yield();
+		}
+		system.RetrieveCompletedJob(&probeJob);
+		latencies.push_back((probeJob.m_executeSeconds - submitSeconds) * 1000000.0);
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+	double totalMicroseconds = 0.0;
+	for (double latency : latencies)
+	{
+		totalMicroseconds += latency;
+	}
+	result.m_averageMicroseconds = totalMicroseconds / (double)numSamples;
+	result.m_medianMicroseconds = latencies[latencies.size() / 2];
+	result.m_percentile99Microseconds = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+	result.m_maxMicroseconds = latencies.back();
+	return result;
+}
+
+std::vector<JobLatencyBenchmarkResult> RunJobLatencyBenchmark(JobSystem& system, int numSamples)
+{
+	std::vector<JobLatencyBenchmarkResult> results;
+	results.push_back(MeasureJobLatency(system, "spinning", numSamples, false));
+	results.push_back(MeasureJobLatency(system, "parked", std::max(1, numSamples / 10), true));
+	return results;
+}
+
+bool Command_JobLatencyBenchmark(EventArgs const& args)
+{
+	if (ReportMissingWorkers("JobLatencyBenchmark"))
+	{
+		return true;
+	}
+
+	int numSamples = args.GetValue(std::string("samples"), 2000);
+	std::vector<JobLatencyBenchmarkResult> results = RunJobLatencyBenchmark(*g_theJobSystem, numSamples);
+	if (g_theConsole)
+	{
+		g_theConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("JobLatencyBenchmark, submit to execute, %i workers", g_theJobSystem->GetNumWorkers()));
+		for (JobLatencyBenchmarkResult const& result : results)
+		{
+			g_theConsole->AddLine(DevConsole::INFO_MINOR, Stringf("%-9s %5i jobs  avg %8.2f us  median %8.2f us  p99 %8.2f us  max %8.2f us",
+				result.m_name.c_str(), result.m_numSamples, result.m_averageMicroseconds, result.m_medianMicroseconds, result.m_percentile99Microseconds, result.m_maxMicroseconds));
+		}
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------------
+// Throughput
+//
+class CounterJob : public Job
+{
+public:
+	virtual void Execute() override
+	{
+		m_numExecuted->fetch_add(1, std::memory_order_relaxed);
+	}
+
+	std::atomic<int>*	m_numExecuted = nullptr;
+};
+
+// Runs queued jobs on the calling thread too until every job of the frame has executed
+static void WaitForExecutedJobs(JobSystem& system, std::atomic<int> const& numExecuted, int numExpected)
+{
+	while (numExecuted.load(std::memory_order_relaxed) < numExpected)
+	{
+		if (!system.ExecuteOneJob())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+std::vector<JobThroughputBenchmarkResult> RunJobThroughputBenchmark(JobSystem& system, int numJobs, int jobsPerFrame)
+{
+	std::vector<JobThroughputBenchmarkResult> results;
+	numJobs = std::max(numJobs, 1);
+	jobsPerFrame = std::max(1, std::min(jobsPerFrame, numJobs));
+
+	std::atomic<int> numExecuted = 0;
+	std::vector<CounterJob> jobs((size_t)jobsPerFrame);
+	std::vector<Job*> jobPointers((size_t)jobsPerFrame);
+	for (int jobIndex = 0; jobIndex < jobsPerFrame; ++jobIndex)
+	{
+		jobs[jobIndex].m_numExecuted = &numExecuted;
+		jobPointers[jobIndex] = &jobs[jobIndex];
+	}
+
+	JobThroughputBenchmarkResult singleResult;
+	singleResult.m_name = "one at a time";
+	singleResult.m_totalMs = TimeMilliseconds([&]()
+	{
+		for (int firstJob = 0; firstJob < numJobs; firstJob += jobsPerFrame)
+		{
+			int numFrameJobs = std::min(jobsPerFrame, numJobs - firstJob);
+			numExecuted.store(0, std::memory_order_relaxed);
+			for (int jobIndex = 0; jobIndex < numFrameJobs; ++jobIndex)
+			{
+				system.AddJobIntoDeque(&jobs[jobIndex]);
+			}
+			WaitForExecutedJobs(system, numExecuted, numFrameJobs);
+			for (int jobIndex = 0; jobIndex < numFrameJobs; ++jobIndex)
+			{
+				while (jobs[jobIndex].m_status.load(std::memory_order_acquire) != JobStatus::COMPLETED)
+				{
+					std::this_thread::yield();
+				}
+				system.RetrieveCompletedJob(&jobs[jobIndex]);
+			}
+		}
+	});
+	results.push_back(singleResult);
+
+	JobThroughputBenchmarkResult batchResult;
+	batchResult.m_name = "batched";
+	batchResult.m_totalMs = TimeMilliseconds([&]()
+	{
+		for (int firstJob = 0; firstJob < numJobs; firstJob += jobsPerFrame)
+		{
+			int numFrameJobs = std::min(jobsPerFrame, numJobs - firstJob);
+			numExecuted.store(0, std::memory_order_relaxed);
+			system.AddJobsIntoDeque(jobPointers.data(), numFrameJobs);
+			WaitForExecutedJobs(system, numExecuted, numFrameJobs);
+			for (int jobIndex = 0; jobIndex < numFrameJobs; ++jobIndex)
+			{
+				while (jobs[jobIndex].m_status.load(std::memory_order_acquire) != JobStatus::COMPLETED)
+				{
+					std::this_thread::yield();
+				}
+			}
+			system.RetrieveAllCompletedJobs();
+		}
+	});
+	results.push_back(batchResult);
+
+	for (JobThroughputBenchmarkResult& result : results)
+	{
+		result.m_numJobs = numJobs;
+		result.m_nanosecondsPerJob = result.m_totalMs * 1000000.0 / (double)numJobs;
+	}
+	return results;
+}
+
+bool Command_JobThroughputBenchmark(EventArgs const& args)
+{
+	if (ReportMissingWorkers("JobThroughputBenchmark"))
+	{
+		return true;
+	}
+
+	int numJobs = args.GetValue(std::string("jobs"), 1000000);
+	int jobsPerFrame = args.GetValue(std::string("perFrame"), 10000);
+	std::vector<JobThroughputBenchmarkResult> results = RunJobThroughputBenchmark(*g_theJobSystem, numJobs, jobsPerFrame);
+	if (g_theConsole)
+	{
+		g_theConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("JobThroughputBenchmark, %i jobs, %i per frame, %i workers", numJobs, jobsPerFrame, g_theJobSystem->GetNumWorkers()));
+		for (JobThroughputBenchmarkResult const& result : results)
+		{
+			g_theConsole->AddLine(DevConsole::INFO_MINOR, Stringf("%-14s %9.2f ms  %8.1f ns per job", result.m_name.c_str(), result.m_totalMs, result.m_nanosecondsPerJob));
+		}
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------------
+// Parallel algorithms
+//
+std::vector<ParallelAlgorithmBenchmarkResult> RunParallelAlgorithmBenchmark(JobSystem& system, int numElements)
+{
+	std::vector<ParallelAlgorithmBenchmarkResult> results;
+	numElements = std::max(numElements, 1);
+
+	RandomNumberGenerator rng;
+	std::vector<float> source((size_t)numElements);
+	for (float& value : source)
+	{
+		value = rng.RollRandomFloatInRange(0.f, 1000.f);
+	}
+	std::vector<float> serialValues((size_t)numElements);
+	std::vector<float> parallelValues((size_t)numElements);
+
+	{
+		ParallelAlgorithmBenchmarkResult result;
+		result.m_name = "for (sqrt)";
+		result.m_serialMs = TimeMilliseconds([&]()
+		{
+			for (int index = 0; index < numElements; ++index)
+			{
+				serialValues[index] = sqrtf(source[index]) * 0.5f + 1.f;
+			}
+		});
+		result.m_parallelMs = TimeMilliseconds([&]()
+		{
+			ParallelFor(&system, 0, numElements, 0, [&](int index)
+			{
+				parallelValues[index] = sqrtf(source[index]) * 0.5f + 1.f;
+			});
+		});
+		result.m_isMatching = serialValues == parallelValues;
+		results.push_back(result);
+	}
+
+	{
+		ParallelAlgorithmBenchmarkResult result;
+		result.m_name = "reduce (sum)";
+		double serialSum = 0.0;
+		double parallelSum = 0.0;
+		result.m_serialMs = TimeMilliseconds([&]()
+		{
+			for (int index = 0; index < numElements; ++index)
+			{
+				serialSum += (double)source[index];
+			}
+		});
+		result.m_parallelMs = TimeMilliseconds([&]()
+		{
+			parallelSum = ParallelReduce(&system, 0, numElements, 0, 0.0, [&](int rangeBegin, int rangeEnd, double partial)
+			{
+				for (int index = rangeBegin; index < rangeEnd; ++index)
+				{
+					partial += (double)source[index];
+				}
+				return partial;
+			}, [](double lhs, double rhs) { return lhs + rhs; });
+		});
+		// Summed in a different order, so only close
+		result.m_isMatching = fabs(serialSum - parallelSum) <= 1e-9 * fabs(serialSum);
+		s_benchmarkSink = s_benchmarkSink + (float)(serialSum + parallelSum);
+		results.push_back(result);
+	}
+
+	{
+		ParallelAlgorithmBenchmarkResult result;
+		result.m_name = "sort";
+		serialValues = source;
+		parallelValues = source;
+		result.m_serialMs = TimeMilliseconds([&]() { std::sort(serialValues.begin(), serialValues.end()); });
+		result.m_parallelMs = TimeMilliseconds([&]() { ParallelSort(&system, parallelValues.begin(), parallelValues.end(), std::less<float>()); });
+		result.m_isMatching = serialValues == parallelValues;
+		results.push_back(result);
+	}
+
+	return results;
+}
+
+bool Command_ParallelBenchmark(EventArgs const& args)
+{
+	if (ReportMissingWorkers("ParallelBenchmark"))
+	{
+		return true;
+	}
+
+	int numElements = args.GetValue(std::string("elements"), 1000000);
+	std::vector<ParallelAlgorithmBenchmarkResult> results = RunParallelAlgorithmBenchmark(*g_theJobSystem, numElements);
+	if (g_theConsole)
+	{
+		g_theConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("ParallelBenchmark, %i floats, %i workers plus the calling thread", numElements, g_theJobSystem->GetNumWorkers()));
+		for (ParallelAlgorithmBenchmarkResult const& result : results)
+		{
+			g_theConsole->AddLine(result.m_isMatching ? DevConsole::INFO_MINOR : DevConsole::ERROR, Stringf("%-13s serial %8.2f ms  parallel %8.2f ms  %s",
+				result.m_name.c_str(), result.m_serialMs, result.m_parallelMs, result.m_isMatching ? "matches" : "MISMATCH"));
+		}
+	}
+	return true;
+}
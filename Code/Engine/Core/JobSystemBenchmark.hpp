@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <vector>
+
+class JobSystem;
+class NamedProperties;
+typedef NamedProperties EventArgs;
+
+//-----------------------------------------------------------------------------------
+// Console benchmarks for g_theJobSystem, see EngineBenchmarks.hpp. They need workers, without a job
+// system or without any workers they only report an error.
+//
+struct JobLatencyBenchmarkResult
+{
+	std::string		m_name;
+	int				m_numSamples = 0;
+	double			m_averageMicroseconds = 0.0;	// From AddJobIntoDeque to the start of Execute
+	double			m_medianMicroseconds = 0.0;
+	double			m_percentile99Microseconds = 0.0;
+	double			m_maxMicroseconds = 0.0;
+};
+
+// One job at a time, either right after the last one finished (workers still spinning) or after
+// a pause long enough for every worker to park
+std::vector<JobLatencyBenchmarkResult>	RunJobLatencyBenchmark(JobSystem& system, int numSamples);
+bool									Command_JobLatencyBenchmark(EventArgs const& args);
+
+struct JobThroughputBenchmarkResult
+{
+	std::string		m_name;
+	int				m_numJobs = 0;
+	double			m_totalMs = 0.0;			// Submit, execute and retrieve every job
+	double			m_nanosecondsPerJob = 0.0;
+};
+
+// numJobs tiny jobs submitted jobsPerFrame at a time, then retrieved, either one AddJobIntoDeque and
+// RetrieveCompletedJob per job or one AddJobsIntoDeque and RetrieveAllCompletedJobs per frame
+std::vector<JobThroughputBenchmarkResult>	RunJobThroughputBenchmark(JobSystem& system, int numJobs, int jobsPerFrame);
+bool										Command_JobThroughputBenchmark(EventArgs const& args);
+
+struct ParallelAlgorithmBenchmarkResult
+{
+	std::string		m_name;
+	double			m_serialMs = 0.0;
+	double			m_parallelMs = 0.0;
+	bool			m_isMatching = false;		// Parallel result equals the serial one
+};
+
+// ParallelFor, ParallelReduce and ParallelSort against plain loops and std::sort on numElements floats
+std::vector<ParallelAlgorithmBenchmarkResult>	RunParallelAlgorithmBenchmark(JobSystem& system, int numElements);
+bool											Command_ParallelBenchmark(EventArgs const& args);
@@ -0,0 +1,157 @@
+#include "Engine/Core/LambdaJob.hpp"
+
+constexpr int LAMBDA_JOBS_PER_BLOCK = 256;
+constexpr int MAX_THREAD_FREE_LAMBDA_JOBS = 1024; // Past this a thread hands half of its free jobs back to the shared pool
+
+//-----------------------------------------------------------------------------------
+// Shared backing store. Threads only come here when their own free list is empty or too long,
+// which happens once per LAMBDA_JOBS_PER_BLOCK jobs at most.
+//
+class LambdaJobPool
+{
+public:
+	~LambdaJobPool()
+	{
+		for (int blockIndex = 0; blockIndex < (int)m_blocks.size(); ++blockIndex)
+		{
+			delete[] m_blocks[blockIndex];
+		}
+		m_blocks.clear();
+	}
+
+	LambdaJob* TakeJobs(int& outNumJobs)
+	{
+		m_mutex.lock();
+
+		if (m_freeJobs == nullptr)
+		{
+			LambdaJob* block = new LambdaJob[LAMBDA_JOBS_PER_BLOCK];
+			m_blocks.push_back(block);
+			for (int jobIndex = 0; jobIndex < LAMBDA_JOBS_PER_BLOCK; ++jobIndex)
+			{
+				block[jobIndex].m_nextFreeJob = m_freeJobs;
+				m_freeJobs = &block[jobIndex];
+			}
+			m_numFreeJobs += LAMBDA_JOBS_PER_BLOCK;
+		}
+
+		// Hand over a block worth of jobs at most so other threads still find some here
+		LambdaJob* jobs = m_freeJobs;
+		LambdaJob* last = jobs;
+		outNumJobs = 1;
+		while (last->m_nextFreeJob && outNumJobs < LAMBDA_JOBS_PER_BLOCK)
+		{
+			last = last->m_nextFreeJob;
+			outNumJobs++;
+		}
+		m_freeJobs = last->m_nextFreeJob;
+		m_numFreeJobs -= outNumJobs;
+		last->m_nextFreeJob = nullptr;
+
+		m_mutex.unlock();
+		return jobs;
+	}
+
+	void GiveJobs(LambdaJob* first, LambdaJob* last, int numJobs)
+	{
+		m_mutex.lock();
+		last->m_nextFreeJob = m_freeJobs;
+		m_freeJobs = first;
+		m_numFreeJobs += numJobs;
+		m_mutex.unlock();
+	}
+
+private:
+	std::mutex					m_mutex;
+	LambdaJob*					m_freeJobs = nullptr;
+	int							m_numFreeJobs = 0;
+	std::vector<LambdaJob*>		m_blocks;
+};
+
+static LambdaJobPool s_lambdaJobPool;
+
+//-----------------------------------------------------------------------------------
+struct LambdaJobFreeList
+{
+	~LambdaJobFreeList()
+	{
+		if (m_freeJobs)
+		{
+			LambdaJob* last = m_freeJobs;
+			while (last->m_nextFreeJob)
+			{
+				last = last->m_nextFreeJob;
+			}
+			s_lambdaJobPool.GiveJobs(m_freeJobs, last, m_numFreeJobs);
+		}
+	}
+
+	LambdaJob*					m_freeJobs = nullptr;
+	int							m_numFreeJobs = 0;
+};
+
+static thread_local LambdaJobFreeList t_lambdaJobFreeList;
+
+//-----------------------------------------------------------------------------------
+void LambdaJob::Execute()
+{
+	m_invokeFunction(m_storage);
+}
+
+void LambdaJob::OnCompleted()
+{
+	if (!m_needsRetrieval)
+	{
+		Recycle();
+	}
+}
+
+void LambdaJob::OnRetrieved()
+{
+	Recycle();
+}
+
+LambdaJob* LambdaJob::Allocate()
+{
+	LambdaJobFreeList& freeList = t_lambdaJobFreeList;
+	if (freeList.m_freeJobs == nullptr)
+	{
+		freeList.m_freeJobs = s_lambdaJobPool.TakeJobs(freeList.m_numFreeJobs);
+	}
+
+	LambdaJob* job = freeList.m_freeJobs;
+	freeList.m_freeJobs = job->m_nextFreeJob;
+	freeList.m_numFreeJobs -= 1;
+
+	job->m_nextFreeJob = nullptr;
+	job->m_status.store(JobStatus::NEW, std::memory_order_relaxed);
+	return job;
+}
+
+void LambdaJob::Recycle()
+{
+	m_destroyFunction(m_storage);
+	m_invokeFunction = nullptr;
+	m_destroyFunction = nullptr;
+
+	// Jobs tend to be created on one thread and recycled on another, so trim long lists
+	LambdaJobFreeList& freeList = t_lambdaJobFreeList;
+	m_nextFreeJob = freeList.m_freeJobs;
+	freeList.m_freeJobs = this;
+	freeList.m_numFreeJobs += 1;
+
+	if (freeList.m_numFreeJobs > MAX_THREAD_FREE_LAMBDA_JOBS)
+	{
+		int numJobsToGive = freeList.m_numFreeJobs / 2;
+		LambdaJob* first = freeList.m_freeJobs;
+		LambdaJob* last = first;
+		for (int jobIndex = 1; jobIndex < numJobsToGive; ++jobIndex)
+		{
+			last = last->m_nextFreeJob;
+		}
+
+		freeList.m_freeJobs = last->m_nextFreeJob;
+		freeList.m_numFreeJobs -= numJobsToGive;
+		s_lambdaJobPool.GiveJobs(first, last, numJobsToGive);
+	}
+}
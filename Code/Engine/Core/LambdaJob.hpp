@@ -0,0 +1,77 @@
+#pragma once
+#include "Engine/Core/JobSystem.hpp"
+#include <new>
+#include <type_traits>
+#include <utility>
+
+constexpr size_t LAMBDA_JOB_INLINE_CAPACITY = 64;
+constexpr size_t LAMBDA_JOB_INLINE_ALIGNMENT = 16;
+
+//-----------------------------------------------------------------------------------
+// Job that runs a callable stored inline, no subclass and no heap allocation per job.
+// LambdaJobs come from a per thread free list backed by shared blocks and go back to it on their
+// own: after OnRetrieved for jobs that need retrieval, right after completion for the others.
+// Never delete a LambdaJob, don't touch it once it has been retrieved, and don't add it to a JobGraph.
+//
+class LambdaJob : public Job
+{
+	friend class LambdaJobPool;
+	friend struct LambdaJobFreeList;
+public:
+	template<typename Func>
+	static LambdaJob*			Create(Func&& func, unsigned int jobFlag = 0, bool needsRetrieval = true);
+
+	virtual void				Execute() override;
+	virtual void				OnCompleted() override;
+	virtual void				OnRetrieved() override;
+
+	LambdaJob(const LambdaJob& copy) = delete;
+
+private:
+	LambdaJob() = default;
+	static LambdaJob*			Allocate();
+	void						Recycle();
+
+private:
+	typedef void (*InvokeFunction)(void* storage);
+	typedef void (*DestroyFunction)(void* storage);
+
+	alignas(LAMBDA_JOB_INLINE_ALIGNMENT) unsigned char m_storage[LAMBDA_JOB_INLINE_CAPACITY];
+	InvokeFunction				m_invokeFunction = nullptr;
+	DestroyFunction				m_destroyFunction = nullptr;
+	LambdaJob*					m_nextFreeJob = nullptr;
+};
+
+template<typename Func>
+LambdaJob* LambdaJob::Create(Func&& func, unsigned int jobFlag, bool needsRetrieval)
+{
+	typedef typename std::decay<Func>::type Callable;
+	static_assert(sizeof(Callable) <= LAMBDA_JOB_INLINE_CAPACITY, "LambdaJob captures are too big to be stored inline, capture by pointer instead");
+	static_assert(alignof(Callable) <= LAMBDA_JOB_INLINE_ALIGNMENT, "LambdaJob captures are over aligned");
+
+	LambdaJob* job = Allocate();
+	new (job->m_storage) Callable(std::forward<Func>(func));
+	job->m_invokeFunction = [](void* storage) { (*static_cast<Callable*>(storage))(); };
+	job->m_destroyFunction = [](void* storage) { static_cast<Callable*>(storage)->~Callable(); };
+	job->m_jobFlag = jobFlag;
+	job->m_needsRetrieval = needsRetrieval;
+	return job;
+}
+
+///---------------------------------------------------------------------------------------------------------------------------------
+/// Helpers that create and queue the job in one go
+///
+template<typename Func>
+LambdaJob* AddLambdaJob(JobSystem* system, Func&& func, unsigned int jobFlag = 0)
+{
+	LambdaJob* job = LambdaJob::Create(std::forward<Func>(func), jobFlag, true);
+	system->AddJobIntoDeque(job);
+	return job;
+}
+
+// The job is recycled as soon as it is done, nothing to retrieve and no pointer handed back
+template<typename Func>
+void AddFireAndForgetJob(JobSystem* system, Func&& func, unsigned int jobFlag = 0)
+{
+	system->AddJobIntoDeque(LambdaJob::Create(std::forward<Func>(func), jobFlag, false));
+}
@@ -1,15 +1,44 @@
 ﻿#include "Engine/Core/NamedProperties.hpp"
 
+NamedProperties::NamedProperties()
+{
+}
+
+NamedProperties::NamedProperties(NamedProperties const& copyFrom)
+{
+	CopyFrom(copyFrom);
+}
+
+NamedProperties::NamedProperties(NamedProperties&& moveFrom)
+{
+	MoveFrom(moveFrom);
+}
+
 NamedProperties::~NamedProperties()
 {
-	for (auto it = m_keyValuePairs.begin(); it != m_keyValuePairs.end(); ++it)
+	Clear();
+	ReleaseStorage();
+}
+
+NamedProperties& NamedProperties::operator=(NamedProperties const& copyFrom)
+{
+	if (this != &copyFrom)
 	{
-		if (it->second != nullptr)
-		{
-			delete it->second;
-			it->second = nullptr;
-		}
+		Clear();
+		CopyFrom(copyFrom);
 	}
+	return *this;
+}
+
+NamedProperties& NamedProperties::operator=(NamedProperties&& moveFrom)
+{
+	if (this != &moveFrom)
+	{
+		Clear();
+		ReleaseStorage();
+		MoveFrom(moveFrom);
+	}
+	return *this;
 }
 
 void NamedProperties::SetValue(std::string const& keyName, const char* value)
@@ -26,7 +55,7 @@ void NamedProperties::PopulateFromXmlElementAttributes(XmlElement const& element
 {
 	const XmlAttribute* attribute = element.FirstAttribute();
 
-	m_keyValuePairs.clear();
+	Clear();
 
 	while (attribute != nullptr)
 	{
@@ -36,7 +65,136 @@ void NamedProperties::PopulateFromXmlElementAttributes(XmlElement const& element
 
 }
 
-NamedPropertiesValueBase::~NamedPropertiesValueBase()
+void NamedProperties::Clear()
+{
+	for (int propertyIndex = 0; propertyIndex < m_numProperties; ++propertyIndex)
+	{
+		m_values[propertyIndex].m_typeId->m_destroy(m_values[propertyIndex].m_storage);
+	}
+	m_numProperties = 0;
+}
+
+// Boxed values are moved by pointer, so this never allocates unless one side has spilled to the heap
+void NamedProperties::Swap(NamedProperties& other)
+{
+	NamedProperties temp(std::move(other));
+	other = std::move(*this);
+	*this = std::move(temp);
+}
+
+int NamedProperties::FindPropertyIndex(unsigned int keyHash) const
+{
+	for (int propertyIndex = 0; propertyIndex < m_numProperties; ++propertyIndex)
+	{
+		if (m_keyHashes[propertyIndex] == keyHash)
+		{
+			return propertyIndex;
+		}
+	}
+	return -1;
+}
+
+void NamedProperties::StoreValue(unsigned int keyHash, NamedPropertyValue& newValue)
+{
+	int propertyIndex = FindPropertyIndex(keyHash);
+	if (propertyIndex >= 0)
+	{
+		NamedPropertyValue& oldValue = m_values[propertyIndex];
+		oldValue.m_typeId->m_destroy(oldValue.m_storage);
+	}
+	else
+	{
+		if (m_numProperties == m_capacity)
+		{
+			Reserve(m_capacity * 2);
+		}
+
+		propertyIndex = m_numProperties++;
+		m_keyHashes[propertyIndex] = keyHash;
+	}
+
+	NamedPropertyValue& propertyValue = m_values[propertyIndex];
+	newValue.m_typeId->m_moveConstruct(propertyValue.m_storage, newValue.m_storage);
+	propertyValue.m_typeId = newValue.m_typeId;
+	newValue.m_typeId->m_destroy(newValue.m_storage);
+	newValue.m_typeId = nullptr;
+}
+
+void NamedProperties::Reserve(int capacity)
 {
+	if (capacity <= m_capacity)
+	{
+		return;
+	}
 
+	unsigned int* keyHashes = new unsigned int[capacity];
+	NamedPropertyValue* values = new NamedPropertyValue[capacity];
+	for (int propertyIndex = 0; propertyIndex < m_numProperties; ++propertyIndex)
+	{
+		NamedPropertyValue& oldValue = m_values[propertyIndex];
+		keyHashes[propertyIndex] = m_keyHashes[propertyIndex];
+		oldValue.m_typeId->m_moveConstruct(values[propertyIndex].m_storage, oldValue.m_storage);
+		values[propertyIndex].m_typeId = oldValue.m_typeId;
+		oldValue.m_typeId->m_destroy(oldValue.m_storage);
+	}
+
+	ReleaseStorage();
+	m_keyHashes = keyHashes;
+	m_values = values;
+	m_capacity = capacity;
+}
+
+void NamedProperties::CopyFrom(NamedProperties const& copyFrom)
+{
+	Reserve(copyFrom.m_numProperties);
+	for (int propertyIndex = 0; propertyIndex < copyFrom.m_numProperties; ++propertyIndex)
+	{
+		NamedPropertyValue const& sourceValue = copyFrom.m_values[propertyIndex];
+		m_keyHashes[propertyIndex] = copyFrom.m_keyHashes[propertyIndex];
+		sourceValue.m_typeId->m_copyConstruct(m_values[propertyIndex].m_storage, sourceValue.m_storage);
+		m_values[propertyIndex].m_typeId = sourceValue.m_typeId;
+
+		// Counted one at a time so a copy that throws leaves only fully built values behind
+		m_numProperties = propertyIndex + 1;
+	}
+}
+
+void NamedProperties::MoveFrom(NamedProperties& moveFrom)
+{
+	if (moveFrom.m_keyHashes != moveFrom.m_inlineKeyHashes)
+	{
+		// Heap storage just changes owner
+		m_keyHashes = moveFrom.m_keyHashes;
+		m_values = moveFrom.m_values;
+		m_numProperties = moveFrom.m_numProperties;
+		m_capacity = moveFrom.m_capacity;
+
+		moveFrom.m_keyHashes = moveFrom.m_inlineKeyHashes;
+		moveFrom.m_values = moveFrom.m_inlineValues;
+		moveFrom.m_numProperties = 0;
+		moveFrom.m_capacity = NAMED_PROPERTIES_INLINE_CAPACITY;
+		return;
+	}
+
+	for (int propertyIndex = 0; propertyIndex < moveFrom.m_numProperties; ++propertyIndex)
+	{
+		NamedPropertyValue& sourceValue = moveFrom.m_values[propertyIndex];
+		m_keyHashes[propertyIndex] = moveFrom.m_keyHashes[propertyIndex];
+		sourceValue.m_typeId->m_moveConstruct(m_values[propertyIndex].m_storage, sourceValue.m_storage);
+		m_values[propertyIndex].m_typeId = sourceValue.m_typeId;
+	}
+	m_numProperties = moveFrom.m_numProperties;
+	moveFrom.Clear();
+}
+
+void NamedProperties::ReleaseStorage()
+{
+	if (m_keyHashes != m_inlineKeyHashes)
+	{
+		delete[] m_keyHashes;
+		delete[] m_values;
+		m_keyHashes = m_inlineKeyHashes;
+		m_values = m_inlineValues;
+		m_capacity = NAMED_PROPERTIES_INLINE_CAPACITY;
+	}
 }
@@ -2,7 +2,9 @@
 #include "Engine/Core/EngineCommon.hpp"
 #include "Engine/Core/HashedCaseInsensitiveString.hpp"
 #include "Engine/Math/Vec2.hpp"
-#include <map>
+#include <new>
+#include <stdexcept>
+#include <utility>
 #include <type_traits>
 #include "Engine/Core/XmlUtils.hpp"
 
@@ -23,29 +25,112 @@ public:
 	static constexpr bool isValid() { return sizeof(test<T>(0)) == sizeof(yes);}
 };
 
-struct NamedPropertiesValueBase
+constexpr int		NAMED_PROPERTIES_INLINE_CAPACITY = 8;			// Properties stored without any heap allocation
+constexpr size_t	NAMED_PROPERTY_INLINE_VALUE_SIZE = 16;			// Values up to this size live in the property itself
+constexpr size_t	NAMED_PROPERTY_INLINE_VALUE_ALIGNMENT = 8;
+
+//-----------------------------------------------------------------------------------
+// One of these exists per stored type and its address doubles as the type id, so type checks are
+// a pointer compare instead of a dynamic_cast. It is deliberately not const: the linker may fold
+// identical read-only data (/OPT:ICF), which would give two types the same id. Small values are
+// constructed in place, anything bigger is boxed and the storage holds the pointer.
+//
+struct NamedPropertyTypeInfo
 {
-	virtual ~NamedPropertiesValueBase();
+	void (*m_copyConstruct)(void* destStorage, void const* sourceStorage);
+	void (*m_moveConstruct)(void* destStorage, void* sourceStorage);		// The source still has to be destroyed
+	void (*m_destroy)(void* storage);
+};
+
+typedef NamedPropertyTypeInfo const* NamedPropertyTypeId;
 
-	virtual void SignalForAbstractClass() {};
+struct NamedPropertyValue
+{
+	NamedPropertyTypeId		m_typeId = nullptr;
+	alignas(NAMED_PROPERTY_INLINE_VALUE_ALIGNMENT) unsigned char m_storage[NAMED_PROPERTY_INLINE_VALUE_SIZE];
 };
 
 template<typename T>
-struct NamedPropertiesValue : NamedPropertiesValueBase 
+struct NamedPropertyType
 {
-	NamedPropertiesValue(T const& value) : m_value(value) {};
-	virtual ~NamedPropertiesValue() {};
+	static constexpr bool IS_INLINE = sizeof(T) <= NAMED_PROPERTY_INLINE_VALUE_SIZE && alignof(T) <= NAMED_PROPERTY_INLINE_VALUE_ALIGNMENT;
+
+	static void Construct(void* storage, T const& value)
+	{
+		if constexpr (IS_INLINE)
+		{
+			new (storage) T(value);
+		}
+		else
+		{
+			*static_cast<T**>(storage) = new T(value);
+		}
+	}
+
+	static void CopyConstruct(void* destStorage, void const* sourceStorage)
+	{
+		Construct(destStorage, *Get(sourceStorage));
+	}
+
+	static void MoveConstruct(void* destStorage, void* sourceStorage)
+	{
+		if constexpr (IS_INLINE)
+		{
+			new (destStorage) T(std::move(*static_cast<T*>(sourceStorage)));
+		}
+		else
+		{
+			// Boxed values just change owner, destroying the source afterwards deletes nullptr
+			*static_cast<T**>(destStorage) = *static_cast<T**>(sourceStorage);
+			*static_cast<T**>(sourceStorage) = nullptr;
+		}
+	}
+
+	static void Destroy(void* storage)
+	{
+		if constexpr (IS_INLINE)
+		{
+			static_cast<T*>(storage)->~T();
+		}
+		else
+		{
+			delete *static_cast<T**>(storage);
+		}
+	}
 
-	T m_value;
+	static T const* Get(void const* storage)
+	{
+		if constexpr (IS_INLINE)
+		{
+			return static_cast<T const*>(storage);
+		}
+		else
+		{
+			return *static_cast<T* const*>(storage);
+		}
+	}
+
+	static inline NamedPropertyTypeInfo TYPE_INFO = { &CopyConstruct, &MoveConstruct, &Destroy };
+	static NamedPropertyTypeId GetTypeId() { return &TYPE_INFO; }
 };
 
 
+//-----------------------------------------------------------------------------------
+// Flat property bag. Keys are the case insensitive hashes of the names, kept in their own packed
+// array so a lookup is a linear scan over a few cache lines. The first NAMED_PROPERTIES_INLINE_CAPACITY
+// properties need no allocation at all, past that both arrays move to the heap.
+//
 class NamedProperties 
 {
 public:
-	NamedProperties() = default;
+	NamedProperties();
+	NamedProperties(NamedProperties const& copyFrom);
+	NamedProperties(NamedProperties&& moveFrom);
 	virtual ~NamedProperties();
 
+	NamedProperties& operator=(NamedProperties const& copyFrom);
+	NamedProperties& operator=(NamedProperties&& moveFrom);
+
 	template<typename T> 
 	void 	SetValue(std::string const& keyName, T const& value);
 	template<typename T>
@@ -61,153 +146,123 @@ public:
 	std::string GetValue(std::string const& keyName, std::string const& defaultValue) const;
 
 	void			PopulateFromXmlElementAttributes(XmlElement const& element);
-public:
-	std::map<HashedCaseInsensitiveString,NamedPropertiesValueBase*> m_keyValuePairs;
+
+	void			Clear();
+	void			Swap(NamedProperties& other);
+	int				GetNumProperties() const { return m_numProperties; }
+
+private:
+	template<typename T>
+	void	SetValueByHash(unsigned int keyHash, T const& value);
+	template<typename T>
+	T		GetValueByHash(unsigned int keyHash, T const& defaultValue) const;
+	template<typename T>
+	static T ParseValueFromText(std::string const& text, T const& defaultValue);
+
+	int					FindPropertyIndex(unsigned int keyHash) const;
+	void				StoreValue(unsigned int keyHash, NamedPropertyValue& newValue);	// Takes over newValue, destroys any previous value under that key
+	void				Reserve(int capacity);
+	void				CopyFrom(NamedProperties const& copyFrom);
+	void				MoveFrom(NamedProperties& moveFrom);
+	void				ReleaseStorage();
+
+private:
+	unsigned int*		m_keyHashes = m_inlineKeyHashes;
+	NamedPropertyValue*	m_values = m_inlineValues;
+	int					m_numProperties = 0;
+	int					m_capacity = NAMED_PROPERTIES_INLINE_CAPACITY;
+
+	unsigned int		m_inlineKeyHashes[NAMED_PROPERTIES_INLINE_CAPACITY];
+	NamedPropertyValue	m_inlineValues[NAMED_PROPERTIES_INLINE_CAPACITY];
 };
 
 template<typename T>
 void NamedProperties::SetValue(std::string const& keyName, T const& value)
 {
-	HashedCaseInsensitiveString hcis = HashedCaseInsensitiveString(keyName);
-
-	auto it = m_keyValuePairs.find(hcis);
-	if (it != m_keyValuePairs.end())
-	{
-		delete it->second;
-		m_keyValuePairs.erase(it);
-	}
-
-	m_keyValuePairs[hcis] = new NamedPropertiesValue<T>(value);
+	SetValueByHash(HashedCaseInsensitiveString::GetHashCode(keyName), value);
 }
 
 template<typename T>
 void NamedProperties::SetValue(HashedCaseInsensitiveString const& keyName, T const& value)
 {
-	auto it = m_keyValuePairs.find(keyName);
-	if (it != m_keyValuePairs.end())
-	{
-		delete it->second;
-		m_keyValuePairs.erase(it);
-	}
+	SetValueByHash(keyName.GetHash(), value);
+}
 
-	m_keyValuePairs[keyName] = new NamedPropertiesValue<T>(value);
+template<typename T>
+T NamedProperties::GetValue(HashedCaseInsensitiveString const& keyName, T const& defaultValue) const
+{
+	return GetValueByHash(keyName.GetHash(), defaultValue);
+}
 
+template<typename T>
+T NamedProperties::GetValue(std::string const& keyName, T const& defaultValue) const
+{
+	return GetValueByHash(HashedCaseInsensitiveString::GetHashCode(keyName), defaultValue);
 }
 
 template<typename T>
-T NamedProperties::GetValue(HashedCaseInsensitiveString const& keyName, T const& defaultValue) const
+void NamedProperties::SetValueByHash(unsigned int keyHash, T const& value)
 {
-	auto it = m_keyValuePairs.find(keyName);
+	// Built on the side first so a constructor that throws leaves every property as it was
+	NamedPropertyValue newValue;
+	NamedPropertyType<T>::Construct(newValue.m_storage, value);
+	newValue.m_typeId = NamedPropertyType<T>::GetTypeId();
+	StoreValue(keyHash, newValue);
+}
 
-	if (it == m_keyValuePairs.end())
+template<typename T>
+T NamedProperties::GetValueByHash(unsigned int keyHash, T const& defaultValue) const
+{
+	int propertyIndex = FindPropertyIndex(keyHash);
+	if (propertyIndex < 0)
 	{
 		return defaultValue;
 	}
 
-	NamedPropertiesValue<T>* valuePtr = dynamic_cast<NamedPropertiesValue<T>*>(it->second);
-
-	if (valuePtr)
+	NamedPropertyValue const& propertyValue = m_values[propertyIndex];
+	if (propertyValue.m_typeId == NamedPropertyType<T>::GetTypeId())
 	{
-		return valuePtr->m_value;
+		return *NamedPropertyType<T>::Get(propertyValue.m_storage);
 	}
 
-	NamedPropertiesValue<std::string>* stringValueType = dynamic_cast<NamedPropertiesValue<std::string>*>(it->second);
-
-	if (stringValueType)
+	// Values that came in as text (console commands, xml) are parsed on request
+	if (propertyValue.m_typeId == NamedPropertyType<std::string>::GetTypeId())
 	{
-		std::string value = stringValueType->m_value;
-
-		if constexpr (std::is_same_v<T, bool>)
-		{
-			if (ToLower(value) == "true")
-				return true;
-			else if (ToLower(value) == "false")
-				return false;
-			else
-				throw std::runtime_error("Invalid boolean text");
-		}
-		else if constexpr (std::is_integral_v<T>)
-		{
-			return atoi(value.c_str());
-		}
-		else if constexpr (std::is_floating_point_v<T>)
-		{
-			return (float)atof(value.c_str());
-		}
-		else if constexpr (Check_Set_From_Text<T>::isValid())
-		{
-			T typeValue;
-			typeValue.SetFromText(value.c_str());
-			return typeValue;
-		}
-		else
-		{
-			return defaultValue;
-		}
-	}
-	else
-	{
-		return defaultValue;
+		return ParseValueFromText(*NamedPropertyType<std::string>::Get(propertyValue.m_storage), defaultValue);
 	}
 
+	return defaultValue;
 }
 
 template<typename T>
-T NamedProperties::GetValue(std::string const& keyName, T const& defaultValue) const
+T NamedProperties::ParseValueFromText(std::string const& value, T const& defaultValue)
 {
-	HashedCaseInsensitiveString hcis = HashedCaseInsensitiveString(keyName);
-
-	auto it = m_keyValuePairs.find(hcis);
-
-	if (it == m_keyValuePairs.end())
+	if constexpr (std::is_same_v<T, bool>)
 	{
-		return defaultValue;
+		if (ToLower(value) == "true")
+			return true;
+		else if (ToLower(value) == "false")
+			return false;
+		else
+			throw std::runtime_error("Invalid boolean text");
 	}
-
-	NamedPropertiesValue<T>* valuePtr = dynamic_cast<NamedPropertiesValue<T>*>(it->second);
-
-	if (valuePtr)
+	else if constexpr (std::is_integral_v<T>)
 	{
-		return valuePtr->m_value;
+		return (T)atoi(value.c_str());
 	}
-
-	NamedPropertiesValue<std::string>* stringValueType = dynamic_cast<NamedPropertiesValue<std::string>*>(it->second);
-
-	if (stringValueType)
+	else if constexpr (std::is_floating_point_v<T>)
 	{
-		std::string value = stringValueType->m_value;
-		
-		if constexpr (std::is_same_v<T, bool>)
-		{
-			if (ToLower(value) == "true")
-				return true;
-			else if (ToLower(value) == "false")
-				return false;
-			else
-				throw std::runtime_error("Invalid boolean text");
-		}
-		else if constexpr(std::is_integral_v<T>)
-		{
-			return atoi(value.c_str());
-		}
-		else if constexpr(std::is_floating_point_v<T>)
-		{
-			return (float)atof(value.c_str());
-		}
-		else if constexpr(Check_Set_From_Text<T>::isValid())
-		{
-			T typeValue;
-			typeValue.SetFromText(value.c_str());
-			return typeValue;
-		}
-		else 
-		{
-			return defaultValue;
-		}
+		return (T)atof(value.c_str());
+	}
+	else if constexpr (Check_Set_From_Text<T>::isValid())
+	{
+		T typeValue;
+		typeValue.SetFromText(value.c_str());
+		return typeValue;
 	}
 	else
 	{
+		UNUSED(value);
 		return defaultValue;
 	}
-
 }
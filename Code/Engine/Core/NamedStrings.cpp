@@ -164,10 +164,11 @@ EulerAngles NamedStrings::GetValue(std::string const& keyName, EulerAngles const
 	else
 	{
 		EulerAngles value = EulerAngles();
-		Strings strings = SplitStringOnDelimiter((iter->second).c_str(), ',');
-		value.m_yawDegrees = (float)atof(strings[0].c_str());
-		value.m_pitchDegrees = (float)atof(strings[1].c_str());
-		value.m_rollDegrees = (float)atof(strings[2].c_str());
+		std::string_view strings[3];
+		SplitStringViewOnDelimiter(iter->second, ',', strings, 3);
+		value.m_yawDegrees = ParseFloatFromText(strings[0]);
+		value.m_pitchDegrees = ParseFloatFromText(strings[1]);
+		value.m_rollDegrees = ParseFloatFromText(strings[2]);
 		return value;
 	}
 
@@ -183,9 +184,10 @@ FloatRange NamedStrings::GetValue(std::string const& keyName, FloatRange const&
 	else
 	{
 		FloatRange value = FloatRange();
-		Strings strings = SplitStringOnDelimiter((iter->second).c_str(), '~');
-		value.m_min = (float)atof(strings[0].c_str());
-		value.m_max = (float)atof(strings[1].c_str());
+		std::string_view strings[2];
+		SplitStringViewOnDelimiter(iter->second, '~', strings, 2);
+		value.m_min = ParseFloatFromText(strings[0]);
+		value.m_max = ParseFloatFromText(strings[1]);
 		return value;
 	}
 
@@ -0,0 +1,874 @@
+#include "Engine/Core/NetChannel.hpp"
+#include "Engine/Core/BufferWriter.hpp"
+#include "Engine/Core/BufferParser.hpp"
+#include "Engine/Core/Serialization.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Math/Vec3.hpp"
+#include "Engine/Core/Rgba8.hpp"
+#include <algorithm>
+
+constexpr uint8_t	NET_PACKET_HAS_ACKS = 1 << 0;
+constexpr uint8_t	NET_PACKET_HAS_SNAPSHOT = 1 << 1;
+constexpr uint8_t	NET_PACKET_HAS_BASELINE = 1 << 2;
+
+constexpr size_t	NET_PACKET_HEADER_SIZE = sizeof(uint16_t) * 3 + sizeof(uint32_t) + sizeof(uint8_t);		// Protocol, sequence, ack, ack bits, flags
+constexpr size_t	NET_PACKET_MESSAGE_COUNTS_SIZE = sizeof(uint16_t) * 2;									// Reliable and unreliable counts, always there
+constexpr size_t	NET_SNAPSHOT_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint16_t) * 2 + sizeof(uint32_t) * 2;	// Flags, id, baseline id, full size, encoded size
+constexpr size_t	NET_RELIABLE_MESSAGE_HEADER_SIZE = sizeof(uint16_t) * 2;								// Id, size
+constexpr size_t	NET_UNRELIABLE_MESSAGE_HEADER_SIZE = sizeof(uint16_t);
+
+// True when a comes after b, allowing for wrap around
+static bool IsSequenceNewer(uint16_t a, uint16_t b)
+{
+	return a != b && (uint16_t)(a - b) < 0x8000;
+}
+
+// Packets come from the network, every read is checked first instead of dying in the parser
+template<typename T>
+static bool TryParse(BufferParser& parser, T& outValue)
+{
+	if (parser.GetRemainingSize() < sizeof(T))
+	{
+		return false;
+	}
+	parser.ParseArray(&outValue, 1);
+	return true;
+}
+
+static bool TryParseBytes(BufferParser& parser, NetMessage& outBytes, size_t numBytes)
+{
+	if (parser.GetRemainingSize() < numBytes)
+	{
+		return false;
+	}
+	outBytes.resize(numBytes);
+	if (numBytes > 0)
+	{
+		parser.ParseByteArray(outBytes.data(), numBytes);
+	}
+	return true;
+}
+
+static void AppendVarint(BufferWriter& writer, size_t value)
+{
+	while (value >= 0x80)
+	{
+		writer.AppendPrimitive<uint8_t>((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	writer.AppendPrimitive<uint8_t>((uint8_t)value);
+}
+
+static bool TryParseVarint(BufferParser& parser, size_t& outValue)
+{
+	outValue = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		uint8_t byte = 0;
+		if (!TryParse(parser, byte))
+		{
+			return false;
+		}
+		outValue |= (size_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//-----------------------------------------------------------------------------------
+// A snapshot is XORed with its baseline, bytes past the end of the baseline against zero, so
+// whatever did not change becomes zero runs. The result is written as (zero run, literal run,
+// literal bytes) triples. Against no baseline the same encoding just squeezes out zeros.
+//
+static void EncodeSnapshotDelta(BufferWriter& writer, NetMessage const* baseline, NetMessage const& snapshot)
+{
+	size_t snapshotSize = snapshot.size();
+	NetMessage delta(snapshot);
+	if (baseline)
+	{
+		size_t numOverlappingBytes = std::min(snapshotSize, baseline->size());
+		for (size_t byteIndex = 0; byteIndex < numOverlappingBytes; ++byteIndex)
+		{
+			delta[byteIndex] ^= (*baseline)[byteIndex];
+		}
+	}
+
+	size_t position = 0;
+	while (position < snapshotSize)
+	{
+		size_t zeroStart = position;
+		while (position < snapshotSize && delta[position] == 0)
+		{
+			position++;
+		}
+
+		// A lone zero stays in the literal run, a new triple would cost more than it saves
+		size_t literalStart = position;
+		while (position < snapshotSize && !(delta[position] == 0 && (position + 1 == snapshotSize || delta[position + 1] == 0)))
+		{
+			position++;
+		}
+
+		AppendVarint(writer, literalStart - zeroStart);
+		AppendVarint(writer, position - literalStart);
+		writer.AppendByteArray(delta.data() + literalStart, position - literalStart);
+	}
+}
+
+// Worst case of EncodeSnapshotDelta whatever the baseline. Past the first triple every zero run is
+// at least two zeros long, which pays for its varints but for a byte per 128 bytes of run, and a
+// literal run costs a byte per 128 literals on top of them. A lone trailing zero costs one more.
+static size_t GetMaxEncodedSnapshotSize(size_t snapshotSize)
+{
+	return snapshotSize + snapshotSize / 64 + 4;
+}
+
+static bool DecodeSnapshotDelta(BufferParser& parser, NetMessage const* baseline, size_t snapshotSize, NetMessage& outSnapshot)
+{
+	if (baseline)
+	{
+		outSnapshot.assign(baseline->begin(), baseline->begin() + std::min(baseline->size(), snapshotSize));
+	}
+	outSnapshot.resize(snapshotSize, 0);
+
+	size_t position = 0;
+	while (position < snapshotSize)
+	{
+		size_t numZeros = 0;
+		size_t numLiterals = 0;
+		if (!TryParseVarint(parser, numZeros) || !TryParseVarint(parser, numLiterals))
+		{
+			return false;
+		}
+		if (numZeros > snapshotSize - position || numLiterals > snapshotSize - position - numZeros || numLiterals > parser.GetRemainingSize())
+		{
+			return false;
+		}
+		if (numZeros + numLiterals == 0)
+		{
+			return false;
+		}
+
+		position += numZeros;
+		for (size_t literalIndex = 0; literalIndex < numLiterals; ++literalIndex)
+		{
+			outSnapshot[position++] ^= parser.ParseByte();
+		}
+	}
+	return true;
+}
+
+// -----------------------------CHANNEL----------------------------------
+NetChannel::NetChannel(NetChannelConfig const& config)
+	:m_config(config)
+{
+	GUARANTEE_OR_DIE(m_config.m_maxPacketSize >= NET_CHANNEL_MIN_PACKET_SIZE && m_config.m_maxPacketSize <= NET_CHANNEL_MAX_PACKET_SIZE,
+		Stringf("Net channel packet size of %zu bytes is not in [%zu, %zu]", m_config.m_maxPacketSize, NET_CHANNEL_MIN_PACKET_SIZE, NET_CHANNEL_MAX_PACKET_SIZE));
+	m_sentPackets.resize(NET_CHANNEL_PACKET_WINDOW);
+	m_sentSnapshots.resize(NET_CHANNEL_SNAPSHOT_WINDOW);
+	m_receivedSnapshots.resize(NET_CHANNEL_SNAPSHOT_WINDOW);
+	m_reliableIncoming.resize(NET_CHANNEL_RELIABLE_WINDOW);
+	m_isReliableReceived.resize(NET_CHANNEL_RELIABLE_WINDOW, false);
+}
+
+bool NetChannel::SendUnreliable(NetMessage&& payload)
+{
+	if (payload.size() > GetMaxMessageSize())
+	{
+		return false;
+	}
+	m_unreliableOutgoing.push_back(std::move(payload));
+	return true;
+}
+
+bool NetChannel::SendReliable(NetMessage&& payload)
+{
+	if (payload.size() > GetMaxMessageSize())
+	{
+		return false;
+	}
+	m_reliableOutgoing.emplace_back();
+	m_reliableOutgoing.back().m_id = m_nextReliableId++;
+	m_reliableOutgoing.back().m_payload = std::move(payload);
+	return true;
+}
+
+bool NetChannel::SetSnapshot(NetMessage const& snapshot)
+{
+	if (snapshot.size() > GetMaxSnapshotSize())
+	{
+		return false;
+	}
+	m_pendingSnapshot = snapshot;
+	m_isSnapshotPending = true;
+	return true;
+}
+
+size_t NetChannel::GetMaxMessageSize() const
+{
+	return m_config.m_maxPacketSize - NET_PACKET_HEADER_SIZE - NET_PACKET_MESSAGE_COUNTS_SIZE - NET_RELIABLE_MESSAGE_HEADER_SIZE;
+}
+
+size_t NetChannel::GetMaxSnapshotSize() const
+{
+	size_t maxEncodedSize = m_config.m_maxPacketSize - NET_PACKET_HEADER_SIZE - NET_PACKET_MESSAGE_COUNTS_SIZE - NET_SNAPSHOT_HEADER_SIZE;
+	size_t maxSnapshotSize = maxEncodedSize - maxEncodedSize / 65;
+	while (GetMaxEncodedSnapshotSize(maxSnapshotSize) > maxEncodedSize)
+	{
+		maxSnapshotSize--;
+	}
+	return maxSnapshotSize;
+}
+
+void NetChannel::WritePacket(NetMessage& outPacket, double currentSeconds)
+{
+	outPacket.clear();
+	BufferWriter writer(outPacket, eBufferEndian::LITTLE);
+	writer.Reserve(m_config.m_maxPacketSize);
+
+	uint16_t sequence = m_nextSequence++;
+	SentPacket& sentPacket = m_sentPackets[sequence % NET_CHANNEL_PACKET_WINDOW];
+	if (sentPacket.m_isUsed && !sentPacket.m_isAcked)
+	{
+		m_stats.m_numPacketsLost++;
+	}
+	sentPacket.m_sequence = sequence;
+	sentPacket.m_isUsed = true;
+	sentPacket.m_isAcked = false;
+	sentPacket.m_hasSnapshot = false;
+	sentPacket.m_sentSeconds = currentSeconds;
+	sentPacket.m_reliableIds.clear();
+
+	// The snapshot always fits alone, but when it leaves no room for the oldest reliable message due
+	// it sits out every other packet so a snapshot every tick cannot starve reliable messages
+	NetMessage const* baseline = nullptr;
+	NetMessage encodedSnapshot;
+	bool isSnapshotInPacket = false;
+	if (m_isSnapshotPending)
+	{
+		baseline = GetSnapshotBaseline();
+		BufferWriter snapshotWriter(encodedSnapshot, eBufferEndian::LITTLE);
+		snapshotWriter.Reserve(m_pendingSnapshot.size() / 4);
+		EncodeSnapshotDelta(snapshotWriter, baseline, m_pendingSnapshot);
+
+		size_t packetSizeWithSnapshot = NET_PACKET_HEADER_SIZE + NET_PACKET_MESSAGE_COUNTS_SIZE + NET_SNAPSHOT_HEADER_SIZE + encodedSnapshot.size();
+		isSnapshotInPacket = !m_wasSnapshotInLastPacket || packetSizeWithSnapshot + GetNextReliableMessageSize(currentSeconds) <= m_config.m_maxPacketSize;
+		if (!isSnapshotInPacket)
+		{
+			m_stats.m_numSnapshotsDeferred++;
+		}
+	}
+	m_wasSnapshotInLastPacket = isSnapshotInPacket;
+
+	uint8_t flags = 0;
+	if (m_hasReceivedPacket)
+	{
+		flags |= NET_PACKET_HAS_ACKS;
+	}
+	if (isSnapshotInPacket)
+	{
+		flags |= NET_PACKET_HAS_SNAPSHOT;
+	}
+
+	writer.AppendPrimitive<uint16_t>(NET_CHANNEL_PROTOCOL_ID);
+	writer.AppendPrimitive<uint16_t>(sequence);
+	writer.AppendPrimitive<uint16_t>(m_remoteSequence);
+	writer.AppendPrimitive<uint32_t>(m_receivedBits);
+	writer.AppendPrimitive<uint8_t>(flags);
+
+	if (isSnapshotInPacket)
+	{
+		WriteSnapshot(writer, sentPacket, baseline, encodedSnapshot);
+	}
+
+	size_t packetSize = writer.GetBufferSize() + NET_PACKET_MESSAGE_COUNTS_SIZE;
+	WriteReliableMessages(writer, sentPacket, packetSize, currentSeconds);
+	WriteUnreliableMessages(writer, packetSize);
+
+	m_stats.m_numPacketsSent++;
+	m_stats.m_numBytesSent += outPacket.size();
+}
+
+// The baseline has to be one the peer still remembers, so no further back than its window
+NetMessage const* NetChannel::GetSnapshotBaseline() const
+{
+	SnapshotSlot const& baselineSlot = m_sentSnapshots[m_ackedSnapshotId % NET_CHANNEL_SNAPSHOT_WINDOW];
+	if (m_hasAckedSnapshot && (uint16_t)(m_nextSnapshotId - m_ackedSnapshotId) < NET_CHANNEL_SNAPSHOT_WINDOW && baselineSlot.m_isValid && baselineSlot.m_id == m_ackedSnapshotId)
+	{
+		return &baselineSlot.m_snapshot;
+	}
+	return nullptr;
+}
+
+void NetChannel::WriteSnapshot(BufferWriter& writer, SentPacket& sentPacket, NetMessage const* baseline, NetMessage const& encodedSnapshot)
+{
+	uint16_t snapshotId = m_nextSnapshotId++;
+
+	writer.AppendPrimitive<uint8_t>(baseline ? NET_PACKET_HAS_BASELINE : 0);
+	writer.AppendPrimitive<uint16_t>(snapshotId);
+	writer.AppendPrimitive<uint16_t>(m_ackedSnapshotId);
+	writer.AppendPrimitive<uint32_t>((uint32_t)m_pendingSnapshot.size());
+	writer.AppendPrimitive<uint32_t>((uint32_t)encodedSnapshot.size());
+	writer.AppendByteArray(encodedSnapshot.data(), encodedSnapshot.size());
+
+	m_stats.m_numSnapshotBytesSent += encodedSnapshot.size();
+	m_stats.m_numSnapshotFullBytes += m_pendingSnapshot.size();
+
+	SnapshotSlot& sentSlot = m_sentSnapshots[snapshotId % NET_CHANNEL_SNAPSHOT_WINDOW];
+	sentSlot.m_id = snapshotId;
+	sentSlot.m_isValid = true;
+	sentSlot.m_snapshot.swap(m_pendingSnapshot);
+	m_pendingSnapshot.clear();
+	m_isSnapshotPending = false;
+
+	sentPacket.m_hasSnapshot = true;
+	sentPacket.m_snapshotId = snapshotId;
+}
+
+bool NetChannel::IsReliableMessageDue(ReliableMessage const& message, double currentSeconds) const
+{
+	double resendSeconds = std::max(m_config.m_reliableResendSeconds, m_stats.m_roundTripSeconds * 1.25);
+	return !message.m_isAcked && (message.m_lastSentSeconds < 0.0 || currentSeconds - message.m_lastSentSeconds >= resendSeconds);
+}
+
+size_t NetChannel::GetNextReliableMessageSize(double currentSeconds) const
+{
+	for (ReliableMessage const& message : m_reliableOutgoing)
+	{
+		if ((uint16_t)(message.m_id - m_reliableOutgoing.front().m_id) >= NET_CHANNEL_RELIABLE_WINDOW)
+		{
+			break;
+		}
+		if (IsReliableMessageDue(message, currentSeconds))
+		{
+			return NET_RELIABLE_MESSAGE_HEADER_SIZE + message.m_payload.size();
+		}
+	}
+	return 0;
+}
+
+void NetChannel::WriteReliableMessages(BufferWriter& writer, SentPacket& sentPacket, size_t& packetSize, double currentSeconds)
+{
+	std::vector<ReliableMessage*> messagesToSend;
+	for (ReliableMessage& message : m_reliableOutgoing)
+	{
+		// The receiver only keeps a window of ids, nothing past it goes out until the front is acked
+		if ((uint16_t)(message.m_id - m_reliableOutgoing.front().m_id) >= NET_CHANNEL_RELIABLE_WINDOW)
+		{
+			break;
+		}
+		if (!IsReliableMessageDue(message, currentSeconds))
+		{
+			continue;
+		}
+
+		size_t messageSize = NET_RELIABLE_MESSAGE_HEADER_SIZE + message.m_payload.size();
+		if (packetSize + messageSize > m_config.m_maxPacketSize)
+		{
+			break;
+		}
+		packetSize += messageSize;
+		messagesToSend.push_back(&message);
+	}
+
+	writer.AppendPrimitive<uint16_t>((uint16_t)messagesToSend.size());
+	for (ReliableMessage* message : messagesToSend)
+	{
+		writer.AppendPrimitive<uint16_t>(message->m_id);
+		writer.AppendPrimitive<uint16_t>((uint16_t)message->m_payload.size());
+		writer.AppendByteArray(message->m_payload.data(), message->m_payload.size());
+
+		if (message->m_lastSentSeconds >= 0.0)
+		{
+			m_stats.m_numReliableResends++;
+		}
+		message->m_lastSentSeconds = currentSeconds;
+		sentPacket.m_reliableIds.push_back(message->m_id);
+	}
+}
+
+void NetChannel::WriteUnreliableMessages(BufferWriter& writer, size_t& packetSize)
+{
+	// Whatever does not fit waits for the next packet
+	size_t numMessagesToSend = 0;
+	for (NetMessage const& message : m_unreliableOutgoing)
+	{
+		size_t messageSize = NET_UNRELIABLE_MESSAGE_HEADER_SIZE + message.size();
+		if (packetSize + messageSize > m_config.m_maxPacketSize)
+		{
+			break;
+		}
+		packetSize += messageSize;
+		numMessagesToSend++;
+	}
+
+	writer.AppendPrimitive<uint16_t>((uint16_t)numMessagesToSend);
+	for (size_t messageIndex = 0; messageIndex < numMessagesToSend; ++messageIndex)
+	{
+		NetMessage const& message = m_unreliableOutgoing[messageIndex];
+		writer.AppendPrimitive<uint16_t>((uint16_t)message.size());
+		writer.AppendByteArray(message.data(), message.size());
+	}
+	m_unreliableOutgoing.erase(m_unreliableOutgoing.begin(), m_unreliableOutgoing.begin() + numMessagesToSend);
+}
+
+bool NetChannel::ReadPacket(void const* data, size_t numBytes, double currentSeconds)
+{
+	BufferParser parser(data, numBytes, eBufferEndian::LITTLE);
+
+	uint16_t protocolId = 0;
+	uint16_t sequence = 0;
+	uint16_t ack = 0;
+	uint32_t ackBits = 0;
+	uint8_t flags = 0;
+	if (!TryParse(parser, protocolId) || !TryParse(parser, sequence) || !TryParse(parser, ack) || !TryParse(parser, ackBits) || !TryParse(parser, flags))
+	{
+		return false;
+	}
+	if (protocolId != NET_CHANNEL_PROTOCOL_ID)
+	{
+		return false;
+	}
+
+	// Duplicates and packets too old to ack are dropped whole
+	if (m_hasReceivedPacket && !IsSequenceNewer(sequence, m_remoteSequence))
+	{
+		uint16_t age = (uint16_t)(m_remoteSequence - sequence);
+		if (age == 0 || age > 32 || (m_receivedBits & (1u << (age - 1))) != 0)
+		{
+			return false;
+		}
+	}
+
+	// Everything is parsed before anything is applied, a packet is acked only when all of it was used
+	uint16_t snapshotId = 0;
+	NetMessage snapshot;
+	if (flags & NET_PACKET_HAS_SNAPSHOT)
+	{
+		uint8_t snapshotFlags = 0;
+		uint16_t baselineId = 0;
+		uint32_t snapshotSize = 0;
+		uint32_t encodedSize = 0;
+		if (!TryParse(parser, snapshotFlags) || !TryParse(parser, snapshotId) || !TryParse(parser, baselineId) || !TryParse(parser, snapshotSize) || !TryParse(parser, encodedSize))
+		{
+			return false;
+		}
+		if (snapshotSize > NET_CHANNEL_MAX_PACKET_SIZE || encodedSize > parser.GetRemainingSize())
+		{
+			return false;
+		}
+
+		NetMessage const* baseline = nullptr;
+		if (snapshotFlags & NET_PACKET_HAS_BASELINE)
+		{
+			SnapshotSlot const& baselineSlot = m_receivedSnapshots[baselineId % NET_CHANNEL_SNAPSHOT_WINDOW];
+			if (!baselineSlot.m_isValid || baselineSlot.m_id != baselineId)
+			{
+				return false;
+			}
+			baseline = &baselineSlot.m_snapshot;
+		}
+
+		BufferParser snapshotParser((unsigned char const*)data + (numBytes - parser.GetRemainingSize()), encodedSize, eBufferEndian::LITTLE);
+		if (!DecodeSnapshotDelta(snapshotParser, baseline, snapshotSize, snapshot) || snapshotParser.GetRemainingSize() != 0)
+		{
+			return false;
+		}
+		parser.SetBufferOffset(numBytes - parser.GetRemainingSize() + encodedSize);		// Skip what the snapshot parser read
+	}
+
+	uint16_t numReliable = 0;
+	if (!TryParse(parser, numReliable))
+	{
+		return false;
+	}
+	std::vector<std::pair<uint16_t, NetMessage>> reliableMessages(numReliable);
+	for (std::pair<uint16_t, NetMessage>& reliableMessage : reliableMessages)
+	{
+		uint16_t messageSize = 0;
+		if (!TryParse(parser, reliableMessage.first) || !TryParse(parser, messageSize) || !TryParseBytes(parser, reliableMessage.second, messageSize))
+		{
+			return false;
+		}
+	}
+
+	uint16_t numUnreliable = 0;
+	if (!TryParse(parser, numUnreliable))
+	{
+		return false;
+	}
+	std::vector<NetMessage> unreliableMessages(numUnreliable);
+	for (NetMessage& unreliableMessage : unreliableMessages)
+	{
+		uint16_t messageSize = 0;
+		if (!TryParse(parser, messageSize) || !TryParseBytes(parser, unreliableMessage, messageSize))
+		{
+			return false;
+		}
+	}
+
+	if (parser.GetRemainingSize() != 0)
+	{
+		return false;
+	}
+
+	// Remember the packet for our acks
+	if (!m_hasReceivedPacket)
+	{
+		m_hasReceivedPacket = true;
+		m_remoteSequence = sequence;
+		m_receivedBits = 0;
+	}
+	else if (IsSequenceNewer(sequence, m_remoteSequence))
+	{
+		uint16_t shift = (uint16_t)(sequence - m_remoteSequence);
+		if (shift < 32)
+		{
+			m_receivedBits = (m_receivedBits << shift) | (1u << (shift - 1));
+		}
+		else
+		{
+			m_receivedBits = shift == 32 ? (1u << 31) : 0;
+		}
+		m_remoteSequence = sequence;
+	}
+	else
+	{
+		m_receivedBits |= 1u << ((uint16_t)(m_remoteSequence - sequence) - 1);
+	}
+	m_stats.m_numPacketsReceived++;
+
+	// A late snapshot never replaces a newer one in its slot, the sender is too far ahead to use it as a baseline anyway
+	SnapshotSlot& snapshotSlot = m_receivedSnapshots[snapshotId % NET_CHANNEL_SNAPSHOT_WINDOW];
+	if ((flags & NET_PACKET_HAS_SNAPSHOT) && !(snapshotSlot.m_isValid && IsSequenceNewer(snapshotSlot.m_id, snapshotId)))
+	{
+		snapshotSlot.m_id = snapshotId;
+		snapshotSlot.m_isValid = true;
+		snapshotSlot.m_snapshot.swap(snapshot);
+
+		if (!m_hasLatestSnapshot || IsSequenceNewer(snapshotId, m_latestSnapshotId))
+		{
+			m_hasLatestSnapshot = true;
+			m_latestSnapshotId = snapshotId;
+			m_isSnapshotAvailable = true;
+		}
+	}
+
+	for (std::pair<uint16_t, NetMessage>& reliableMessage : reliableMessages)
+	{
+		uint16_t distance = (uint16_t)(reliableMessage.first - m_nextExpectedReliableId);
+		int slotIndex = reliableMessage.first % NET_CHANNEL_RELIABLE_WINDOW;
+		if (distance < NET_CHANNEL_RELIABLE_WINDOW && !m_isReliableReceived[slotIndex])
+		{
+			m_reliableIncoming[slotIndex].swap(reliableMessage.second);
+			m_isReliableReceived[slotIndex] = true;
+		}
+	}
+	while (m_isReliableReceived[m_nextExpectedReliableId % NET_CHANNEL_RELIABLE_WINDOW])
+	{
+		int slotIndex = m_nextExpectedReliableId % NET_CHANNEL_RELIABLE_WINDOW;
+		m_reliableDelivered.push_back(std::move(m_reliableIncoming[slotIndex]));
+		m_reliableIncoming[slotIndex].clear();
+		m_isReliableReceived[slotIndex] = false;
+		m_nextExpectedReliableId++;
+	}
+
+	std::move(unreliableMessages.begin(), unreliableMessages.end(), std::back_inserter(m_unreliableDelivered));
+
+	if (flags & NET_PACKET_HAS_ACKS)
+	{
+		OnPacketAcked(ack, currentSeconds);
+		for (uint16_t bitIndex = 0; bitIndex < 32; ++bitIndex)
+		{
+			if (ackBits & (1u << bitIndex))
+			{
+				OnPacketAcked((uint16_t)(ack - 1 - bitIndex), currentSeconds);
+			}
+		}
+	}
+	return true;
+}
+
+void NetChannel::OnPacketAcked(uint16_t sequence, double currentSeconds)
+{
+	SentPacket& sentPacket = m_sentPackets[sequence % NET_CHANNEL_PACKET_WINDOW];
+	if (!sentPacket.m_isUsed || sentPacket.m_sequence != sequence || sentPacket.m_isAcked)
+	{
+		return;
+	}
+	sentPacket.m_isAcked = true;
+	m_stats.m_numPacketsAcked++;
+
+	double roundTripSeconds = currentSeconds - sentPacket.m_sentSeconds;
+	m_stats.m_roundTripSeconds = m_stats.m_numPacketsAcked == 1 ? roundTripSeconds : m_stats.m_roundTripSeconds + 0.1 * (roundTripSeconds - m_stats.m_roundTripSeconds);
+
+	if (sentPacket.m_hasSnapshot && (!m_hasAckedSnapshot || IsSequenceNewer(sentPacket.m_snapshotId, m_ackedSnapshotId)))
+	{
+		m_hasAckedSnapshot = true;
+		m_ackedSnapshotId = sentPacket.m_snapshotId;
+	}
+
+	for (uint16_t reliableId : sentPacket.m_reliableIds)
+	{
+		if (m_reliableOutgoing.empty())
+		{
+			break;
+		}
+		size_t messageIndex = (uint16_t)(reliableId - m_reliableOutgoing.front().m_id);
+		if (messageIndex < m_reliableOutgoing.size())
+		{
+			m_reliableOutgoing[messageIndex].m_isAcked = true;
+		}
+	}
+	while (!m_reliableOutgoing.empty() && m_reliableOutgoing.front().m_isAcked)
+	{
+		m_reliableOutgoing.pop_front();
+	}
+}
+
+void NetChannel::TakeReliableMessages(std::vector<NetMessage>& outMessages)
+{
+	std::move(m_reliableDelivered.begin(), m_reliableDelivered.end(), std::back_inserter(outMessages));
+	m_reliableDelivered.clear();
+}
+
+void NetChannel::TakeUnreliableMessages(std::vector<NetMessage>& outMessages)
+{
+	std::move(m_unreliableDelivered.begin(), m_unreliableDelivered.end(), std::back_inserter(outMessages));
+	m_unreliableDelivered.clear();
+}
+
+bool NetChannel::TakeSnapshot(NetMessage& outSnapshot)
+{
+	if (!m_isSnapshotAvailable)
+	{
+		return false;
+	}
+	outSnapshot = m_receivedSnapshots[m_latestSnapshotId % NET_CHANNEL_SNAPSHOT_WINDOW].m_snapshot;
+	m_isSnapshotAvailable = false;
+	return true;
+}
+
+// -----------------------------LOOPBACK LINK----------------------------------
+NetLoopbackLink::NetLoopbackLink(NetLoopbackLinkConfig const& config)
+	:m_config(config),
+	m_rng(config.m_seed)
+{
+}
+
+void NetLoopbackLink::Send(int toEndpoint, NetMessage const& packet, double currentSeconds)
+{
+	if (m_rng.RollRandomFloatZeroToOne() < m_config.m_lossChance)
+	{
+		return;
+	}
+
+	InFlightPacket inFlightPacket;
+	inFlightPacket.m_deliverSeconds = currentSeconds + m_config.m_latencySeconds + m_config.m_jitterSeconds * (double)m_rng.RollRandomFloatZeroToOne();
+	inFlightPacket.m_toEndpoint = toEndpoint;
+	inFlightPacket.m_packet = packet;
+	m_inFlight.push_back(std::move(inFlightPacket));
+}
+
+void NetLoopbackLink::Receive(int endpoint, std::vector<NetMessage>& outPackets, double currentSeconds)
+{
+	std::vector<InFlightPacket> arrived;
+	for (size_t packetIndex = 0; packetIndex < m_inFlight.size();)
+	{
+		InFlightPacket& inFlightPacket = m_inFlight[packetIndex];
+		if (inFlightPacket.m_toEndpoint == endpoint && inFlightPacket.m_deliverSeconds <= currentSeconds)
+		{
+			arrived.push_back(std::move(inFlightPacket));
+			inFlightPacket = std::move(m_inFlight.back());
+			m_inFlight.pop_back();
+		}
+		else
+		{
+			++packetIndex;
+		}
+	}
+
+	std::sort(arrived.begin(), arrived.end(), [](InFlightPacket const& a, InFlightPacket const& b) { return a.m_deliverSeconds < b.m_deliverSeconds; });
+	for (InFlightPacket& arrivedPacket : arrived)
+	{
+		outPackets.push_back(std::move(arrivedPacket.m_packet));
+	}
+}
+
+// -----------------------------LOOPBACK TEST----------------------------------
+struct NetTestWorld
+{
+	std::vector<Vec3>	m_positions;
+	std::vector<Rgba8>	m_colors;
+	std::vector<int>	m_healths;
+};
+
+static NetMessage BuildTestSnapshot(uint32_t tick, NetTestWorld const& world)
+{
+	NetMessage snapshot;
+	BufferWriter writer(snapshot, eBufferEndian::LITTLE);
+	writer.AppendPrimitive<uint32_t>(tick);
+	SerializeValue(writer, world.m_positions);
+	SerializeValue(writer, world.m_colors);
+	SerializeValue(writer, world.m_healths);
+	return snapshot;
+}
+
+NetChannelLoopbackResult RunNetChannelLoopbackTest(NetLoopbackLinkConfig const& linkConfig, int numTicks)
+{
+	constexpr int NUM_ENTITIES = 48;				// Keeps the whole world under GetMaxSnapshotSize for the default packet size
+	constexpr int NUM_MOVING_ENTITIES = 8;
+	constexpr int RELIABLE_TICK_INTERVAL = 6;
+	constexpr int MAX_DRAIN_TICKS = 600;
+	constexpr double TICK_SECONDS = 1.0 / 60.0;
+
+	NetChannelLoopbackResult result;
+	NetLoopbackLink link(linkConfig);
+	NetChannel server;
+	NetChannel client;
+
+	NetTestWorld world;
+	for (int entityIndex = 0; entityIndex < NUM_ENTITIES; ++entityIndex)
+	{
+		world.m_positions.push_back(Vec3((float)(entityIndex % 16), (float)(entityIndex / 16), 0.f));
+		world.m_colors.push_back(Rgba8((unsigned char)entityIndex, 128, 255, 255));
+		world.m_healths.push_back(100);
+	}
+
+	std::vector<NetMessage> sentSnapshots;
+	std::vector<NetMessage> packets;
+	std::vector<NetMessage> messages;
+	NetMessage snapshot;
+	uint32_t nextExpectedReliable = 0;
+	double currentSeconds = 0.0;
+
+	for (int tick = 0; tick < numTicks + MAX_DRAIN_TICKS; ++tick)
+	{
+		bool isDraining = tick >= numTicks;
+		if (isDraining && result.m_numReliableDelivered == result.m_numReliableSent)
+		{
+			break;
+		}
+		currentSeconds += TICK_SECONDS;
+
+		// Server moves some of the entities and sends the whole world, the channel sends what changed
+		for (int moveIndex = 0; moveIndex < NUM_MOVING_ENTITIES; ++moveIndex)
+		{
+			int entityIndex = moveIndex * (NUM_ENTITIES / NUM_MOVING_ENTITIES);
+			world.m_positions[entityIndex].x += 0.01f;
+			world.m_positions[entityIndex].z = (float)tick * 0.001f;
+		}
+		if (tick % 30 == 0)
+		{
+			world.m_healths[tick % NUM_ENTITIES] -= 1;
+		}
+		sentSnapshots.push_back(BuildTestSnapshot((uint32_t)tick, world));
+		if (!server.SetSnapshot(sentSnapshots.back()))
+		{
+			return result;
+		}
+		result.m_numSnapshotsSent++;
+
+		if (!isDraining)
+		{
+			server.SendUnreliable(NetMessage(16, (unsigned char)tick));
+			result.m_numUnreliableSent++;
+
+			if (tick % RELIABLE_TICK_INTERVAL == 0)
+			{
+				NetMessage reliableMessage;
+				BufferWriter writer(reliableMessage, eBufferEndian::LITTLE);
+				writer.AppendPrimitive<uint32_t>((uint32_t)result.m_numReliableSent++);
+				writer.AppendZeroBytes(28);
+				server.SendReliable(std::move(reliableMessage));
+			}
+		}
+
+		// Both ends read what arrived before writing, so their packets carry the freshest acks
+		packets.clear();
+		link.Receive(0, packets, currentSeconds);
+		for (NetMessage const& receivedPacket : packets)
+		{
+			server.ReadPacket(receivedPacket.data(), receivedPacket.size(), currentSeconds);
+		}
+
+		packets.clear();
+		link.Receive(1, packets, currentSeconds);
+		for (NetMessage const& receivedPacket : packets)
+		{
+			client.ReadPacket(receivedPacket.data(), receivedPacket.size(), currentSeconds);
+		}
+
+		NetMessage packet;
+		server.WritePacket(packet, currentSeconds);
+		link.Send(1, packet, currentSeconds);
+		client.WritePacket(packet, currentSeconds);
+		link.Send(0, packet, currentSeconds);
+
+		// Every snapshot that comes out has to match what the server had on that tick
+		if (client.TakeSnapshot(snapshot))
+		{
+			result.m_numSnapshotsTaken++;
+			BufferParser parser(snapshot, eBufferEndian::LITTLE);
+			uint32_t snapshotTick = parser.ParseUint32();
+			if (snapshotTick >= sentSnapshots.size() || sentSnapshots[snapshotTick] != snapshot)
+			{
+				result.m_numSnapshotsMismatched++;
+			}
+		}
+
+		messages.clear();
+		client.TakeReliableMessages(messages);
+		for (NetMessage const& message : messages)
+		{
+			BufferParser parser(message, eBufferEndian::LITTLE);
+			if (parser.ParseUint32() != nextExpectedReliable++)
+			{
+				result.m_isReliableInOrder = false;
+			}
+			result.m_numReliableDelivered++;
+		}
+
+		messages.clear();
+		client.TakeUnreliableMessages(messages);
+		result.m_numUnreliableDelivered += (int)messages.size();
+	}
+
+	NetChannelStats const& stats = server.GetStats();
+	if (stats.m_numPacketsSent > 0)
+	{
+		result.m_averageFullSnapshotBytes = (double)stats.m_numSnapshotFullBytes / (double)result.m_numSnapshotsSent;
+		result.m_averageSentSnapshotBytes = (double)stats.m_numSnapshotBytesSent / (double)result.m_numSnapshotsSent;
+		result.m_averagePacketBytes = (double)stats.m_numBytesSent / (double)stats.m_numPacketsSent;
+	}
+	result.m_roundTripSeconds = stats.m_roundTripSeconds;
+	result.m_isSucceeded = result.m_isReliableInOrder && result.m_numReliableDelivered == result.m_numReliableSent && result.m_numSnapshotsMismatched == 0 && result.m_numSnapshotsTaken > 0;
+	return result;
+}
+
+bool Command_NetChannelTest(EventArgs const& args)
+{
+	NetLoopbackLinkConfig linkConfig;
+	linkConfig.m_lossChance = args.GetValue(std::string("loss"), 0.05f);
+	linkConfig.m_latencySeconds = args.GetValue(std::string("latency"), 0.05);
+	linkConfig.m_jitterSeconds = args.GetValue(std::string("jitter"), 0.01);
+	linkConfig.m_seed = (unsigned int)args.GetValue(std::string("seed"), 0);
+	int numTicks = args.GetValue(std::string("ticks"), 600);
+
+	NetChannelLoopbackResult result = RunNetChannelLoopbackTest(linkConfig, numTicks);
+	if (g_theConsole)
+	{
+		g_theConsole->AddLine(result.m_isSucceeded ? DevConsole::INFO_MAJOR : DevConsole::ERROR,
+			Stringf("NetChannelTest %s: reliable %i/%i%s, unreliable %i/%i, snapshots %i taken %i mismatched, snapshot %.0f of %.0f bytes, packet %.0f bytes, rtt %.1fms",
+				result.m_isSucceeded ? "passed" : "failed", result.m_numReliableDelivered, result.m_numReliableSent, result.m_isReliableInOrder ? "" : " out of order",
+				result.m_numUnreliableDelivered, result.m_numUnreliableSent, result.m_numSnapshotsTaken, result.m_numSnapshotsMismatched,
+				result.m_averageSentSnapshotBytes, result.m_averageFullSnapshotBytes, result.m_averagePacketBytes, result.m_roundTripSeconds * 1000.0));
+	}
+	return true;
+}
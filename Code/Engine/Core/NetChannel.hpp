@@ -0,0 +1,196 @@
+#pragma once
+#include "Engine/Core/NetSystem.hpp"
+#include "Engine/Math/RandomNumberGenerator.hpp"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+class BufferWriter;
+class NamedProperties;
+typedef NamedProperties EventArgs;
+
+//-----------------------------------------------------------------------------------
+// Packet level protocol for state replication over UDP. Every packet carries a sequence number and
+// acks the last 33 packets received, so there is no head of line blocking and nothing waits on a
+// resend. On top of that a packet carries:
+//	- unreliable messages, sent once
+//	- reliable messages, resent until acked and delivered in order
+//	- a snapshot of the game state, delta compressed against the last snapshot the peer acked
+//
+// The channel does not own a socket, WritePacket and ReadPacket exchange whole datagrams so the
+// same code runs over SendToSocket/ReceiveFromSocket (NetSystem does it for every peer when
+// m_hasChannels is set) or over a NetLoopbackLink in tests.
+//
+// Nothing is fragmented, a packet never grows past m_maxPacketSize. Messages and snapshots too big
+// to fit an otherwise empty packet are rejected when they are queued.
+//
+constexpr uint16_t	NET_CHANNEL_PROTOCOL_ID = 0x4E43;
+constexpr int		NET_CHANNEL_PACKET_WINDOW = 256;		// Sent packets remembered for acks
+constexpr int		NET_CHANNEL_SNAPSHOT_WINDOW = 32;		// Snapshots remembered as delta baselines
+constexpr int		NET_CHANNEL_RELIABLE_WINDOW = 1024;		// Most reliable messages in flight
+constexpr size_t	NET_CHANNEL_MIN_PACKET_SIZE = 128;
+constexpr size_t	NET_CHANNEL_MAX_PACKET_SIZE = 65507;	// Biggest UDP payload over IPv4
+
+struct NetChannelConfig
+{
+	size_t		m_maxPacketSize = 1200;					// Keep it under the path MTU, IP fragments are lost together
+	double		m_reliableResendSeconds = 0.1;			// Shortest wait before a reliable message is sent again, it grows with the round trip
+};
+
+struct NetChannelStats
+{
+	int			m_numPacketsSent = 0;
+	int			m_numPacketsReceived = 0;
+	int			m_numPacketsAcked = 0;
+	int			m_numPacketsLost = 0;					// Never acked by the time their slot was reused
+	int			m_numReliableResends = 0;
+	int			m_numSnapshotsDeferred = 0;				// Left for the next packet to make room for a reliable message
+	size_t		m_numBytesSent = 0;
+	size_t		m_numSnapshotBytesSent = 0;				// Encoded snapshot bytes
+	size_t		m_numSnapshotFullBytes = 0;				// What the same snapshots are uncompressed
+	double		m_roundTripSeconds = 0.0;				// Smoothed over acked packets
+};
+
+class NetChannel
+{
+public:
+	explicit NetChannel(NetChannelConfig const& config = NetChannelConfig());
+
+	// False when the payload can never fit a packet, it is dropped
+	bool				SendUnreliable(NetMessage&& payload);
+	bool				SendReliable(NetMessage&& payload);
+	bool				SetSnapshot(NetMessage const& snapshot);							// Goes out in the next packet, or the one after when a reliable message needs the room
+	size_t				GetMaxMessageSize() const;
+	size_t				GetMaxSnapshotSize() const;											// Holds even against no baseline
+
+	void				WritePacket(NetMessage& outPacket, double currentSeconds);			// Call every network tick, even with nothing queued, to keep acks flowing
+	bool				ReadPacket(void const* data, size_t numBytes, double currentSeconds);	// False for stale, duplicate or malformed packets, which are ignored
+
+	void				TakeReliableMessages(std::vector<NetMessage>& outMessages);			// Appends in send order
+	void				TakeUnreliableMessages(std::vector<NetMessage>& outMessages);		// Appends in arrival order
+	bool				TakeSnapshot(NetMessage& outSnapshot);								// The newest snapshot, when one arrived since the last call
+
+	NetChannelStats const&	GetStats() const { return m_stats; }
+
+private:
+	struct SentPacket
+	{
+		uint16_t				m_sequence = 0;
+		bool					m_isUsed = false;
+		bool					m_isAcked = false;
+		bool					m_hasSnapshot = false;
+		uint16_t				m_snapshotId = 0;
+		double					m_sentSeconds = 0.0;
+		std::vector<uint16_t>	m_reliableIds;
+	};
+
+	struct ReliableMessage
+	{
+		uint16_t				m_id = 0;
+		bool					m_isAcked = false;
+		double					m_lastSentSeconds = -1.0;
+		NetMessage				m_payload;
+	};
+
+	struct SnapshotSlot
+	{
+		uint16_t				m_id = 0;
+		bool					m_isValid = false;
+		NetMessage				m_snapshot;
+	};
+
+	NetMessage const*	GetSnapshotBaseline() const;
+	void				WriteSnapshot(BufferWriter& writer, SentPacket& sentPacket, NetMessage const* baseline, NetMessage const& encodedSnapshot);
+	bool				IsReliableMessageDue(ReliableMessage const& message, double currentSeconds) const;
+	size_t				GetNextReliableMessageSize(double currentSeconds) const;
+	void				WriteReliableMessages(BufferWriter& writer, SentPacket& sentPacket, size_t& packetSize, double currentSeconds);
+	void				WriteUnreliableMessages(BufferWriter& writer, size_t& packetSize);
+	void				OnPacketAcked(uint16_t sequence, double currentSeconds);
+
+private:
+	NetChannelConfig			m_config;
+	NetChannelStats				m_stats;
+
+	// Sending
+	uint16_t					m_nextSequence = 0;
+	std::vector<SentPacket>		m_sentPackets;
+	std::deque<ReliableMessage>	m_reliableOutgoing;
+	uint16_t					m_nextReliableId = 0;
+	std::vector<NetMessage>		m_unreliableOutgoing;
+	NetMessage					m_pendingSnapshot;
+	bool						m_isSnapshotPending = false;
+	bool						m_wasSnapshotInLastPacket = false;
+	uint16_t					m_nextSnapshotId = 0;
+	std::vector<SnapshotSlot>	m_sentSnapshots;
+	uint16_t					m_ackedSnapshotId = 0;
+	bool						m_hasAckedSnapshot = false;
+
+	// Receiving
+	uint16_t					m_remoteSequence = 0;
+	uint32_t					m_receivedBits = 0;		// Bit n set when m_remoteSequence - 1 - n arrived
+	bool						m_hasReceivedPacket = false;
+	std::vector<NetMessage>		m_reliableIncoming;
+	std::vector<bool>			m_isReliableReceived;
+	uint16_t					m_nextExpectedReliableId = 0;
+	std::vector<NetMessage>		m_reliableDelivered;
+	std::vector<NetMessage>		m_unreliableDelivered;
+	std::vector<SnapshotSlot>	m_receivedSnapshots;
+	uint16_t					m_latestSnapshotId = 0;
+	bool						m_hasLatestSnapshot = false;
+	bool						m_isSnapshotAvailable = false;
+};
+
+//-----------------------------------------------------------------------------------
+// Stands in for the network between two channels: packets are dropped, delayed and, with jitter,
+// reordered. Time is passed in so tests can run faster than real time.
+//
+struct NetLoopbackLinkConfig
+{
+	float		m_lossChance = 0.f;
+	double		m_latencySeconds = 0.0;					// One way
+	double		m_jitterSeconds = 0.0;					// Added latency is random in [0, jitter]
+	unsigned int m_seed = 0;
+};
+
+class NetLoopbackLink
+{
+public:
+	explicit NetLoopbackLink(NetLoopbackLinkConfig const& config);
+
+	void				Send(int toEndpoint, NetMessage const& packet, double currentSeconds);		// Endpoint 0 or 1
+	void				Receive(int endpoint, std::vector<NetMessage>& outPackets, double currentSeconds);
+
+private:
+	struct InFlightPacket
+	{
+		double			m_deliverSeconds = 0.0;
+		int				m_toEndpoint = 0;
+		NetMessage		m_packet;
+	};
+
+	NetLoopbackLinkConfig		m_config;
+	RandomNumberGenerator		m_rng;
+	std::vector<InFlightPacket>	m_inFlight;
+};
+
+struct NetChannelLoopbackResult
+{
+	bool		m_isSucceeded = false;
+	int			m_numReliableSent = 0;
+	int			m_numReliableDelivered = 0;
+	bool		m_isReliableInOrder = true;
+	int			m_numUnreliableSent = 0;
+	int			m_numUnreliableDelivered = 0;
+	int			m_numSnapshotsSent = 0;
+	int			m_numSnapshotsTaken = 0;
+	int			m_numSnapshotsMismatched = 0;
+	double		m_averageFullSnapshotBytes = 0.0;
+	double		m_averageSentSnapshotBytes = 0.0;
+	double		m_averagePacketBytes = 0.0;
+	double		m_roundTripSeconds = 0.0;
+};
+
+// Replicates a moving set of entities at 60 Hz between two channels over a NetLoopbackLink and checks
+// every snapshot and reliable message that comes out the other side
+NetChannelLoopbackResult	RunNetChannelLoopbackTest(NetLoopbackLinkConfig const& linkConfig, int numTicks);
+bool						Command_NetChannelTest(EventArgs const& args);
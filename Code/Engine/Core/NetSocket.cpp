@@ -0,0 +1,604 @@
+#include "Engine/Core/NetSocket.hpp"
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <mstcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#undef  ERROR
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+#endif
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+typedef SOCKET			NativeSocket;
+typedef int				NativeSocketLength;
+typedef WSAPOLLFD		NativePollDescriptor;
+#define NATIVE_SOCKET_ERROR			SOCKET_ERROR
+#define NATIVE_IN_PROGRESS_ERROR	WSAEWOULDBLOCK		// A non blocking connect reports WSAEWOULDBLOCK
+#else
+typedef int				NativeSocket;
+typedef socklen_t		NativeSocketLength;
+typedef pollfd			NativePollDescriptor;
+#define NATIVE_SOCKET_ERROR			-1
+#define NATIVE_IN_PROGRESS_ERROR	EINPROGRESS
+#endif
+
+#if defined(MSG_NOSIGNAL)
+constexpr int NET_SEND_FLAGS = MSG_NOSIGNAL;		// A peer closing on us is an error code, not a SIGPIPE
+#else
+constexpr int NET_SEND_FLAGS = 0;
+#endif
+
+static NativeSocket ToNative(NetSocketHandle socketHandle)
+{
+	return (NativeSocket)socketHandle;
+}
+
+static bool IsWouldBlockError(int errorCode)
+{
+#if defined(_WIN32)
+	return errorCode == WSAEWOULDBLOCK;
+#else
+	return errorCode == EWOULDBLOCK || errorCode == EAGAIN || errorCode == EINTR;
+#endif
+}
+
+static bool SetSocketNonBlocking(NetSocketHandle socketHandle)
+{
+#if defined(_WIN32)
+	unsigned long blockingMode = 1;
+	return ioctlsocket(ToNative(socketHandle), FIONBIO, &blockingMode) == 0;
+#else
+	int flags = fcntl(ToNative(socketHandle), F_GETFL, 0);
+	return flags >= 0 && fcntl(ToNative(socketHandle), F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+static NetSocketHandle FromNative(NativeSocket nativeSocket)
+{
+#if defined(_WIN32)
+	return nativeSocket == INVALID_SOCKET ? INVALID_NET_SOCKET : (NetSocketHandle)nativeSocket;
+#else
+	return nativeSocket < 0 ? INVALID_NET_SOCKET : (NetSocketHandle)nativeSocket;
+#endif
+}
+
+static sockaddr_in ToSocketAddress(NetAddress const& address)
+{
+	sockaddr_in socketAddress;
+	std::memset(&socketAddress, 0, sizeof(socketAddress));
+	socketAddress.sin_family = AF_INET;
+	socketAddress.sin_addr.s_addr = address.m_address;
+	socketAddress.sin_port = address.m_port;
+	return socketAddress;
+}
+
+// -----------------------------ADDRESS----------------------------------
+bool NetAddress::FromString(std::string const& hostAddressString, NetAddress& outAddress)
+{
+	size_t colonPos = hostAddressString.find(':');
+	if (colonPos == std::string::npos)
+	{
+		return false;
+	}
+
+	std::string ipAddress = hostAddressString.substr(0, colonPos);
+	int port = atoi(hostAddressString.c_str() + colonPos + 1);
+	if (port < 0 || port > 0xFFFF)
+	{
+		return false;
+	}
+
+	in_addr address;
+	if (inet_pton(AF_INET, ipAddress.c_str(), &address) != 1)
+	{
+		return false;
+	}
+
+	outAddress.m_address = (uint32_t)address.s_addr;
+	outAddress.m_port = htons((uint16_t)port);
+	return true;
+}
+
+int NetAddress::GetPort() const
+{
+	return (int)ntohs(m_port);
+}
+
+// -----------------------------SOCKETS----------------------------------
+bool NetSocketStartUp()
+{
+#if defined(_WIN32)
+	WSADATA wsaData;
+	return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+#else
+	return true;
+#endif
+}
+
+void NetSocketShutDown()
+{
+#if defined(_WIN32)
+	WSACleanup();
+#endif
+}
+
+int GetLastNetSocketError()
+{
+#if defined(_WIN32)
+	return WSAGetLastError();
+#else
+	return errno;
+#endif
+}
+
+NetSocketHandle CreateTcpSocket()
+{
+	NetSocketHandle socketHandle = FromNative(socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+	if (socketHandle == INVALID_NET_SOCKET)
+	{
+		return INVALID_NET_SOCKET;
+	}
+
+	if (!SetSocketNonBlocking(socketHandle))
+	{
+		CloseNetSocket(socketHandle);
+		return INVALID_NET_SOCKET;
+	}
+
+	int isNoDelay = 1;
+	setsockopt(ToNative(socketHandle), IPPROTO_TCP, TCP_NODELAY, (char const*)&isNoDelay, sizeof(isNoDelay));
+	return socketHandle;
+}
+
+void CloseNetSocket(NetSocketHandle& socketHandle)
+{
+	if (socketHandle == INVALID_NET_SOCKET)
+	{
+		return;
+	}
+#if defined(_WIN32)
+	closesocket(ToNative(socketHandle));
+#else
+	close(ToNative(socketHandle));
+#endif
+	socketHandle = INVALID_NET_SOCKET;
+}
+
+bool BindAndListen(NetSocketHandle socketHandle, NetAddress const& address)
+{
+	int isReusingAddress = 1;
+	setsockopt(ToNative(socketHandle), SOL_SOCKET, SO_REUSEADDR, (char const*)&isReusingAddress, sizeof(isReusingAddress));
+
+	sockaddr_in socketAddress = ToSocketAddress(address);
+	if (bind(ToNative(socketHandle), (sockaddr const*)&socketAddress, (NativeSocketLength)sizeof(socketAddress)) == NATIVE_SOCKET_ERROR)
+	{
+		return false;
+	}
+	return listen(ToNative(socketHandle), SOMAXCONN) != NATIVE_SOCKET_ERROR;
+}
+
+NetAddress GetSocketLocalAddress(NetSocketHandle socketHandle)
+{
+	NetAddress address;
+	sockaddr_in socketAddress;
+	NativeSocketLength addressLength = (NativeSocketLength)sizeof(socketAddress);
+	if (getsockname(ToNative(socketHandle), (sockaddr*)&socketAddress, &addressLength) != NATIVE_SOCKET_ERROR)
+	{
+		address.m_address = (uint32_t)socketAddress.sin_addr.s_addr;
+		address.m_port = socketAddress.sin_port;
+	}
+	return address;
+}
+
+NetSocketHandle AcceptConnection(NetSocketHandle listenSocket)
+{
+	NetSocketHandle socketHandle = FromNative(accept(ToNative(listenSocket), nullptr, nullptr));
+	if (socketHandle == INVALID_NET_SOCKET)
+	{
+		return INVALID_NET_SOCKET;
+	}
+
+	if (!SetSocketNonBlocking(socketHandle))
+	{
+		CloseNetSocket(socketHandle);
+		return INVALID_NET_SOCKET;
+	}
+
+	int isNoDelay = 1;
+	setsockopt(ToNative(socketHandle), IPPROTO_TCP, TCP_NODELAY, (char const*)&isNoDelay, sizeof(isNoDelay));
+	return socketHandle;
+}
+
+NetSocketResult StartConnect(NetSocketHandle socketHandle, NetAddress const& address)
+{
+	sockaddr_in socketAddress = ToSocketAddress(address);
+	if (connect(ToNative(socketHandle), (sockaddr const*)&socketAddress, (NativeSocketLength)sizeof(socketAddress)) != NATIVE_SOCKET_ERROR)
+	{
+		return NetSocketResult::OK;
+	}
+	return GetLastNetSocketError() == NATIVE_IN_PROGRESS_ERROR ? NetSocketResult::IN_PROGRESS : NetSocketResult::FAILED;
+}
+
+NetSocketResult FinishConnect(NetSocketHandle socketHandle)
+{
+	int socketError = 0;
+	NativeSocketLength errorLength = (NativeSocketLength)sizeof(socketError);
+	if (getsockopt(ToNative(socketHandle), SOL_SOCKET, SO_ERROR, (char*)&socketError, &errorLength) == NATIVE_SOCKET_ERROR)
+	{
+		return NetSocketResult::FAILED;
+	}
+	return socketError == 0 ? NetSocketResult::OK : NetSocketResult::FAILED;
+}
+
+NetSocketResult SendOnSocket(NetSocketHandle socketHandle, void const* data, size_t numBytes, size_t& outNumBytesSent)
+{
+	outNumBytesSent = 0;
+	int result = (int)send(ToNative(socketHandle), (char const*)data, (int)numBytes, NET_SEND_FLAGS);
+	if (result == NATIVE_SOCKET_ERROR)
+	{
+		return IsWouldBlockError(GetLastNetSocketError()) ? NetSocketResult::WOULD_BLOCK : NetSocketResult::FAILED;
+	}
+	outNumBytesSent = (size_t)result;
+	return NetSocketResult::OK;
+}
+
+NetSocketResult ReceiveOnSocket(NetSocketHandle socketHandle, void* buffer, size_t bufferSize, size_t& outNumBytesReceived)
+{
+	outNumBytesReceived = 0;
+	int result = (int)recv(ToNative(socketHandle), (char*)buffer, (int)bufferSize, 0);
+	if (result == 0)
+	{
+		return NetSocketResult::CLOSED;
+	}
+	if (result == NATIVE_SOCKET_ERROR)
+	{
+		return IsWouldBlockError(GetLastNetSocketError()) ? NetSocketResult::WOULD_BLOCK : NetSocketResult::FAILED;
+	}
+	outNumBytesReceived = (size_t)result;
+	return NetSocketResult::OK;
+}
+
+NetSocketResult SendGatherOnSocket(NetSocketHandle socketHandle, NetIoBuffer const* buffers, int numBuffers, size_t& outNumBytesSent)
+{
+	outNumBytesSent = 0;
+	numBuffers = numBuffers < NET_MAX_IO_BUFFERS ? numBuffers : NET_MAX_IO_BUFFERS;
+#if defined(_WIN32)
+	WSABUF nativeBuffers[NET_MAX_IO_BUFFERS];
+	for (int bufferIndex = 0; bufferIndex < numBuffers; ++bufferIndex)
+	{
+		nativeBuffers[bufferIndex].buf = (char*)buffers[bufferIndex].m_data;
+		nativeBuffers[bufferIndex].len = (ULONG)buffers[bufferIndex].m_size;
+	}
+	DWORD numBytesSent = 0;
+	if (WSASend(ToNative(socketHandle), nativeBuffers, (DWORD)numBuffers, &numBytesSent, 0, nullptr, nullptr) == NATIVE_SOCKET_ERROR)
+	{
+		return IsWouldBlockError(GetLastNetSocketError()) ? NetSocketResult::WOULD_BLOCK : NetSocketResult::FAILED;
+	}
+	outNumBytesSent = (size_t)numBytesSent;
+#else
+	iovec nativeBuffers[NET_MAX_IO_BUFFERS];
+	for (int bufferIndex = 0; bufferIndex < numBuffers; ++bufferIndex)
+	{
+		nativeBuffers[bufferIndex].iov_base = buffers[bufferIndex].m_data;
+		nativeBuffers[bufferIndex].iov_len = buffers[bufferIndex].m_size;
+	}
+	msghdr message;
+	std::memset(&message, 0, sizeof(message));
+	message.msg_iov = nativeBuffers;
+	message.msg_iovlen = numBuffers;
+	ssize_t result = sendmsg(ToNative(socketHandle), &message, NET_SEND_FLAGS);
+	if (result < 0)
+	{
+		return IsWouldBlockError(GetLastNetSocketError()) ? NetSocketResult::WOULD_BLOCK : NetSocketResult::FAILED;
+	}
+	outNumBytesSent = (size_t)result;
+#endif
+	return NetSocketResult::OK;
+}
+
+NetSocketResult ReceiveScatterOnSocket(NetSocketHandle socketHandle, NetIoBuffer const* buffers, int numBuffers, size_t& outNumBytesReceived)
+{
+	outNumBytesReceived = 0;
+	numBuffers = numBuffers < NET_MAX_IO_BUFFERS ? numBuffers : NET_MAX_IO_BUFFERS;
+#if defined(_WIN32)
+	WSABUF nativeBuffers[NET_MAX_IO_BUFFERS];
+	for (int bufferIndex = 0; bufferIndex < numBuffers; ++bufferIndex)
+	{
+		nativeBuffers[bufferIndex].buf = (char*)buffers[bufferIndex].m_data;
+		nativeBuffers[bufferIndex].len = (ULONG)buffers[bufferIndex].m_size;
+	}
+	DWORD numBytesReceived = 0;
+	DWORD flags = 0;
+	if (WSARecv(ToNative(socketHandle), nativeBuffers, (DWORD)numBuffers, &numBytesReceived, &flags, nullptr, nullptr) == NATIVE_SOCKET_ERROR)
+	{
+		return IsWouldBlockError(GetLastNetSocketError()) ? NetSocketResult::WOULD_BLOCK : NetSocketResult::FAILED;
+	}
+#else
+	iovec nativeBuffers[NET_MAX_IO_BUFFERS];
+	for (int bufferIndex = 0; bufferIndex < numBuffers; ++bufferIndex)
+	{
+		nativeBuffers[bufferIndex].iov_base = buffers[bufferIndex].m_data;
+		nativeBuffers[bufferIndex].iov_len = buffers[bufferIndex].m_size;
+	}
+	ssize_t numBytesReceived = readv(ToNative(socketHandle), nativeBuffers, numBuffers);
+	if (numBytesReceived < 0)
+	{
+		return IsWouldBlockError(GetLastNetSocketError()) ? NetSocketResult::WOULD_BLOCK : NetSocketResult::FAILED;
+	}
+#endif
+	if (numBytesReceived == 0)
+	{
+		return NetSocketResult::CLOSED;
+	}
+	outNumBytesReceived = (size_t)numBytesReceived;
+	return NetSocketResult::OK;
+}
+
+NetSocketHandle CreateUdpSocket()
+{
+	NetSocketHandle socketHandle = FromNative(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+	if (socketHandle == INVALID_NET_SOCKET)
+	{
+		return INVALID_NET_SOCKET;
+	}
+
+	if (!SetSocketNonBlocking(socketHandle))
+	{
+		CloseNetSocket(socketHandle);
+		return INVALID_NET_SOCKET;
+	}
+
+#if defined(_WIN32)
+	// Otherwise an ICMP port unreachable from an earlier send fails the next receive
+	BOOL isReportingConnectionReset = FALSE;
+	DWORD numBytesReturned = 0;
+	WSAIoctl(ToNative(socketHandle), SIO_UDP_CONNRESET, &isReportingConnectionReset, sizeof(isReportingConnectionReset), nullptr, 0, &numBytesReturned, nullptr, nullptr);
+#endif
+	return socketHandle;
+}
+
+bool BindUdpSocket(NetSocketHandle socketHandle, NetAddress const& address)
+{
+	sockaddr_in socketAddress = ToSocketAddress(address);
+	return bind(ToNative(socketHandle), (sockaddr const*)&socketAddress, (NativeSocketLength)sizeof(socketAddress)) != NATIVE_SOCKET_ERROR;
+}
+
+NetSocketResult SendToSocket(NetSocketHandle socketHandle, void const* data, size_t numBytes, NetAddress const& toAddress)
+{
+	sockaddr_in socketAddress = ToSocketAddress(toAddress);
+	int result = (int)sendto(ToNative(socketHandle), (char const*)data, (int)numBytes, NET_SEND_FLAGS, (sockaddr const*)&socketAddress, (NativeSocketLength)sizeof(socketAddress));
+	if (result == NATIVE_SOCKET_ERROR)
+	{
+		return IsWouldBlockError(GetLastNetSocketError()) ? NetSocketResult::WOULD_BLOCK : NetSocketResult::FAILED;
+	}
+	return NetSocketResult::OK;
+}
+
+NetSocketResult ReceiveFromSocket(NetSocketHandle socketHandle, void* buffer, size_t bufferSize, size_t& outNumBytesReceived, NetAddress& outFromAddress)
+{
+	outNumBytesReceived = 0;
+	sockaddr_in socketAddress;
+	NativeSocketLength addressLength = (NativeSocketLength)sizeof(socketAddress);
+	int result = (int)recvfrom(ToNative(socketHandle), (char*)buffer, (int)bufferSize, 0, (sockaddr*)&socketAddress, &addressLength);
+	if (result == NATIVE_SOCKET_ERROR)
+	{
+		return IsWouldBlockError(GetLastNetSocketError()) ? NetSocketResult::WOULD_BLOCK : NetSocketResult::FAILED;
+	}
+	outFromAddress.m_address = (uint32_t)socketAddress.sin_addr.s_addr;
+	outFromAddress.m_port = socketAddress.sin_port;
+	outNumBytesReceived = (size_t)result;
+	return NetSocketResult::OK;
+}
+
+// -----------------------------POLLER----------------------------------
+#if defined(__linux__)
+NetPoller::NetPoller()
+{
+	m_epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+	m_wakeDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+	// The wake descriptor is told apart from sockets by its null user data
+	epoll_event wakeEvent;
+	wakeEvent.events = EPOLLIN;
+	wakeEvent.data.ptr = nullptr;
+	epoll_ctl(m_epollDescriptor, EPOLL_CTL_ADD, m_wakeDescriptor, &wakeEvent);
+}
+
+NetPoller::~NetPoller()
+{
+	close(m_wakeDescriptor);
+	close(m_epollDescriptor);
+}
+
+static uint32_t GetEpollEvents(unsigned int interestFlags)
+{
+	uint32_t events = 0;
+	if (interestFlags & NET_POLL_READ)
+	{
+		events |= EPOLLIN;
+	}
+	if (interestFlags & NET_POLL_WRITE)
+	{
+		events |= EPOLLOUT;
+	}
+	return events;
+}
+
+bool NetPoller::Add(NetSocketHandle socketHandle, unsigned int interestFlags, void* userData)
+{
+	epoll_event socketEvent;
+	socketEvent.events = GetEpollEvents(interestFlags);
+	socketEvent.data.ptr = userData;
+	return epoll_ctl(m_epollDescriptor, EPOLL_CTL_ADD, ToNative(socketHandle), &socketEvent) == 0;
+}
+
+bool NetPoller::Modify(NetSocketHandle socketHandle, unsigned int interestFlags, void* userData)
+{
+	epoll_event socketEvent;
+	socketEvent.events = GetEpollEvents(interestFlags);
+	socketEvent.data.ptr = userData;
+	return epoll_ctl(m_epollDescriptor, EPOLL_CTL_MOD, ToNative(socketHandle), &socketEvent) == 0;
+}
+
+void NetPoller::Remove(NetSocketHandle socketHandle)
+{
+	epoll_event unusedEvent;
+	epoll_ctl(m_epollDescriptor, EPOLL_CTL_DEL, ToNative(socketHandle), &unusedEvent);
+}
+
+int NetPoller::Wait(std::vector<NetPollEvent>& outEvents, int timeoutMilliseconds)
+{
+	outEvents.clear();
+
+	epoll_event readyEvents[64];
+	int numReady = epoll_wait(m_epollDescriptor, readyEvents, 64, timeoutMilliseconds);
+	for (int eventIndex = 0; eventIndex < numReady; ++eventIndex)
+	{
+		epoll_event const& readyEvent = readyEvents[eventIndex];
+		if (readyEvent.data.ptr == nullptr)
+		{
+			uint64_t wakeCount;
+			ssize_t numRead = read(m_wakeDescriptor, &wakeCount, sizeof(wakeCount));
+			(void)numRead;
+			continue;
+		}
+
+		NetPollEvent pollEvent;
+		pollEvent.m_userData = readyEvent.data.ptr;
+		pollEvent.m_flags = ((readyEvent.events & EPOLLIN) ? NET_POLL_READ : 0u)
+			| ((readyEvent.events & EPOLLOUT) ? NET_POLL_WRITE : 0u)
+			| ((readyEvent.events & (EPOLLERR | EPOLLHUP)) ? NET_POLL_ERROR : 0u);
+		outEvents.push_back(pollEvent);
+	}
+	return (int)outEvents.size();
+}
+
+void NetPoller::Wake()
+{
+	uint64_t wakeCount = 1;
+	ssize_t numWritten = write(m_wakeDescriptor, &wakeCount, sizeof(wakeCount));
+	(void)numWritten;
+}
+
+#else
+NetPoller::NetPoller()
+{
+	m_wakeSocket = CreateUdpSocket();
+	NetAddress::FromString("127.0.0.1:0", m_wakeAddress);
+	BindUdpSocket(m_wakeSocket, m_wakeAddress);
+	m_wakeAddress = GetSocketLocalAddress(m_wakeSocket);
+}
+
+NetPoller::~NetPoller()
+{
+	CloseNetSocket(m_wakeSocket);
+}
+
+bool NetPoller::Add(NetSocketHandle socketHandle, unsigned int interestFlags, void* userData)
+{
+	m_entries.push_back(PollEntry{ socketHandle, interestFlags, userData });
+	return true;
+}
+
+bool NetPoller::Modify(NetSocketHandle socketHandle, unsigned int interestFlags, void* userData)
+{
+	for (PollEntry& entry : m_entries)
+	{
+		if (entry.m_socket == socketHandle)
+		{
+			entry.m_interestFlags = interestFlags;
+			entry.m_userData = userData;
+			return true;
+		}
+	}
+	return false;
+}
+
+void NetPoller::Remove(NetSocketHandle socketHandle)
+{
+	for (size_t entryIndex = 0; entryIndex < m_entries.size(); ++entryIndex)
+	{
+		if (m_entries[entryIndex].m_socket == socketHandle)
+		{
+			m_entries[entryIndex] = m_entries.back();
+			m_entries.pop_back();
+			return;
+		}
+	}
+}
+
+int NetPoller::Wait(std::vector<NetPollEvent>& outEvents, int timeoutMilliseconds)
+{
+	outEvents.clear();
+
+	// The wake socket goes first, then one descriptor per entry in the same order
+	std::vector<NativePollDescriptor> descriptors(m_entries.size() + 1);
+	descriptors[0].fd = ToNative(m_wakeSocket);
+	descriptors[0].events = POLLIN;
+	descriptors[0].revents = 0;
+	for (size_t entryIndex = 0; entryIndex < m_entries.size(); ++entryIndex)
+	{
+		NativePollDescriptor& descriptor = descriptors[entryIndex + 1];
+		descriptor.fd = ToNative(m_entries[entryIndex].m_socket);
+		descriptor.events = (short)(((m_entries[entryIndex].m_interestFlags & NET_POLL_READ) ? POLLIN : 0) | ((m_entries[entryIndex].m_interestFlags & NET_POLL_WRITE) ? POLLOUT : 0));
+		descriptor.revents = 0;
+	}
+
+#if defined(_WIN32)
+	int numReady = WSAPoll(descriptors.data(), (ULONG)descriptors.size(), timeoutMilliseconds);
+#else
+	int numReady = poll(descriptors.data(), (nfds_t)descriptors.size(), timeoutMilliseconds);
+#endif
+	if (numReady <= 0)
+	{
+		return 0;
+	}
+
+	if (descriptors[0].revents & POLLIN)
+	{
+		char wakeBytes[64];
+		while (recv(ToNative(m_wakeSocket), wakeBytes, (int)sizeof(wakeBytes), 0) > 0)
+		{
+		}
+	}
+
+	for (size_t entryIndex = 0; entryIndex < m_entries.size(); ++entryIndex)
+	{
+		short readyEvents = descriptors[entryIndex + 1].revents;
+		if (readyEvents == 0)
+		{
+			continue;
+		}
+
+		NetPollEvent pollEvent;
+		pollEvent.m_userData = m_entries[entryIndex].m_userData;
+		pollEvent.m_flags = ((readyEvents & POLLIN) ? NET_POLL_READ : 0u)
+			| ((readyEvents & POLLOUT) ? NET_POLL_WRITE : 0u)
+			| ((readyEvents & (POLLERR | POLLHUP | POLLNVAL)) ? NET_POLL_ERROR : 0u);
+		outEvents.push_back(pollEvent);
+	}
+	return (int)outEvents.size();
+}
+
+void NetPoller::Wake()
+{
+	char wakeByte = 1;
+	SendToSocket(m_wakeSocket, &wakeByte, 1, m_wakeAddress);
+}
+#endif
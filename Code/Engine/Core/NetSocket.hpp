@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------------
+// Thin portable layer over winsock and BSD sockets. Every socket it creates is non blocking, TCP
+// ones with Nagle disabled, calls never block and report WOULD_BLOCK instead.
+//
+typedef uintptr_t NetSocketHandle;
+constexpr NetSocketHandle INVALID_NET_SOCKET = ~(NetSocketHandle)0;
+constexpr int NET_MAX_IO_BUFFERS = 64;		// Most buffers one gather send or scatter receive takes
+
+enum class NetSocketResult
+{
+	OK,
+	WOULD_BLOCK,
+	IN_PROGRESS,
+	CLOSED,
+	FAILED
+};
+
+// One piece of a gather send or a scatter receive
+struct NetIoBuffer
+{
+	void*				m_data = nullptr;
+	size_t				m_size = 0;
+};
+
+struct NetAddress
+{
+	uint32_t			m_address = 0;		// IPv4, network byte order
+	uint16_t			m_port = 0;			// Network byte order
+
+	static bool			FromString(std::string const& hostAddressString, NetAddress& outAddress);	// "127.0.0.1:3100"
+	int					GetPort() const;															// Host byte order
+
+	bool				operator==(NetAddress const& compare) const { return m_address == compare.m_address && m_port == compare.m_port; }
+	bool				operator!=(NetAddress const& compare) const { return !(*this == compare); }
+};
+
+bool				NetSocketStartUp();
+void				NetSocketShutDown();
+int					GetLastNetSocketError();
+
+NetSocketHandle		CreateTcpSocket();
+void				CloseNetSocket(NetSocketHandle& socketHandle);
+bool				BindAndListen(NetSocketHandle socketHandle, NetAddress const& address);
+NetAddress			GetSocketLocalAddress(NetSocketHandle socketHandle);
+NetSocketHandle		AcceptConnection(NetSocketHandle listenSocket);						// INVALID_NET_SOCKET when nobody is waiting
+NetSocketResult		StartConnect(NetSocketHandle socketHandle, NetAddress const& address);	// OK, IN_PROGRESS or FAILED
+NetSocketResult		FinishConnect(NetSocketHandle socketHandle);							// Once the socket is writable: OK or FAILED
+NetSocketResult		SendOnSocket(NetSocketHandle socketHandle, void const* data, size_t numBytes, size_t& outNumBytesSent);
+NetSocketResult		ReceiveOnSocket(NetSocketHandle socketHandle, void* buffer, size_t bufferSize, size_t& outNumBytesReceived);
+NetSocketResult		SendGatherOnSocket(NetSocketHandle socketHandle, NetIoBuffer const* buffers, int numBuffers, size_t& outNumBytesSent);			// One call for all of the buffers, in order
+NetSocketResult		ReceiveScatterOnSocket(NetSocketHandle socketHandle, NetIoBuffer const* buffers, int numBuffers, size_t& outNumBytesReceived);	// Fills the buffers in order
+
+NetSocketHandle		CreateUdpSocket();
+bool				BindUdpSocket(NetSocketHandle socketHandle, NetAddress const& address);		// Port 0 picks a free port, see GetSocketLocalAddress
+NetSocketResult		SendToSocket(NetSocketHandle socketHandle, void const* data, size_t numBytes, NetAddress const& toAddress);
+NetSocketResult		ReceiveFromSocket(NetSocketHandle socketHandle, void* buffer, size_t bufferSize, size_t& outNumBytesReceived, NetAddress& outFromAddress);	// One datagram, cut to bufferSize
+
+//-----------------------------------------------------------------------------------
+// Waits on many sockets at once. epoll on Linux, WSAPoll/poll over the registered sockets elsewhere.
+// Everything but Wake has to be called from the thread that owns the poller.
+//
+enum NetPollFlags : unsigned int
+{
+	NET_POLL_READ	= 1 << 0,
+	NET_POLL_WRITE	= 1 << 1,
+	NET_POLL_ERROR	= 1 << 2,
+};
+
+struct NetPollEvent
+{
+	void*			m_userData = nullptr;
+	unsigned int	m_flags = 0;
+};
+
+class NetPoller
+{
+public:
+	NetPoller();
+	~NetPoller();
+
+	NetPoller(NetPoller const& copy) = delete;
+	NetPoller& operator=(NetPoller const& copy) = delete;
+
+	bool			Add(NetSocketHandle socketHandle, unsigned int interestFlags, void* userData);
+	bool			Modify(NetSocketHandle socketHandle, unsigned int interestFlags, void* userData);
+	void			Remove(NetSocketHandle socketHandle);
+
+	// Fills outEvents with the sockets that are ready, returns early when another thread calls Wake
+	int				Wait(std::vector<NetPollEvent>& outEvents, int timeoutMilliseconds);
+	void			Wake();
+
+private:
+#if defined(__linux__)
+	int				m_epollDescriptor = -1;
+	int				m_wakeDescriptor = -1;		// eventfd
+#else
+	struct PollEntry
+	{
+		NetSocketHandle	m_socket;
+		unsigned int	m_interestFlags;
+		void*			m_userData;
+	};
+	std::vector<PollEntry>	m_entries;
+	NetSocketHandle	m_wakeSocket = INVALID_NET_SOCKET;	// UDP socket sending to itself on loopback
+	NetAddress		m_wakeAddress;
+#endif
+};
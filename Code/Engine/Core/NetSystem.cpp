@@ -1,17 +1,79 @@
-﻿#define WIN32_LEAN_AND_MEAN	
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#pragma comment(lib, "Ws2_32.lib")
-#undef  ERROR
-
 #include "Engine/Core/NetSystem.hpp"
+#include "Engine/Core/NetChannel.hpp"
 #include "Engine/Core/ErrorWarningAssert.hpp"
 #include "Engine/Core/StringUtils.hpp"
 #include "Engine/Core/EventSystem.hpp"
 #include "Engine/Core/NamedStrings.hpp"
 #include "Engine/Core/DevConsole.hpp"
 #include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/BufferWriter.hpp"
+#include "Engine/Core/BufferParser.hpp"
 #include "Game/EngineBuildPreferences.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+
+constexpr double NET_RECONNECT_INTERVAL_SECONDS = 0.1;
+constexpr int NET_IDLE_WAIT_MILLISECONDS = 100;
+
+// The header lives next to a payload shared by every connection it is broadcast to
+struct NetOutgoingFrame
+{
+	unsigned char					m_header[NET_MESSAGE_HEADER_SIZE];
+	std::shared_ptr<NetMessage const>	m_payload;
+
+	size_t GetFrameSize() const { return NET_MESSAGE_HEADER_SIZE + m_payload->size(); }
+};
+
+struct NetConnection
+{
+	NetSocketHandle					m_socket = INVALID_NET_SOCKET;
+	bool							m_isConnecting = false;		// Client socket waiting for its connect to finish
+	bool							m_isWriteWanted = false;	// Registered for writability because the socket could not take everything
+	std::deque<NetOutgoingFrame>	m_outgoing;
+	size_t							m_outgoingOffset = 0;		// Bytes of the front frame already sent
+
+	// Received bytes wrap around a power of two ring, recv writes straight into its free space
+	std::vector<unsigned char>		m_recvRing;
+	size_t							m_recvStart = 0;
+	size_t							m_recvSize = 0;
+};
+
+struct NetChannelPeer
+{
+	NetAddress						m_address;
+	NetChannel						m_channel;
+	double							m_lastReceivedSeconds = 0.0;
+};
+
+static size_t RoundUpToPowerOfTwo(size_t value)
+{
+	size_t powerOfTwo = 1;
+	while (powerOfTwo < value)
+	{
+		powerOfTwo <<= 1;
+	}
+	return powerOfTwo;
+}
+
+static void CopyFromRing(NetConnection const* connection, size_t offset, void* destination, size_t numBytes)
+{
+	size_t capacity = connection->m_recvRing.size();
+	size_t first = (connection->m_recvStart + offset) & (capacity - 1);
+	size_t numFirstBytes = std::min(numBytes, capacity - first);
+	std::memcpy(destination, connection->m_recvRing.data() + first, numFirstBytes);
+	std::memcpy((unsigned char*)destination + numFirstBytes, connection->m_recvRing.data(), numBytes - numFirstBytes);
+}
+
+static void GrowRing(NetConnection* connection, size_t minCapacity)
+{
+	std::vector<unsigned char> newRing(RoundUpToPowerOfTwo(minCapacity));
+	CopyFromRing(connection, 0, newRing.data(), connection->m_recvSize);
+	connection->m_recvRing.swap(newRing);
+	connection->m_recvStart = 0;
+}
 
 NetSystem::NetSystem(const NetSystemConfig& config)
 	:m_config(config),
@@ -30,80 +92,77 @@ NetSystem::NetSystem(const NetSystemConfig& config)
 		m_mode = NetSystemMode::NONE;
 	}
 
-	IN_ADDR address;
-	size_t colonPos = m_config.m_hostAddressString.find(':');
-	std::string ipaddress = m_config.m_hostAddressString.substr(0, colonPos);
-	std::string portString = m_config.m_hostAddressString.substr(colonPos + 1);
-
-	int result = inet_pton(AF_INET, ipaddress.c_str(), &address);
-	if (result == SOCKET_ERROR)
+	if (m_mode != NetSystemMode::NONE && !NetAddress::FromString(m_config.m_hostAddressString, m_hostAddress))
 	{
-		int errorCode = WSAGetLastError();
-		ERROR_AND_DIE(Stringf("Cannot create host address with error code: %i", errorCode));
+		ERROR_AND_DIE(Stringf("Cannot create host address from %s", m_config.m_hostAddressString.c_str()));
 	}
-	m_hostAddress = address.S_un.S_addr;
-	m_hostPort = htons(static_cast<unsigned short>(std::stoi(portString)));
-
-	m_sendBuffer = new char[m_config.m_sendBufferSize];
-	m_recvBuffer = new char[m_config.m_recvBufferSize];
-
 }
 
 NetSystem::~NetSystem()
 {
-	delete m_sendBuffer;
-	delete m_recvBuffer;
+	ShutDown();
 }
 
 void NetSystem::StartUp()
 {
 #if !defined (ENGINE_DISABLE_NETWORK)
+	if (m_mode == NetSystemMode::NONE)
+	{
+		return;
+	}
 
-	// Start up the windows socket
-	WSADATA wsaData;
-	int iResult;
-	iResult = WSAStartup(MAKEWORD(2, 2), &wsaData);
-	if (iResult == SOCKET_ERROR)
+	if (!NetSocketStartUp())
 	{
-		int errorCode = WSAGetLastError();
-		ERROR_AND_DIE(Stringf("Cannot create the socket for the client with error code: %i", errorCode));
+		ERROR_AND_DIE(Stringf("Cannot start up the sockets with error code: %i", GetLastNetSocketError()));
 	}
 
+	m_poller = new NetPoller();
+	m_isQuitting.store(false, std::memory_order_release);
+
 	if (m_mode == NetSystemMode::CLIENT)
 	{
-		m_clientSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-
-		unsigned long blockingMode = 1;
-		ioctlsocket(m_clientSocket, FIONBIO, &blockingMode);
 		m_clientState = ClientState::DISCONNECTED;
 	}
 	else if (m_mode == NetSystemMode::SERVER)
 	{
-		m_listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-
-		unsigned long blockingMode = 1;
-		ioctlsocket(m_listenSocket, FIONBIO, &blockingMode);
+		m_listenSocket = CreateTcpSocket();
+		if (m_listenSocket == INVALID_NET_SOCKET || !BindAndListen(m_listenSocket, m_hostAddress))
+		{
+			ERROR_AND_DIE(Stringf("Cannot bind and listen on %s with error code: %i", m_config.m_hostAddressString.c_str(), GetLastNetSocketError()));
+		}
 
-		sockaddr_in addr;
-		addr.sin_family = AF_INET;
-		addr.sin_addr.S_un.S_addr = (m_hostAddress);
-		addr.sin_port = m_hostPort;
+		// The listen socket is told apart from connections by pointing at itself
+		m_poller->Add(m_listenSocket, NET_POLL_READ, &m_listenSocket);
+		m_listenPort = GetSocketLocalAddress(m_listenSocket).GetPort();
+		m_serverState = ServerState::LISTENING;
+	}
 
-		int bindResult = bind(m_listenSocket, (sockaddr*)&addr, (int)sizeof(addr));
-		if (bindResult == SOCKET_ERROR)
+	if (m_config.m_hasChannels)
+	{
+		// Servers take datagrams on the port they listen on, clients on any free one
+		NetAddress channelAddress;
+		if (m_mode == NetSystemMode::SERVER)
 		{
-			ERROR_AND_DIE("Cannot bind socket");
+			channelAddress = GetSocketLocalAddress(m_listenSocket);
 		}
-		int result = listen(m_listenSocket, SOMAXCONN);
-
-		if (result == SOCKET_ERROR)
+		m_channelSocket = CreateUdpSocket();
+		if (m_channelSocket == INVALID_NET_SOCKET || !BindUdpSocket(m_channelSocket, channelAddress))
 		{
-			ERROR_AND_DIE("Cannot listen to the client");
+			ERROR_AND_DIE(Stringf("Cannot bind the channel socket for %s with error code: %i", m_config.m_hostAddressString.c_str(), GetLastNetSocketError()));
 		}
-		m_serverState = ServerState::LISTENING;
+		m_poller->Add(m_channelSocket, NET_POLL_READ, &m_channelSocket);
+		m_datagramBuffer.resize(NET_CHANNEL_MAX_PACKET_SIZE);
+		m_nextChannelTickSeconds = GetCurrentTimeSeconds();
 
+		if (m_mode == NetSystemMode::CLIENT)
+		{
+			NetChannelPeer* peer = new NetChannelPeer();
+			peer->m_address = m_hostAddress;
+			m_channelPeers.push_back(peer);
+		}
 	}
 
+	m_networkThread = new std::thread(&NetSystem::NetworkThreadMain, this);
 #else
 	return;
 #endif
@@ -112,16 +171,36 @@ void NetSystem::StartUp()
 void NetSystem::ShutDown()
 {
 #if !defined (ENGINE_DISABLE_NETWORK)
-	if (m_mode == NetSystemMode::CLIENT)
+	if (m_networkThread == nullptr)
 	{
-		closesocket(m_clientSocket);
+		return;
 	}
-	if (m_mode == NetSystemMode::SERVER)
+
+	m_isQuitting.store(true, std::memory_order_release);
+	m_poller->Wake();
+	m_networkThread->join();
+	delete m_networkThread;
+	m_networkThread = nullptr;
+
+	while (!m_connections.empty())
 	{
-		closesocket(m_clientSocket);
-		closesocket(m_listenSocket);
+		CloseConnection(m_connections.back());
 	}
-	WSACleanup();
+	CloseNetSocket(m_listenSocket);
+	CloseNetSocket(m_channelSocket);
+	for (NetChannelPeer* peer : m_channelPeers)
+	{
+		delete peer;
+	}
+	m_channelPeers.clear();
+
+	delete m_poller;
+	m_poller = nullptr;
+
+	m_clientState = ClientState::DISCONNECTED;
+	m_serverState = ServerState::DISCONNECTED;
+	m_numConnections = 0;
+	NetSocketShutDown();
 #else
 	return;
 #endif
@@ -130,372 +209,669 @@ void NetSystem::ShutDown()
 void NetSystem::BeginFrame()
 {
 #if !defined (ENGINE_DISABLE_NETWORK)
-	if (m_mode == NetSystemMode::CLIENT)
+	if (!m_config.m_isDispatchingMessages)
 	{
-		if (m_clientState == ClientState::DISCONNECTED)
-		{
-			if (m_clientSocket == INVALID_SOCKET)
-			{
-				m_clientSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-				unsigned long blockingMode = 1;
-				ioctlsocket(m_clientSocket, FIONBIO, &blockingMode);
-			}
+		return;
+	}
 
-			sockaddr_in addr;
-			addr.sin_family = AF_INET;
-			addr.sin_addr.S_un.S_addr = (m_hostAddress);
-			addr.sin_port = (m_hostPort);
-			int result = connect(m_clientSocket, (sockaddr*)(&addr), (int)sizeof(addr));
+	std::vector<NetMessage> messages;
+	TakeReceivedMessages(messages);
 
-			if (result == SOCKET_ERROR)
-			{
-				int errorCode = WSAGetLastError();
-				if (errorCode == WSAEWOULDBLOCK)
-				{
-					m_clientState = ClientState::CONNECTING;
-				}
-				else
-				{
-					m_clientState = ClientState::TERMINATED;
-					ERROR_AND_DIE("Cannot connect the client socket");
-				}
+	for (NetMessage const& message : messages)
+	{
+		if (message.empty())
+		{
+			continue;
+		}
 
-			}
-			else
+		std::string messageText(message.begin(), message.end());
+		if (m_mode == NetSystemMode::CLIENT)
+		{
+			if (g_theConsole)
 			{
-				m_clientState = ClientState::CONNECTED;
+				g_theConsole->Execute(messageText);
 			}
 		}
-		if (m_clientState == ClientState::CONNECTING)
+		else if (m_mode == NetSystemMode::SERVER)
 		{
-			fd_set writeSockets;
-			fd_set exceptSockets;
-			FD_ZERO(&writeSockets);
-			FD_ZERO(&exceptSockets);
-			FD_SET(m_clientSocket, &writeSockets);
-			FD_SET(m_clientSocket, &exceptSockets);
-			timeval waitTime = { 0 };
+			EventArgs arguments;
+			arguments.SetValue(std::string("InputText"), messageText);
+			g_theEventSystem->FireEvent("echo", arguments);
+		}
+	}
+#else
+	return;
+#endif
+}
 
-			int selectResult = select(0, NULL, &writeSockets, &exceptSockets, &waitTime);
+void NetSystem::EndFrame()
+{
+#if !defined (ENGINE_DISABLE_NETWORK)
+	// Sending happens on the network thread as soon as strings are queued
+#else
+	return;
+#endif
+}
 
-			if (selectResult == SOCKET_ERROR)
-			{
-				sockaddr_in addr;
-				addr.sin_family = AF_INET;
-				addr.sin_addr.S_un.S_addr = (m_hostAddress);
-				addr.sin_port = (m_hostPort);
-				int result = connect(m_clientSocket, (sockaddr*)(&addr), (int)sizeof(addr));
-
-				if (result == SOCKET_ERROR)
-				{
-					int errorCode = WSAGetLastError();
-					if (errorCode == WSAEWOULDBLOCK)
-					{
-						m_clientState = ClientState::CONNECTING;
-					}
-					else
-					{
-						m_clientState = ClientState::TERMINATED;
-						DebuggerPrintf("Error: %d", errorCode);
-					}
-				}
-			}
-			else if (selectResult > 0)
-			{
-				if (FD_ISSET(m_clientSocket, &exceptSockets))
-				{
-					sockaddr_in addr;
-					addr.sin_family = AF_INET;
-					addr.sin_addr.S_un.S_addr = (m_hostAddress);
-					addr.sin_port = (m_hostPort);
-					int result = connect(m_clientSocket, (sockaddr*)(&addr), (int)sizeof(addr));
-					if (result == SOCKET_ERROR)
-					{
-						int errorCode = WSAGetLastError();
-						if (errorCode == WSAEWOULDBLOCK)
-						{
-							m_clientState = ClientState::CONNECTING;
-						}
-						else
-						{
-							m_clientState = ClientState::TERMINATED;
-							DebuggerPrintf("Error: %d", errorCode);
-						}
-					}
-					else
-					{
-						m_clientState = ClientState::CONNECTED;
-					}
-				}
-				else if (FD_ISSET(m_clientSocket, &writeSockets))
-				{
-					m_clientState = ClientState::CONNECTED;
-				}
-				else
-				{
-					m_clientState = ClientState::CONNECTING;
-				}
-			}
+void NetSystem::AddStringToQueue(std::string const& stringLine)
+{
+	AddMessageToQueue(NetMessage(stringLine.begin(), stringLine.end()));
+}
+
+void NetSystem::AddMessageToQueue(NetMessage const& payload)
+{
+	AddMessageToQueue(NetMessage(payload));
+}
+
+void NetSystem::AddMessageToQueue(NetMessage&& payload)
+{
+	GUARANTEE_OR_DIE(payload.size() <= (size_t)m_config.m_maxMessageSize, Stringf("Net message of %zu bytes is over the %i byte limit", payload.size(), m_config.m_maxMessageSize));
+	std::shared_ptr<NetMessage const> sharedPayload = std::make_shared<NetMessage const>(std::move(payload));
+
+	m_sendQueueMutex.lock();
+	bool wasEmpty = m_sendQueue.empty();
+	m_sendQueue.push_back(std::move(sharedPayload));
+	m_sendQueueMutex.unlock();
+
+	// One wake per batch, the network thread takes the whole queue at once
+	if (wasEmpty && m_poller)
+	{
+		m_poller->Wake();
+	}
+}
+
+std::string NetSystem::GetCurrentRecvQueue() const
+{
+	std::string recvQueue;
+	m_recvQueueMutex.lock();
+	for (NetMessage const& message : m_recvQueue)
+	{
+		recvQueue.append(message.begin(), message.end());
+		recvQueue.push_back('\0');
+	}
+	m_recvQueueMutex.unlock();
+	return recvQueue;
+}
+
+void NetSystem::TakeReceivedMessages(std::vector<NetMessage>& outMessages)
+{
+	m_recvQueueMutex.lock();
+	if (outMessages.empty())
+	{
+		outMessages.swap(m_recvQueue);
+	}
+	else
+	{
+		std::move(m_recvQueue.begin(), m_recvQueue.end(), std::back_inserter(outMessages));
+		m_recvQueue.clear();
+	}
+	m_recvQueueMutex.unlock();
+}
+
+NetSystemMode NetSystem::GetSystemMode() const
+{
+	return m_mode;
+}
+
+ClientState NetSystem::GetClientState() const
+{
+	return m_clientState;
+}
+
+ServerState NetSystem::GetServerState() const
+{
+	return m_serverState;
+}
+
+int NetSystem::GetNumConnections() const
+{
+	return m_numConnections.load(std::memory_order_acquire);
+}
+
+int NetSystem::GetListenPort() const
+{
+	return m_listenPort.load(std::memory_order_acquire);
+}
+
+void NetSystem::GetChannelPeers(std::vector<NetAddress>& outPeers) const
+{
+	m_channelMutex.lock();
+	for (NetChannelPeer const* peer : m_channelPeers)
+	{
+		outPeers.push_back(peer->m_address);
+	}
+	m_channelMutex.unlock();
+}
+
+bool NetSystem::SendReliableOnChannel(NetAddress const& peer, NetMessage&& payload)
+{
+	m_channelMutex.lock();
+	NetChannel* channel = FindChannel(peer);
+	bool isQueued = channel && channel->SendReliable(std::move(payload));
+	m_channelMutex.unlock();
+	return isQueued;
+}
+
+bool NetSystem::SendUnreliableOnChannel(NetAddress const& peer, NetMessage&& payload)
+{
+	m_channelMutex.lock();
+	NetChannel* channel = FindChannel(peer);
+	bool isQueued = channel && channel->SendUnreliable(std::move(payload));
+	m_channelMutex.unlock();
+	return isQueued;
+}
+
+bool NetSystem::SetChannelSnapshot(NetAddress const& peer, NetMessage const& snapshot)
+{
+	m_channelMutex.lock();
+	NetChannel* channel = FindChannel(peer);
+	bool isSet = channel && channel->SetSnapshot(snapshot);
+	m_channelMutex.unlock();
+	return isSet;
+}
+
+bool NetSystem::TakeChannelMessages(NetAddress const& peer, std::vector<NetMessage>& outReliableMessages, std::vector<NetMessage>& outUnreliableMessages)
+{
+	m_channelMutex.lock();
+	NetChannel* channel = FindChannel(peer);
+	if (channel)
+	{
+		channel->TakeReliableMessages(outReliableMessages);
+		channel->TakeUnreliableMessages(outUnreliableMessages);
+	}
+	m_channelMutex.unlock();
+	return channel != nullptr;
+}
+
+bool NetSystem::TakeChannelSnapshot(NetAddress const& peer, NetMessage& outSnapshot)
+{
+	m_channelMutex.lock();
+	NetChannel* channel = FindChannel(peer);
+	bool isTaken = channel && channel->TakeSnapshot(outSnapshot);
+	m_channelMutex.unlock();
+	return isTaken;
+}
+
+bool NetSystem::GetChannelStats(NetAddress const& peer, NetChannelStats& outStats) const
+{
+	m_channelMutex.lock();
+	NetChannel* channel = FindChannel(peer);
+	if (channel)
+	{
+		outStats = channel->GetStats();
+	}
+	m_channelMutex.unlock();
+	return channel != nullptr;
+}
+
+NetChannel* NetSystem::FindChannel(NetAddress const& peer) const
+{
+	for (NetChannelPeer* channelPeer : m_channelPeers)
+	{
+		if (channelPeer->m_address == peer)
+		{
+			return &channelPeer->m_channel;
 		}
-		if (m_clientState == ClientState::CONNECTED)
+	}
+	return nullptr;
+}
+
+// -----------------------------NETWORK THREAD----------------------------------
+void NetSystem::NetworkThreadMain()
+{
+	std::vector<NetPollEvent> events;
+	while (!m_isQuitting.load(std::memory_order_acquire))
+	{
+		if (m_mode == NetSystemMode::CLIENT && m_connections.empty() && GetCurrentTimeSeconds() >= m_nextConnectSeconds)
 		{
-			int currentBufferSize = m_config.m_sendBufferSize;
-			std::memset(m_sendBuffer, 0, m_config.m_sendBufferSize);
+			TryConnectToServer();
+		}
+
+		// Channels wake the thread on their tick, round up so it is never early
+		int waitMilliseconds = NET_IDLE_WAIT_MILLISECONDS;
+		if (m_channelSocket != INVALID_NET_SOCKET)
+		{
+			double secondsToTick = std::max(m_nextChannelTickSeconds - GetCurrentTimeSeconds(), 0.0);
+			waitMilliseconds = std::min(waitMilliseconds, (int)std::ceil(secondsToTick * 1000.0));
+		}
 
-			while (m_sendQueue.empty() == false && currentBufferSize > 0)
+		m_poller->Wait(events, waitMilliseconds);
+		for (NetPollEvent const& pollEvent : events)
+		{
+			if (pollEvent.m_userData == &m_listenSocket)
 			{
-				std::string& currentString = m_sendQueue.front();
-
-				if (currentString.size() < currentBufferSize)
-				{
-					std::string sendString = currentString;
-					sendString.push_back('\0');
-					memcpy(m_sendBuffer + (m_config.m_sendBufferSize - currentBufferSize), sendString.c_str(), sendString.size());
-					currentBufferSize -= (int)sendString.size();
-					m_sendQueue.pop_front();
-				}
-				else
-				{
-					std::string sendString = currentString.substr(0, currentBufferSize);
-					currentString.erase(0, sendString.size());
-					memcpy(m_sendBuffer + (m_config.m_sendBufferSize - currentBufferSize), sendString.c_str(), sendString.size());
-					currentBufferSize = 0;
-				}
+				AcceptConnections();
 			}
-			int result = 0;
-			
-			if (currentBufferSize < m_config.m_sendBufferSize)
+			else if (pollEvent.m_userData == &m_channelSocket)
 			{
-				result = send(m_clientSocket, m_sendBuffer, m_config.m_sendBufferSize, 0);
-				currentBufferSize = m_config.m_sendBufferSize;
-				if (result == SOCKET_ERROR)
-				{
-					int sendError = WSAGetLastError();
-					if (sendError != WSAEWOULDBLOCK)
-					{
-						closesocket(m_clientSocket);
-						m_clientSocket = INVALID_SOCKET;
-						m_clientSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-	
-						unsigned long blockingMode = 1;
-						ioctlsocket(m_clientSocket, FIONBIO, &blockingMode);
-						m_clientState = ClientState::DISCONNECTED;
-					}
-				}
+				ReceiveOnChannels();
 			}
-			
-
-			while (true)
+			else
 			{
-				result = recv(m_clientSocket, m_recvBuffer, m_config.m_recvBufferSize, 0);
-
-				if (result > 0)
-				{
-					m_recvQueue.append(m_recvBuffer, result);
-
-					while (!m_recvQueue.empty() && m_recvQueue.back() == '\0')
-					{
-						Strings commands = SplitStringOnDelimiter(m_recvQueue, '\0');
-
-						for (const std::string& command : commands)
-						{
-							if (!command.empty())
-							{
-								g_theConsole->Execute(command);
-							}
-						}
-						m_recvQueue.clear();
-					}
-				}
-				else if (result == 0)
-				{
-					closesocket(m_clientSocket);
-					m_clientSocket = INVALID_SOCKET;
-					m_clientState = ClientState::DISCONNECTED;
-					break;
-				}
-				else if (result == SOCKET_ERROR)
-				{
-					int errorCode = WSAGetLastError();
-					if (errorCode == WSAEWOULDBLOCK)
-					{
-						break;
-					}
-					else
-					{
-						closesocket(m_clientSocket);
-						m_clientSocket = INVALID_SOCKET;
-						m_clientState = ClientState::DISCONNECTED;
-						break;
-					}
-				}
+				HandleConnectionEvent(static_cast<NetConnection*>(pollEvent.m_userData), pollEvent.m_flags);
 			}
 		}
+
+		QueueOutgoingMessages();
+		UpdateConnectionStates();
+
+		if (m_channelSocket != INVALID_NET_SOCKET && GetCurrentTimeSeconds() >= m_nextChannelTickSeconds)
+		{
+			SendOnChannels();
+		}
 	}
+}
 
-	if (m_mode == NetSystemMode::SERVER)
+void NetSystem::TryConnectToServer()
+{
+	m_nextConnectSeconds = GetCurrentTimeSeconds() + NET_RECONNECT_INTERVAL_SECONDS;
+
+	NetSocketHandle socketHandle = CreateTcpSocket();
+	if (socketHandle == INVALID_NET_SOCKET)
+	{
+		return;
+	}
+
+	NetSocketResult result = StartConnect(socketHandle, m_hostAddress);
+	if (result == NetSocketResult::FAILED)
+	{
+		CloseNetSocket(socketHandle);
+		m_clientState = ClientState::DISCONNECTED;
+		return;
+	}
+
+	NetConnection* connection = new NetConnection();
+	connection->m_socket = socketHandle;
+	connection->m_isConnecting = result == NetSocketResult::IN_PROGRESS;
+	m_connections.push_back(connection);
+
+	if (connection->m_isConnecting)
+	{
+		m_poller->Add(socketHandle, NET_POLL_WRITE, connection);
+		m_clientState = ClientState::CONNECTING;
+	}
+	else
 	{
-		int result = 0;
+		m_poller->Add(socketHandle, NET_POLL_READ, connection);
+		m_clientState = ClientState::CONNECTED;
+	}
+}
 
-		if (m_serverState == ServerState::LISTENING)
+void NetSystem::AcceptConnections()
+{
+	for (;;)
+	{
+		NetSocketHandle socketHandle = AcceptConnection(m_listenSocket);
+		if (socketHandle == INVALID_NET_SOCKET)
 		{
-			if (m_clientSocket == INVALID_SOCKET)
-			{
-				m_clientSocket = accept(m_listenSocket, NULL, NULL);
-
-				if (m_clientSocket == INVALID_SOCKET)
-				{
-					int errorCode = WSAGetLastError();
-					if (errorCode != WSAEWOULDBLOCK)
-					{
-						m_serverState = ServerState::DISCONNECTED;
-						ERROR_AND_DIE("clientSocket is invalid ");
-					}
-					m_serverState = ServerState::LISTENING;
-				}
-				else
-				{
-					unsigned long blockingMode = 1;
-					ioctlsocket(m_clientSocket, FIONBIO, &blockingMode);
-					m_serverState = ServerState::CONNECTED;
-				}
-			}
-			else
+			return;
+		}
+
+		if ((int)m_connections.size() >= m_config.m_maxConnections)
+		{
+			CloseNetSocket(socketHandle);
+			continue;
+		}
+
+		NetConnection* connection = new NetConnection();
+		connection->m_socket = socketHandle;
+		m_connections.push_back(connection);
+		m_poller->Add(socketHandle, NET_POLL_READ, connection);
+	}
+}
+
+void NetSystem::HandleConnectionEvent(NetConnection* connection, unsigned int pollFlags)
+{
+	if (connection->m_isConnecting)
+	{
+		if (FinishConnect(connection->m_socket) != NetSocketResult::OK)
+		{
+			CloseConnection(connection);
+			m_clientState = ClientState::DISCONNECTED;
+			return;
+		}
+
+		connection->m_isConnecting = false;
+		m_poller->Modify(connection->m_socket, NET_POLL_READ, connection);
+		m_clientState = ClientState::CONNECTED;
+		return;
+	}
+
+	if (pollFlags & (NET_POLL_READ | NET_POLL_ERROR))
+	{
+		ReceiveOnConnection(connection);
+		return;
+	}
+	if (pollFlags & NET_POLL_WRITE)
+	{
+		FlushConnection(connection);
+	}
+}
+
+void NetSystem::ReceiveOnConnection(NetConnection* connection)
+{
+	if (connection->m_recvRing.empty())
+	{
+		connection->m_recvRing.resize(RoundUpToPowerOfTwo((size_t)std::max(m_config.m_recvBufferSize, (int)NET_MESSAGE_HEADER_SIZE)));
+	}
+
+	std::vector<NetMessage> messages;
+	bool isOpen = true;
+	while (isOpen)
+	{
+		// A full ring means a message bigger than it is still coming in
+		size_t capacity = connection->m_recvRing.size();
+		if (connection->m_recvSize == capacity)
+		{
+			GrowRing(connection, capacity * 2);
+			capacity = connection->m_recvRing.size();
+		}
+
+		// The free space is at most two pieces, the end of the ring and the start when it wraps
+		size_t freeStart = (connection->m_recvStart + connection->m_recvSize) & (capacity - 1);
+		size_t numFreeBytes = capacity - connection->m_recvSize;
+		size_t numFirstBytes = std::min(numFreeBytes, capacity - freeStart);
+
+		NetIoBuffer buffers[2];
+		buffers[0].m_data = connection->m_recvRing.data() + freeStart;
+		buffers[0].m_size = numFirstBytes;
+		buffers[1].m_data = connection->m_recvRing.data();
+		buffers[1].m_size = numFreeBytes - numFirstBytes;
+
+		size_t numBytesReceived = 0;
+		NetSocketResult result = ReceiveScatterOnSocket(connection->m_socket, buffers, buffers[1].m_size > 0 ? 2 : 1, numBytesReceived);
+		if (result == NetSocketResult::WOULD_BLOCK)
+		{
+			break;
+		}
+
+		if (result == NetSocketResult::OK)
+		{
+			connection->m_recvSize += numBytesReceived;
+			isOpen = ExtractMessages(connection, messages);
+		}
+		else
+		{
+			isOpen = false;
+		}
+	}
+
+	if (!messages.empty())
+	{
+		m_recvQueueMutex.lock();
+		std::move(messages.begin(), messages.end(), std::back_inserter(m_recvQueue));
+		m_recvQueueMutex.unlock();
+	}
+
+	if (!isOpen)
+	{
+		CloseConnection(connection);
+		return;
+	}
+	if (connection->m_isWriteWanted)
+	{
+		FlushConnection(connection);
+	}
+}
+
+bool NetSystem::ExtractMessages(NetConnection* connection, std::vector<NetMessage>& outMessages)
+{
+	while (connection->m_recvSize >= NET_MESSAGE_HEADER_SIZE)
+	{
+		unsigned char header[NET_MESSAGE_HEADER_SIZE];
+		CopyFromRing(connection, 0, header, NET_MESSAGE_HEADER_SIZE);
+		BufferParser headerParser(header, NET_MESSAGE_HEADER_SIZE, eBufferEndian::LITTLE);
+		size_t payloadSize = (size_t)headerParser.ParseUint32();
+		if (payloadSize > (size_t)m_config.m_maxMessageSize)
+		{
+			return false;
+		}
+
+		size_t frameSize = NET_MESSAGE_HEADER_SIZE + payloadSize;
+		if (connection->m_recvSize < frameSize)
+		{
+			if (frameSize > connection->m_recvRing.size())
 			{
-				m_serverState = ServerState::CONNECTED;
+				GrowRing(connection, frameSize);
 			}
+			return true;
 		}
-		if (m_serverState == ServerState::CONNECTED)
+
+		outMessages.emplace_back(payloadSize);
+		if (payloadSize > 0)
 		{
-			int currentBufferSize = m_config.m_sendBufferSize;
-			std::memset(m_sendBuffer, 0, m_config.m_sendBufferSize);
+			CopyFromRing(connection, NET_MESSAGE_HEADER_SIZE, outMessages.back().data(), payloadSize);
+		}
+		connection->m_recvStart = (connection->m_recvStart + frameSize) & (connection->m_recvRing.size() - 1);
+		connection->m_recvSize -= frameSize;
+	}
+	return true;
+}
 
-			while (m_sendQueue.empty() == false && currentBufferSize > 0)
+void NetSystem::FlushConnection(NetConnection* connection)
+{
+	while (!connection->m_outgoing.empty())
+	{
+		// Gather headers and payloads of as many frames as one call takes, skipping what was already sent
+		NetIoBuffer buffers[NET_MAX_IO_BUFFERS];
+		int numBuffers = 0;
+		size_t numBytesGathered = 0;
+		size_t numBytesToSkip = connection->m_outgoingOffset;
+		for (NetOutgoingFrame const& frame : connection->m_outgoing)
+		{
+			if (numBuffers + 2 > NET_MAX_IO_BUFFERS || numBytesGathered >= (size_t)m_config.m_sendBufferSize)
 			{
-				std::string& currentString = m_sendQueue.front();
-
-				if (currentString.size() < currentBufferSize)
-				{
-					std::string sendString = currentString;
-					sendString.push_back('\0');
-					memcpy(m_sendBuffer + (m_config.m_sendBufferSize - currentBufferSize), sendString.c_str(), sendString.size());
-					currentBufferSize -= (int)sendString.size();
-					m_sendQueue.pop_front();
-				}
-				else
-				{
-					std::string sendString = currentString.substr(0, currentBufferSize);
-					currentString.erase(0, sendString.size());
-					memcpy(m_sendBuffer + (m_config.m_sendBufferSize - currentBufferSize), sendString.c_str(), sendString.size());
-					currentBufferSize = 0;
-				}
+				break;
 			}
 
-			if (currentBufferSize < m_config.m_sendBufferSize)
+			size_t numHeaderBytesToSkip = std::min(numBytesToSkip, NET_MESSAGE_HEADER_SIZE);
+			if (numHeaderBytesToSkip < NET_MESSAGE_HEADER_SIZE)
 			{
-				result = send(m_clientSocket, m_sendBuffer, m_config.m_sendBufferSize, 0);
-				if (result == SOCKET_ERROR)
-				{
-					int sendError = WSAGetLastError();
-					if (sendError != WSAEWOULDBLOCK)
-					{
-						closesocket(m_clientSocket);
-						m_clientSocket = INVALID_SOCKET;
-						m_clientSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-
-						unsigned long blockingMode = 1;
-						ioctlsocket(m_clientSocket, FIONBIO, &blockingMode);
-						m_serverState = ServerState::LISTENING;
-					}
-				}
+				buffers[numBuffers].m_data = (void*)(frame.m_header + numHeaderBytesToSkip);
+				buffers[numBuffers].m_size = NET_MESSAGE_HEADER_SIZE - numHeaderBytesToSkip;
+				numBytesGathered += buffers[numBuffers++].m_size;
 			}
+			numBytesToSkip -= numHeaderBytesToSkip;
 
-
-			while (true)
+			size_t numPayloadBytesToSkip = std::min(numBytesToSkip, frame.m_payload->size());
+			if (numPayloadBytesToSkip < frame.m_payload->size())
 			{
-				result = recv(m_clientSocket, m_recvBuffer, m_config.m_recvBufferSize, 0);
-
-				if (result > 0)
-				{
-					m_recvQueue.append(m_recvBuffer, result);
-
-					while (!m_recvQueue.empty() && m_recvQueue.back() == '\0')
-					{
-						Strings commands = SplitStringOnDelimiter(m_recvQueue, '\0');
-
-						for (const std::string& command : commands)
-						{
-							if (!command.empty())
-							{
-								EventArgs arguments;
-								arguments.SetValue(std::string("InputText"), command);
-								g_theEventSystem->FireEvent("echo", arguments);
-							}
-						}
-						m_recvQueue.clear(); 
-					}
-				}
-				else if (result == 0)
-				{
-					closesocket(m_clientSocket);
-					m_clientSocket = INVALID_SOCKET;
-					m_serverState = ServerState::LISTENING;
-					break;
-				}
-				else if (result == SOCKET_ERROR)
-				{
-					int errorCode = WSAGetLastError();
-					if (errorCode == WSAEWOULDBLOCK)
-					{
-						break;
-					}
-					else
-					{
-						closesocket(m_clientSocket);
-						m_clientSocket = INVALID_SOCKET;
-						m_serverState = ServerState::LISTENING;
-						break;
-					}
-				}
+				buffers[numBuffers].m_data = (void*)(frame.m_payload->data() + numPayloadBytesToSkip);
+				buffers[numBuffers].m_size = frame.m_payload->size() - numPayloadBytesToSkip;
+				numBytesGathered += buffers[numBuffers++].m_size;
 			}
+			numBytesToSkip = 0;
 		}
 
+		size_t numBytesSent = 0;
+		NetSocketResult result = SendGatherOnSocket(connection->m_socket, buffers, numBuffers, numBytesSent);
+		if (result == NetSocketResult::WOULD_BLOCK)
+		{
+			break;
+		}
+		if (result != NetSocketResult::OK)
+		{
+			CloseConnection(connection);
+			return;
+		}
+
+		size_t numBytesDone = connection->m_outgoingOffset + numBytesSent;
+		while (!connection->m_outgoing.empty() && numBytesDone >= connection->m_outgoing.front().GetFrameSize())
+		{
+			numBytesDone -= connection->m_outgoing.front().GetFrameSize();
+			connection->m_outgoing.pop_front();
+		}
+		connection->m_outgoingOffset = numBytesDone;
+
+		if (numBytesSent < numBytesGathered)
+		{
+			break;
+		}
 	}
-#else
-	return;
-#endif
-}
 
-void NetSystem::EndFrame()
-{
-#if !defined (ENGINE_DISABLE_NETWORK)
-	// Do normal system stuff and return appropriate return values
-#else
-	return;
-#endif
+	// Only ask for writability while something is stuck, a writable socket would wake us constantly
+	bool isDone = connection->m_outgoing.empty();
+	if (isDone == connection->m_isWriteWanted)
+	{
+		connection->m_isWriteWanted = !isDone;
+		m_poller->Modify(connection->m_socket, NET_POLL_READ | (isDone ? 0u : (unsigned int)NET_POLL_WRITE), connection);
+	}
 }
 
-void NetSystem::AddStringToQueue(std::string const& stringLine)
+void NetSystem::QueueOutgoingMessages()
 {
-	m_sendQueue.push_back(stringLine);
+	std::vector<NetConnection*> connections;
+	for (NetConnection* connection : m_connections)
+	{
+		if (!connection->m_isConnecting)
+		{
+			connections.push_back(connection);
+		}
+	}
+
+	// Messages wait in the queue until there is someone to send them to
+	if (connections.empty())
+	{
+		return;
+	}
+
+	std::vector<std::shared_ptr<NetMessage const>> payloads;
+	m_sendQueueMutex.lock();
+	payloads.swap(m_sendQueue);
+	m_sendQueueMutex.unlock();
+
+	if (payloads.empty())
+	{
+		return;
+	}
+
+	std::vector<NetOutgoingFrame> frames(payloads.size());
+	for (size_t frameIndex = 0; frameIndex < frames.size(); ++frameIndex)
+	{
+		BufferWriter headerWriter(frames[frameIndex].m_header, NET_MESSAGE_HEADER_SIZE, eBufferEndian::LITTLE);
+		headerWriter.AppendPrimitive<uint32_t>((uint32_t)payloads[frameIndex]->size());
+		frames[frameIndex].m_payload = std::move(payloads[frameIndex]);
+	}
+
+	// Every connection shares the same payloads
+	for (NetConnection* connection : connections)
+	{
+		connection->m_outgoing.insert(connection->m_outgoing.end(), frames.begin(), frames.end());
+		FlushConnection(connection);
+	}
 }
 
-std::string NetSystem::GetCurrentRecvQueue() const
+void NetSystem::CloseConnection(NetConnection* connection)
 {
-	return m_recvQueue;
+	m_poller->Remove(connection->m_socket);
+	CloseNetSocket(connection->m_socket);
+	m_connections.erase(std::find(m_connections.begin(), m_connections.end(), connection));
+	delete connection;
+
+	if (m_mode == NetSystemMode::CLIENT)
+	{
+		m_clientState = ClientState::DISCONNECTED;
+		m_nextConnectSeconds = GetCurrentTimeSeconds() + NET_RECONNECT_INTERVAL_SECONDS;
+	}
 }
 
-NetSystemMode NetSystem::GetSystemMode() const
+void NetSystem::UpdateConnectionStates()
 {
-	return m_mode;
+	int numConnections = 0;
+	for (NetConnection* connection : m_connections)
+	{
+		if (!connection->m_isConnecting)
+		{
+			numConnections++;
+		}
+	}
+	m_numConnections.store(numConnections, std::memory_order_release);
+
+	if (m_mode == NetSystemMode::SERVER)
+	{
+		m_serverState = numConnections > 0 ? ServerState::CONNECTED : ServerState::LISTENING;
+	}
 }
 
-ClientState NetSystem::GetClientState() const
+void NetSystem::ReceiveOnChannels()
 {
-	return m_clientState;
+	double currentSeconds = GetCurrentTimeSeconds();
+	m_channelMutex.lock();
+	for (;;)
+	{
+		size_t numBytesReceived = 0;
+		NetAddress fromAddress;
+		NetSocketResult result = ReceiveFromSocket(m_channelSocket, m_datagramBuffer.data(), m_datagramBuffer.size(), numBytesReceived, fromAddress);
+		if (result != NetSocketResult::OK)
+		{
+			break;
+		}
+
+		NetChannelPeer* fromPeer = nullptr;
+		for (NetChannelPeer* peer : m_channelPeers)
+		{
+			if (peer->m_address == fromAddress)
+			{
+				fromPeer = peer;
+				break;
+			}
+		}
+
+		if (fromPeer)
+		{
+			if (fromPeer->m_channel.ReadPacket(m_datagramBuffer.data(), numBytesReceived, currentSeconds))
+			{
+				fromPeer->m_lastReceivedSeconds = currentSeconds;
+			}
+			continue;
+		}
+
+		// Clients only talk to the host, servers take new peers until they are full and only for a packet that parses
+		if (m_mode != NetSystemMode::SERVER || (int)m_channelPeers.size() >= m_config.m_maxConnections)
+		{
+			continue;
+		}
+		NetChannelPeer* newPeer = new NetChannelPeer();
+		newPeer->m_address = fromAddress;
+		if (newPeer->m_channel.ReadPacket(m_datagramBuffer.data(), numBytesReceived, currentSeconds))
+		{
+			newPeer->m_lastReceivedSeconds = currentSeconds;
+			m_channelPeers.push_back(newPeer);
+		}
+		else
+		{
+			delete newPeer;
+		}
+	}
+	m_channelMutex.unlock();
 }
 
-ServerState NetSystem::GetServerState() const
+void NetSystem::SendOnChannels()
 {
-	return m_serverState;
+	double currentSeconds = GetCurrentTimeSeconds();
+	// Ticks stay on their schedule, but a thread that fell behind skips the ones it missed instead of bursting
+	m_nextChannelTickSeconds += m_config.m_channelTickSeconds;
+	if (m_nextChannelTickSeconds < currentSeconds)
+	{
+		m_nextChannelTickSeconds = currentSeconds + m_config.m_channelTickSeconds;
+	}
+
+	NetMessage packet;
+	m_channelMutex.lock();
+	for (size_t peerIndex = 0; peerIndex < m_channelPeers.size();)
+	{
+		NetChannelPeer* peer = m_channelPeers[peerIndex];
+		if (m_mode == NetSystemMode::SERVER && currentSeconds - peer->m_lastReceivedSeconds > m_config.m_channelTimeoutSeconds)
+		{
+			delete peer;
+			m_channelPeers.erase(m_channelPeers.begin() + peerIndex);
+			continue;
+		}
+
+		// A datagram the socket cannot take is lost like any other, the channel resends what matters
+		peer->m_channel.WritePacket(packet, currentSeconds);
+		SendToSocket(m_channelSocket, packet.data(), packet.size(), peer->m_address);
+		++peerIndex;
+	}
+	m_channelMutex.unlock();
 }
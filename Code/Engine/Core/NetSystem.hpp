@@ -1,15 +1,28 @@
-#pragma 
+#pragma once
+#include "Engine/Core/NetSocket.hpp"
+#include <atomic>
 #include <string>
 #include <cstdint>
 #include <vector>
-#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class NetChannel;
+struct NetChannelStats;
 
 struct NetSystemConfig
 {
 	std::string m_modeString;
 	std::string m_hostAddressString;
-	int			m_sendBufferSize = 2048;
-	int			m_recvBufferSize = 2048;
+	int			m_sendBufferSize = 65536;		// A send call stops gathering messages past this many bytes
+	int			m_recvBufferSize = 65536;		// Starting size of each connection's receive ring, it grows for bigger messages
+	int			m_maxMessageSize = 1 << 20;		// Connections announcing a bigger message are closed
+	int			m_maxConnections = 64;			// Server only, connections past this are refused
+	bool		m_isDispatchingMessages = true;	// BeginFrame runs received messages (console commands on clients, echo events on servers), otherwise take them with TakeReceivedMessages
+	bool		m_hasChannels = false;			// Also run a NetChannel per peer over a UDP socket on the host port, see the channel functions
+	double		m_channelTickSeconds = 1.0 / 60.0;	// Every channel writes a packet this often
+	double		m_channelTimeoutSeconds = 5.0;	// Server only, channels of peers silent for this long are dropped
 };
 
 enum class NetSystemMode
@@ -36,6 +49,23 @@ enum class ServerState
 	TERMINATED
 };
 
+struct NetConnection;
+struct NetChannelPeer;
+
+// A message payload, build one with a BufferWriter over it and read it back with a BufferParser.
+// On the wire every payload follows a 4 byte little endian length header.
+typedef std::vector<unsigned char> NetMessage;
+constexpr size_t NET_MESSAGE_HEADER_SIZE = 4;
+
+//-----------------------------------------------------------------------------------
+// All socket work happens on a dedicated network thread that waits on every socket at once, a
+// server serves any number of clients from it. The game thread only touches queues: strings
+// added with AddStringToQueue or AddMessageToQueue are sent to the server, or to every client of
+// a server, and received messages are handed back in BeginFrame.
+// With m_hasChannels the network thread also runs a NetChannel per peer over UDP: a client's one
+// channel goes to the host address from StartUp, a server opens one on the first valid packet from
+// a new address. The game thread reaches a channel by its peer address, which fails for unknown peers.
+//
 class NetSystem
 {
 public:
@@ -49,24 +79,69 @@ public:
 	void				EndFrame();
 
 	void				AddStringToQueue(std::string const& stringLine);
-	std::string			GetCurrentRecvQueue() const;
+	void				AddMessageToQueue(NetMessage&& payload);
+	void				AddMessageToQueue(NetMessage const& payload);
+	std::string			GetCurrentRecvQueue() const;											// Received messages BeginFrame has not handled yet, '\0' separated
+	void				TakeReceivedMessages(std::vector<NetMessage>& outMessages);				// Appends and clears them
 	NetSystemMode		GetSystemMode() const;
 	ClientState			GetClientState() const;
 	ServerState			GetServerState() const;
+	int					GetNumConnections() const;
+	int					GetListenPort() const;													// The bound port, useful when the config asked for port 0
+
+	void				GetChannelPeers(std::vector<NetAddress>& outPeers) const;
+	bool				SendReliableOnChannel(NetAddress const& peer, NetMessage&& payload);	// False for unknown peers and payloads too big for a packet
+	bool				SendUnreliableOnChannel(NetAddress const& peer, NetMessage&& payload);
+	bool				SetChannelSnapshot(NetAddress const& peer, NetMessage const& snapshot);
+	bool				TakeChannelMessages(NetAddress const& peer, std::vector<NetMessage>& outReliableMessages, std::vector<NetMessage>& outUnreliableMessages);
+	bool				TakeChannelSnapshot(NetAddress const& peer, NetMessage& outSnapshot);
+	bool				GetChannelStats(NetAddress const& peer, NetChannelStats& outStats) const;
+
 private:
+	void				NetworkThreadMain();
+	void				TryConnectToServer();
+	void				AcceptConnections();
+	void				HandleConnectionEvent(NetConnection* connection, unsigned int pollFlags);
+	void				ReceiveOnConnection(NetConnection* connection);
+	bool				ExtractMessages(NetConnection* connection, std::vector<NetMessage>& outMessages);
+	void				FlushConnection(NetConnection* connection);
+	void				QueueOutgoingMessages();
+	void				CloseConnection(NetConnection* connection);
+	void				UpdateConnectionStates();
+	void				ReceiveOnChannels();
+	void				SendOnChannels();
+	NetChannel*			FindChannel(NetAddress const& peer) const;								// Lock m_channelMutex first
 
+private:
 	NetSystemConfig				m_config;
 	NetSystemMode				m_mode;
-	ClientState					m_clientState = ClientState::DISCONNECTED;
-	ServerState					m_serverState;
-	uintptr_t					m_clientSocket = ~0ull;	// equivalent to INVALID_SOCKET;
-	unsigned long				m_hostAddress = 0;
-	unsigned short				m_hostPort = 0;
-	uintptr_t					m_listenSocket = ~0ull;
-	char*						m_sendBuffer;
-	char*						m_recvBuffer;
-
-	std::deque<std::string>	m_sendQueue;
-	std::string					m_recvQueue;
+	std::atomic<ClientState>	m_clientState = ClientState::DISCONNECTED;
+	std::atomic<ServerState>	m_serverState = ServerState::DISCONNECTED;
+	NetAddress					m_hostAddress;
+	std::atomic<int>			m_listenPort = 0;
+	std::atomic<int>			m_numConnections = 0;
+
+	// Network thread only
+	NetPoller*					m_poller = nullptr;
+	NetSocketHandle				m_listenSocket = INVALID_NET_SOCKET;
+	std::vector<NetConnection*>	m_connections;
+	double						m_nextConnectSeconds = 0.0;
+	NetSocketHandle				m_channelSocket = INVALID_NET_SOCKET;
+	double						m_nextChannelTickSeconds = 0.0;
+	std::vector<unsigned char>	m_datagramBuffer;
+
+	std::thread*				m_networkThread = nullptr;
+	std::atomic<bool>			m_isQuitting = false;
+
+	// Game thread to network thread
+	std::mutex					m_sendQueueMutex;
+	std::vector<std::shared_ptr<NetMessage const>>	m_sendQueue;
+
+	// Network thread to game thread
+	mutable std::mutex			m_recvQueueMutex;
+	std::vector<NetMessage>		m_recvQueue;
 
+	// Both threads, the network thread reads and writes packets under the lock
+	mutable std::mutex			m_channelMutex;
+	std::vector<NetChannelPeer*>	m_channelPeers;
 };
@@ -0,0 +1,171 @@
+#include "Engine/Core/NetSystemBenchmark.hpp"
+#include "Engine/Core/NetSystem.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include <algorithm>
+#include <thread>
+
+template<typename Condition>
+static bool WaitForCondition(Condition const& condition, double timeoutSeconds)
+{
+	double giveUpSeconds = GetCurrentTimeSeconds() + timeoutSeconds;
+	while (!condition())
+	{
+		if (GetCurrentTimeSeconds() > giveUpSeconds)
+		{
+			return false;
+		}
+		std::this_thread::yield();
+	}
+	return true;
+}
+
+NetLoopbackBenchmarkResult RunNetLoopbackBenchmark(int numClients, int numMessages, int numRoundTrips)
+{
+	NetLoopbackBenchmarkResult benchmarkResult;
+	benchmarkResult.m_numClients = numClients;
+	benchmarkResult.m_numMessages = numClients * numMessages;
+
+	NetSystemConfig serverConfig;
+	serverConfig.m_modeString = "Server";
+	serverConfig.m_hostAddressString = "127.0.0.1:0";
+	serverConfig.m_isDispatchingMessages = false;
+	serverConfig.m_maxConnections = numClients;
+	NetSystem server(serverConfig);
+	server.StartUp();
+
+	NetSystemConfig clientConfig;
+	clientConfig.m_modeString = "Client";
+	clientConfig.m_hostAddressString = Stringf("127.0.0.1:%i", server.GetListenPort());
+	clientConfig.m_isDispatchingMessages = false;
+
+	std::vector<NetSystem*> clients;
+	for (int clientIndex = 0; clientIndex < numClients; ++clientIndex)
+	{
+		clients.push_back(new NetSystem(clientConfig));
+		clients.back()->StartUp();
+	}
+
+	auto deleteClients = [&clients](size_t firstClient)
+	{
+		for (size_t clientIndex = firstClient; clientIndex < clients.size(); ++clientIndex)
+		{
+			clients[clientIndex]->ShutDown();
+			delete clients[clientIndex];
+		}
+		clients.resize(std::min(firstClient, clients.size()));
+	};
+
+	bool isConnected = WaitForCondition([&]()
+	{
+		for (NetSystem* client : clients)
+		{
+			if (client->GetClientState() != ClientState::CONNECTED)
+			{
+				return false;
+			}
+		}
+		return server.GetNumConnections() == numClients;
+	}, 5.0);
+	if (!isConnected)
+	{
+		deleteClients(0);
+		return benchmarkResult;
+	}
+
+	// Throughput, every client floods the server
+	NetMessage payload(48, 'x');
+	std::vector<NetMessage> messages;
+	int numReceived = 0;
+
+	double startSeconds = GetCurrentTimeSeconds();
+	for (int messageIndex = 0; messageIndex < numMessages; ++messageIndex)
+	{
+		for (NetSystem* client : clients)
+		{
+			client->AddMessageToQueue(payload);
+		}
+	}
+	bool isAllReceived = WaitForCondition([&]()
+	{
+		server.TakeReceivedMessages(messages);
+		numReceived += (int)messages.size();
+		messages.clear();
+		return numReceived >= benchmarkResult.m_numMessages;
+	}, 30.0);
+	double elapsedSeconds = GetCurrentTimeSeconds() - startSeconds;
+	benchmarkResult.m_messagesPerSecond = elapsedSeconds > 0.0 ? (double)numReceived / elapsedSeconds : 0.0;
+
+	// Latency, one client pings and the server echoes. Servers send to every client so drop the others first
+	deleteClients(1);
+	bool isSingleClient = WaitForCondition([&]() { return server.GetNumConnections() == 1; }, 5.0);
+
+	std::vector<double> roundTripsMs;
+	NetSystem* client = clients.empty() ? nullptr : clients[0];
+	for (int roundTripIndex = 0; client && isAllReceived && isSingleClient && roundTripIndex < numRoundTrips; ++roundTripIndex)
+	{
+		double pingSeconds = GetCurrentTimeSeconds();
+		client->AddStringToQueue("ping");
+
+		bool isEchoed = WaitForCondition([&]()
+		{
+			server.TakeReceivedMessages(messages);
+			return !messages.empty();
+		}, 5.0);
+		for (NetMessage& message : messages)
+		{
+			server.AddMessageToQueue(std::move(message));
+		}
+		messages.clear();
+
+		bool isAnswered = isEchoed && WaitForCondition([&]()
+		{
+			client->TakeReceivedMessages(messages);
+			return !messages.empty();
+		}, 5.0);
+		messages.clear();
+
+		if (!isAnswered)
+		{
+			break;
+		}
+		roundTripsMs.push_back((GetCurrentTimeSeconds() - pingSeconds) * 1000.0);
+	}
+
+	deleteClients(0);
+	server.ShutDown();
+
+	if (!roundTripsMs.empty())
+	{
+		double totalMs = 0.0;
+		for (double roundTripMs : roundTripsMs)
+		{
+			totalMs += roundTripMs;
+		}
+		std::sort(roundTripsMs.begin(), roundTripsMs.end());
+		benchmarkResult.m_averageRoundTripMs = totalMs / (double)roundTripsMs.size();
+		benchmarkResult.m_medianRoundTripMs = roundTripsMs[roundTripsMs.size() / 2];
+		benchmarkResult.m_worstRoundTripMs = roundTripsMs.back();
+	}
+	benchmarkResult.m_isSucceeded = isAllReceived && (int)roundTripsMs.size() == numRoundTrips;
+	return benchmarkResult;
+}
+
+bool Command_NetBenchmark(EventArgs const& args)
+{
+	int numClients = args.GetValue(std::string("clients"), 8);
+	int numMessages = args.GetValue(std::string("messages"), 10000);
+	int numRoundTrips = args.GetValue(std::string("roundtrips"), 1000);
+
+	NetLoopbackBenchmarkResult result = RunNetLoopbackBenchmark(numClients, numMessages, numRoundTrips);
+	if (g_theConsole)
+	{
+		g_theConsole->AddLine(result.m_isSucceeded ? DevConsole::INFO_MAJOR : DevConsole::ERROR,
+			Stringf("NetBenchmark %s: %i clients, %i messages, %.0f messages/s, round trip avg %.3fms median %.3fms worst %.3fms",
+				result.m_isSucceeded ? "done" : "failed", result.m_numClients, result.m_numMessages, result.m_messagesPerSecond,
+				result.m_averageRoundTripMs, result.m_medianRoundTripMs, result.m_worstRoundTripMs));
+	}
+	return true;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+class NamedProperties;
+typedef NamedProperties EventArgs;
+
+//-----------------------------------------------------------------------------------
+// Runs a NetSystem server and clients over loopback: throughput with numClients clients sending
+// numMessages each, then round trip latency with one client. The instances are private, the
+// game's own NetSystem is untouched.
+//
+struct NetLoopbackBenchmarkResult
+{
+	int			m_numClients = 0;
+	int			m_numMessages = 0;
+	double		m_messagesPerSecond = 0.0;
+	double		m_averageRoundTripMs = 0.0;
+	double		m_medianRoundTripMs = 0.0;
+	double		m_worstRoundTripMs = 0.0;
+	bool		m_isSucceeded = false;
+};
+
+NetLoopbackBenchmarkResult	RunNetLoopbackBenchmark(int numClients, int numMessages, int numRoundTrips);
+bool						Command_NetBenchmark(EventArgs const& args);
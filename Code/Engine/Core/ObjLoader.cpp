@@ -1,206 +1,492 @@
 #include "Engine/Core/ObjLoader.hpp"
 #include "Engine/Core/FileUtils.hpp"
 #include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Core/ParallelAlgorithms.hpp"
 #include "Engine/Math/MathUtils.hpp"
 #include "Engine/Core/VertexUtils.hpp"
-#include <chrono>
-#include <iostream>
-#include <vector>
-#include <map>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <filesystem>
+#include <map>
 #include <string>
-#include <windows.h>
-#include <unordered_set>
-#include <functional>
+#include <string_view>
+#include <vector>
+
+constexpr size_t	MIN_OBJ_CHUNK_BYTES = 1024 * 1024;		// Smaller files are parsed on the calling thread
+constexpr int		OBJ_CHUNKS_PER_THREAD = 4;
+
+// Face corners store OBJ indexes as written (1 based) when positive and 0 when missing. Negative
+// (relative) indexes are turned into an index relative to the start of their chunk and offset by
+// this bias, they only become absolute once every chunk has been parsed and counted.
+constexpr int		OBJ_CHUNK_RELATIVE_BIAS = 1 << 30;
+
+//-----------------------------------------------------------------------------------
+struct ObjFaceCorner
+{
+	int		m_positionIndex = 0;
+	int		m_uvIndex = 0;
+	int		m_normalIndex = 0;
+};
+
+// usemtl and mtllib lines, replayed in order during the merge since they are stateful
+struct ObjStateChange
+{
+	int					m_faceIndex = 0;			// Applies to this face of the chunk and every face after it
+	bool				m_isMaterialLibrary = false;
+	std::string_view	m_name;
+};
+
+struct ObjChunk
+{
+	std::string_view				m_text;
+
+	std::vector<Vec3>				m_positions;
+	std::vector<Vec2>				m_uvs;
+	std::vector<Vec3>				m_normals;
+	std::vector<ObjFaceCorner>		m_corners;
+	std::vector<int>				m_faceCornerCounts;
+	std::vector<ObjStateChange>		m_stateChanges;
+};
 
-struct VertexIndexStructure
+struct ObjVertexKey
 {
-	int		m_vertPositionIndex = -1;
-	int		m_vertTextureCoordsIndex = -1;
-	int		m_vertNormalIndex = -1;
+	int				m_positionIndex = -1;			// -1 marks an empty slot
+	int				m_uvIndex = -1;
+	int				m_normalIndex = -1;
+	unsigned int	m_vertexIndex = 0;
+};
 
-	unsigned int m_vertexPositionInArray = 0;
+//-----------------------------------------------------------------------------------
+// In place tokenizing, every helper advances cursor and never reads past end
+//
+static bool IsObjSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
 
-	bool operator ==(VertexIndexStructure const& other) const
+static void SkipObjSpaces(char const*& cursor, char const* end)
+{
+	while (cursor < end && IsObjSpace(*cursor))
 	{
-		return m_vertPositionIndex == other.m_vertPositionIndex &&
-			m_vertTextureCoordsIndex == other.m_vertTextureCoordsIndex &&
-			m_vertNormalIndex == other.m_vertNormalIndex;
+		++cursor;
 	}
-};
-struct VertexIndexHasher
+}
+
+static std::string_view ParseObjToken(char const*& cursor, char const* end)
 {
-	std::size_t operator()(const VertexIndexStructure& vertex) const
+	SkipObjSpaces(cursor, end);
+	char const* tokenStart = cursor;
+	while (cursor < end && !IsObjSpace(*cursor))
 	{
-		std::size_t hash1 = std::hash<int>()(vertex.m_vertPositionIndex);
-		std::size_t hash2 = std::hash<int>()(vertex.m_vertTextureCoordsIndex);
-		std::size_t hash3 = std::hash<int>()(vertex.m_vertNormalIndex);
+		++cursor;
+	}
+	return std::string_view(tokenStart, (size_t)(cursor - tokenStart));
+}
 
-		return hash1 ^ (hash2 << 1) ^ (hash3 << 2);
+static float ParseObjFloat(char const*& cursor, char const* end)
+{
+	SkipObjSpaces(cursor, end);
+	if (cursor < end && *cursor == '+')
+	{
+		++cursor;
 	}
-};
 
-bool ObjLoader::Load(const std::string& fileName, std::vector<Vertex_PCUTBN>& out_Vertexes, std::vector<unsigned int>& out_Indexes, bool& out_hasNormal, bool& out_hasUVs, const Mat44& transform /*= Mat44()*/)
+	float value = 0.f;
+	std::from_chars_result result = std::from_chars(cursor, end, value);
+	cursor = result.ptr;
+	return value;
+}
+
+static int ParseObjInt(char const*& cursor, char const* end)
+{
+	if (cursor < end && *cursor == '+')
+	{
+		++cursor;
+	}
+
+	int value = 0;
+	std::from_chars_result result = std::from_chars(cursor, end, value);
+	cursor = result.ptr;
+	return value;
+}
+
+static int EncodeObjIndex(int index, int numParsedInChunk)
+{
+	if (index >= 0)
+	{
+		return index;
+	}
+	return numParsedInChunk + index - OBJ_CHUNK_RELATIVE_BIAS;
+}
+
+// Back to a 0 based index into the whole file, -1 when missing
+static int DecodeObjIndex(int encodedIndex, int chunkBaseIndex)
 {
-	std::vector<uint8_t> buffer;
+	if (encodedIndex > 0)
+	{
+		return encodedIndex - 1;
+	}
+	if (encodedIndex == 0)
+	{
+		return -1;
+	}
+	return chunkBaseIndex + encodedIndex + OBJ_CHUNK_RELATIVE_BIAS;
+}
 
-	auto total_start_time = std::chrono::high_resolution_clock::now();
+static void ParseObjFace(ObjChunk& chunk, char const*& cursor, char const* end)
+{
+	int numCorners = 0;
+	for (;;)
+	{
+		SkipObjSpaces(cursor, end);
+		if (cursor >= end || *cursor == '#')
+		{
+			break;
+		}
 
-	FileReadToBinary(buffer, fileName);
-	std::string bufferString = std::string(buffer.begin(), buffer.end());
+		char const* cornerStart = cursor;
+		ObjFaceCorner corner;
+		corner.m_positionIndex = EncodeObjIndex(ParseObjInt(cursor, end), (int)chunk.m_positions.size());
+		if (cursor < end && *cursor == '/')
+		{
+			++cursor;
+			if (cursor < end && *cursor != '/')
+			{
+				corner.m_uvIndex = EncodeObjIndex(ParseObjInt(cursor, end), (int)chunk.m_uvs.size());
+			}
+			if (cursor < end && *cursor == '/')
+			{
+				++cursor;
+				corner.m_normalIndex = EncodeObjIndex(ParseObjInt(cursor, end), (int)chunk.m_normals.size());
+			}
+		}
 
-	Strings strings = SplitStringOnDelimiter(bufferString, "\n", true);
-	out_Vertexes.reserve(strings.size());
-	out_Indexes.reserve(strings.size());
+		if (cursor == cornerStart)
+		{
+			// Not a number, skip the garbage token
+			ParseObjToken(cursor, end);
+			continue;
+		}
 
-	std::vector<Vec3> positions;
-	std::vector<Vec2> uvs;
-	std::vector<Vec3> normals;
-	std::map<std::string, Rgba8> materials;
-	std::unordered_set<VertexIndexStructure, VertexIndexHasher> vertsDictionary;
+		if (corner.m_positionIndex != 0)
+		{
+			chunk.m_corners.push_back(corner);
+			numCorners++;
+		}
+	}
 
-	Rgba8 currentMatColor = Rgba8::WHITE;
+	chunk.m_faceCornerCounts.push_back(numCorners);
+}
 
-	int vertex_count = 0;
-	int uv_count = 0;
-	int normal_count = 0;
-	int face_count = 0;
-	int triangle_count = 0;
+static void ParseObjChunk(ObjChunk& chunk)
+{
+	char const* cursor = chunk.m_text.data();
+	char const* textEnd = cursor + chunk.m_text.size();
 
-	for (int stringIndex = 0; stringIndex < (int)strings.size(); stringIndex++) {
-		if (!strings[stringIndex].empty() && strings[stringIndex].back() == '\r') {
-			strings[stringIndex].erase(strings[stringIndex].size() - 1);
+	while (cursor < textEnd)
+	{
+		char const* lineEnd = (char const*)memchr(cursor, '\n', (size_t)(textEnd - cursor));
+		if (lineEnd == nullptr)
+		{
+			lineEnd = textEnd;
 		}
 
-		Strings stringPiece = SplitStringOnDelimiter(strings[stringIndex], " ", true);
+		std::string_view keyword = ParseObjToken(cursor, lineEnd);
+		if (keyword == "v")
+		{
+			float x = ParseObjFloat(cursor, lineEnd);
+			float y = ParseObjFloat(cursor, lineEnd);
+			float z = ParseObjFloat(cursor, lineEnd);
+			chunk.m_positions.push_back(Vec3(x, y, z));
+		}
+		else if (keyword == "vt")
+		{
+			float u = ParseObjFloat(cursor, lineEnd);
+			float v = ParseObjFloat(cursor, lineEnd);
+			chunk.m_uvs.push_back(Vec2(u, v));
+		}
+		else if (keyword == "vn")
+		{
+			float x = ParseObjFloat(cursor, lineEnd);
+			float y = ParseObjFloat(cursor, lineEnd);
+			float z = ParseObjFloat(cursor, lineEnd);
+			chunk.m_normals.push_back(Vec3(x, y, z));
+		}
+		else if (keyword == "f")
+		{
+			ParseObjFace(chunk, cursor, lineEnd);
+		}
+		else if (keyword == "usemtl" || keyword == "mtllib")
+		{
+			ObjStateChange stateChange;
+			stateChange.m_faceIndex = (int)chunk.m_faceCornerCounts.size();
+			stateChange.m_isMaterialLibrary = keyword == "mtllib";
+			stateChange.m_name = ParseObjToken(cursor, lineEnd);
+			chunk.m_stateChanges.push_back(stateChange);
+		}
 
-		if (!stringPiece.empty()) {
-			if (stringPiece[0] == "v") {
-				Vec3 position = Vec3(std::stof(stringPiece[1].c_str()), std::stof(stringPiece[2].c_str()), std::stof(stringPiece[3].c_str()));
-				positions.push_back(position);
-				vertex_count++;
-			}
+		// A last line without a newline ends at textEnd, stepping past it would leave the buffer
+		cursor = (lineEnd < textEnd) ? lineEnd + 1 : textEnd;
+	}
+}
 
-			if (stringPiece[0] == "vt") {
-				out_hasUVs = true;
-				Vec2 uvVector = Vec2(std::stof(stringPiece[1].c_str()), std::stof(stringPiece[2].c_str()));
-				uvs.push_back(uvVector);
-				uv_count++;
-			}
+static void LoadObjMaterialLibrary(std::string const& objFileName, std::string_view libraryName, std::map<std::string, Rgba8, std::less<>>& materials, std::vector<std::string>* out_materialLibraryFiles)
+{
+	std::string mtlFileName = (std::filesystem::path(objFileName).parent_path() / std::string(libraryName)).string();
+	if (out_materialLibraryFiles && std::find(out_materialLibraryFiles->begin(), out_materialLibraryFiles->end(), mtlFileName) == out_materialLibraryFiles->end())
+	{
+		out_materialLibraryFiles->push_back(mtlFileName);
+	}
 
-			if (stringPiece[0] == "vn") {
-				out_hasNormal = true;
-				Vec3 normalVector = Vec3(std::stof(stringPiece[1].c_str()), std::stof(stringPiece[2].c_str()), std::stof(stringPiece[3].c_str()));
-				normals.push_back(normalVector);
-				normal_count++;
-			}
+	MappedFile mtlFile;
+	if (!mtlFile.Open(mtlFileName) || mtlFile.GetSize() == 0)
+	{
+		return;
+	}
 
-			if (stringPiece[0] == "f") 
+	char const* cursor = (char const*)mtlFile.GetData();
+	char const* textEnd = cursor + mtlFile.GetSize();
+	std::string currentMtlName;
+
+	while (cursor < textEnd)
+	{
+		char const* lineEnd = (char const*)memchr(cursor, '\n', (size_t)(textEnd - cursor));
+		if (lineEnd == nullptr)
+		{
+			lineEnd = textEnd;
+		}
+
+		std::string_view keyword = ParseObjToken(cursor, lineEnd);
+		if (keyword == "newmtl")
+		{
+			currentMtlName = std::string(ParseObjToken(cursor, lineEnd));
+		}
+		else if (keyword == "Kd" && !currentMtlName.empty())
+		{
+			float rNorm = ParseObjFloat(cursor, lineEnd);
+			float gNorm = ParseObjFloat(cursor, lineEnd);
+			float bNorm = ParseObjFloat(cursor, lineEnd);
+			materials[currentMtlName] = Rgba8(DenormalizeByte(rNorm), DenormalizeByte(gNorm), DenormalizeByte(bNorm));
+		}
+
+		cursor = (lineEnd < textEnd) ? lineEnd + 1 : textEnd;
+	}
+}
+
+static unsigned int HashObjVertexKey(int positionIndex, int uvIndex, int normalIndex)
+{
+	unsigned int hash = (unsigned int)positionIndex * 0x9E3779B1u;
+	hash ^= (unsigned int)uvIndex * 0x85EBCA77u + (hash << 6) + (hash >> 2);
+	hash ^= (unsigned int)normalIndex * 0xC2B2AE3Du + (hash << 6) + (hash >> 2);
+	return hash;
+}
+
+static void GrowObjVertexTable(std::vector<ObjVertexKey>& table)
+{
+	std::vector<ObjVertexKey> oldTable;
+	oldTable.swap(table);
+	table.resize(oldTable.size() * 2);
+
+	size_t mask = table.size() - 1;
+	for (size_t oldIndex = 0; oldIndex < oldTable.size(); ++oldIndex)
+	{
+		ObjVertexKey const& key = oldTable[oldIndex];
+		if (key.m_positionIndex >= 0)
+		{
+			size_t slotIndex = HashObjVertexKey(key.m_positionIndex, key.m_uvIndex, key.m_normalIndex) & mask;
+			while (table[slotIndex].m_positionIndex >= 0)
 			{
-				std::vector<VertexIndexStructure> tmpVerts;
+				slotIndex = (slotIndex + 1) & mask;
+			}
+			table[slotIndex] = key;
+		}
+	}
+}
 
-				for (int i = 1; i < (int)stringPiece.size(); i++) 
-				{
-					VertexIndexStructure vert = VertexIndexStructure();
+//-----------------------------------------------------------------------------------
+// The file is mapped and cut into line aligned chunks that are tokenized in parallel without any
+// copies. The merge then walks the faces in file order, so vertexes come out deduplicated and in
+// the order they are first used, exactly as a serial parse would produce them.
+//
+bool ObjLoader::Load(const std::string& fileName, std::vector<Vertex_PCUTBN>& out_Vertexes, std::vector<unsigned int>& out_Indexes, bool& out_hasNormal, bool& out_hasUVs, const Mat44& transform /*= Mat44()*/, bool isParallel /*= true*/, std::vector<std::string>* out_materialLibraryFiles /*= nullptr*/)
+{
+	MappedFile objFile;
+	if (!objFile.Open(fileName))
+	{
+		return false;
+	}
 
-					Strings subFaceString = SplitStringOnDelimiter(stringPiece[i], "/", false);
+	char const* fileText = (char const*)objFile.GetData();
+	size_t fileSize = objFile.GetSize();
 
-					if (subFaceString.size() > 0 && !subFaceString[0].empty()) {
-						uint32_t posIndex = std::stoi(subFaceString[0].c_str()) - 1;
-						vert.m_vertPositionIndex = posIndex;
-					}
+	// Cut into chunks that start right after a newline
+	int numThreads = g_theJobSystem && isParallel ? g_theJobSystem->GetNumWorkers() + 1 : 1;
+	int numChunks = (int)(fileSize / MIN_OBJ_CHUNK_BYTES);
+	numChunks = numChunks < 1 ? 1 : (numChunks > numThreads * OBJ_CHUNKS_PER_THREAD ? numThreads * OBJ_CHUNKS_PER_THREAD : numChunks);
 
-					if (subFaceString.size() > 1 && !subFaceString[1].empty()) {
-						uint32_t uvIndex = std::stoi(subFaceString[1].c_str()) - 1;
-						vert.m_vertTextureCoordsIndex = uvIndex;
-					}
+	std::vector<ObjChunk> chunks((size_t)numChunks);
+	size_t chunkStart = 0;
+	for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+	{
+		size_t chunkEnd = chunkIndex == numChunks - 1 ? fileSize : fileSize * (size_t)(chunkIndex + 1) / (size_t)numChunks;
+		if (chunkEnd < chunkStart)
+		{
+			chunkEnd = chunkStart;
+		}
+		while (chunkEnd < fileSize && fileText[chunkEnd - 1] != '\n')
+		{
+			chunkEnd++;
+		}
 
-					if (subFaceString.size() > 2 && !subFaceString[2].empty()) {
-						uint32_t normalIndex = std::stoi(subFaceString[2].c_str()) - 1;
-						vert.m_vertNormalIndex = normalIndex;
-					}
-					if (vert.m_vertPositionIndex != -1)
-					{
+		chunks[chunkIndex].m_text = std::string_view(fileText + chunkStart, chunkEnd - chunkStart);
+		chunkStart = chunkEnd;
+	}
 
-						auto it = vertsDictionary.find(vert);
-						if (it == vertsDictionary.end())
-						{
-							vert.m_vertexPositionInArray = (unsigned int)out_Vertexes.size();
-
-							Vertex_PCUTBN tbnVert;
-							tbnVert.m_position = positions[vert.m_vertPositionIndex];
-							if (vert.m_vertTextureCoordsIndex != -1)
-							{
-								tbnVert.m_uvTexCoords = uvs[vert.m_vertTextureCoordsIndex];
-							}
-							tbnVert.m_color = currentMatColor;
-							if (vert.m_vertNormalIndex != -1)
-							{
-								tbnVert.m_normal = normals[vert.m_vertNormalIndex];
-							}
-							vertsDictionary.insert(vert);
-							out_Vertexes.push_back(tbnVert);
-						}
-						else 
-						{
-							vert.m_vertexPositionInArray = it->m_vertexPositionInArray;
-						}
-						tmpVerts.push_back(vert);
-					}
-				}
+	ParallelFor(0, numChunks, 1, [&chunks](int chunkIndex)
+	{
+		ParseObjChunk(chunks[chunkIndex]);
+	});
 
-				for (int i = 1; i < (int)tmpVerts.size() - 1; i++) 
-				{
-					out_Indexes.push_back(tmpVerts[0].m_vertexPositionInArray);
+	// Gather the attribute streams in file order
+	std::vector<Vec3> positions;
+	std::vector<Vec2> uvs;
+	std::vector<Vec3> normals;
+	std::vector<int> chunkPositionBases((size_t)numChunks);
+	std::vector<int> chunkUVBases((size_t)numChunks);
+	std::vector<int> chunkNormalBases((size_t)numChunks);
+	size_t numCorners = 0;
+	for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+	{
+		ObjChunk const& chunk = chunks[chunkIndex];
+		chunkPositionBases[chunkIndex] = (int)positions.size();
+		chunkUVBases[chunkIndex] = (int)uvs.size();
+		chunkNormalBases[chunkIndex] = (int)normals.size();
+		positions.insert(positions.end(), chunk.m_positions.begin(), chunk.m_positions.end());
+		uvs.insert(uvs.end(), chunk.m_uvs.begin(), chunk.m_uvs.end());
+		normals.insert(normals.end(), chunk.m_normals.begin(), chunk.m_normals.end());
+		numCorners += chunk.m_corners.size();
+	}
 
-					out_Indexes.push_back(tmpVerts[i].m_vertexPositionInArray);
+	if (!uvs.empty())
+	{
+		out_hasUVs = true;
+	}
+	if (!normals.empty())
+	{
+		out_hasNormal = true;
+	}
 
-					out_Indexes.push_back(tmpVerts[i + 1].m_vertexPositionInArray);
+	// Deduplicate (position, uv, normal) triples through an open addressing table kept at most half full
+	size_t tableSize = 16;
+	while (tableSize < positions.size() * 2)
+	{
+		tableSize <<= 1;
+	}
+	std::vector<ObjVertexKey> vertexTable(tableSize);
+	size_t numUniqueVertexes = 0;
 
-					triangle_count++;
-				}
-				face_count++;
-			}
+	out_Vertexes.reserve(out_Vertexes.size() + positions.size());
+	out_Indexes.reserve(out_Indexes.size() + numCorners * 3);
 
-			if (stringPiece[0] == "mtllib") {
-				std::filesystem::path filePath(fileName);
-				std::filesystem::path directory = filePath.parent_path();
-				std::filesystem::path mtlFilePath = directory / stringPiece[1];
-				std::string strPath = mtlFilePath.string();
+	std::map<std::string, Rgba8, std::less<>> materials;
+	Rgba8 currentMatColor = Rgba8::WHITE;
+	std::vector<unsigned int> faceVertexIndexes;
 
-				std::vector<uint8_t> mtlBuffer;
-				FileReadToBinary(mtlBuffer, strPath);
-				std::string mtlBufferString = std::string(mtlBuffer.begin(), mtlBuffer.end());
+	for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+	{
+		ObjChunk const& chunk = chunks[chunkIndex];
+		size_t cornerIndex = 0;
+		size_t stateChangeIndex = 0;
 
-				Strings mtlBufferStrings = SplitStringOnDelimiter(mtlBufferString, "\n", true);
-				std::string currentMtlName;
+		int numFaces = (int)chunk.m_faceCornerCounts.size();
 
-				for (int mtlIndex = 0; mtlIndex < (int)mtlBufferStrings.size(); mtlIndex++) {
-					if (!mtlBufferStrings[mtlIndex].empty() && mtlBufferStrings[mtlIndex].back() == '\r') {
-						mtlBufferStrings[mtlIndex].erase(mtlBufferStrings[mtlIndex].size() - 1);
+		// Runs one extra time past the last face for state changes that come after it
+		for (int faceIndex = 0; faceIndex <= numFaces; ++faceIndex)
+		{
+			while (stateChangeIndex < chunk.m_stateChanges.size() && chunk.m_stateChanges[stateChangeIndex].m_faceIndex <= faceIndex)
+			{
+				ObjStateChange const& stateChange = chunk.m_stateChanges[stateChangeIndex++];
+				if (stateChange.m_isMaterialLibrary)
+				{
+					LoadObjMaterialLibrary(fileName, stateChange.m_name, materials, out_materialLibraryFiles);
+				}
+				else
+				{
+					auto materialIter = materials.find(stateChange.m_name);
+					if (materialIter != materials.end())
+					{
+						currentMatColor = materialIter->second;
 					}
+				}
+			}
 
-					Strings mtlStrings = SplitStringOnDelimiter(mtlBufferStrings[mtlIndex], " ");
+			if (faceIndex == numFaces)
+			{
+				break;
+			}
 
-					if (mtlStrings[0] == "newmtl") {
-						currentMtlName = mtlStrings[1];
-					}
+			faceVertexIndexes.clear();
+			int numFaceCorners = chunk.m_faceCornerCounts[faceIndex];
+			for (int faceCornerIndex = 0; faceCornerIndex < numFaceCorners; ++faceCornerIndex)
+			{
+				ObjFaceCorner const& corner = chunk.m_corners[cornerIndex++];
+				int positionIndex = DecodeObjIndex(corner.m_positionIndex, chunkPositionBases[chunkIndex]);
+				int uvIndex = DecodeObjIndex(corner.m_uvIndex, chunkUVBases[chunkIndex]);
+				int normalIndex = DecodeObjIndex(corner.m_normalIndex, chunkNormalBases[chunkIndex]);
+
+				if (positionIndex < 0 || positionIndex >= (int)positions.size())
+				{
+					continue;
+				}
+				if (uvIndex >= (int)uvs.size())
+				{
+					uvIndex = -1;
+				}
+				if (normalIndex >= (int)normals.size())
+				{
+					normalIndex = -1;
+				}
 
-					if (mtlStrings[0] == "Kd") {
-						if (!currentMtlName.empty()) {
-							float rNorm = std::stof(mtlStrings[1]);
-							float gNorm = std::stof(mtlStrings[2]);
-							float bNorm = std::stof(mtlStrings[3]);
-							materials[currentMtlName] = Rgba8(DenormalizeByte(rNorm), DenormalizeByte(gNorm), DenormalizeByte(bNorm));
-						}
+				if ((numUniqueVertexes + 1) * 2 > vertexTable.size())
+				{
+					GrowObjVertexTable(vertexTable);
+				}
+
+				size_t mask = vertexTable.size() - 1;
+				size_t slotIndex = HashObjVertexKey(positionIndex, uvIndex, normalIndex) & mask;
+				for (;;)
+				{
+					ObjVertexKey& key = vertexTable[slotIndex];
+					if (key.m_positionIndex < 0)
+					{
+						key.m_positionIndex = positionIndex;
+						key.m_uvIndex = uvIndex;
+						key.m_normalIndex = normalIndex;
+						key.m_vertexIndex = (unsigned int)out_Vertexes.size();
+						numUniqueVertexes++;
+
+						out_Vertexes.push_back(Vertex_PCUTBN(positions[positionIndex], currentMatColor,
+							uvIndex >= 0 ? uvs[uvIndex] : Vec2(0.f, 0.f), Vec3::ZERO, Vec3::ZERO,
+							normalIndex >= 0 ? normals[normalIndex] : Vec3::ZERO));
+						break;
 					}
+					if (key.m_positionIndex == positionIndex && key.m_uvIndex == uvIndex && key.m_normalIndex == normalIndex)
+					{
+						break;
+					}
+					slotIndex = (slotIndex + 1) & mask;
 				}
+				faceVertexIndexes.push_back(vertexTable[slotIndex].m_vertexIndex);
 			}
 
-			if (stringPiece[0] == "usemtl") {
-				if (materials.find(stringPiece[1]) != materials.end()) {
-					currentMatColor = materials[stringPiece[1]];
-				}
+			// Fan triangulation, same as before
+			for (int i = 1; i < (int)faceVertexIndexes.size() - 1; i++)
+			{
+				out_Indexes.push_back(faceVertexIndexes[0]);
+				out_Indexes.push_back(faceVertexIndexes[i]);
+				out_Indexes.push_back(faceVertexIndexes[i + 1]);
 			}
 		}
 	}
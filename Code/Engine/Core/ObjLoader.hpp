@@ -8,8 +8,11 @@
 class ObjLoader 
 {
 public:
+	// Without isParallel the whole file is parsed as one chunk on the calling thread, the result is the same.
+	// out_materialLibraryFiles gets the path of every mtllib the obj references, found or not.
 	static bool Load( const std::string& fileName, 
 		std::vector<Vertex_PCUTBN>& out_Vertexes, std::vector<unsigned int>& out_Indexes,
-		bool& out_hasNormal, bool& out_hasUVs, const Mat44& transform = Mat44());
+		bool& out_hasNormal, bool& out_hasUVs, const Mat44& transform = Mat44(), bool isParallel = true,
+		std::vector<std::string>* out_materialLibraryFiles = nullptr);
 };
 	
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "Engine/Core/ObjLoaderBenchmark.hpp"
+#include "Engine/Core/ObjLoader.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/FileUtils.hpp"
+#include "Engine/Core/JobSystem.hpp"
+#include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <filesystem>
+
+constexpr char const*	OBJ_BENCHMARK_GENERATED_FILE_NAME = "ObjLoaderBenchmark.obj";
+constexpr int			OBJ_BENCHMARK_BYTES_PER_GRID_VERTEX = 150;		// One v, vt, vn and f line per grid vertex, roughly
+
+// A wavy grid with uvs and normals, quads whose corners use all three indexes like exported meshes
+static std::vector<unsigned char> GenerateGridObjText(int numMegabytes)
+{
+	int gridSize = (int)sqrt((double)numMegabytes * 1024.0 * 1024.0 / (double)OBJ_BENCHMARK_BYTES_PER_GRID_VERTEX);
+	gridSize = std::max(gridSize, 2);
+
+	std::vector<unsigned char> text;
+	text.reserve((size_t)gridSize * (size_t)gridSize * OBJ_BENCHMARK_BYTES_PER_GRID_VERTEX);
+	auto appendLine = [&text](std::string_view line)
+	{
+		text.insert(text.end(), line.begin(), line.end());
+	};
+
+	for (int y = 0; y < gridSize; ++y)
+	{
+		for (int x = 0; x < gridSize; ++x)
+		{
+			float height = sinf((float)x * 0.1f) * cosf((float)y * 0.1f);
+			appendLine(StringfTemp("v %.4f %.4f %.4f\n", (float)x, (float)y, height));
+			appendLine(StringfTemp("vt %.4f %.4f\n", (float)x / (float)(gridSize - 1), (float)y / (float)(gridSize - 1)));
+			appendLine(StringfTemp("vn %.4f %.4f 1.0\n", -0.1f * cosf((float)x * 0.1f), 0.1f * sinf((float)y * 0.1f)));
+		}
+	}
+	for (int y = 0; y < gridSize - 1; ++y)
+	{
+		for (int x = 0; x < gridSize - 1; ++x)
+		{
+			int a = y * gridSize + x + 1;
+			int b = a + 1;
+			int c = b + gridSize;
+			int d = a + gridSize;
+			appendLine(StringfTemp("f %i/%i/%i %i/%i/%i %i/%i/%i %i/%i/%i\n", a, a, a, b, b, b, c, c, c, d, d, d));
+		}
+	}
+	return text;
+}
+
+static double TimeObjLoadMs(std::string const& fileName, bool isParallel, std::vector<Vertex_PCUTBN>& out_vertexes, std::vector<unsigned int>& out_indexes, bool& out_isLoaded)
+{
+	out_vertexes.clear();
+	out_indexes.clear();
+	bool hasNormals = false;
+	bool hasUVs = false;
+
+	double startSeconds = GetCurrentTimeSeconds();
+	out_isLoaded = ObjLoader::Load(fileName, out_vertexes, out_indexes, hasNormals, hasUVs, Mat44(), isParallel);
+	return (GetCurrentTimeSeconds() - startSeconds) * 1000.0;
+}
+
+ObjLoaderBenchmarkResult RunObjLoaderBenchmark(std::string const& fileName, int numRuns, int numMegabytes)
+{
+	ObjLoaderBenchmarkResult result;
+	result.m_fileName = fileName;
+	numRuns = std::max(numRuns, 1);
+
+	bool isGenerated = fileName.empty();
+	if (isGenerated)
+	{
+		result.m_fileName = OBJ_BENCHMARK_GENERATED_FILE_NAME;
+		if (FileWriteBinary(result.m_fileName, GenerateGridObjText(std::max(numMegabytes, 1))) != 0)
+		{
+			return result;
+		}
+	}
+
+	std::error_code errorCode;
+	uintmax_t fileSize = std::filesystem::file_size(result.m_fileName, errorCode);
+	result.m_fileMegabytes = errorCode ? 0.0 : (double)fileSize / (1024.0 * 1024.0);
+
+	std::vector<Vertex_PCUTBN> serialVertexes;
+	std::vector<unsigned int> serialIndexes;
+	std::vector<Vertex_PCUTBN> parallelVertexes;
+	std::vector<unsigned int> parallelIndexes;
+	bool isSerialLoaded = false;
+	bool isParallelLoaded = false;
+
+	// Alternate the two so both see the file equally warm in the OS cache
+	result.m_serialMs = DBL_MAX;
+	result.m_parallelMs = DBL_MAX;
+	for (int runIndex = 0; runIndex < numRuns; ++runIndex)
+	{
+		result.m_serialMs = std::min(result.m_serialMs, TimeObjLoadMs(result.m_fileName, false, serialVertexes, serialIndexes, isSerialLoaded));
+		result.m_parallelMs = std::min(result.m_parallelMs, TimeObjLoadMs(result.m_fileName, true, parallelVertexes, parallelIndexes, isParallelLoaded));
+	}
+
+	result.m_isLoaded = isSerialLoaded && isParallelLoaded;
+	result.m_isMatching = result.m_isLoaded && serialVertexes == parallelVertexes && serialIndexes == parallelIndexes;
+	result.m_numVertexes = (int)parallelVertexes.size();
+	result.m_numTriangles = (int)parallelIndexes.size() / 3;
+
+	if (isGenerated)
+	{
+		std::filesystem::remove(result.m_fileName, errorCode);
+	}
+	return result;
+}
+
+bool Command_ObjLoaderBenchmark(EventArgs const& args)
+{
+	std::string fileName = args.GetValue(std::string("file"), std::string(""));
+	int numRuns = args.GetValue(std::string("runs"), 3);
+	int numMegabytes = args.GetValue(std::string("size"), 64);
+	ObjLoaderBenchmarkResult result = RunObjLoaderBenchmark(fileName, numRuns, numMegabytes);
+	if (g_theConsole == nullptr)
+	{
+		return true;
+	}
+
+	if (!result.m_isLoaded)
+	{
+		g_theConsole->AddLine(DevConsole::ERROR, Stringf("ObjLoaderBenchmark cannot load %s", result.m_fileName.c_str()));
+		return true;
+	}
+
+	int numThreads = g_theJobSystem ? g_theJobSystem->GetNumWorkers() + 1 : 1;
+	g_theConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("ObjLoaderBenchmark, %s, %.1f MB, %i vertexes, %i triangles, best of %i",
+		result.m_fileName.c_str(), result.m_fileMegabytes, result.m_numVertexes, result.m_numTriangles, std::max(numRuns, 1)));
+	g_theConsole->AddLine(DevConsole::INFO_MINOR, Stringf("serial             %8.2f ms  %8.1f MB/s", result.m_serialMs,
+		result.m_serialMs > 0.0 ? result.m_fileMegabytes * 1000.0 / result.m_serialMs : 0.0));
+	g_theConsole->AddLine(DevConsole::INFO_MINOR, Stringf("parallel (%2i thr)  %8.2f ms  %8.1f MB/s", numThreads, result.m_parallelMs,
+		result.m_parallelMs > 0.0 ? result.m_fileMegabytes * 1000.0 / result.m_parallelMs : 0.0));
+	g_theConsole->AddLine(result.m_isMatching ? DevConsole::INFO_MINOR : DevConsole::ERROR, result.m_isMatching ? "Both loads produced the same mesh" : "MISMATCH between the serial and parallel loads");
+	return true;
+}
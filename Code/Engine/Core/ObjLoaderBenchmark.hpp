@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+
+class NamedProperties;
+typedef NamedProperties EventArgs;
+
+//-----------------------------------------------------------------------------------
+// Times ObjLoader::Load parsing the file as one chunk on the calling thread against the parallel
+// chunked parse, reports both in MB/s and checks that they produced the same mesh.
+//
+struct ObjLoaderBenchmarkResult
+{
+	std::string		m_fileName;
+	double			m_fileMegabytes = 0.0;
+	int				m_numVertexes = 0;
+	int				m_numTriangles = 0;
+	double			m_serialMs = 0.0;			// Best of the runs
+	double			m_parallelMs = 0.0;			// Best of the runs
+	bool			m_isLoaded = false;
+	bool			m_isMatching = false;		// Same vertexes and indexes from both loads
+};
+
+// Loads fileName numRuns times each way. An empty fileName benchmarks a generated grid mesh of
+// about numMegabytes instead, written to the working directory and deleted afterwards.
+ObjLoaderBenchmarkResult	RunObjLoaderBenchmark(std::string const& fileName, int numRuns, int numMegabytes);
+bool						Command_ObjLoaderBenchmark(EventArgs const& args);
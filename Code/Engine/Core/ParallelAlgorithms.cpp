@@ -0,0 +1,117 @@
+#include "Engine/Core/ParallelAlgorithms.hpp"
+
+constexpr int AUTOMATIC_CHUNKS_PER_THREAD = 4;
+constexpr int MIN_AUTOMATIC_CHUNK_SIZE = 256;
+constexpr int MAX_PARALLEL_HELPER_JOBS = 64;
+
+//-----------------------------------------------------------------------------------
+struct ParallelRangeContext
+{
+	ParallelRangeFunction			m_rangeFunction = nullptr;
+	void*							m_userData = nullptr;
+	int								m_begin = 0;
+	int								m_end = 0;
+	int								m_chunkSize = 1;
+	int								m_numChunks = 0;
+	std::atomic<int>				m_nextChunk = 0;
+	std::atomic<int>				m_numPendingHelpers = 0;
+};
+
+static void RunParallelRangeChunks(ParallelRangeContext& context)
+{
+	for (;;)
+	{
+		int chunkIndex = context.m_nextChunk.fetch_add(1, std::memory_order_relaxed);
+		if (chunkIndex >= context.m_numChunks)
+		{
+			return;
+		}
+
+		int rangeBegin = context.m_begin + chunkIndex * context.m_chunkSize;
+		int rangeEnd = std::min(rangeBegin + context.m_chunkSize, context.m_end);
+		context.m_rangeFunction(context.m_userData, rangeBegin, rangeEnd);
+	}
+}
+
+//-----------------------------------------------------------------------------------
+class ParallelRangeJob : public Job
+{
+public:
+	ParallelRangeJob() { m_needsRetrieval = false; }
+
+	virtual void Execute() override
+	{
+		RunParallelRangeChunks(*m_context);
+	}
+
+	virtual void OnCompleted() override
+	{
+		// Last access to the context, it lives on the stack of the calling thread
+		m_context->m_numPendingHelpers.fetch_sub(1, std::memory_order_acq_rel);
+	}
+
+	ParallelRangeContext*			m_context = nullptr;
+};
+
+//-----------------------------------------------------------------------------------
+int GetParallelChunkSize(JobSystem* system, int begin, int end, int grainSize)
+{
+	if (grainSize > 0)
+	{
+		return grainSize;
+	}
+
+	int numThreads = (system ? system->GetNumWorkers() : 0) + 1;
+	int chunkSize = (end - begin) / (numThreads * AUTOMATIC_CHUNKS_PER_THREAD);
+	return std::max(chunkSize, MIN_AUTOMATIC_CHUNK_SIZE);
+}
+
+void ParallelForRangeInternal(JobSystem* system, int begin, int end, int grainSize, ParallelRangeFunction rangeFunction, void* userData)
+{
+	if (end <= begin)
+	{
+		return;
+	}
+
+	ParallelRangeContext context;
+	context.m_rangeFunction = rangeFunction;
+	context.m_userData = userData;
+	context.m_begin = begin;
+	context.m_end = end;
+	context.m_chunkSize = GetParallelChunkSize(system, begin, end, grainSize);
+	context.m_numChunks = (end - begin + context.m_chunkSize - 1) / context.m_chunkSize;
+
+	int numWorkers = system ? system->GetNumWorkers() : 0;
+	int numHelpers = std::min(numWorkers, context.m_numChunks - 1);
+
+	if (numHelpers <= 0)
+	{
+		RunParallelRangeChunks(context);
+		return;
+	}
+
+	// One helper per worker at most, each one keeps pulling chunks until the range is exhausted
+	ParallelRangeJob helperJobs[MAX_PARALLEL_HELPER_JOBS];
+	Job* helpers[MAX_PARALLEL_HELPER_JOBS];
+	numHelpers = std::min(numHelpers, MAX_PARALLEL_HELPER_JOBS);
+	for (int helperIndex = 0; helperIndex < numHelpers; ++helperIndex)
+	{
+		helperJobs[helperIndex].m_context = &context;
+		helpers[helperIndex] = &helperJobs[helperIndex];
+	}
+
+	context.m_numPendingHelpers.store(numHelpers, std::memory_order_relaxed);
+	system->AddJobsIntoDeque(helpers, numHelpers);
+
+	RunParallelRangeChunks(context);
+
+	// Helpers that haven't started yet would find no chunk left, but they still reference the
+	// context, so help out with whatever is queued until they are all done
+	while (context.m_numPendingHelpers.load(std::memory_order_acquire) > 0)
+	{
+		if (!system->ExecuteOneJob())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
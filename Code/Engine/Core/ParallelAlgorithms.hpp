@@ -0,0 +1,149 @@
+#pragma once
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/JobSystem.hpp"
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <vector>
+
+//-----------------------------------------------------------------------------------
+// Data parallel helpers built on the job system. The range [begin, end) is cut into chunks of
+// grainSize indices (grainSize <= 0 picks one automatically), a helper job per worker pulls chunks
+// from a shared counter and the calling thread pulls chunks too, so no chunk ever waits for a
+// worker while the caller is idle. The call returns once every chunk is done.
+// Every helper uses g_theJobSystem unless a system is passed, and runs serially without one.
+//
+typedef void (*ParallelRangeFunction)(void* userData, int rangeBegin, int rangeEnd);
+
+void	ParallelForRangeInternal(JobSystem* system, int begin, int end, int grainSize, ParallelRangeFunction rangeFunction, void* userData);
+int		GetParallelChunkSize(JobSystem* system, int begin, int end, int grainSize);
+
+// func(int rangeBegin, int rangeEnd), for loops that want to work on a whole chunk at once
+template<typename RangeFunc>
+void ParallelForRange(JobSystem* system, int begin, int end, int grainSize, RangeFunc const& func)
+{
+	ParallelRangeFunction trampoline = [](void* userData, int rangeBegin, int rangeEnd)
+	{
+		(*static_cast<RangeFunc const*>(userData))(rangeBegin, rangeEnd);
+	};
+	ParallelForRangeInternal(system, begin, end, grainSize, trampoline, const_cast<void*>(static_cast<void const*>(&func)));
+}
+
+template<typename RangeFunc>
+void ParallelForRange(int begin, int end, int grainSize, RangeFunc const& func)
+{
+	ParallelForRange(g_theJobSystem, begin, end, grainSize, func);
+}
+
+// func(int index)
+template<typename IndexFunc>
+void ParallelFor(JobSystem* system, int begin, int end, int grainSize, IndexFunc const& func)
+{
+	ParallelForRange(system, begin, end, grainSize, [&func](int rangeBegin, int rangeEnd)
+	{
+		for (int index = rangeBegin; index < rangeEnd; ++index)
+		{
+			func(index);
+		}
+	});
+}
+
+template<typename IndexFunc>
+void ParallelFor(int begin, int end, int grainSize, IndexFunc const& func)
+{
+	ParallelFor(g_theJobSystem, begin, end, grainSize, func);
+}
+
+// rangeFunc(int rangeBegin, int rangeEnd, T partial) -> T folds a chunk into a partial result starting
+// at identity, combineFunc(T lhs, T rhs) -> T merges partials. Partials are combined in chunk order
+// so the result does not depend on which thread ran which chunk.
+template<typename T, typename RangeFunc, typename CombineFunc>
+T ParallelReduce(JobSystem* system, int begin, int end, int grainSize, T const& identity, RangeFunc const& rangeFunc, CombineFunc const& combineFunc)
+{
+	if (end <= begin)
+	{
+		return identity;
+	}
+
+	int chunkSize = GetParallelChunkSize(system, begin, end, grainSize);
+	int numChunks = (end - begin + chunkSize - 1) / chunkSize;
+	std::vector<T> partials((size_t)numChunks, identity);
+
+	ParallelForRange(system, 0, numChunks, 1, [&](int chunkBegin, int chunkEnd)
+	{
+		for (int chunkIndex = chunkBegin; chunkIndex < chunkEnd; ++chunkIndex)
+		{
+			int rangeBegin = begin + chunkIndex * chunkSize;
+			int rangeEnd = std::min(rangeBegin + chunkSize, end);
+			partials[chunkIndex] = rangeFunc(rangeBegin, rangeEnd, identity);
+		}
+	});
+
+	T result = identity;
+	for (int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+	{
+		result = combineFunc(result, partials[chunkIndex]);
+	}
+	return result;
+}
+
+template<typename T, typename RangeFunc, typename CombineFunc>
+T ParallelReduce(int begin, int end, int grainSize, T const& identity, RangeFunc const& rangeFunc, CombineFunc const& combineFunc)
+{
+	return ParallelReduce(g_theJobSystem, begin, end, grainSize, identity, rangeFunc, combineFunc);
+}
+
+// Sorts runs of the range in parallel, then merges neighbouring runs pairwise in parallel rounds.
+// Not stable, same as std::sort.
+template<typename RandomIt, typename Compare>
+void ParallelSort(JobSystem* system, RandomIt first, RandomIt last, Compare const& compare, int grainSize = 0)
+{
+	int count = (int)std::distance(first, last);
+	if (count < 2)
+	{
+		return;
+	}
+
+	int runSize = GetParallelChunkSize(system, 0, count, grainSize);
+	int numRuns = (count + runSize - 1) / runSize;
+
+	if (numRuns <= 1)
+	{
+		std::sort(first, last, compare);
+		return;
+	}
+
+	ParallelFor(system, 0, numRuns, 1, [&](int runIndex)
+	{
+		RandomIt runBegin = first + (runIndex * runSize);
+		RandomIt runEnd = first + std::min((runIndex + 1) * runSize, count);
+		std::sort(runBegin, runEnd, compare);
+	});
+
+	for (int mergedRunSize = runSize; mergedRunSize < count; mergedRunSize *= 2)
+	{
+		int numMerges = (count + 2 * mergedRunSize - 1) / (2 * mergedRunSize);
+		ParallelFor(system, 0, numMerges, 1, [&](int mergeIndex)
+		{
+			int mergeBegin = mergeIndex * 2 * mergedRunSize;
+			int mergeMiddle = std::min(mergeBegin + mergedRunSize, count);
+			int mergeEnd = std::min(mergeBegin + 2 * mergedRunSize, count);
+			if (mergeMiddle < mergeEnd)
+			{
+				std::inplace_merge(first + mergeBegin, first + mergeMiddle, first + mergeEnd, compare);
+			}
+		});
+	}
+}
+
+template<typename RandomIt, typename Compare>
+void ParallelSort(RandomIt first, RandomIt last, Compare const& compare, int grainSize = 0)
+{
+	ParallelSort(g_theJobSystem, first, last, compare, grainSize);
+}
+
+template<typename RandomIt>
+void ParallelSort(RandomIt first, RandomIt last)
+{
+	ParallelSort(g_theJobSystem, first, last, std::less<>());
+}
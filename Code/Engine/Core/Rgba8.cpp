@@ -60,24 +60,25 @@ unsigned char Rgba8::DenormalizeByte(float value)
 
 void Rgba8::SetFromText(char const* text)
 {
-	Strings strings = SplitStringOnDelimiter(text, ',');
+	std::string_view strings[4];
+	int numStrings = SplitStringViewOnDelimiter(text, ',', strings, 4);
 
-	GUARANTEE_OR_DIE(strings.size() == 3||strings.size() == 4, "Parameter number doesn't match");
+	GUARANTEE_OR_DIE(numStrings == 3||numStrings == 4, "Parameter number doesn't match");
 
-	if (strings.size() == 3)
+	if (numStrings == 3)
 	{
-		r = static_cast<unsigned char>(atoi(strings[0].c_str()));
-		g = static_cast<unsigned char>(atoi(strings[1].c_str()));
-		b = static_cast<unsigned char>(atoi(strings[2].c_str()));
+		r = static_cast<unsigned char>(ParseIntFromText(strings[0]));
+		g = static_cast<unsigned char>(ParseIntFromText(strings[1]));
+		b = static_cast<unsigned char>(ParseIntFromText(strings[2]));
 		a = static_cast<unsigned char>(255);
 	}
 
-	if (strings.size() == 4)
+	if (numStrings == 4)
 	{
-		r = static_cast<unsigned char>(atoi(strings[0].c_str()));
-		g = static_cast<unsigned char>(atoi(strings[1].c_str()));
-		b = static_cast<unsigned char>(atoi(strings[2].c_str()));
-		a = static_cast<unsigned char>(atoi(strings[3].c_str()));
+		r = static_cast<unsigned char>(ParseIntFromText(strings[0]));
+		g = static_cast<unsigned char>(ParseIntFromText(strings[1]));
+		b = static_cast<unsigned char>(ParseIntFromText(strings[2]));
+		a = static_cast<unsigned char>(ParseIntFromText(strings[3]));
 	}
 }
 
@@ -0,0 +1,419 @@
+#pragma once
+#include "Engine/Core/BufferParser.hpp"
+#include "Engine/Core/BufferWriter.hpp"
+#include "Engine/Core/Rgba8.hpp"
+#include "Engine/Core/Vertex_PCU.hpp"
+#include "Engine/Math/AABB2.hpp"
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include "Engine/Math/Vec3.hpp"
+#include "Engine/Math/Vec4.hpp"
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+//-----------------------------------------------------------------------------------
+// Binary serialization generated from a compile time list of fields, one list gives both the
+// writer and the parser. A type describes itself with a static constexpr function:
+//
+//	struct Player
+//	{
+//		static constexpr uint32_t SERIAL_VERSION = 2;
+//		static constexpr auto GetSerialFields()
+//		{
+//			return std::make_tuple(
+//				MakeSerialField(&Player::m_position),
+//				MakeRemovedSerialField<float>(1, 2),			// m_health, dropped in version 2
+//				MakeSerialField(&Player::m_inventory, 2));		// added in version 2
+//		}
+//		Vec3				m_position;
+//		std::vector<int>	m_inventory;
+//	};
+//
+// Numbers, enums, std::string, std::vector and any type with a field list can be fields.
+// Versioned types write their version before their fields, a vector of them writes it once for
+// all the elements. Fields missing from older data keep the value they had before parsing.
+// Types whose memory matches their wire layout can set SERIAL_IS_BLITTABLE, vectors of them are
+// then copied in one go when the buffer has the platform's endianness.
+//
+constexpr uint32_t SERIAL_FIRST_VERSION = 1;
+
+template<typename Class, typename Member>
+struct SerialField
+{
+	typedef Member MemberType;
+
+	Member Class::*		m_member;
+	uint32_t			m_sinceVersion;			// First version that has the field
+};
+
+// A field that used to be in the data, parsed and thrown away when reading versions [since, until)
+template<typename Member>
+struct SerialRemovedField
+{
+	typedef Member MemberType;
+
+	uint32_t			m_sinceVersion;
+	uint32_t			m_untilVersion;
+};
+
+template<typename Class, typename Member>
+constexpr SerialField<Class, Member> MakeSerialField(Member Class::* member, uint32_t sinceVersion = SERIAL_FIRST_VERSION)
+{
+	return SerialField<Class, Member>{ member, sinceVersion };
+}
+
+template<typename Member>
+constexpr SerialRemovedField<Member> MakeRemovedSerialField(uint32_t sinceVersion, uint32_t untilVersion)
+{
+	return SerialRemovedField<Member>{ sinceVersion, untilVersion };
+}
+
+///---------------------------------------------------------------------------------------------------------------------------------
+/// Schemas, read from the type itself unless specialized below for engine types that can't describe themselves
+///
+template<typename T, typename = void>
+struct SerialVersionOf { static constexpr uint32_t VALUE = 0; };
+template<typename T>
+struct SerialVersionOf<T, std::void_t<decltype(T::SERIAL_VERSION)>> { static constexpr uint32_t VALUE = T::SERIAL_VERSION; };
+
+template<typename T, typename = void>
+struct SerialBlittableOf { static constexpr bool VALUE = false; };
+template<typename T>
+struct SerialBlittableOf<T, std::void_t<decltype(T::SERIAL_IS_BLITTABLE)>> { static constexpr bool VALUE = T::SERIAL_IS_BLITTABLE; };
+
+template<typename T, typename = void>
+struct SerialSchema
+{
+	static constexpr bool IS_DEFINED = false;
+};
+
+template<typename T>
+struct SerialSchema<T, std::void_t<decltype(T::GetSerialFields())>>
+{
+	static constexpr bool IS_DEFINED = true;
+	static constexpr uint32_t VERSION = SerialVersionOf<T>::VALUE;				// 0 for types that are never versioned
+	static constexpr bool IS_BLITTABLE = SerialBlittableOf<T>::VALUE;
+	static constexpr auto GetFields() { return T::GetSerialFields(); }
+};
+
+#define SERIAL_BLITTABLE_SCHEMA(Type, ...)												\
+	template<>																			\
+	struct SerialSchema<Type>															\
+	{																					\
+		static constexpr bool IS_DEFINED = true;										\
+		static constexpr uint32_t VERSION = 0;											\
+		static constexpr bool IS_BLITTABLE = true;										\
+		static constexpr auto GetFields() { return std::make_tuple(__VA_ARGS__); }		\
+	}
+
+SERIAL_BLITTABLE_SCHEMA(Vec2, MakeSerialField(&Vec2::x), MakeSerialField(&Vec2::y));
+SERIAL_BLITTABLE_SCHEMA(Vec3, MakeSerialField(&Vec3::x), MakeSerialField(&Vec3::y), MakeSerialField(&Vec3::z));
+SERIAL_BLITTABLE_SCHEMA(Vec4, MakeSerialField(&Vec4::x), MakeSerialField(&Vec4::y), MakeSerialField(&Vec4::z), MakeSerialField(&Vec4::w));
+SERIAL_BLITTABLE_SCHEMA(IntVec2, MakeSerialField(&IntVec2::x), MakeSerialField(&IntVec2::y));
+SERIAL_BLITTABLE_SCHEMA(Rgba8, MakeSerialField(&Rgba8::r), MakeSerialField(&Rgba8::g), MakeSerialField(&Rgba8::b), MakeSerialField(&Rgba8::a));
+SERIAL_BLITTABLE_SCHEMA(AABB2, MakeSerialField(&AABB2::m_mins), MakeSerialField(&AABB2::m_maxs));
+SERIAL_BLITTABLE_SCHEMA(Vertex_PCU, MakeSerialField(&Vertex_PCU::m_position), MakeSerialField(&Vertex_PCU::m_color), MakeSerialField(&Vertex_PCU::m_uvTexCoords));
+
+///---------------------------------------------------------------------------------------------------------------------------------
+/// Compile time checks on schemas
+///
+template<typename T>
+constexpr size_t GetSerialFieldsSize();
+template<typename T>
+constexpr bool AreSerialFieldsBlittable();
+
+// Instantiated by IsSerialBlittable and by every field walk, so a bad blittable schema fails to
+// compile whether the type is written alone, in a vector or as a field
+template<typename T>
+constexpr bool IsSerialSchemaValid()
+{
+	if constexpr (SerialSchema<T>::IS_BLITTABLE)
+	{
+		static_assert(SerialSchema<T>::VERSION == 0, "Blittable types can't be versioned, their layout is their schema");
+		static_assert(GetSerialFieldsSize<T>() == sizeof(T), "Blittable type has padding or fields missing from its schema");
+		static_assert(AreSerialFieldsBlittable<T>(), "Every field of a blittable type has to be blittable too");
+	}
+	return true;
+}
+
+template<typename T>
+constexpr bool IsSerialBlittable()
+{
+	if constexpr (std::is_arithmetic<T>::value)
+	{
+		return !std::is_same<T, bool>::value;
+	}
+	else if constexpr (std::is_class<T>::value)
+	{
+		if constexpr (SerialSchema<T>::IS_DEFINED)
+		{
+			return IsSerialSchemaValid<T>() && SerialSchema<T>::IS_BLITTABLE;
+		}
+	}
+	return false;
+}
+
+template<typename T>
+constexpr size_t GetSerialFieldsSize()
+{
+	return std::apply([](auto const&... field) { return (size_t(0) + ... + sizeof(typename std::decay_t<decltype(field)>::MemberType)); }, SerialSchema<T>::GetFields());
+}
+
+template<typename T>
+constexpr bool AreSerialFieldsBlittable()
+{
+	return std::apply([](auto const&... field) { return (true && ... && IsSerialBlittable<typename std::decay_t<decltype(field)>::MemberType>()); }, SerialSchema<T>::GetFields());
+}
+
+template<typename T>
+constexpr uint32_t GetSerialReadVersion()
+{
+	return SerialSchema<T>::VERSION == 0 ? SERIAL_FIRST_VERSION : SerialSchema<T>::VERSION;
+}
+
+template<typename T>
+void SerializeValue(BufferWriter& writer, T const& value);
+template<typename T>
+void DeserializeValue(BufferParser& parser, T& value);
+
+///---------------------------------------------------------------------------------------------------------------------------------
+/// Fields, unrolled at compile time over the tuple of fields
+///
+template<typename Class, typename Member>
+void SerializeField(BufferWriter& writer, Class const& object, SerialField<Class, Member> const& field)
+{
+	SerializeValue(writer, object.*(field.m_member));
+}
+
+template<typename Class, typename Member>
+void SerializeField(BufferWriter& writer, Class const& object, SerialRemovedField<Member> const& field)
+{
+	UNUSED(writer);
+	UNUSED(object);
+	UNUSED(field);
+}
+
+template<typename Class, typename Member>
+void DeserializeField(BufferParser& parser, Class& object, SerialField<Class, Member> const& field, uint32_t version)
+{
+	if (version >= field.m_sinceVersion)
+	{
+		DeserializeValue(parser, object.*(field.m_member));
+	}
+}
+
+template<typename Class, typename Member>
+void DeserializeField(BufferParser& parser, Class& object, SerialRemovedField<Member> const& field, uint32_t version)
+{
+	UNUSED(object);
+	if (version >= field.m_sinceVersion && version < field.m_untilVersion)
+	{
+		Member discarded{};
+		DeserializeValue(parser, discarded);
+	}
+}
+
+template<typename T>
+void SerializeFields(BufferWriter& writer, T const& object)
+{
+	static_assert(IsSerialSchemaValid<T>());
+	std::apply([&](auto const&... field) { (SerializeField(writer, object, field), ...); }, SerialSchema<T>::GetFields());
+}
+
+template<typename T>
+void DeserializeFields(BufferParser& parser, T& object, uint32_t version)
+{
+	static_assert(IsSerialSchemaValid<T>());
+	std::apply([&](auto const&... field) { (DeserializeField(parser, object, field, version), ...); }, SerialSchema<T>::GetFields());
+}
+
+template<typename T>
+uint32_t DeserializeSchemaVersion(BufferParser& parser)
+{
+	if constexpr (SerialSchema<T>::VERSION == 0)
+	{
+		UNUSED(parser);
+		return SERIAL_FIRST_VERSION;
+	}
+	else
+	{
+		uint32_t version = parser.ParseUint32();
+		GUARANTEE_OR_DIE(version >= SERIAL_FIRST_VERSION && version <= SerialSchema<T>::VERSION, Stringf("Serialized data has version %u, newest known is %u", version, SerialSchema<T>::VERSION));
+		return version;
+	}
+}
+
+///---------------------------------------------------------------------------------------------------------------------------------
+/// Arrays, one copy when the element is blittable and no byte swap is needed, element by element otherwise
+///
+template<typename T>
+void SerializeArray(BufferWriter& writer, T const* values, size_t count)
+{
+	if constexpr (IsSerialBlittable<T>() && std::is_arithmetic<T>::value)
+	{
+		writer.AppendArray(values, count);
+	}
+	else if constexpr (IsSerialBlittable<T>())
+	{
+		if (!writer.IsByteSwapNeeded())
+		{
+			writer.AppendByteArray((void const*)values, count * sizeof(T));
+			return;
+		}
+		for (size_t index = 0; index < count; ++index)
+		{
+			SerializeFields(writer, values[index]);
+		}
+	}
+	else if constexpr (std::is_class<T>::value && SerialSchema<T>::IS_DEFINED)
+	{
+		if constexpr (SerialSchema<T>::VERSION != 0)
+		{
+			writer.AppendPrimitive<uint32_t>(SerialSchema<T>::VERSION);
+		}
+		for (size_t index = 0; index < count; ++index)
+		{
+			SerializeFields(writer, values[index]);
+		}
+	}
+	else
+	{
+		for (size_t index = 0; index < count; ++index)
+		{
+			SerializeValue(writer, values[index]);
+		}
+	}
+}
+
+template<typename T>
+void DeserializeArray(BufferParser& parser, T* values, size_t count)
+{
+	if constexpr (IsSerialBlittable<T>() && std::is_arithmetic<T>::value)
+	{
+		parser.ParseArray(values, count);
+	}
+	else if constexpr (IsSerialBlittable<T>())
+	{
+		if (!parser.IsByteSwapNeeded())
+		{
+			parser.ParseByteArray((void*)values, count * sizeof(T));
+			return;
+		}
+		for (size_t index = 0; index < count; ++index)
+		{
+			DeserializeFields(parser, values[index], SERIAL_FIRST_VERSION);
+		}
+	}
+	else if constexpr (std::is_class<T>::value && SerialSchema<T>::IS_DEFINED)
+	{
+		uint32_t version = DeserializeSchemaVersion<T>(parser);
+		for (size_t index = 0; index < count; ++index)
+		{
+			DeserializeFields(parser, values[index], version);
+		}
+	}
+	else
+	{
+		for (size_t index = 0; index < count; ++index)
+		{
+			DeserializeValue(parser, values[index]);
+		}
+	}
+}
+
+///---------------------------------------------------------------------------------------------------------------------------------
+/// Values, picked at compile time by type
+///
+template<typename T>
+struct IsSerialVector : std::false_type {};
+template<typename Element, typename Allocator>
+struct IsSerialVector<std::vector<Element, Allocator>> : std::true_type {};
+
+template<typename T>
+void SerializeValue(BufferWriter& writer, T const& value)
+{
+	if constexpr (std::is_arithmetic<T>::value)
+	{
+		writer.AppendPrimitive(value);
+	}
+	else if constexpr (std::is_enum<T>::value)
+	{
+		writer.AppendPrimitive(static_cast<std::underlying_type_t<T>>(value));
+	}
+	else if constexpr (std::is_same<T, std::string>::value)
+	{
+		writer.AppendLengthPrecededString(value);
+	}
+	else if constexpr (IsSerialVector<T>::value)
+	{
+		static_assert(!std::is_same<typename T::value_type, bool>::value, "std::vector<bool> is not serializable, use a vector of uint8_t");
+		writer.AppendPrimitive<uint32_t>((uint32_t)value.size());
+		SerializeArray(writer, value.data(), value.size());
+	}
+	else
+	{
+		static_assert(SerialSchema<T>::IS_DEFINED, "Type has no serialization schema, give it a static constexpr GetSerialFields()");
+		if constexpr (SerialSchema<T>::VERSION != 0)
+		{
+			writer.AppendPrimitive<uint32_t>(SerialSchema<T>::VERSION);
+		}
+		SerializeFields(writer, value);
+	}
+}
+
+template<typename T>
+void DeserializeValue(BufferParser& parser, T& value)
+{
+	if constexpr (std::is_same<T, bool>::value)
+	{
+		value = parser.ParseBool();
+	}
+	else if constexpr (std::is_arithmetic<T>::value)
+	{
+		parser.ParseArray(&value, 1);
+	}
+	else if constexpr (std::is_enum<T>::value)
+	{
+		std::underlying_type_t<T> underlyingValue;
+		parser.ParseArray(&underlyingValue, 1);
+		value = static_cast<T>(underlyingValue);
+	}
+	else if constexpr (std::is_same<T, std::string>::value)
+	{
+		value.clear();
+		parser.ParseStringAfter32BitLength(value);
+	}
+	else if constexpr (IsSerialVector<T>::value)
+	{
+		// Every element takes at least a byte, so a corrupted count fails here instead of allocating
+		uint32_t count = parser.ParseUint32();
+		GUARANTEE_OR_DIE(count <= parser.GetRemainingSize(), Stringf("Serialized array of %u elements is bigger than the buffer", count));
+		value.resize(count);
+		DeserializeArray(parser, value.data(), value.size());
+	}
+	else
+	{
+		static_assert(SerialSchema<T>::IS_DEFINED, "Type has no serialization schema, give it a static constexpr GetSerialFields()");
+		DeserializeFields(parser, value, DeserializeSchemaVersion<T>(parser));
+	}
+}
+
+///---------------------------------------------------------------------------------------------------------------------------------
+/// Whole buffers, little endian unless asked otherwise so the blittable fast path is taken on every platform we ship
+///
+template<typename T>
+void SerializeToBuffer(T const& value, std::vector<unsigned char>& outBuffer, eBufferEndian endian = eBufferEndian::LITTLE)
+{
+	BufferWriter writer(outBuffer, endian);
+	SerializeValue(writer, value);
+}
+
+template<typename T>
+void DeserializeFromBuffer(T& value, std::vector<unsigned char> const& buffer, eBufferEndian endian = eBufferEndian::LITTLE)
+{
+	BufferParser parser(buffer, endian);
+	DeserializeValue(parser, value);
+}
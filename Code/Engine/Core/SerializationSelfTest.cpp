@@ -0,0 +1,185 @@
+#include "Engine/Core/SerializationSelfTest.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Core/Serialization.hpp"
+
+enum class SerialTestTeam : uint8_t
+{
+	RED,
+	BLUE,
+};
+
+struct SerialTestItem
+{
+	static constexpr auto GetSerialFields()
+	{
+		return std::make_tuple(MakeSerialField(&SerialTestItem::m_name), MakeSerialField(&SerialTestItem::m_count));
+	}
+
+	bool operator==(SerialTestItem const& compare) const { return m_name == compare.m_name && m_count == compare.m_count; }
+
+	std::string		m_name;
+	int				m_count = 0;
+};
+
+// Version 1 of SerialTestUnit, written by hand to check that newer code still reads it
+struct SerialTestUnitV1
+{
+	static constexpr uint32_t SERIAL_VERSION = 1;
+	static constexpr auto GetSerialFields()
+	{
+		return std::make_tuple(MakeSerialField(&SerialTestUnitV1::m_position), MakeSerialField(&SerialTestUnitV1::m_health));
+	}
+
+	Vec3			m_position;
+	float			m_health = 0.f;
+};
+
+struct SerialTestUnit
+{
+	static constexpr uint32_t SERIAL_VERSION = 2;
+	static constexpr auto GetSerialFields()
+	{
+		return std::make_tuple(
+			MakeSerialField(&SerialTestUnit::m_position),
+			MakeRemovedSerialField<float>(1, 2),
+			MakeSerialField(&SerialTestUnit::m_team, 2),
+			MakeSerialField(&SerialTestUnit::m_items, 2),
+			MakeSerialField(&SerialTestUnit::m_path, 2));
+	}
+
+	bool operator==(SerialTestUnit const& compare) const
+	{
+		return m_position == compare.m_position && m_team == compare.m_team && m_items == compare.m_items && m_path == compare.m_path;
+	}
+
+	Vec3							m_position;
+	SerialTestTeam					m_team = SerialTestTeam::RED;
+	std::vector<SerialTestItem>		m_items;
+	std::vector<Vec2>				m_path;
+};
+
+struct SerialTestScene
+{
+	static constexpr auto GetSerialFields()
+	{
+		return std::make_tuple(
+			MakeSerialField(&SerialTestScene::m_name),
+			MakeSerialField(&SerialTestScene::m_units),
+			MakeSerialField(&SerialTestScene::m_vertexes),
+			MakeSerialField(&SerialTestScene::m_heights),
+			MakeSerialField(&SerialTestScene::m_bounds));
+	}
+
+	std::string						m_name;
+	std::vector<SerialTestUnit>		m_units;
+	std::vector<Vertex_PCU>			m_vertexes;
+	std::vector<double>				m_heights;
+	AABB2							m_bounds;
+};
+
+static SerialTestScene MakeSerialTestScene()
+{
+	SerialTestScene scene;
+	scene.m_name = "self test";
+	for (int unitIndex = 0; unitIndex < 3; ++unitIndex)
+	{
+		SerialTestUnit unit;
+		unit.m_position = Vec3((float)unitIndex, -2.5f * (float)unitIndex, 1000.125f);
+		unit.m_team = (unitIndex % 2) ? SerialTestTeam::BLUE : SerialTestTeam::RED;
+		for (int itemIndex = 0; itemIndex < unitIndex; ++itemIndex)
+		{
+			unit.m_items.push_back(SerialTestItem{ Stringf("item %i", itemIndex), itemIndex * 7 - 3 });
+			unit.m_path.push_back(Vec2((float)itemIndex * 0.5f, -(float)unitIndex));
+		}
+		scene.m_units.push_back(unit);
+	}
+	for (int vertexIndex = 0; vertexIndex < 16; ++vertexIndex)
+	{
+		float value = (float)vertexIndex;
+		scene.m_vertexes.push_back(Vertex_PCU(Vec3(value, value * 2.f, -value), Rgba8((unsigned char)vertexIndex, 2, 3, 255), Vec2(value / 16.f, 1.f - value / 16.f)));
+		scene.m_heights.push_back((double)value * 1.0e10);
+	}
+	scene.m_bounds = AABB2(Vec2(-1.f, -2.f), Vec2(3.f, 4.f));
+	return scene;
+}
+
+static bool AreScenesEqual(SerialTestScene const& lhs, SerialTestScene const& rhs)
+{
+	if (lhs.m_name != rhs.m_name || !(lhs.m_units == rhs.m_units) || lhs.m_heights != rhs.m_heights || lhs.m_vertexes.size() != rhs.m_vertexes.size())
+	{
+		return false;
+	}
+	if (lhs.m_bounds.m_mins != rhs.m_bounds.m_mins || lhs.m_bounds.m_maxs != rhs.m_bounds.m_maxs)
+	{
+		return false;
+	}
+	for (size_t vertexIndex = 0; vertexIndex < lhs.m_vertexes.size(); ++vertexIndex)
+	{
+		Vertex_PCU const& a = lhs.m_vertexes[vertexIndex];
+		Vertex_PCU const& b = rhs.m_vertexes[vertexIndex];
+		if (a.m_position != b.m_position || !(a.m_color == b.m_color) || a.m_uvTexCoords != b.m_uvTexCoords)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool RunSerializationSelfTest(std::string& outFailure)
+{
+	SerialTestScene const scene = MakeSerialTestScene();
+	eBufferEndian const endians[] = { eBufferEndian::LITTLE, eBufferEndian::BIG };
+	for (eBufferEndian endian : endians)
+	{
+		char const* endianName = endian == eBufferEndian::LITTLE ? "little" : "big";
+
+		std::vector<unsigned char> buffer;
+		SerializeToBuffer(scene, buffer, endian);
+		SerialTestScene readScene;
+		BufferParser parser(buffer, endian);
+		DeserializeValue(parser, readScene);
+		if (!AreScenesEqual(scene, readScene))
+		{
+			outFailure = Stringf("scene read back differently, %s endian", endianName);
+			return false;
+		}
+		if (parser.GetRemainingSize() != 0)
+		{
+			outFailure = Stringf("scene left %i bytes unread, %s endian", (int)parser.GetRemainingSize(), endianName);
+			return false;
+		}
+
+		// Version 1 had a health field that version 2 dropped, and none of the version 2 fields
+		std::vector<SerialTestUnitV1> oldUnits = { { Vec3(1.f, 2.f, 3.f), 50.f }, { Vec3(-4.f, 5.f, -6.f), 75.f } };
+		std::vector<unsigned char> oldBuffer;
+		SerializeToBuffer(oldUnits, oldBuffer, endian);
+		std::vector<SerialTestUnit> upgradedUnits;
+		DeserializeFromBuffer(upgradedUnits, oldBuffer, endian);
+		if (upgradedUnits.size() != oldUnits.size() || upgradedUnits[1].m_position != oldUnits[1].m_position || !upgradedUnits[1].m_items.empty())
+		{
+			outFailure = Stringf("version 1 units did not upgrade, %s endian", endianName);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Command_SerializationSelfTest(EventArgs const& args)
+{
+	UNUSED(args);
+	std::string failure;
+	bool isPassing = RunSerializationSelfTest(failure);
+	if (g_theConsole)
+	{
+		if (isPassing)
+		{
+			g_theConsole->AddLine(DevConsole::INFO_MAJOR, "SerializationSelfTest passed");
+		}
+		else
+		{
+			g_theConsole->AddLine(DevConsole::ERROR, Stringf("SerializationSelfTest failed: %s", failure.c_str()));
+		}
+	}
+	return true;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <string>
+
+class NamedProperties;
+typedef NamedProperties EventArgs;
+
+//-----------------------------------------------------------------------------------
+// Round trips a few schemas through Serialization.hpp in both endiannesses: nested and versioned
+// types, strings, enums, vectors taking the blittable fast path, and data written by an older
+// version of a schema. Returns false and says what differed on the first failure.
+//
+bool	RunSerializationSelfTest(std::string& outFailure);
+bool	Command_SerializationSelfTest(EventArgs const& args);
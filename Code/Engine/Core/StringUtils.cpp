@@ -3,6 +3,8 @@
 #include "Engine/Core/NamedProperties.hpp"
 #include <stdarg.h>
 #include <cctype>
+#include <charconv>
+#include <cstdio>
 //-----------------------------------------------------------------------------------------------
 constexpr int STRINGF_STACK_LOCAL_TEMP_LENGTH = 2048;
 //-----------------------------------------------------------------------------------------------
@@ -38,91 +40,257 @@ const std::string Stringf( int maxLength, char const* format, ... )
 	return returnValue;
 }
 
+//-----------------------------------------------------------------------------------------------
+static int FormatIntoBuffer( char* buffer, size_t bufferSize, char const* format, va_list variableArgumentList )
+{
+	int length = vsnprintf( buffer, bufferSize, format, variableArgumentList );
+	if( length < 0 )
+	{
+		if( bufferSize > 0 )
+			buffer[ 0 ] = '\0';
+		return 0;
+	}
+	return (size_t)length < bufferSize ? length : (int)bufferSize - 1;
+}
+//-----------------------------------------------------------------------------------------------
+int StringfToBuffer( char* buffer, size_t bufferSize, char const* format, ... )
+{
+	va_list variableArgumentList;
+	va_start( variableArgumentList, format );
+	int length = FormatIntoBuffer( buffer, bufferSize, format, variableArgumentList );
+	va_end( variableArgumentList );
+	return length;
+}
+//-----------------------------------------------------------------------------------------------
+void StringfInto( std::string& outString, char const* format, ... )
+{
+	char textLiteral[ STRINGF_STACK_LOCAL_TEMP_LENGTH ];
+	va_list variableArgumentList;
+	va_list variableArgumentListCopy;
+	va_start( variableArgumentList, format );
+	va_copy( variableArgumentListCopy, variableArgumentList );
+	int length = vsnprintf( textLiteral, STRINGF_STACK_LOCAL_TEMP_LENGTH, format, variableArgumentList );
+	va_end( variableArgumentList );
+
+	// Short results copy into the capacity the string already has, long ones format a second time straight into it
+	if( length < 0 )
+	{
+		outString.clear();
+	}
+	else if( length < STRINGF_STACK_LOCAL_TEMP_LENGTH )
+	{
+		outString.assign( textLiteral, (size_t)length );
+	}
+	else
+	{
+		outString.resize( (size_t)length );
+		vsnprintf( &outString[ 0 ], (size_t)length + 1, format, variableArgumentListCopy );
+	}
+	va_end( variableArgumentListCopy );
+}
+//-----------------------------------------------------------------------------------------------
+std::string_view StringfTemp( char const* format, ... )
+{
+	thread_local char textLiteral[ STRINGF_STACK_LOCAL_TEMP_LENGTH ];
+	va_list variableArgumentList;
+	va_start( variableArgumentList, format );
+	int length = FormatIntoBuffer( textLiteral, STRINGF_STACK_LOCAL_TEMP_LENGTH, format, variableArgumentList );
+	va_end( variableArgumentList );
+	return std::string_view( textLiteral, (size_t)length );
+}
+
 Strings SplitStringOnDelimiter(std::string const& originalString, char delimiterToSplitOn)
 {
 	Strings result;
+	for (std::string_view part : StringSplitter(originalString, delimiterToSplitOn))
+	{
+		result.emplace_back(part);
+	}
+	return result;
+}
 
-	std::string subStringTemporary;
-
-	char currentChar;
+Strings SplitStringOnDelimiter(std::string const& originalString, std::string const& delimiterToSplitOn, bool removeEmpty /*= false*/)
+{
+	Strings strings;
+	std::string_view text = originalString;
+	size_t start = 0;
+	size_t end = text.find(delimiterToSplitOn);
 
-	for (int charIndex = 0; charIndex < originalString.length(); charIndex++)
+	while (end != std::string::npos)
 	{
-		currentChar = originalString[charIndex];
+		std::string_view part = text.substr(start, end - start);
 
-		if (currentChar != delimiterToSplitOn)
+		// Pieces of nothing but spaces count as empty
+		if (!removeEmpty || part.find_first_not_of(' ') != std::string_view::npos)
 		{
-			subStringTemporary.append(1, currentChar);
-			if (charIndex == originalString.length() - 1)
-			{
-				result.push_back(subStringTemporary);
-				subStringTemporary.clear();
-			}
+			strings.emplace_back(part);
 		}
-		else 
+
+		start = end + delimiterToSplitOn.size();
+		end = text.find(delimiterToSplitOn, start);
+	}
+
+	strings.emplace_back(text.substr(start));
+
+	return strings;
+}
+
+StringViews SplitStringViewOnDelimiter(std::string_view originalString, char delimiterToSplitOn)
+{
+	StringViews parts;
+	SplitStringViewOnDelimiter(originalString, delimiterToSplitOn, parts);
+	return parts;
+}
+
+void SplitStringViewOnDelimiter(std::string_view originalString, char delimiterToSplitOn, StringViews& outParts)
+{
+	outParts.clear();
+	for (std::string_view part : StringSplitter(originalString, delimiterToSplitOn))
+	{
+		outParts.push_back(part);
+	}
+}
+
+int SplitStringViewOnDelimiter(std::string_view originalString, char delimiterToSplitOn, std::string_view* outParts, int maxParts)
+{
+	int numParts = 0;
+	for (std::string_view part : StringSplitter(originalString, delimiterToSplitOn))
+	{
+		if (numParts < maxParts)
 		{
-			result.push_back(subStringTemporary);
-			subStringTemporary.clear();
+			outParts[numParts] = part;
 		}
+		numParts++;
 	}
+	return numParts;
+}
 
-	if (originalString.length() == 0 || originalString[originalString.length() - 1] == delimiterToSplitOn)
+bool StringSplitter::GetNext(std::string_view& outPart)
+{
+	if (m_isDone)
 	{
-		subStringTemporary.clear();
-		result.push_back(subStringTemporary);
+		return false;
 	}
 
-	return result;
+	size_t end = m_text.find(m_delimiter, m_position);
+	if (end == std::string_view::npos)
+	{
+		outPart = m_text.substr(m_position);
+		m_isDone = true;
+		return true;
+	}
+
+	outPart = m_text.substr(m_position, end - m_position);
+	m_position = end + 1;
+	return true;
 }
 
-Strings SplitStringOnDelimiter(std::string const& originalString, std::string const& delimiterToSplitOn, bool removeEmpty /*= false*/)
+bool StringTokenizer::GetNext(std::string_view& outToken)
 {
-	Strings strings;
-	size_t start = 0;
-	size_t end = originalString.find(delimiterToSplitOn);
+	size_t start = m_text.find_first_not_of(m_delimiters, m_position);
+	if (start == std::string_view::npos)
+	{
+		m_position = m_text.size();
+		return false;
+	}
 
-	while (end != std::string::npos)
+	size_t end = m_text.find_first_of(m_delimiters, start);
+	if (end == std::string_view::npos)
 	{
-		if (removeEmpty)
-		{
-			std::string subString = originalString.substr(start, end - start);
+		end = m_text.size();
+	}
 
-			bool emptyString = false;
+	outToken = m_text.substr(start, end - start);
+	m_position = end;
+	return true;
+}
 
-			if (subString.size() == 0)
-			{
-				emptyString = true;
-			}
+std::string_view StringTokenizer::GetRemaining() const
+{
+	size_t start = m_text.find_first_not_of(m_delimiters, m_position);
+	return start == std::string_view::npos ? std::string_view() : m_text.substr(start);
+}
 
-			for (char c: subString)
-			{
-				if (c != ' ')
-				{
-					emptyString = false;
-					continue;
-				}
-				emptyString = true;
-			}
+std::string_view TrimStringView(std::string_view text, std::string_view charactersToTrim)
+{
+	size_t start = text.find_first_not_of(charactersToTrim);
+	if (start == std::string_view::npos)
+	{
+		return std::string_view();
+	}
+	size_t end = text.find_last_not_of(charactersToTrim);
+	return text.substr(start, end - start + 1);
+}
 
-			if (emptyString == false)
-			{
-				strings.push_back(originalString.substr(start, end - start));
-			}
+// from_chars takes neither whitespace nor a leading '+'
+static std::string_view SkipToNumber(std::string_view text)
+{
+	size_t start = text.find_first_not_of(" \t\r\n\f\v");
+	if (start == std::string_view::npos)
+	{
+		return std::string_view();
+	}
+	text.remove_prefix(start);
+	if (text.size() > 1 && text[0] == '+' && text[1] != '-' && text[1] != '+')
+	{
+		text.remove_prefix(1);
+	}
+	return text;
+}
 
-			start = end + delimiterToSplitOn.size();
-			end = originalString.find(delimiterToSplitOn, start);
-		}
-		else 
-		{
-			strings.push_back(originalString.substr(start, end - start));
-			start = end + delimiterToSplitOn.size();
-			end = originalString.find(delimiterToSplitOn, start);
-		}
+template<typename T>
+static bool TryParseWholeNumber(std::string_view text, T& outValue)
+{
+	text = SkipToNumber(TrimStringView(text, " \t\r\n\f\v"));
+	T value;
+	std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+	if (text.empty() || result.ec != std::errc() || result.ptr != text.data() + text.size())
+	{
+		return false;
 	}
+	outValue = value;
+	return true;
+}
 
-	strings.push_back(originalString.substr(start));
+bool TryParseInt(std::string_view text, int& outValue)
+{
+	return TryParseWholeNumber(text, outValue);
+}
 
-	return strings;
+bool TryParseUint32(std::string_view text, uint32_t& outValue)
+{
+	return TryParseWholeNumber(text, outValue);
+}
+
+bool TryParseInt64(std::string_view text, int64_t& outValue)
+{
+	return TryParseWholeNumber(text, outValue);
+}
+
+bool TryParseFloat(std::string_view text, float& outValue)
+{
+	return TryParseWholeNumber(text, outValue);
+}
+
+bool TryParseDouble(std::string_view text, double& outValue)
+{
+	return TryParseWholeNumber(text, outValue);
+}
+
+int ParseIntFromText(std::string_view text, int defaultValue)
+{
+	text = SkipToNumber(text);
+	int value = defaultValue;
+	std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+	return result.ec == std::errc() ? value : defaultValue;
+}
+
+float ParseFloatFromText(std::string_view text, float defaultValue)
+{
+	text = SkipToNumber(text);
+	float value = defaultValue;
+	std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+	return result.ec == std::errc() ? value : defaultValue;
 }
 
 std::string ToLower(const std::string& string)
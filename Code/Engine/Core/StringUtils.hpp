@@ -2,20 +2,100 @@
 //-----------------------------------------------------------------------------------------------
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstdint>
 
 class NamedProperties;
 typedef NamedProperties EventArgs;
 
 typedef std::vector<std::string >		Strings; 
+typedef std::vector<std::string_view>	StringViews;		// Views into a string that has to outlive them
 //-----------------------------------------------------------------------------------------------
 const std::string Stringf( char const* format, ... );
 const std::string Stringf( int maxLength, char const* format, ... );
 
+// Same formatting without a new string: into a caller buffer (returns the length written, cut to fit),
+// into a string whose capacity gets reused, or into a per thread buffer that the next call on that thread overwrites
+int					StringfToBuffer( char* buffer, size_t bufferSize, char const* format, ... );
+void				StringfInto( std::string& outString, char const* format, ... );
+std::string_view	StringfTemp( char const* format, ... );
+
 Strings SplitStringOnDelimiter( std::string const& originalString, char delimiterToSplitOn = ',');
 
 // This overload can use multiple delimiter as one, like "'\r\n'"
 Strings SplitStringOnDelimiter(std::string const& originalString, std::string const& delimiterToSplitOn, bool removeEmpty = false);
 
+// Same pieces as SplitStringOnDelimiter, as views. The array version never allocates: it fills at most
+// maxParts views and returns how many pieces there are in total.
+StringViews	SplitStringViewOnDelimiter(std::string_view originalString, char delimiterToSplitOn = ',');
+void		SplitStringViewOnDelimiter(std::string_view originalString, char delimiterToSplitOn, StringViews& outParts);
+int			SplitStringViewOnDelimiter(std::string_view originalString, char delimiterToSplitOn, std::string_view* outParts, int maxParts);
+
+//-----------------------------------------------------------------------------------------------
+// Walks the pieces between delimiters one at a time, empty ones included, like SplitStringOnDelimiter:
+//	for (std::string_view part : StringSplitter(text, ','))
+//
+class StringSplitter
+{
+public:
+	StringSplitter(std::string_view text, char delimiter) : m_text(text), m_delimiter(delimiter) {}
+
+	bool				GetNext(std::string_view& outPart);
+
+	class Iterator
+	{
+	public:
+		Iterator(StringSplitter* splitter) : m_splitter(splitter) { ++*this; }
+
+		std::string_view	operator*() const { return m_part; }
+		Iterator&			operator++() { if (m_splitter && !m_splitter->GetNext(m_part)) { m_splitter = nullptr; } return *this; }
+		bool				operator!=(Iterator const& compare) const { return m_splitter != compare.m_splitter; }
+
+	private:
+		StringSplitter*		m_splitter = nullptr;
+		std::string_view	m_part;
+	};
+
+	Iterator			begin() { return Iterator(this); }
+	Iterator			end() { return Iterator(nullptr); }
+
+private:
+	std::string_view	m_text;
+	size_t				m_position = 0;
+	char				m_delimiter = ',';
+	bool				m_isDone = false;
+};
+
+//-----------------------------------------------------------------------------------------------
+// Yields the non empty tokens between runs of any of the delimiter characters, whitespace by default
+//
+class StringTokenizer
+{
+public:
+	StringTokenizer(std::string_view text, std::string_view delimiters = " \t\r\n") : m_text(text), m_delimiters(delimiters) {}
+
+	bool				GetNext(std::string_view& outToken);
+	std::string_view	GetRemaining() const;							// Everything after the last token, leading delimiters skipped
+
+private:
+	std::string_view	m_text;
+	std::string_view	m_delimiters;
+	size_t				m_position = 0;
+};
+
+std::string_view	TrimStringView(std::string_view text, std::string_view charactersToTrim = " \t\r\n");
+
+// Strict: the whole text, surrounding whitespace aside, has to be the number. Nothing is written on failure.
+bool	TryParseInt(std::string_view text, int& outValue);
+bool	TryParseUint32(std::string_view text, uint32_t& outValue);
+bool	TryParseInt64(std::string_view text, int64_t& outValue);
+bool	TryParseFloat(std::string_view text, float& outValue);
+bool	TryParseDouble(std::string_view text, double& outValue);
+
+// Lenient like atoi/atof: leading whitespace and trailing junk are ignored, defaultValue when there is no number
+int		ParseIntFromText(std::string_view text, int defaultValue = 0);
+float	ParseFloatFromText(std::string_view text, float defaultValue = 0.f);
+
 std::string ToLower(const std::string& string);
 void		TrimString(std::string& originalString, char delimiterToTrim);
 std::string	GetStringWithQuotes(const std::string& originalString);
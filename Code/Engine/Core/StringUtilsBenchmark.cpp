@@ -0,0 +1,206 @@
+#include "Engine/Core/StringUtilsBenchmark.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Core/Time.hpp"
+#include <cstdlib>
+
+// Keeps the optimizer from dropping the work being timed
+static volatile size_t s_benchmarkSink = 0;
+
+// The character at a time split the engine used before the string_view helpers, kept as the baseline
+static Strings SplitStringOnDelimiterOneCharAtATime(std::string const& originalString, char delimiterToSplitOn)
+{
+	Strings result;
+	std::string subStringTemporary;
+	for (int charIndex = 0; charIndex < (int)originalString.length(); charIndex++)
+	{
+		char currentChar = originalString[charIndex];
+		if (currentChar != delimiterToSplitOn)
+		{
+			subStringTemporary.append(1, currentChar);
+			if (charIndex == (int)originalString.length() - 1)
+			{
+				result.push_back(subStringTemporary);
+				subStringTemporary.clear();
+			}
+		}
+		else
+		{
+			result.push_back(subStringTemporary);
+			subStringTemporary.clear();
+		}
+	}
+	if (originalString.length() == 0 || originalString[originalString.length() - 1] == delimiterToSplitOn)
+	{
+		subStringTemporary.clear();
+		result.push_back(subStringTemporary);
+	}
+	return result;
+}
+
+template<typename Work>
+static double TimeMilliseconds(int numIterations, Work const& work)
+{
+	double startSeconds = GetCurrentTimeSeconds();
+	for (int iteration = 0; iteration < numIterations; ++iteration)
+	{
+		work();
+	}
+	return (GetCurrentTimeSeconds() - startSeconds) * 1000.0;
+}
+
+std::vector<StringBenchmarkResult> RunStringUtilsBenchmark(int numIterations)
+{
+	std::vector<StringBenchmarkResult> results;
+	std::string const vectorText = "12.5,-3.25,1024.0";
+	std::string const commandText = "spawn type=Marine position=12.5,3,0 team=blue count=4 name=\"squad leader\"";
+	std::string const objLine = "v -0.512345 1.250000 3.999999";
+	std::string const numberList = "17,-4,1024,65535,8,0,-2147,99";
+
+	{
+		StringBenchmarkResult result;
+		result.m_name = "split xml vector";
+		result.m_baselineMs = TimeMilliseconds(numIterations, [&]()
+		{
+			Strings strings = SplitStringOnDelimiterOneCharAtATime(vectorText, ',');
+			s_benchmarkSink = s_benchmarkSink + strings.size();
+		});
+		result.m_optimizedMs = TimeMilliseconds(numIterations, [&]()
+		{
+			std::string_view strings[3];
+			s_benchmarkSink = s_benchmarkSink + SplitStringViewOnDelimiter(vectorText, ',', strings, 3);
+		});
+		results.push_back(result);
+	}
+
+	{
+		StringBenchmarkResult result;
+		result.m_name = "split owning (old vs new)";
+		result.m_baselineMs = TimeMilliseconds(numIterations, [&]()
+		{
+			s_benchmarkSink = s_benchmarkSink + SplitStringOnDelimiterOneCharAtATime(commandText, ' ').size();
+		});
+		result.m_optimizedMs = TimeMilliseconds(numIterations, [&]()
+		{
+			s_benchmarkSink = s_benchmarkSink + SplitStringOnDelimiter(commandText, ' ').size();
+		});
+		results.push_back(result);
+	}
+
+	{
+		StringBenchmarkResult result;
+		result.m_name = "console command key=value";
+		result.m_baselineMs = TimeMilliseconds(numIterations, [&]()
+		{
+			Strings words = SplitStringOnDelimiterOneCharAtATime(commandText, ' ');
+			for (size_t wordIndex = 1; wordIndex < words.size(); ++wordIndex)
+			{
+				Strings keyValue = SplitStringOnDelimiterOneCharAtATime(words[wordIndex], '=');
+				s_benchmarkSink = s_benchmarkSink + keyValue.size();
+			}
+		});
+		result.m_optimizedMs = TimeMilliseconds(numIterations, [&]()
+		{
+			StringSplitter words(commandText, ' ');
+			std::string_view word;
+			words.GetNext(word);
+			while (words.GetNext(word))
+			{
+				std::string_view keyValue[2];
+				s_benchmarkSink = s_benchmarkSink + SplitStringViewOnDelimiter(word, '=', keyValue, 2);
+			}
+		});
+		results.push_back(result);
+	}
+
+	{
+		StringBenchmarkResult result;
+		result.m_name = "obj vertex line";
+		result.m_baselineMs = TimeMilliseconds(numIterations, [&]()
+		{
+			Strings tokens = SplitStringOnDelimiterOneCharAtATime(objLine, ' ');
+			float sum = 0.f;
+			for (size_t tokenIndex = 1; tokenIndex < tokens.size(); ++tokenIndex)
+			{
+				sum += (float)atof(tokens[tokenIndex].c_str());
+			}
+			s_benchmarkSink = s_benchmarkSink + (size_t)sum;
+		});
+		result.m_optimizedMs = TimeMilliseconds(numIterations, [&]()
+		{
+			StringTokenizer tokens(objLine);
+			std::string_view token;
+			tokens.GetNext(token);
+			float sum = 0.f;
+			while (tokens.GetNext(token))
+			{
+				float value = 0.f;
+				TryParseFloat(token, value);
+				sum += value;
+			}
+			s_benchmarkSink = s_benchmarkSink + (size_t)sum;
+		});
+		results.push_back(result);
+	}
+
+	{
+		StringBenchmarkResult result;
+		result.m_name = "int list atoi vs from_chars";
+		Strings numbers = SplitStringOnDelimiter(numberList, ',');
+		StringViews numberViews = SplitStringViewOnDelimiter(numberList, ',');
+		result.m_baselineMs = TimeMilliseconds(numIterations, [&]()
+		{
+			int sum = 0;
+			for (std::string const& number : numbers)
+			{
+				sum += atoi(number.c_str());
+			}
+			s_benchmarkSink = s_benchmarkSink + (size_t)sum;
+		});
+		result.m_optimizedMs = TimeMilliseconds(numIterations, [&]()
+		{
+			int sum = 0;
+			for (std::string_view number : numberViews)
+			{
+				sum += ParseIntFromText(number);
+			}
+			s_benchmarkSink = s_benchmarkSink + (size_t)sum;
+		});
+		results.push_back(result);
+	}
+
+	{
+		StringBenchmarkResult result;
+		result.m_name = "Stringf vs StringfInto";
+		std::string reusedString;
+		result.m_baselineMs = TimeMilliseconds(numIterations, [&]()
+		{
+			std::string text = Stringf("Entity %d at (%.2f, %.2f) owned by %s", 42, 12.5f, -3.25f, "player one");
+			s_benchmarkSink = s_benchmarkSink + text.size();
+		});
+		result.m_optimizedMs = TimeMilliseconds(numIterations, [&]()
+		{
+			StringfInto(reusedString, "Entity %d at (%.2f, %.2f) owned by %s", 42, 12.5f, -3.25f, "player one");
+			s_benchmarkSink = s_benchmarkSink + reusedString.size();
+		});
+		results.push_back(result);
+	}
+
+	return results;
+}
+
+bool Command_StringBenchmark(EventArgs const& args)
+{
+	int numIterations = args.GetValue(std::string("iterations"), 200000);
+	std::vector<StringBenchmarkResult> results = RunStringUtilsBenchmark(numIterations);
+	if (g_theConsole)
+	{
+		g_theConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("StringBenchmark, %i iterations each", numIterations));
+		for (StringBenchmarkResult const& result : results)
+		{
+			g_theConsole->AddLine(DevConsole::INFO_MINOR, Stringf("%-28s %8.2fms -> %8.2fms (%.1fx)", result.m_name.c_str(), result.m_baselineMs, result.m_optimizedMs,
+				result.m_optimizedMs > 0.0 ? result.m_baselineMs / result.m_optimizedMs : 0.0));
+		}
+	}
+	return true;
+}
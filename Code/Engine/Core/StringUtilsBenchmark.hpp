@@ -0,0 +1,18 @@
+#pragma once
+#include "Engine/Core/StringUtils.hpp"
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------------
+// Times the owning string helpers against their string_view and from_chars counterparts on
+// the kind of text the engine parses: xml vectors, console commands, obj lines and Stringf.
+//
+struct StringBenchmarkResult
+{
+	std::string		m_name;
+	double			m_baselineMs = 0.0;		// Owning strings, atoi/atof, or Stringf
+	double			m_optimizedMs = 0.0;	// Views and from_chars, or the buffer Stringf variants
+};
+
+std::vector<StringBenchmarkResult>	RunStringUtilsBenchmark(int numIterations);
+bool								Command_StringBenchmark(EventArgs const& args);
@@ -11,6 +11,13 @@
 #include "Engine/Math/ConvexPoly2.hpp"
 #include "Engine/Core/VertexUtils.hpp"
 #include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/ParallelAlgorithms.hpp"
+#include "Engine/Math/SIMDUtils.hpp"
+
+// Vertex arrays shorter than this are transformed on the calling thread, below it handing chunks to
+// the job system costs more than it saves
+constexpr int MIN_VERTS_FOR_PARALLEL_TRANSFORM = 32768;
+constexpr int VERTS_PER_TRANSFORM_CHUNK = 8192;
 
 
 void AddVertsForCapsule2D(std::vector<Vertex_PCU>& verts, Capsule2 const& capsule, Rgba8 const& color)
@@ -1106,24 +1113,210 @@ void AddVertsForSolidHexagon3D(std::vector<Vertex_PCU>& verts, std::vector<unsig
 	}
 }
 
+//-----------------------------------------------------------------------------------
+// Transforms the Vec3 found every strideInFloats floats, 8 at a time with AVX2 and 4 at a time with SSE.
+// Positions go through the same multiplies and adds, in the same order, as Mat44::TransformPosition3D,
+// and directions as TransformVectorQuantity3D followed by GetNormalized, so every path gives the
+// same bits as the one vertex at a time code.
+//
+template<bool IS_POSITION>
+static void TransformStridedVec3s(float* firstVec3, int strideInFloats, int numVec3s, Vec3 const& iBasis, Vec3 const& jBasis, Vec3 const& kBasis, Vec3 const& translation)
+{
+	int vecIndex = 0;
+#if defined(ENGINE_SIMD_AVX2)
+	__m256i gatherOffsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(strideInFloats));
+	__m256 iX = _mm256_set1_ps(iBasis.x), iY = _mm256_set1_ps(iBasis.y), iZ = _mm256_set1_ps(iBasis.z);
+	__m256 jX = _mm256_set1_ps(jBasis.x), jY = _mm256_set1_ps(jBasis.y), jZ = _mm256_set1_ps(jBasis.z);
+	__m256 kX = _mm256_set1_ps(kBasis.x), kY = _mm256_set1_ps(kBasis.y), kZ = _mm256_set1_ps(kBasis.z);
+	__m256 tX = _mm256_set1_ps(translation.x), tY = _mm256_set1_ps(translation.y), tZ = _mm256_set1_ps(translation.z);
+	for (; vecIndex + 8 <= numVec3s; vecIndex += 8)
+	{
+		float* first = firstVec3 + (size_t)vecIndex * strideInFloats;
+		__m256 x = _mm256_i32gather_ps(first, gatherOffsets, 4);
+		__m256 y = _mm256_i32gather_ps(first + 1, gatherOffsets, 4);
+		__m256 z = _mm256_i32gather_ps(first + 2, gatherOffsets, 4);
+
+		__m256 newX = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(iX, x), _mm256_mul_ps(jX, y)), _mm256_mul_ps(kX, z));
+		__m256 newY = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(iY, x), _mm256_mul_ps(jY, y)), _mm256_mul_ps(kY, z));
+		__m256 newZ = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(iZ, x), _mm256_mul_ps(jZ, y)), _mm256_mul_ps(kZ, z));
+		if constexpr (IS_POSITION)
+		{
+			newX = _mm256_add_ps(newX, tX);
+			newY = _mm256_add_ps(newY, tY);
+			newZ = _mm256_add_ps(newZ, tZ);
+		}
+		else
+		{
+			__m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(newX, newX), _mm256_mul_ps(newY, newY)), _mm256_mul_ps(newZ, newZ)));
+			__m256 oneDivideLength = _mm256_div_ps(_mm256_set1_ps(1.f), length);
+			__m256 isZeroLength = _mm256_cmp_ps(length, _mm256_setzero_ps(), _CMP_EQ_OQ);
+			newX = _mm256_andnot_ps(isZeroLength, _mm256_mul_ps(newX, oneDivideLength));
+			newY = _mm256_andnot_ps(isZeroLength, _mm256_mul_ps(newY, oneDivideLength));
+			newZ = _mm256_andnot_ps(isZeroLength, _mm256_mul_ps(newZ, oneDivideLength));
+		}
+
+		// No scatter before AVX-512, the results go back one vertex at a time
+		alignas(32) float newXs[8];
+		alignas(32) float newYs[8];
+		alignas(32) float newZs[8];
+		_mm256_store_ps(newXs, newX);
+		_mm256_store_ps(newYs, newY);
+		_mm256_store_ps(newZs, newZ);
+		for (int lane = 0; lane < 8; ++lane)
+		{
+			float* vec3 = first + lane * strideInFloats;
+			vec3[0] = newXs[lane];
+			vec3[1] = newYs[lane];
+			vec3[2] = newZs[lane];
+		}
+	}
+#elif defined(ENGINE_SIMD_SSE)
+	__m128 iX = _mm_set1_ps(iBasis.x), iY = _mm_set1_ps(iBasis.y), iZ = _mm_set1_ps(iBasis.z);
+	__m128 jX = _mm_set1_ps(jBasis.x), jY = _mm_set1_ps(jBasis.y), jZ = _mm_set1_ps(jBasis.z);
+	__m128 kX = _mm_set1_ps(kBasis.x), kY = _mm_set1_ps(kBasis.y), kZ = _mm_set1_ps(kBasis.z);
+	__m128 tX = _mm_set1_ps(translation.x), tY = _mm_set1_ps(translation.y), tZ = _mm_set1_ps(translation.z);
+	for (; vecIndex + 4 <= numVec3s; vecIndex += 4)
+	{
+		float* vec0 = firstVec3 + (size_t)vecIndex * strideInFloats;
+		float* vec1 = vec0 + strideInFloats;
+		float* vec2 = vec1 + strideInFloats;
+		float* vec3 = vec2 + strideInFloats;
+		__m128 x = _mm_setr_ps(vec0[0], vec1[0], vec2[0], vec3[0]);
+		__m128 y = _mm_setr_ps(vec0[1], vec1[1], vec2[1], vec3[1]);
+		__m128 z = _mm_setr_ps(vec0[2], vec1[2], vec2[2], vec3[2]);
+
+		__m128 newX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(iX, x), _mm_mul_ps(jX, y)), _mm_mul_ps(kX, z));
+		__m128 newY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(iY, x), _mm_mul_ps(jY, y)), _mm_mul_ps(kY, z));
+		__m128 newZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(iZ, x), _mm_mul_ps(jZ, y)), _mm_mul_ps(kZ, z));
+		if constexpr (IS_POSITION)
+		{
+			newX = _mm_add_ps(newX, tX);
+			newY = _mm_add_ps(newY, tY);
+			newZ = _mm_add_ps(newZ, tZ);
+		}
+		else
+		{
+			__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(newX, newX), _mm_mul_ps(newY, newY)), _mm_mul_ps(newZ, newZ)));
+			__m128 oneDivideLength = _mm_div_ps(_mm_set1_ps(1.f), length);
+			__m128 isZeroLength = _mm_cmpeq_ps(length, _mm_setzero_ps());
+			newX = _mm_andnot_ps(isZeroLength, _mm_mul_ps(newX, oneDivideLength));
+			newY = _mm_andnot_ps(isZeroLength, _mm_mul_ps(newY, oneDivideLength));
+			newZ = _mm_andnot_ps(isZeroLength, _mm_mul_ps(newZ, oneDivideLength));
+		}
+
+		alignas(16) float newXs[4];
+		alignas(16) float newYs[4];
+		alignas(16) float newZs[4];
+		_mm_store_ps(newXs, newX);
+		_mm_store_ps(newYs, newY);
+		_mm_store_ps(newZs, newZ);
+		float* vecs[4] = { vec0, vec1, vec2, vec3 };
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			vecs[lane][0] = newXs[lane];
+			vecs[lane][1] = newYs[lane];
+			vecs[lane][2] = newZs[lane];
+		}
+	}
+#endif
+	for (; vecIndex < numVec3s; ++vecIndex)
+	{
+		float* vec3 = firstVec3 + (size_t)vecIndex * strideInFloats;
+		float x = vec3[0];
+		float y = vec3[1];
+		float z = vec3[2];
+		float newX = iBasis.x * x + jBasis.x * y + kBasis.x * z;
+		float newY = iBasis.y * x + jBasis.y * y + kBasis.y * z;
+		float newZ = iBasis.z * x + jBasis.z * y + kBasis.z * z;
+		if constexpr (IS_POSITION)
+		{
+			newX = newX + translation.x;
+			newY = newY + translation.y;
+			newZ = newZ + translation.z;
+		}
+		else
+		{
+			float length = sqrtf((newX * newX) + (newY * newY) + (newZ * newZ));
+			float oneDivideLength = length == 0.f ? 0.f : 1.f / length;
+			newX = length == 0.f ? 0.f : newX * oneDivideLength;
+			newY = length == 0.f ? 0.f : newY * oneDivideLength;
+			newZ = length == 0.f ? 0.f : newZ * oneDivideLength;
+		}
+		vec3[0] = newX;
+		vec3[1] = newY;
+		vec3[2] = newZ;
+	}
+}
+
+void TransformVertexArray3D(int numVerts, Vertex_PCU* verts, Mat44 const& transform)
+{
+	static_assert(sizeof(Vertex_PCU) % sizeof(float) == 0, "Vertex_PCU must be a whole number of floats to be walked as one");
+	if (numVerts <= 0)
+	{
+		return;
+	}
+	TransformStridedVec3s<true>(&verts[0].m_position.x, (int)(sizeof(Vertex_PCU) / sizeof(float)), numVerts,
+		transform.GetIBasis3D(), transform.GetJBasis3D(), transform.GetKBasis3D(), transform.GetTranslation3D());
+}
+
+void TransformVertexArray3D(int numVerts, Vertex_PCUTBN* verts, Mat44 const& transform)
+{
+	static_assert(sizeof(Vertex_PCUTBN) % sizeof(float) == 0, "Vertex_PCUTBN must be a whole number of floats to be walked as one");
+	if (numVerts <= 0)
+	{
+		return;
+	}
+	int strideInFloats = (int)(sizeof(Vertex_PCUTBN) / sizeof(float));
+	Vec3 iBasis = transform.GetIBasis3D();
+	Vec3 jBasis = transform.GetJBasis3D();
+	Vec3 kBasis = transform.GetKBasis3D();
+	TransformStridedVec3s<true>(&verts[0].m_position.x, strideInFloats, numVerts, iBasis, jBasis, kBasis, transform.GetTranslation3D());
+	TransformStridedVec3s<false>(&verts[0].m_tangent.x, strideInFloats, numVerts, iBasis, jBasis, kBasis, Vec3::ZERO);
+	TransformStridedVec3s<false>(&verts[0].m_bitangent.x, strideInFloats, numVerts, iBasis, jBasis, kBasis, Vec3::ZERO);
+
+	// Normals need the inverse transpose to stay perpendicular under non uniform scale. Its bases are
+	// the cofactors J x K, K x I and I x J over the determinant; only the sign of the determinant is kept
+	// since the result is normalized, and a flattened (singular) transform still gets usable normals.
+	Vec3 normalIBasis = CrossProduct3D(jBasis, kBasis);
+	Vec3 normalJBasis = CrossProduct3D(kBasis, iBasis);
+	Vec3 normalKBasis = CrossProduct3D(iBasis, jBasis);
+	if (DotProduct3D(iBasis, normalIBasis) < 0.f)
+	{
+		normalIBasis = -normalIBasis;
+		normalJBasis = -normalJBasis;
+		normalKBasis = -normalKBasis;
+	}
+	TransformStridedVec3s<false>(&verts[0].m_normal.x, strideInFloats, numVerts, normalIBasis, normalJBasis, normalKBasis, Vec3::ZERO);
+}
+
 void TransformVertexArray3D(std::vector<Vertex_PCU>& verts, const Mat44& transform)
 {
-	for (int i = 0; i < (int)verts.size(); i++)
+	int numVerts = (int)verts.size();
+	if (numVerts < MIN_VERTS_FOR_PARALLEL_TRANSFORM)
 	{
-		verts[i].m_position = transform.TransformPosition3D(verts[i].m_position);
+		TransformVertexArray3D(numVerts, verts.data(), transform);
+		return;
 	}
+
+	ParallelForRange(0, numVerts, VERTS_PER_TRANSFORM_CHUNK, [&verts, &transform](int rangeBegin, int rangeEnd)
+	{
+		TransformVertexArray3D(rangeEnd - rangeBegin, verts.data() + rangeBegin, transform);
+	});
 }
 
 void TransformVertexArray3D(std::vector<Vertex_PCUTBN>& verts, const Mat44& transform)
 {
-	for (int i = 0; i < (int)verts.size(); i++)
+	int numVerts = (int)verts.size();
+	if (numVerts < MIN_VERTS_FOR_PARALLEL_TRANSFORM)
 	{
-		verts[i].m_position = transform.TransformPosition3D(verts[i].m_position);
-		
-		verts[i].m_normal = transform.TransformVectorQuantity3D(verts[i].m_normal).GetNormalized();
-		verts[i].m_tangent = transform.TransformVectorQuantity3D(verts[i].m_tangent).GetNormalized();
-		verts[i].m_bitangent = transform.TransformVectorQuantity3D(verts[i].m_bitangent).GetNormalized();
+		TransformVertexArray3D(numVerts, verts.data(), transform);
+		return;
 	}
+
+	ParallelForRange(0, numVerts, VERTS_PER_TRANSFORM_CHUNK, [&verts, &transform](int rangeBegin, int rangeEnd)
+	{
+		TransformVertexArray3D(rangeEnd - rangeBegin, verts.data() + rangeBegin, transform);
+	});
 }
 
 AABB2 GetVertexBounds2D(const std::vector<Vertex_PCU>& verts)
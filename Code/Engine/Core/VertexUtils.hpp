@@ -115,10 +115,17 @@ void AddVertsForArrow3D(std::vector<Vertex_PCU>& verts, const Vec3& start, const
 void TransformVertexArrayXY3D(int numVerts, Vertex_PCU* verts, float uniformScaleXY
 	, float rotationDegreesAboutZ, Vec2 const& translationXY);
 
+// Large arrays are split across the job system workers. Normals are transformed by the inverse
+// transpose and, with tangents and bitangents, normalized.
 void TransformVertexArray3D(std::vector<Vertex_PCU>&verts, const Mat44& transform);
 
 void TransformVertexArray3D(std::vector<Vertex_PCUTBN>& verts, const Mat44& transform);
 
+// Same transforms, always on the calling thread
+void TransformVertexArray3D(int numVerts, Vertex_PCU* verts, Mat44 const& transform);
+
+void TransformVertexArray3D(int numVerts, Vertex_PCUTBN* verts, Mat44 const& transform);
+
 void CalculateTangentSpaceBasisVectors(
 	std::vector<Vertex_PCUTBN>& vertexes,
 	std::vector<unsigned int>& indexes,
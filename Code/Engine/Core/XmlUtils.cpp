@@ -6,8 +6,9 @@ int ParseXmlAttribute(XmlElement const& element, char const* attributeName, int
 	{
 		const char* text = element.FindAttribute(attributeName)->Value();
 		int value = defaultValue;
-		Strings strings = SplitStringOnDelimiter(text, ',');
-		value = atoi(strings[0].c_str());
+		std::string_view strings[1];
+		SplitStringViewOnDelimiter(text, ',', strings, 1);
+		value = ParseIntFromText(strings[0]);
 		return value;
 	}
 	else
@@ -61,8 +62,9 @@ float ParseXmlAttribute(XmlElement const& element, char const* attributeName, fl
 	{
 		const char* text = element.FindAttribute(attributeName)->Value();
 		float value = defaultValue;
-		Strings strings = SplitStringOnDelimiter(text, ',');
-		value = static_cast<float>(atof(strings[0].c_str()));
+		std::string_view strings[1];
+		SplitStringViewOnDelimiter(text, ',', strings, 1);
+		value = ParseFloatFromText(strings[0]);
 		return value;
 	}
 	else
@@ -93,11 +93,12 @@ void IntVec2::RotateMinus90Degrees()
 
 void IntVec2::SetFromText(char const* text)
 {
-	Strings strings = SplitStringOnDelimiter(text, ',');
+	std::string_view strings[2];
+	int numStrings = SplitStringViewOnDelimiter(text, ',', strings, 2);
 
-	GUARANTEE_OR_DIE(strings.size() == 2, "You can not input not two char into this function");
-	x = atoi(strings[0].c_str());
-	y = atoi(strings[1].c_str());
+	GUARANTEE_OR_DIE(numStrings == 2, "You can not input not two char into this function");
+	x = ParseIntFromText(strings[0]);
+	y = ParseIntFromText(strings[1]);
 }
 
 bool IntVec2::operator!=(const IntVec2& compare) const
@@ -3,7 +3,7 @@
 #include "Engine/Math/Vec3.hpp"
 #include "Engine/Math/Vec4.hpp"
 
-struct Mat44 
+struct alignas(16) Mat44	// Aligned so each basis loads straight into an SSE register
 {
 	enum {Ix,Iy,Iz,Iw,  Jx,Jy,Jz,Jw,  Kx,Ky,Kz,Kw,	Tx,Ty,Tz,Tw	}; // index nicknames, [0] thru [15]
 	float m_value[16];	// stored in "basis major" order (Ix,Iy,Iz,Iw,Jx...) - translation in [12,13,14]
@@ -33,6 +33,7 @@ struct Mat44
 	Vec2 const		TransformPosition2D( Vec2 const& positionXY) const;				// assumes z=0, w=1
 	Vec3 const		TransformPosition3D( Vec3 const& position3D) const;				// assumes w=1
 	Vec4 const		TransformHomogeneous3D( Vec4 const& homogeneousPoint3D) const;	// w is provided
+	void			TransformPositionArray3D(Vec3 const* positions, Vec3* out_positions, int numPositions) const;	// assumes w=1, out_positions may be positions
 
 	float*			GetAsFloatArray();		// non-const (mutable) version
 	float const*	GetAsFloatArray() const;
@@ -48,6 +49,8 @@ struct Mat44
 	Vec4 const		GetKBasis4D() const;
 	Vec4 const		GetTranslation4D() const;
 	Mat44 const		GetOrthonormalInverse() const;
+	Mat44 const		GetInverse() const;							// General inverse, a singular matrix gives back identity
+	bool			TryGetInverse(Mat44& out_inverse) const;	// False (and out_inverse untouched) when singular
 
 	void			SetTranslation2D(Vec2 const& translationXY);	// Sets translationZ =0, tranlationW =1
 	void			SetTranslation3D(Vec3 const& translationXYZ);	// Sets translationW =1
@@ -0,0 +1,322 @@
+#include "Engine/Math/Matrix44Benchmark.hpp"
+#include "Engine/Math/Matrix44.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/RandomNumberGenerator.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include <cmath>
+#include <cstring>
+
+// Keeps the optimizer from dropping the work being timed
+static volatile float s_benchmarkSink = 0.f;
+
+//-----------------------------------------------------------------------------------
+// The scalar Mat44 math as it was before the SIMD kernels, kept as the reference
+//
+static void ScalarAppend(Mat44& matrix, Mat44 const& appendThis)
+{
+	float const* a = matrix.m_value;
+	float const* b = appendThis.m_value;
+	float result[16];
+	for (int basisIndex = 0; basisIndex < 4; ++basisIndex)
+	{
+		float const* basis = &b[basisIndex * 4];
+		for (int row = 0; row < 4; ++row)
+		{
+			result[basisIndex * 4 + row] = a[Mat44::Ix + row] * basis[0] + a[Mat44::Jx + row] * basis[1] + a[Mat44::Kx + row] * basis[2] + a[Mat44::Tx + row] * basis[3];
+		}
+	}
+	memcpy(matrix.m_value, result, sizeof(result));
+}
+
+static Vec3 const ScalarTransformPosition3D(Mat44 const& matrix, Vec3 const& position3D)
+{
+	float const* m = matrix.m_value;
+	float newX = m[Mat44::Ix] * position3D.x + m[Mat44::Jx] * position3D.y + m[Mat44::Kx] * position3D.z + m[Mat44::Tx];
+	float newY = m[Mat44::Iy] * position3D.x + m[Mat44::Jy] * position3D.y + m[Mat44::Ky] * position3D.z + m[Mat44::Ty];
+	float newZ = m[Mat44::Iz] * position3D.x + m[Mat44::Jz] * position3D.y + m[Mat44::Kz] * position3D.z + m[Mat44::Tz];
+	return Vec3(newX, newY, newZ);
+}
+
+static Vec4 const ScalarTransformHomogeneous3D(Mat44 const& matrix, Vec4 const& point)
+{
+	float const* m = matrix.m_value;
+	float newX = point.x * m[Mat44::Ix] + point.y * m[Mat44::Jx] + point.z * m[Mat44::Kx] + point.w * m[Mat44::Tx];
+	float newY = point.x * m[Mat44::Iy] + point.y * m[Mat44::Jy] + point.z * m[Mat44::Ky] + point.w * m[Mat44::Ty];
+	float newZ = point.x * m[Mat44::Iz] + point.y * m[Mat44::Jz] + point.z * m[Mat44::Kz] + point.w * m[Mat44::Tz];
+	float newW = point.x * m[Mat44::Iw] + point.y * m[Mat44::Jw] + point.z * m[Mat44::Kw] + point.w * m[Mat44::Tw];
+	return Vec4(newX, newY, newZ, newW);
+}
+
+static Mat44 const RollRandomMatrix(RandomNumberGenerator& rng)
+{
+	Mat44 matrix;
+	for (int valueIndex = 0; valueIndex < 16; ++valueIndex)
+	{
+		matrix.m_value[valueIndex] = rng.RollRandomFloatInRange(-4.f, 4.f);
+	}
+	return matrix;
+}
+
+static Mat44 const RollRandomRigidTransform(RandomNumberGenerator& rng)
+{
+	Mat44 matrix = Mat44::CreateTranslation3D(Vec3(rng.RollRandomFloatInRange(-100.f, 100.f), rng.RollRandomFloatInRange(-100.f, 100.f), rng.RollRandomFloatInRange(-100.f, 100.f)));
+	matrix.AppendZRotation(rng.RollRandomFloatInRange(0.f, 360.f));
+	matrix.AppendYRotation(rng.RollRandomFloatInRange(0.f, 360.f));
+	matrix.AppendXRotation(rng.RollRandomFloatInRange(0.f, 360.f));
+	return matrix;
+}
+
+static bool AreBitwiseEqual(void const* first, void const* second, size_t numBytes)
+{
+	return memcmp(first, second, numBytes) == 0;
+}
+
+static float GetLargestDifference(Mat44 const& first, Mat44 const& second)
+{
+	float largestDifference = 0.f;
+	for (int valueIndex = 0; valueIndex < 16; ++valueIndex)
+	{
+		float difference = fabsf(first.m_value[valueIndex] - second.m_value[valueIndex]);
+		largestDifference = difference > largestDifference ? difference : largestDifference;
+	}
+	return largestDifference;
+}
+
+Mat44EquivalenceResult RunMat44EquivalenceTest(int numMatrices)
+{
+	Mat44EquivalenceResult result;
+	RandomNumberGenerator rng(1234);
+	float const inverseTolerance = 1e-3f;
+
+	for (int matrixIndex = 0; matrixIndex < numMatrices; ++matrixIndex)
+	{
+		Mat44 matrix = RollRandomMatrix(rng);
+		Mat44 appendThis = RollRandomMatrix(rng);
+
+		Mat44 simdProduct = matrix;
+		simdProduct.Append(appendThis);
+		Mat44 scalarProduct = matrix;
+		ScalarAppend(scalarProduct, appendThis);
+		Mat44 simdSquare = matrix;
+		simdSquare.Append(simdSquare);
+		Mat44 scalarSquare = matrix;
+		ScalarAppend(scalarSquare, matrix);
+		if (!AreBitwiseEqual(simdProduct.m_value, scalarProduct.m_value, sizeof(simdProduct.m_value)) ||
+			!AreBitwiseEqual(simdSquare.m_value, scalarSquare.m_value, sizeof(simdSquare.m_value)))
+		{
+			result.m_numAppendMismatches++;
+		}
+
+		Vec3 positions[8];
+		Vec3 transformedPositions[8];
+		for (int positionIndex = 0; positionIndex < 8; ++positionIndex)
+		{
+			positions[positionIndex] = Vec3(rng.RollRandomFloatInRange(-50.f, 50.f), rng.RollRandomFloatInRange(-50.f, 50.f), rng.RollRandomFloatInRange(-50.f, 50.f));
+		}
+		matrix.TransformPositionArray3D(positions, transformedPositions, 8);
+		bool isTransformMatching = true;
+		for (int positionIndex = 0; positionIndex < 8; ++positionIndex)
+		{
+			Vec3 scalarPosition = ScalarTransformPosition3D(matrix, positions[positionIndex]);
+			Vec3 simdPosition = matrix.TransformPosition3D(positions[positionIndex]);
+			Vec4 point(positions[positionIndex].x, positions[positionIndex].y, positions[positionIndex].z, rng.RollRandomFloatInRange(-2.f, 2.f));
+			Vec4 scalarPoint = ScalarTransformHomogeneous3D(matrix, point);
+			Vec4 simdPoint = matrix.TransformHomogeneous3D(point);
+			isTransformMatching = isTransformMatching && AreBitwiseEqual(&scalarPosition, &simdPosition, sizeof(Vec3));
+			isTransformMatching = isTransformMatching && AreBitwiseEqual(&scalarPosition, &transformedPositions[positionIndex], sizeof(Vec3));
+			isTransformMatching = isTransformMatching && AreBitwiseEqual(&scalarPoint, &simdPoint, sizeof(Vec4));
+		}
+		if (!isTransformMatching)
+		{
+			result.m_numTransformMismatches++;
+		}
+
+		// A random matrix can be close to singular, so the general case is checked on its product with the
+		// inverse, relative to how large the inverse is
+		Mat44 inverse;
+		if (matrix.TryGetInverse(inverse))
+		{
+			Mat44 shouldBeIdentity = matrix;
+			ScalarAppend(shouldBeIdentity, inverse);
+			float inverseScale = 1.f;
+			for (int valueIndex = 0; valueIndex < 16; ++valueIndex)
+			{
+				inverseScale = fabsf(inverse.m_value[valueIndex]) > inverseScale ? fabsf(inverse.m_value[valueIndex]) : inverseScale;
+			}
+			float error = GetLargestDifference(shouldBeIdentity, Mat44()) / inverseScale;
+			result.m_largestInverseError = error > result.m_largestInverseError ? error : result.m_largestInverseError;
+			if (error > inverseTolerance)
+			{
+				result.m_numInverseFailures++;
+			}
+		}
+
+		Mat44 rigidTransform = RollRandomRigidTransform(rng);
+		float rigidError = GetLargestDifference(rigidTransform.GetInverse(), rigidTransform.GetOrthonormalInverse()) / 100.f;
+		result.m_largestInverseError = rigidError > result.m_largestInverseError ? rigidError : result.m_largestInverseError;
+		if (rigidError > inverseTolerance)
+		{
+			result.m_numInverseFailures++;
+		}
+		result.m_numMatricesTested++;
+	}
+
+	Mat44 singular = Mat44::CreateNonUniformScale3D(Vec3(1.f, 0.f, 1.f));
+	Mat44 untouched = Mat44::CreateTranslation3D(Vec3(1.f, 2.f, 3.f));
+	Mat44 inverse = untouched;
+	if (singular.TryGetInverse(inverse) || !AreBitwiseEqual(inverse.m_value, untouched.m_value, sizeof(inverse.m_value)))
+	{
+		result.m_numInverseFailures++;
+	}
+
+	result.m_isSucceeded = result.m_numAppendMismatches == 0 && result.m_numTransformMismatches == 0 && result.m_numInverseFailures == 0;
+	return result;
+}
+
+template<typename Work>
+static double TimeMilliseconds(int numIterations, Work const& work)
+{
+	double startSeconds = GetCurrentTimeSeconds();
+	for (int iteration = 0; iteration < numIterations; ++iteration)
+	{
+		work(iteration);
+	}
+	return (GetCurrentTimeSeconds() - startSeconds) * 1000.0;
+}
+
+std::vector<Mat44BenchmarkResult> RunMat44Benchmark(int numIterations)
+{
+	constexpr int NUM_MATRICES = 64;
+	constexpr int NUM_POSITIONS = 1024;
+	RandomNumberGenerator rng(99);
+	std::vector<Mat44> matrices;
+	for (int matrixIndex = 0; matrixIndex < NUM_MATRICES; ++matrixIndex)
+	{
+		matrices.push_back(RollRandomRigidTransform(rng));
+	}
+	std::vector<Vec3> positions(NUM_POSITIONS);
+	std::vector<Vec3> transformedPositions(NUM_POSITIONS);
+	for (Vec3& position : positions)
+	{
+		position = Vec3(rng.RollRandomFloatInRange(-50.f, 50.f), rng.RollRandomFloatInRange(-50.f, 50.f), rng.RollRandomFloatInRange(-50.f, 50.f));
+	}
+
+	std::vector<Mat44BenchmarkResult> results;
+	{
+		Mat44BenchmarkResult result;
+		result.m_name = "Append";
+		Mat44 product;
+		result.m_scalarMs = TimeMilliseconds(numIterations, [&](int iteration)
+		{
+			ScalarAppend(product, matrices[iteration % NUM_MATRICES]);
+		});
+		s_benchmarkSink = s_benchmarkSink + product.m_value[Mat44::Tx];
+		product = Mat44();
+		result.m_simdMs = TimeMilliseconds(numIterations, [&](int iteration)
+		{
+			product.Append(matrices[iteration % NUM_MATRICES]);
+		});
+		s_benchmarkSink = s_benchmarkSink + product.m_value[Mat44::Tx];
+		results.push_back(result);
+	}
+
+	{
+		Mat44BenchmarkResult result;
+		result.m_name = "TransformPosition3D";
+		Vec3 sum;
+		result.m_scalarMs = TimeMilliseconds(numIterations, [&](int iteration)
+		{
+			sum += ScalarTransformPosition3D(matrices[iteration % NUM_MATRICES], positions[iteration % NUM_POSITIONS]);
+		});
+		result.m_simdMs = TimeMilliseconds(numIterations, [&](int iteration)
+		{
+			sum += matrices[iteration % NUM_MATRICES].TransformPosition3D(positions[iteration % NUM_POSITIONS]);
+		});
+		s_benchmarkSink = s_benchmarkSink + sum.x;
+		results.push_back(result);
+	}
+
+	{
+		Mat44BenchmarkResult result;
+		result.m_name = "TransformHomogeneous3D";
+		Vec4 sum;
+		result.m_scalarMs = TimeMilliseconds(numIterations, [&](int iteration)
+		{
+			Vec3 const& position = positions[iteration % NUM_POSITIONS];
+			Vec4 point = ScalarTransformHomogeneous3D(matrices[iteration % NUM_MATRICES], Vec4(position.x, position.y, position.z, 1.f));
+			sum.x += point.x;
+			sum.w += point.w;
+		});
+		result.m_simdMs = TimeMilliseconds(numIterations, [&](int iteration)
+		{
+			Vec3 const& position = positions[iteration % NUM_POSITIONS];
+			Vec4 point = matrices[iteration % NUM_MATRICES].TransformHomogeneous3D(Vec4(position.x, position.y, position.z, 1.f));
+			sum.x += point.x;
+			sum.w += point.w;
+		});
+		s_benchmarkSink = s_benchmarkSink + sum.x + sum.w;
+		results.push_back(result);
+	}
+
+	{
+		Mat44BenchmarkResult result;
+		result.m_name = "TransformPositionArray3D x1024";
+		int numBatches = numIterations / NUM_POSITIONS + 1;
+		result.m_scalarMs = TimeMilliseconds(numBatches, [&](int iteration)
+		{
+			Mat44 const& matrix = matrices[iteration % NUM_MATRICES];
+			for (int positionIndex = 0; positionIndex < NUM_POSITIONS; ++positionIndex)
+			{
+				transformedPositions[positionIndex] = ScalarTransformPosition3D(matrix, positions[positionIndex]);
+			}
+		});
+		s_benchmarkSink = s_benchmarkSink + transformedPositions[7].x;
+		result.m_simdMs = TimeMilliseconds(numBatches, [&](int iteration)
+		{
+			matrices[iteration % NUM_MATRICES].TransformPositionArray3D(positions.data(), transformedPositions.data(), NUM_POSITIONS);
+		});
+		s_benchmarkSink = s_benchmarkSink + transformedPositions[7].x;
+		results.push_back(result);
+	}
+
+	{
+		// There was no general inverse before, so the baseline is the orthonormal one it can stand in for
+		Mat44BenchmarkResult result;
+		result.m_name = "GetInverse vs Orthonormal";
+		Mat44 sum;
+		result.m_scalarMs = TimeMilliseconds(numIterations, [&](int iteration)
+		{
+			sum.m_value[Mat44::Tx] += matrices[iteration % NUM_MATRICES].GetOrthonormalInverse().m_value[Mat44::Tx];
+		});
+		result.m_simdMs = TimeMilliseconds(numIterations, [&](int iteration)
+		{
+			sum.m_value[Mat44::Ty] += matrices[iteration % NUM_MATRICES].GetInverse().m_value[Mat44::Tx];
+		});
+		s_benchmarkSink = s_benchmarkSink + sum.m_value[Mat44::Tx] + sum.m_value[Mat44::Ty];
+		results.push_back(result);
+	}
+	return results;
+}
+
+bool Command_Mat44Benchmark(EventArgs const& args)
+{
+	int numIterations = args.GetValue(std::string("iterations"), 1000000);
+	Mat44EquivalenceResult equivalence = RunMat44EquivalenceTest(10000);
+	std::vector<Mat44BenchmarkResult> results = RunMat44Benchmark(numIterations);
+	if (g_theConsole)
+	{
+		g_theConsole->AddLine(equivalence.m_isSucceeded ? DevConsole::INFO_MAJOR : DevConsole::ERROR,
+			Stringf("Mat44 equivalence over %i matrices: %i append, %i transform mismatches, %i inverse failures (largest error %g)",
+			equivalence.m_numMatricesTested, equivalence.m_numAppendMismatches, equivalence.m_numTransformMismatches, equivalence.m_numInverseFailures, equivalence.m_largestInverseError));
+		g_theConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Mat44Benchmark, %i iterations each", numIterations));
+		for (Mat44BenchmarkResult const& result : results)
+		{
+			g_theConsole->AddLine(DevConsole::INFO_MINOR, Stringf("%-32s %8.2fms -> %8.2fms (%.1fx)", result.m_name.c_str(), result.m_scalarMs, result.m_simdMs,
+				result.m_simdMs > 0.0 ? result.m_scalarMs / result.m_simdMs : 0.0));
+		}
+	}
+	return equivalence.m_isSucceeded;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+
+class NamedProperties;
+typedef NamedProperties EventArgs;
+
+//-----------------------------------------------------------------------------------
+// Checks the Mat44 kernels picked in SIMDUtils.hpp against the plain scalar math they replaced, and
+// times both. Append and the transforms must match bit for bit; the general inverse has no scalar
+// original so it is checked against GetOrthonormalInverse and against M * inverse(M) = identity.
+//
+struct Mat44EquivalenceResult
+{
+	bool		m_isSucceeded = false;
+	int			m_numMatricesTested = 0;
+	int			m_numAppendMismatches = 0;
+	int			m_numTransformMismatches = 0;		// TransformPosition3D, TransformHomogeneous3D and TransformPositionArray3D
+	int			m_numInverseFailures = 0;
+	float		m_largestInverseError = 0.f;
+};
+
+struct Mat44BenchmarkResult
+{
+	std::string		m_name;
+	double			m_scalarMs = 0.0;
+	double			m_simdMs = 0.0;
+};
+
+Mat44EquivalenceResult				RunMat44EquivalenceTest(int numMatrices);
+std::vector<Mat44BenchmarkResult>	RunMat44Benchmark(int numIterations);
+bool								Command_Mat44Benchmark(EventArgs const& args);
@@ -0,0 +1,22 @@
+#pragma once
+#include "Game/EngineBuildPreferences.hpp"
+
+//-----------------------------------------------------------------------------------
+// Compile time selection of the SIMD math kernels. Every kernel has a portable scalar version,
+// the SSE version is used on x64 (or with /arch:SSE2) and the AVX versions only when the compiler
+// is allowed to emit AVX (/arch:AVX, /arch:AVX2 or -mavx). There is no runtime dispatch.
+//
+// #define ENGINE_DISABLE_SIMD in your game's Code/Game/EngineBuildPreferences.hpp to force the scalar
+// versions, e.g. to check a kernel against them.
+//
+#if !defined(ENGINE_DISABLE_SIMD) && (defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ENGINE_SIMD_SSE
+#include <emmintrin.h>
+#if defined(__AVX__)
+#define ENGINE_SIMD_AVX
+#include <immintrin.h>
+#endif
+#if defined(__AVX2__)
+#define ENGINE_SIMD_AVX2
+#endif
+#endif
@@ -350,11 +350,12 @@ void Vec2::Reflect(Vec2 const& vectorToReflect)
 
 void Vec2::SetFromText(char const* text)
 {
-	Strings strings = SplitStringOnDelimiter(text, ',');
+	std::string_view strings[2];
+	int numStrings = SplitStringViewOnDelimiter(text, ',', strings, 2);
 	
-	GUARANTEE_OR_DIE(strings.size()==2,"You can not input not two char into this function");
-	y = static_cast<float>(atof(strings[1].c_str()));
-	x = static_cast<float>(atof(strings[0].c_str()));
+	GUARANTEE_OR_DIE(numStrings==2,"You can not input not two char into this function");
+	y = ParseFloatFromText(strings[1]);
+	x = ParseFloatFromText(strings[0]);
 }
 
 float Vec2::NormalizedAndGetPreviousLength()
@@ -134,12 +134,13 @@ void Vec3::Normalize()
 
 void Vec3::SetFromText(char const* text)
 {
-	Strings strings = SplitStringOnDelimiter(text, ',');
+	std::string_view strings[3];
+	int numStrings = SplitStringViewOnDelimiter(text, ',', strings, 3);
 
-	GUARANTEE_OR_DIE(strings.size() == 3, "You can not input not three char into this function");
-	x = static_cast<float>(atof(strings[0].c_str()));
-	y = static_cast<float>(atof(strings[1].c_str()));
-	z = static_cast<float>(atof(strings[2].c_str()));
+	GUARANTEE_OR_DIE(numStrings == 3, "You can not input not three char into this function");
+	x = ParseFloatFromText(strings[0]);
+	y = ParseFloatFromText(strings[1]);
+	z = ParseFloatFromText(strings[2]);
 }
 
 const Vec3 Vec3::MakeFromPolarRadians(float latitudeRadians, float longitudeRadians, float length /*= 1.0f*/)
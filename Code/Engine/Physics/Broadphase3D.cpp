@@ -0,0 +1,797 @@
+#include "Engine/Physics/Broadphase3D.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+#include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Core/ParallelAlgorithms.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Math/FloatRange.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/RandomNumberGenerator.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include <algorithm>
+#include <cmath>
+
+constexpr int	PROXIES_PER_QUERY_CHUNK = 256;
+constexpr int	PAIRS_PER_NARROW_PHASE_CHUNK = 1024;
+
+//-----------------------------------------------------------------------------------
+// Shapes
+//
+BroadphaseShape3D BroadphaseShape3D::MakeAABB3(AABB3 const& box)
+{
+	BroadphaseShape3D shape;
+	shape.m_type = BroadphaseShapeType::AABB;
+	shape.m_box = AABB3(box);
+	return shape;
+}
+
+BroadphaseShape3D BroadphaseShape3D::MakeOBB3(OBB3 const& orientedBox)
+{
+	BroadphaseShape3D shape;
+	shape.m_type = BroadphaseShapeType::OBB;
+	shape.m_orientedBox = orientedBox;
+	return shape;
+}
+
+BroadphaseShape3D BroadphaseShape3D::MakeSphere(Vec3 const& sphereCenter, float sphereRadius)
+{
+	BroadphaseShape3D shape;
+	shape.m_type = BroadphaseShapeType::SPHERE;
+	shape.m_sphereCenter = sphereCenter;
+	shape.m_sphereRadius = sphereRadius;
+	return shape;
+}
+
+BroadphaseShape3D BroadphaseShape3D::MakeCylinder3(Cylinder3 const& cylinder)
+{
+	BroadphaseShape3D shape;
+	shape.m_type = BroadphaseShapeType::CYLINDER;
+	shape.m_cylinder = cylinder;
+	return shape;
+}
+
+static bool IsZCylinder(Cylinder3 const& cylinder)
+{
+	return cylinder.m_start.x == cylinder.m_end.x && cylinder.m_start.y == cylinder.m_end.y;
+}
+
+AABB3 BroadphaseShape3D::GetBounds() const
+{
+	switch (m_type)
+	{
+	case BroadphaseShapeType::OBB:
+	{
+		Vec3 i = m_orientedBox.GetIBasis();
+		Vec3 j = m_orientedBox.GetJBasis();
+		Vec3 k = m_orientedBox.GetKBasis();
+		Vec3 halfDims = m_orientedBox.GetHalfDimensions();
+		Vec3 center = m_orientedBox.GetCenter();
+		Vec3 extents(fabsf(i.x) * halfDims.x + fabsf(j.x) * halfDims.y + fabsf(k.x) * halfDims.z,
+			fabsf(i.y) * halfDims.x + fabsf(j.y) * halfDims.y + fabsf(k.y) * halfDims.z,
+			fabsf(i.z) * halfDims.x + fabsf(j.z) * halfDims.y + fabsf(k.z) * halfDims.z);
+		return AABB3(center - extents, center + extents);
+	}
+	case BroadphaseShapeType::SPHERE:
+	{
+		Vec3 extents(m_sphereRadius, m_sphereRadius, m_sphereRadius);
+		return AABB3(m_sphereCenter - extents, m_sphereCenter + extents);
+	}
+	case BroadphaseShapeType::CYLINDER:
+	{
+		// The end discs reach r * sin(angle between the axis and each world axis) past the end points
+		Vec3 const& start = m_cylinder.m_start;
+		Vec3 const& end = m_cylinder.m_end;
+		Vec3 axis = end - start;
+		float lengthSquared = axis.x * axis.x + axis.y * axis.y + axis.z * axis.z;
+		float radius = m_cylinder.m_radius;
+		Vec3 extents(radius, radius, radius);
+		if (lengthSquared > 0.f)
+		{
+			extents = Vec3(radius * sqrtf(std::max(0.f, 1.f - axis.x * axis.x / lengthSquared)),
+				radius * sqrtf(std::max(0.f, 1.f - axis.y * axis.y / lengthSquared)),
+				radius * sqrtf(std::max(0.f, 1.f - axis.z * axis.z / lengthSquared)));
+		}
+		Vec3 mins(std::min(start.x, end.x), std::min(start.y, end.y), std::min(start.z, end.z));
+		Vec3 maxs(std::max(start.x, end.x), std::max(start.y, end.y), std::max(start.z, end.z));
+		return AABB3(mins - extents, maxs + extents);
+	}
+	default:
+		return AABB3(m_box);
+	}
+}
+
+Vec3 BroadphaseShape3D::GetCenter() const
+{
+	switch (m_type)
+	{
+	case BroadphaseShapeType::OBB:		return m_orientedBox.GetCenter();
+	case BroadphaseShapeType::SPHERE:	return m_sphereCenter;
+	case BroadphaseShapeType::CYLINDER:	return (m_cylinder.m_start + m_cylinder.m_end) * 0.5f;
+	default:							return m_box.GetCenter();
+	}
+}
+
+//-----------------------------------------------------------------------------------
+// Narrow phase
+//
+static OBB3 GetCylinderBoundingOBB3(Cylinder3 const& cylinder)
+{
+	Vec3 axis = cylinder.m_end - cylinder.m_start;
+	float length = axis.GetLength();
+	Vec3 kBasis = length > 0.f ? axis / length : Vec3(0.f, 0.f, 1.f);
+	Vec3 reference = fabsf(kBasis.z) < 0.9f ? Vec3(0.f, 0.f, 1.f) : Vec3(1.f, 0.f, 0.f);
+	Vec3 iBasis = CrossProduct3D(reference, kBasis).GetNormalized();
+	Vec3 jBasis = CrossProduct3D(kBasis, iBasis);
+	Vec3 center = (cylinder.m_start + cylinder.m_end) * 0.5f;
+	return OBB3(center, iBasis, jBasis, kBasis, Vec3(cylinder.m_radius, cylinder.m_radius, 0.5f * length));
+}
+
+static bool DoOBBsOverlap3D(OBB3 const& first, OBB3 const& second)
+{
+	// Second box in the first one's local space, where the first box is an AABB3
+	Vec3 i = first.GetIBasis();
+	Vec3 j = first.GetJBasis();
+	Vec3 k = first.GetKBasis();
+	auto toLocal = [&](Vec3 const& vector) { return Vec3(DotProduct3D(vector, i), DotProduct3D(vector, j), DotProduct3D(vector, k)); };
+	OBB3 secondLocal(toLocal(second.GetCenter() - first.GetCenter()), toLocal(second.GetIBasis()), toLocal(second.GetJBasis()), toLocal(second.GetKBasis()), second.GetHalfDimensions());
+	return DoOBBAndAABBOverlap3D(secondLocal, first.GetLocalSpaceAABB3());
+}
+
+static Vec3 GetNearestPointOnCylinder3D(Vec3 const& point, Cylinder3 const& cylinder)
+{
+	Vec3 axis = cylinder.m_end - cylinder.m_start;
+	float length = axis.GetLength();
+	Vec3 direction = length > 0.f ? axis / length : Vec3(0.f, 0.f, 1.f);
+	Vec3 toPoint = point - cylinder.m_start;
+	float alongAxis = DotProduct3D(toPoint, direction);
+	Vec3 radial = toPoint - direction * alongAxis;
+	float radialLength = radial.GetLength();
+	if (radialLength > cylinder.m_radius)
+	{
+		radial *= cylinder.m_radius / radialLength;
+	}
+	return cylinder.m_start + direction * GetClamped(alongAxis, 0.f, length) + radial;
+}
+
+static FloatRange GetCylinderMinMaxZ(Cylinder3 const& cylinder)
+{
+	return FloatRange(std::min(cylinder.m_start.z, cylinder.m_end.z), std::max(cylinder.m_start.z, cylinder.m_end.z));
+}
+
+// The bounding box of a tilted cylinder pokes out of the cylinder's own bounds, so those have to
+// overlap too or pairs the tree culls could still pass the narrow phase
+static bool DoTiltedCylinderAndOBBOverlap3D(BroadphaseShape3D const& cylinder, BroadphaseShape3D const& other, OBB3 const& otherBox)
+{
+	return DoAABBsOverlap3D(cylinder.GetBounds(), other.GetBounds()) && DoOBBsOverlap3D(otherBox, GetCylinderBoundingOBB3(cylinder.m_cylinder));
+}
+
+bool DoShapesOverlap3D(BroadphaseShape3D const& first, BroadphaseShape3D const& second)
+{
+	if (first.m_type > second.m_type)
+	{
+		return DoShapesOverlap3D(second, first);
+	}
+
+	Cylinder3 const& cylinder = second.m_cylinder;
+	switch (first.m_type)
+	{
+	case BroadphaseShapeType::AABB:
+		switch (second.m_type)
+		{
+		case BroadphaseShapeType::AABB:		return DoAABBsOverlap3D(first.m_box, second.m_box);
+		case BroadphaseShapeType::OBB:		return DoOBBAndAABBOverlap3D(second.m_orientedBox, first.m_box);
+		case BroadphaseShapeType::SPHERE:	return DoSphereAndAABBOverlap3D(second.m_sphereCenter, second.m_sphereRadius, first.m_box);
+		case BroadphaseShapeType::CYLINDER:
+			if (IsZCylinder(cylinder))
+			{
+				return DoZCylinderAndAABBOverlap3D(Vec2(cylinder.m_start.x, cylinder.m_start.y), cylinder.m_radius, GetCylinderMinMaxZ(cylinder), first.m_box);
+			}
+			return DoAABBsOverlap3D(second.GetBounds(), first.m_box) && DoOBBAndAABBOverlap3D(GetCylinderBoundingOBB3(cylinder), first.m_box);
+		default:							break;
+		}
+		break;
+
+	case BroadphaseShapeType::OBB:
+		switch (second.m_type)
+		{
+		case BroadphaseShapeType::OBB:		return DoOBBsOverlap3D(first.m_orientedBox, second.m_orientedBox);
+		case BroadphaseShapeType::SPHERE:	return DoOBBAndSphereOverlap3D(first.m_orientedBox, second.m_sphereCenter, second.m_sphereRadius);
+		case BroadphaseShapeType::CYLINDER:	return DoTiltedCylinderAndOBBOverlap3D(second, first, first.m_orientedBox);
+		default:							break;
+		}
+		break;
+
+	case BroadphaseShapeType::SPHERE:
+		switch (second.m_type)
+		{
+		case BroadphaseShapeType::SPHERE:	return DoSpheresOverlap3D(first.m_sphereCenter, first.m_sphereRadius, second.m_sphereCenter, second.m_sphereRadius);
+		case BroadphaseShapeType::CYLINDER:
+			if (IsZCylinder(cylinder))
+			{
+				return DoZCylinderAndSphereOverlap3D(Vec2(cylinder.m_start.x, cylinder.m_start.y), cylinder.m_radius, GetCylinderMinMaxZ(cylinder), first.m_sphereCenter, first.m_sphereRadius);
+			}
+			return GetDistanceSquared3D(GetNearestPointOnCylinder3D(first.m_sphereCenter, cylinder), first.m_sphereCenter) < first.m_sphereRadius * first.m_sphereRadius;
+		default:							break;
+		}
+		break;
+
+	case BroadphaseShapeType::CYLINDER:
+		if (IsZCylinder(first.m_cylinder) && IsZCylinder(cylinder))
+		{
+			return DoZCylindersOverlap3D(Vec2(first.m_cylinder.m_start.x, first.m_cylinder.m_start.y), first.m_cylinder.m_radius, GetCylinderMinMaxZ(first.m_cylinder),
+				Vec2(cylinder.m_start.x, cylinder.m_start.y), cylinder.m_radius, GetCylinderMinMaxZ(cylinder));
+		}
+		return DoTiltedCylinderAndOBBOverlap3D(second, first, GetCylinderBoundingOBB3(first.m_cylinder));
+
+	default:
+		break;
+	}
+	return false;
+}
+
+RaycastResult3D RaycastVsShape3D(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, BroadphaseShape3D const& shape)
+{
+	RaycastResult3D result;
+	switch (shape.m_type)
+	{
+	case BroadphaseShapeType::AABB:
+		result = RaycastVsAABB3D(rayStart, rayForwardNormal, rayLength, shape.m_box);
+		break;
+	case BroadphaseShapeType::OBB:
+		result = RaycastVsOBB3D(rayStart, rayForwardNormal, rayLength, shape.m_orientedBox);
+		break;
+	case BroadphaseShapeType::SPHERE:
+		result = RaycastVsSphere3D(rayStart, rayForwardNormal, rayLength, shape.m_sphereCenter, shape.m_sphereRadius);
+		break;
+	case BroadphaseShapeType::CYLINDER:
+		if (IsZCylinder(shape.m_cylinder))
+		{
+			Vec2 centerXY(shape.m_cylinder.m_start.x, shape.m_cylinder.m_start.y);
+			result = RaycastVsCylinderZ3D(rayStart, rayForwardNormal, rayLength, centerXY, GetCylinderMinMaxZ(shape.m_cylinder), shape.m_cylinder.m_radius);
+		}
+		else
+		{
+			result = RaycastVsCylinder3D(rayStart, rayForwardNormal, rayLength, shape.m_cylinder);
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (result.m_didImpact)
+	{
+		result.m_impactDistance = DotProduct3D(result.m_impactPosition - rayStart, rayForwardNormal);
+	}
+	result.m_rayStartPostion = rayStart;
+	result.m_rayDirection = rayForwardNormal;
+	result.m_rayLength = rayLength;
+	return result;
+}
+
+//-----------------------------------------------------------------------------------
+// Broadphase3D
+//
+Broadphase3D::Broadphase3D(float fatMargin)
+	: m_tree(fatMargin)
+{
+}
+
+int Broadphase3D::AddShape(BroadphaseShape3D const& shape, int userData)
+{
+	int proxyId = m_tree.CreateProxy(shape.GetBounds(), userData);
+	GrowProxyArrays();
+	m_shapes[proxyId] = shape;
+	MarkMoved(proxyId);
+	return proxyId;
+}
+
+void Broadphase3D::RemoveShape(int proxyId)
+{
+	GUARANTEE_OR_DIE(m_tree.IsProxy(proxyId), "Removing a shape that is not in the broadphase");
+	m_tree.DestroyProxy(proxyId);
+	MarkMoved(proxyId);
+}
+
+bool Broadphase3D::MoveShape(int proxyId, BroadphaseShape3D const& shape)
+{
+	GUARANTEE_OR_DIE(m_tree.IsProxy(proxyId), "Moving a shape that is not in the broadphase");
+	Vec3 displacement = shape.GetCenter() - m_shapes[proxyId].GetCenter();
+	m_shapes[proxyId] = shape;
+	if (!m_tree.MoveProxy(proxyId, shape.GetBounds(), displacement))
+	{
+		return false;
+	}
+	GrowProxyArrays();
+	MarkMoved(proxyId);
+	return true;
+}
+
+void Broadphase3D::Clear()
+{
+	m_tree.Clear();
+	m_shapes.clear();
+	m_isMoved.clear();
+	m_movedProxies.clear();
+	m_candidatePairs.clear();
+}
+
+void Broadphase3D::MarkMoved(int proxyId)
+{
+	if (!m_isMoved[proxyId])
+	{
+		m_isMoved[proxyId] = 1;
+		m_movedProxies.push_back(proxyId);
+	}
+}
+
+void Broadphase3D::GrowProxyArrays()
+{
+	int nodeCapacity = m_tree.GetNodeCapacity();
+	if ((int)m_shapes.size() < nodeCapacity)
+	{
+		m_shapes.resize(nodeCapacity);
+		m_isMoved.resize(nodeCapacity, 0);
+	}
+}
+
+static bool IsPairLess(BroadphasePair const& first, BroadphasePair const& second)
+{
+	return first.m_firstProxy < second.m_firstProxy || (first.m_firstProxy == second.m_firstProxy && first.m_secondProxy < second.m_secondProxy);
+}
+
+void Broadphase3D::FindOverlappingPairs(std::vector<BroadphasePair>& out_pairs)
+{
+	out_pairs.clear();
+
+	if (!m_movedProxies.empty())
+	{
+		// Pairs between proxies that kept their fat bounds still hold, the rest get found again
+		m_candidatePairs.erase(std::remove_if(m_candidatePairs.begin(), m_candidatePairs.end(), [this](BroadphasePair const& pair)
+		{
+			return m_isMoved[pair.m_firstProxy] || m_isMoved[pair.m_secondProxy];
+		}), m_candidatePairs.end());
+
+		std::vector<int> queryProxies;
+		queryProxies.reserve(m_movedProxies.size());
+		for (int proxyId : m_movedProxies)
+		{
+			if (m_tree.IsProxy(proxyId))
+			{
+				queryProxies.push_back(proxyId);
+			}
+		}
+
+		// A pair of moved proxies is only kept from the query of its lower id
+		int numQueries = (int)queryProxies.size();
+		int numQueryChunks = (numQueries + PROXIES_PER_QUERY_CHUNK - 1) / PROXIES_PER_QUERY_CHUNK;
+		std::vector<std::vector<BroadphasePair>> chunkPairs(numQueryChunks);
+		ParallelFor(0, numQueryChunks, 1, [&](int chunkIndex)
+		{
+			std::vector<BroadphasePair>& pairs = chunkPairs[chunkIndex];
+			int chunkEnd = std::min(numQueries, (chunkIndex + 1) * PROXIES_PER_QUERY_CHUNK);
+			for (int queryIndex = chunkIndex * PROXIES_PER_QUERY_CHUNK; queryIndex < chunkEnd; ++queryIndex)
+			{
+				int queryProxy = queryProxies[queryIndex];
+				m_tree.QueryAABB3(m_tree.GetFatBounds(queryProxy), [&](int otherProxy)
+				{
+					if (otherProxy != queryProxy && (!m_isMoved[otherProxy] || otherProxy > queryProxy))
+					{
+						BroadphasePair pair;
+						pair.m_firstProxy = std::min(queryProxy, otherProxy);
+						pair.m_secondProxy = std::max(queryProxy, otherProxy);
+						pairs.push_back(pair);
+					}
+					return true;
+				});
+			}
+		});
+
+		// The kept pairs are still sorted, sort the new ones and merge
+		size_t numKeptPairs = m_candidatePairs.size();
+		for (std::vector<BroadphasePair> const& pairs : chunkPairs)
+		{
+			m_candidatePairs.insert(m_candidatePairs.end(), pairs.begin(), pairs.end());
+		}
+		ParallelSort(m_candidatePairs.begin() + numKeptPairs, m_candidatePairs.end(), IsPairLess);
+		std::inplace_merge(m_candidatePairs.begin(), m_candidatePairs.begin() + numKeptPairs, m_candidatePairs.end(), IsPairLess);
+
+		for (int proxyId : m_movedProxies)
+		{
+			m_isMoved[proxyId] = 0;
+		}
+		m_movedProxies.clear();
+	}
+
+	int numCandidates = (int)m_candidatePairs.size();
+	int numNarrowPhaseChunks = (numCandidates + PAIRS_PER_NARROW_PHASE_CHUNK - 1) / PAIRS_PER_NARROW_PHASE_CHUNK;
+	std::vector<std::vector<BroadphasePair>> chunkPairs(numNarrowPhaseChunks);
+	ParallelFor(0, numNarrowPhaseChunks, 1, [&](int chunkIndex)
+	{
+		std::vector<BroadphasePair>& pairs = chunkPairs[chunkIndex];
+		int chunkEnd = std::min(numCandidates, (chunkIndex + 1) * PAIRS_PER_NARROW_PHASE_CHUNK);
+		for (int pairIndex = chunkIndex * PAIRS_PER_NARROW_PHASE_CHUNK; pairIndex < chunkEnd; ++pairIndex)
+		{
+			BroadphasePair const& pair = m_candidatePairs[pairIndex];
+			if (DoShapesOverlap3D(m_shapes[pair.m_firstProxy], m_shapes[pair.m_secondProxy]))
+			{
+				pairs.push_back(pair);
+			}
+		}
+	});
+	for (std::vector<BroadphasePair> const& pairs : chunkPairs)
+	{
+		out_pairs.insert(out_pairs.end(), pairs.begin(), pairs.end());
+	}
+}
+
+RaycastResult3D Broadphase3D::Raycast(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, int* out_proxyId) const
+{
+	RaycastResult3D closestResult;
+	closestResult.m_rayStartPostion = rayStart;
+	closestResult.m_rayDirection = rayForwardNormal;
+	closestResult.m_rayLength = rayLength;
+	int closestProxy = AABB_TREE_NULL_NODE;
+
+	m_tree.Raycast(rayStart, rayForwardNormal, rayLength, [&](int proxyId, float maxLength)
+	{
+		RaycastResult3D result = RaycastVsShape3D(rayStart, rayForwardNormal, maxLength, m_shapes[proxyId]);
+		if (!result.m_didImpact || result.m_impactDistance > maxLength)
+		{
+			return maxLength;
+		}
+		closestResult = result;
+		closestProxy = proxyId;
+		return result.m_impactDistance;
+	});
+
+	closestResult.m_rayLength = rayLength;
+	if (out_proxyId)
+	{
+		*out_proxyId = closestProxy;
+	}
+	return closestResult;
+}
+
+int Broadphase3D::QueryShape(BroadphaseShape3D const& shape, std::vector<int>& out_proxyIds) const
+{
+	size_t numProxiesBefore = out_proxyIds.size();
+	m_tree.QueryAABB3(shape.GetBounds(), [&](int proxyId)
+	{
+		if (DoShapesOverlap3D(shape, m_shapes[proxyId]))
+		{
+			out_proxyIds.push_back(proxyId);
+		}
+		return true;
+	});
+	return (int)(out_proxyIds.size() - numProxiesBefore);
+}
+
+//-----------------------------------------------------------------------------------
+// Benchmark
+//
+struct BenchmarkBody
+{
+	BroadphaseShape3D	m_shape;
+	Vec3				m_velocity;
+	int					m_proxyId = -1;
+};
+
+static BroadphaseShape3D MakeRandomShape(RandomNumberGenerator& rng, float worldSize)
+{
+	Vec3 center(rng.RollRandomFloatInRange(0.f, worldSize), rng.RollRandomFloatInRange(0.f, worldSize), rng.RollRandomFloatInRange(0.f, worldSize));
+	float size = rng.RollRandomFloatInRange(0.25f, 0.75f);
+	switch (rng.RollRandomIntLessThan((int)BroadphaseShapeType::COUNT))
+	{
+	case 0:
+	{
+		Vec3 halfDims(size, rng.RollRandomFloatInRange(0.25f, 0.75f), rng.RollRandomFloatInRange(0.25f, 0.75f));
+		return BroadphaseShape3D::MakeAABB3(AABB3(center - halfDims, center + halfDims));
+	}
+	case 1:
+	{
+		Vec3 iBasis = rng.RollRandomVectorOnUnitSphere();
+		Vec3 reference = fabsf(iBasis.z) < 0.9f ? Vec3(0.f, 0.f, 1.f) : Vec3(1.f, 0.f, 0.f);
+		Vec3 jBasis = CrossProduct3D(reference, iBasis).GetNormalized();
+		Vec3 kBasis = CrossProduct3D(iBasis, jBasis);
+		return BroadphaseShape3D::MakeOBB3(OBB3(center, iBasis, jBasis, kBasis, Vec3(size, 0.5f * size, rng.RollRandomFloatInRange(0.25f, 0.75f))));
+	}
+	case 2:
+		return BroadphaseShape3D::MakeSphere(center, size);
+	default:
+	{
+		// Half of them standing up, to go through the DoZCylinder functions
+		Vec3 axis = rng.RollRandomIntLessThan(2) == 0 ? Vec3(0.f, 0.f, 1.f) : rng.RollRandomVectorOnUnitSphere();
+		Cylinder3 cylinder;
+		cylinder.m_start = center - axis * size;
+		cylinder.m_end = center + axis * size;
+		cylinder.m_radius = rng.RollRandomFloatInRange(0.2f, 0.5f);
+		return BroadphaseShape3D::MakeCylinder3(cylinder);
+	}
+	}
+}
+
+static BroadphaseShape3D GetTranslatedShape(BroadphaseShape3D const& shape, Vec3 const& translation)
+{
+	BroadphaseShape3D translated = shape;
+	switch (shape.m_type)
+	{
+	case BroadphaseShapeType::OBB:
+		translated.m_orientedBox = OBB3(shape.m_orientedBox.GetCenter() + translation, shape.m_orientedBox.GetIBasis(), shape.m_orientedBox.GetJBasis(),
+			shape.m_orientedBox.GetKBasis(), shape.m_orientedBox.GetHalfDimensions());
+		break;
+	case BroadphaseShapeType::SPHERE:
+		translated.m_sphereCenter += translation;
+		break;
+	case BroadphaseShapeType::CYLINDER:
+		translated.m_cylinder.m_start += translation;
+		translated.m_cylinder.m_end += translation;
+		break;
+	default:
+		translated.m_box = AABB3(shape.m_box.m_mins + translation, shape.m_box.m_maxs + translation);
+		break;
+	}
+	return translated;
+}
+
+// Enough room for a couple of neighbors per shape
+static float GetBenchmarkWorldSize(int numShapes)
+{
+	return 2.f * cbrtf((float)numShapes);
+}
+
+static void MakeBenchmarkBodies(int numShapes, RandomNumberGenerator& rng, std::vector<BenchmarkBody>& out_bodies)
+{
+	float worldSize = GetBenchmarkWorldSize(numShapes);
+	out_bodies.resize(numShapes);
+	for (BenchmarkBody& body : out_bodies)
+	{
+		body.m_shape = MakeRandomShape(rng, worldSize);
+		body.m_velocity = rng.RollRandomVectorOnUnitSphere() * rng.RollRandomFloatInRange(0.f, 3.f);
+	}
+}
+
+// Every body moves one frame at 60 Hz, bouncing off the world bounds, and churnEvery-th bodies get
+// removed and added again. Returns how many moves left their fat bounds.
+static int StepBenchmarkBodies(Broadphase3D& broadphase, std::vector<BenchmarkBody>& bodies, RandomNumberGenerator& rng, int frameIndex, int churnEvery)
+{
+	float worldSize = GetBenchmarkWorldSize((int)bodies.size());
+	int numReinserted = 0;
+	for (int bodyIndex = 0; bodyIndex < (int)bodies.size(); ++bodyIndex)
+	{
+		BenchmarkBody& body = bodies[bodyIndex];
+		if (churnEvery > 0 && (bodyIndex + frameIndex) % churnEvery == 0)
+		{
+			broadphase.RemoveShape(body.m_proxyId);
+			body.m_shape = MakeRandomShape(rng, worldSize);
+			body.m_proxyId = broadphase.AddShape(body.m_shape, bodyIndex);
+			continue;
+		}
+
+		Vec3 center = body.m_shape.GetCenter();
+		if ((center.x < 0.f && body.m_velocity.x < 0.f) || (center.x > worldSize && body.m_velocity.x > 0.f)) body.m_velocity.x = -body.m_velocity.x;
+		if ((center.y < 0.f && body.m_velocity.y < 0.f) || (center.y > worldSize && body.m_velocity.y > 0.f)) body.m_velocity.y = -body.m_velocity.y;
+		if ((center.z < 0.f && body.m_velocity.z < 0.f) || (center.z > worldSize && body.m_velocity.z > 0.f)) body.m_velocity.z = -body.m_velocity.z;
+		body.m_shape = GetTranslatedShape(body.m_shape, body.m_velocity * (1.f / 60.f));
+		numReinserted += broadphase.MoveShape(body.m_proxyId, body.m_shape) ? 1 : 0;
+	}
+	return numReinserted;
+}
+
+static void FindEveryOverlappingPair(std::vector<BenchmarkBody> const& bodies, std::vector<BroadphasePair>& out_pairs)
+{
+	out_pairs.clear();
+	for (int firstIndex = 0; firstIndex < (int)bodies.size(); ++firstIndex)
+	{
+		for (int secondIndex = firstIndex + 1; secondIndex < (int)bodies.size(); ++secondIndex)
+		{
+			if (DoShapesOverlap3D(bodies[firstIndex].m_shape, bodies[secondIndex].m_shape))
+			{
+				BroadphasePair pair;
+				pair.m_firstProxy = std::min(bodies[firstIndex].m_proxyId, bodies[secondIndex].m_proxyId);
+				pair.m_secondProxy = std::max(bodies[firstIndex].m_proxyId, bodies[secondIndex].m_proxyId);
+				out_pairs.push_back(pair);
+			}
+		}
+	}
+	std::sort(out_pairs.begin(), out_pairs.end(), IsPairLess);
+}
+
+static bool DoPairListsMatch(std::vector<BroadphasePair> const& first, std::vector<BroadphasePair> const& second)
+{
+	if (first.size() != second.size())
+	{
+		return false;
+	}
+	for (size_t pairIndex = 0; pairIndex < first.size(); ++pairIndex)
+	{
+		if (first[pairIndex].m_firstProxy != second[pairIndex].m_firstProxy || first[pairIndex].m_secondProxy != second[pairIndex].m_secondProxy)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Closest hit over every body, to check Broadphase3D::Raycast against
+static float RaycastEveryBody(std::vector<BenchmarkBody> const& bodies, Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength)
+{
+	float closestDistance = rayLength + 1.f;
+	for (BenchmarkBody const& body : bodies)
+	{
+		RaycastResult3D result = RaycastVsShape3D(rayStart, rayForwardNormal, rayLength, body.m_shape);
+		if (result.m_didImpact && result.m_impactDistance <= rayLength)
+		{
+			closestDistance = std::min(closestDistance, result.m_impactDistance);
+		}
+	}
+	return closestDistance;
+}
+
+static void SetAxisComponent(Vec3& vector, int axis, float value)
+{
+	(axis == 0 ? vector.x : (axis == 1 ? vector.y : vector.z)) = value;
+}
+
+static float GetAxisComponent(Vec3 const& vector, int axis)
+{
+	return axis == 0 ? vector.x : (axis == 1 ? vector.y : vector.z);
+}
+
+// Axis aligned ray starting exactly on a face plane of bounds and running along that face from
+// outside the bounds, where a slab test multiplying 0 by infinity gets a NaN
+static void MakeOnPlaneRay(AABB3 const& bounds, RandomNumberGenerator& rng, Vec3& out_rayStart, Vec3& out_rayForwardNormal, float& out_rayLength)
+{
+	int forwardAxis = rng.RollRandomIntRange(0, 2);
+	int planeAxis = (forwardAxis + 1) % 3;
+	int otherAxis = (forwardAxis + 2) % 3;
+	if (rng.RollRandomIntLessThan(2) == 0)
+	{
+		std::swap(planeAxis, otherAxis);
+	}
+	bool isForward = rng.RollRandomIntLessThan(2) == 0;
+	float forwardMins = GetAxisComponent(bounds.m_mins, forwardAxis);
+	float forwardMaxs = GetAxisComponent(bounds.m_maxs, forwardAxis);
+
+	out_rayStart = Vec3();
+	SetAxisComponent(out_rayStart, forwardAxis, isForward ? forwardMins - 1.f : forwardMaxs + 1.f);
+	SetAxisComponent(out_rayStart, planeAxis, rng.RollRandomIntLessThan(2) == 0 ? GetAxisComponent(bounds.m_mins, planeAxis) : GetAxisComponent(bounds.m_maxs, planeAxis));
+	SetAxisComponent(out_rayStart, otherAxis, rng.RollRandomFloatInRange(GetAxisComponent(bounds.m_mins, otherAxis), GetAxisComponent(bounds.m_maxs, otherAxis)));
+	out_rayForwardNormal = Vec3();
+	SetAxisComponent(out_rayForwardNormal, forwardAxis, isForward ? 1.f : -1.f);
+	out_rayLength = forwardMaxs - forwardMins + 2.f;
+}
+
+int RunBroadphaseEquivalenceTest(int numShapes, int numFrames, float fatMargin)
+{
+	RandomNumberGenerator rng;
+	std::vector<BenchmarkBody> bodies;
+	MakeBenchmarkBodies(numShapes, rng, bodies);
+	Broadphase3D broadphase(fatMargin);
+	for (int bodyIndex = 0; bodyIndex < numShapes; ++bodyIndex)
+	{
+		bodies[bodyIndex].m_proxyId = broadphase.AddShape(bodies[bodyIndex].m_shape, bodyIndex);
+	}
+
+	float worldSize = GetBenchmarkWorldSize(numShapes);
+	int numMismatchedFrames = 0;
+	std::vector<BroadphasePair> pairs;
+	std::vector<BroadphasePair> expectedPairs;
+	for (int frameIndex = 0; frameIndex < numFrames; ++frameIndex)
+	{
+		if (frameIndex > 0)
+		{
+			StepBenchmarkBodies(broadphase, bodies, rng, frameIndex, 50);
+		}
+		broadphase.FindOverlappingPairs(pairs);
+		FindEveryOverlappingPair(bodies, expectedPairs);
+		bool doesFrameMatch = DoPairListsMatch(pairs, expectedPairs) && broadphase.GetTree().IsValid();
+
+		// Half random rays, half axis aligned rays on a face plane of a shape's bounds
+		for (int rayIndex = 0; rayIndex < 64 && doesFrameMatch; ++rayIndex)
+		{
+			Vec3 rayStart(rng.RollRandomFloatInRange(0.f, worldSize), rng.RollRandomFloatInRange(0.f, worldSize), rng.RollRandomFloatInRange(0.f, worldSize));
+			Vec3 rayForwardNormal = rng.RollRandomVectorOnUnitSphere();
+			float rayLength = 0.5f * worldSize;
+			if (rayIndex % 2 == 1)
+			{
+				MakeOnPlaneRay(bodies[rng.RollRandomIntLessThan(numShapes)].m_shape.GetBounds(), rng, rayStart, rayForwardNormal, rayLength);
+			}
+			RaycastResult3D result = broadphase.Raycast(rayStart, rayForwardNormal, rayLength);
+			float expectedDistance = RaycastEveryBody(bodies, rayStart, rayForwardNormal, rayLength);
+			bool didExpectImpact = expectedDistance <= rayLength;
+			doesFrameMatch = result.m_didImpact == didExpectImpact && (!didExpectImpact || fabsf(result.m_impactDistance - expectedDistance) < 1e-3f);
+		}
+
+		for (int queryIndex = 0; queryIndex < 32 && doesFrameMatch; ++queryIndex)
+		{
+			BroadphaseShape3D queryShape = MakeRandomShape(rng, worldSize);
+			std::vector<int> proxyIds;
+			broadphase.QueryShape(queryShape, proxyIds);
+			int numExpected = 0;
+			for (BenchmarkBody const& body : bodies)
+			{
+				numExpected += DoShapesOverlap3D(queryShape, body.m_shape) ? 1 : 0;
+			}
+			doesFrameMatch = (int)proxyIds.size() == numExpected;
+		}
+
+		numMismatchedFrames += doesFrameMatch ? 0 : 1;
+	}
+	return numMismatchedFrames;
+}
+
+template<typename Work>
+static double TimeSeconds(Work const& work)
+{
+	double startSeconds = GetCurrentTimeSeconds();
+	work();
+	return GetCurrentTimeSeconds() - startSeconds;
+}
+
+static BroadphaseBenchmarkResult RunBroadphaseScene(char const* name, int numShapes, int numFrames, bool areMoving, int churnEvery)
+{
+	BroadphaseBenchmarkResult result;
+	result.m_name = name;
+	result.m_numShapes = numShapes;
+	result.m_numFrames = numFrames;
+
+	RandomNumberGenerator rng;
+	std::vector<BenchmarkBody> bodies;
+	MakeBenchmarkBodies(numShapes, rng, bodies);
+	Broadphase3D broadphase;
+	for (int bodyIndex = 0; bodyIndex < numShapes; ++bodyIndex)
+	{
+		bodies[bodyIndex].m_proxyId = broadphase.AddShape(bodies[bodyIndex].m_shape, bodyIndex);
+	}
+
+	// First frame pairs everything up, it is not what the frames after it cost
+	std::vector<BroadphasePair> pairs;
+	broadphase.FindOverlappingPairs(pairs);
+
+	double moveSeconds = 0.0;
+	double findPairsSeconds = 0.0;
+	int numReinserted = 0;
+	for (int frameIndex = 1; frameIndex <= numFrames; ++frameIndex)
+	{
+		if (areMoving)
+		{
+			moveSeconds += TimeSeconds([&]() { numReinserted += StepBenchmarkBodies(broadphase, bodies, rng, frameIndex, churnEvery); });
+		}
+		findPairsSeconds += TimeSeconds([&]() { broadphase.FindOverlappingPairs(pairs); });
+	}
+
+	result.m_moveMs = 1000.0 * moveSeconds / (double)std::max(1, numFrames);
+	result.m_findPairsMs = 1000.0 * findPairsSeconds / (double)std::max(1, numFrames);
+	result.m_numPairs = (int)pairs.size();
+	result.m_numReinsertedPerFrame = numReinserted / std::max(1, numFrames);
+	return result;
+}
+
+std::vector<BroadphaseBenchmarkResult> RunBroadphaseBenchmark(int numShapes, int numFrames)
+{
+	std::vector<BroadphaseBenchmarkResult> results;
+	results.push_back(RunBroadphaseScene("static", numShapes, numFrames, false, 0));
+	results.push_back(RunBroadphaseScene("moving", numShapes, numFrames, true, 0));
+	results.push_back(RunBroadphaseScene("churn", numShapes, numFrames, true, 100));
+	return results;
+}
+
+bool Command_BroadphaseBenchmark(EventArgs const& args)
+{
+	int numShapes = args.GetValue(std::string("shapes"), 50000);
+	int numFrames = args.GetValue(std::string("frames"), 60);
+	int numMismatchedFrames = RunBroadphaseEquivalenceTest(2000, 20, AABB_TREE_DEFAULT_FAT_MARGIN) + RunBroadphaseEquivalenceTest(2000, 20, 0.f);
+	std::vector<BroadphaseBenchmarkResult> results = RunBroadphaseBenchmark(numShapes, numFrames);
+	if (g_theConsole)
+	{
+		g_theConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("BroadphaseBenchmark, %i shapes, %i frames", numShapes, numFrames));
+		for (BroadphaseBenchmarkResult const& result : results)
+		{
+			g_theConsole->AddLine(DevConsole::INFO_MINOR, Stringf("%-7s moves %.2f ms, pairs %.2f ms per frame, %i reinserted per frame, %i pairs",
+				result.m_name.c_str(), result.m_moveMs, result.m_findPairsMs, result.m_numReinsertedPerFrame, result.m_numPairs));
+		}
+		g_theConsole->AddLine(numMismatchedFrames == 0 ? DevConsole::INFO_MINOR : DevConsole::ERROR,
+			Stringf("%i frames disagree with testing every pair of shapes", numMismatchedFrames));
+	}
+	return true;
+}
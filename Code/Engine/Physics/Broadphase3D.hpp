@@ -0,0 +1,121 @@
+#pragma once
+#include "Engine/Math/AABB3.hpp"
+#include "Engine/Math/OBB3.hpp"
+#include "Engine/Math/Cylinder3.hpp"
+#include "Engine/Physics/DynamicAABBTree3D.hpp"
+#include "Engine/Physics/RaycastUtils.hpp"
+#include <string>
+#include <vector>
+
+class NamedProperties;
+typedef NamedProperties EventArgs;
+
+//-----------------------------------------------------------------------------------
+// Broadphase for 3D shapes over a DynamicAABBTree3D. Finding overlapping pairs, raycasts and
+// volume queries first cull with the fat bounds in the tree, then confirm with the MathUtils and
+// RaycastUtils function for each pair of shape types.
+//
+// Narrow phase notes:
+//	- Cylinders whose axis is along z use the DoZCylinder functions. MathUtils has nothing for
+//	  other cylinders against boxes or cylinders, so those are tested as the box around the
+//	  cylinder. That may report a few overlaps near the rims.
+//	- Cylinders against spheres are exact for any axis.
+//	- OBB3 against OBB3 is DoOBBAndAABBOverlap3D in the first box's local space.
+//
+enum class BroadphaseShapeType
+{
+	AABB = 0,
+	OBB,
+	SPHERE,
+	CYLINDER,
+	COUNT
+};
+
+struct BroadphaseShape3D
+{
+public:
+	static BroadphaseShape3D	MakeAABB3(AABB3 const& box);
+	static BroadphaseShape3D	MakeOBB3(OBB3 const& orientedBox);
+	static BroadphaseShape3D	MakeSphere(Vec3 const& sphereCenter, float sphereRadius);
+	static BroadphaseShape3D	MakeCylinder3(Cylinder3 const& cylinder);
+
+	AABB3	GetBounds() const;
+	Vec3	GetCenter() const;
+
+public:
+	BroadphaseShapeType		m_type = BroadphaseShapeType::AABB;
+	AABB3					m_box;					// Only the member matching m_type is used
+	OBB3					m_orientedBox;
+	Vec3					m_sphereCenter;
+	float					m_sphereRadius = 0.f;
+	Cylinder3				m_cylinder = {};
+};
+
+// Exact but for a cylinder whose axis is not along z against a box or another cylinder, which tests
+// the cylinder as its bounding OBB3: never misses an overlap, may report one near the rims
+bool			DoShapesOverlap3D(BroadphaseShape3D const& first, BroadphaseShape3D const& second);
+// Impact distances are measured from the impact position, whatever the underlying raycast fills in
+RaycastResult3D	RaycastVsShape3D(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, BroadphaseShape3D const& shape);
+
+struct BroadphasePair
+{
+	int		m_firstProxy = -1;		// Always the lower id of the two
+	int		m_secondProxy = -1;
+};
+
+class Broadphase3D
+{
+public:
+	explicit Broadphase3D(float fatMargin = AABB_TREE_DEFAULT_FAT_MARGIN);
+
+	int		AddShape(BroadphaseShape3D const& shape, int userData = -1);
+	void	RemoveShape(int proxyId);
+	// How far the shape moved is used to predict its next moves. Returns true when it left its fat
+	// bounds and got inserted in the tree again.
+	bool	MoveShape(int proxyId, BroadphaseShape3D const& shape);
+	void	Clear();
+
+	// Every pair of shapes that overlap, narrow phase included, sorted by ids. Only shapes that left
+	// their fat bounds (or were added or removed) since the last call get queried against the tree;
+	// the other candidate pairs come from the last call, so scenes that barely move only pay for
+	// the narrow phase. Queries and narrow phase run in parallel on g_theJobSystem.
+	void	FindOverlappingPairs(std::vector<BroadphasePair>& out_pairs);
+
+	// Closest hit, out_proxyId gets the shape hit or -1
+	RaycastResult3D	Raycast(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, int* out_proxyId = nullptr) const;
+	// Appends every shape overlapping the given one and returns how many were appended
+	int				QueryShape(BroadphaseShape3D const& shape, std::vector<int>& out_proxyIds) const;
+
+	BroadphaseShape3D const&	GetShape(int proxyId) const		{ return m_shapes[proxyId]; }
+	int							GetUserData(int proxyId) const	{ return m_tree.GetUserData(proxyId); }
+	int							GetNumShapes() const			{ return m_tree.GetNumProxies(); }
+	DynamicAABBTree3D const&	GetTree() const					{ return m_tree; }
+
+private:
+	void	MarkMoved(int proxyId);
+	void	GrowProxyArrays();
+
+private:
+	DynamicAABBTree3D				m_tree;
+	std::vector<BroadphaseShape3D>	m_shapes;				// By proxy id
+	std::vector<unsigned char>		m_isMoved;				// By proxy id, fat bounds changed or proxy added or removed since the last FindOverlappingPairs
+	std::vector<int>				m_movedProxies;
+	std::vector<BroadphasePair>		m_candidatePairs;		// Pairs with overlapping fat bounds as of the last FindOverlappingPairs
+};
+
+struct BroadphaseBenchmarkResult
+{
+	std::string		m_name;
+	int				m_numShapes = 0;
+	int				m_numFrames = 0;
+	double			m_moveMs = 0.0;				// Per frame, MoveShape and the adds and removes
+	double			m_findPairsMs = 0.0;		// Per frame
+	int				m_numPairs = 0;				// On the last frame
+	int				m_numReinsertedPerFrame = 0;
+};
+
+// Compares FindOverlappingPairs, Raycast and QueryShape with testing every shape, returns the number
+// of frames that disagree. Raycasts include axis aligned rays starting on the face planes of shapes.
+int										RunBroadphaseEquivalenceTest(int numShapes, int numFrames, float fatMargin);
+std::vector<BroadphaseBenchmarkResult>	RunBroadphaseBenchmark(int numShapes, int numFrames);
+bool									Command_BroadphaseBenchmark(EventArgs const& args);
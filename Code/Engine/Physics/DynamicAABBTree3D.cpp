@@ -0,0 +1,365 @@
+#include "Engine/Physics/DynamicAABBTree3D.hpp"
+#include "Engine/Core/EngineCommon.hpp"
+
+//-----------------------------------------------------------------------------------
+static AABB3 GetUnion(AABB3 const& first, AABB3 const& second)
+{
+	return AABB3(std::min(first.m_mins.x, second.m_mins.x), std::min(first.m_mins.y, second.m_mins.y), std::min(first.m_mins.z, second.m_mins.z),
+		std::max(first.m_maxs.x, second.m_maxs.x), std::max(first.m_maxs.y, second.m_maxs.y), std::max(first.m_maxs.z, second.m_maxs.z));
+}
+
+// Half the surface area is enough to compare insertion costs
+static float GetHalfSurfaceArea(AABB3 const& bounds)
+{
+	float dimensionX = bounds.m_maxs.x - bounds.m_mins.x;
+	float dimensionY = bounds.m_maxs.y - bounds.m_mins.y;
+	float dimensionZ = bounds.m_maxs.z - bounds.m_mins.z;
+	return dimensionX * dimensionY + dimensionY * dimensionZ + dimensionZ * dimensionX;
+}
+
+static bool DoesContain(AABB3 const& outer, AABB3 const& inner)
+{
+	return outer.m_mins.x <= inner.m_mins.x && outer.m_mins.y <= inner.m_mins.y && outer.m_mins.z <= inner.m_mins.z &&
+		inner.m_maxs.x <= outer.m_maxs.x && inner.m_maxs.y <= outer.m_maxs.y && inner.m_maxs.z <= outer.m_maxs.z;
+}
+
+static AABB3 GetGrownBounds(AABB3 const& bounds, float margin)
+{
+	return AABB3(bounds.m_mins.x - margin, bounds.m_mins.y - margin, bounds.m_mins.z - margin,
+		bounds.m_maxs.x + margin, bounds.m_maxs.y + margin, bounds.m_maxs.z + margin);
+}
+
+//-----------------------------------------------------------------------------------
+DynamicAABBTree3D::DynamicAABBTree3D(float fatMargin)
+	: m_fatMargin(fatMargin)
+{
+}
+
+int DynamicAABBTree3D::CreateProxy(AABB3 const& bounds, int userData)
+{
+	int proxyId = AllocateNode();
+	AABBTreeNode3D& node = m_nodes[proxyId];
+	node.m_fatBounds = GetGrownBounds(bounds, m_fatMargin);
+	node.m_userData = userData;
+	node.m_height = 0;
+	InsertLeaf(proxyId);
+	m_numProxies++;
+	return proxyId;
+}
+
+void DynamicAABBTree3D::DestroyProxy(int proxyId)
+{
+	GUARANTEE_OR_DIE(IsProxy(proxyId), "DynamicAABBTree3D::DestroyProxy was given an id that is not a live proxy");
+	RemoveLeaf(proxyId);
+	FreeNode(proxyId);
+	m_numProxies--;
+}
+
+bool DynamicAABBTree3D::MoveProxy(int proxyId, AABB3 const& bounds, Vec3 const& displacement)
+{
+	GUARANTEE_OR_DIE(IsProxy(proxyId), "DynamicAABBTree3D::MoveProxy was given an id that is not a live proxy");
+
+	AABB3 fatBounds = GetGrownBounds(bounds, m_fatMargin);
+	Vec3 predictedDisplacement = displacement * AABB_TREE_DISPLACEMENT_MULTIPLIER;
+	fatBounds.m_mins = Vec3(fatBounds.m_mins.x + std::min(predictedDisplacement.x, 0.f), fatBounds.m_mins.y + std::min(predictedDisplacement.y, 0.f), fatBounds.m_mins.z + std::min(predictedDisplacement.z, 0.f));
+	fatBounds.m_maxs = Vec3(fatBounds.m_maxs.x + std::max(predictedDisplacement.x, 0.f), fatBounds.m_maxs.y + std::max(predictedDisplacement.y, 0.f), fatBounds.m_maxs.z + std::max(predictedDisplacement.z, 0.f));
+
+	AABB3 const& treeBounds = m_nodes[proxyId].m_fatBounds;
+	if (DoesContain(treeBounds, bounds))
+	{
+		// Still inside, keep it unless it has slowed down so much that its fat bounds are far too big
+		if (DoesContain(GetGrownBounds(fatBounds, 4.f * m_fatMargin), treeBounds))
+		{
+			return false;
+		}
+	}
+
+	RemoveLeaf(proxyId);
+	m_nodes[proxyId].m_fatBounds = fatBounds;
+	InsertLeaf(proxyId);
+	return true;
+}
+
+void DynamicAABBTree3D::Clear()
+{
+	m_nodes.clear();
+	m_root = AABB_TREE_NULL_NODE;
+	m_freeList = AABB_TREE_NULL_NODE;
+	m_numProxies = 0;
+}
+
+int DynamicAABBTree3D::GetHeight() const
+{
+	return m_root == AABB_TREE_NULL_NODE ? 0 : m_nodes[m_root].m_height;
+}
+
+float DynamicAABBTree3D::GetAreaRatio() const
+{
+	if (m_root == AABB_TREE_NULL_NODE)
+	{
+		return 0.f;
+	}
+
+	float rootArea = GetHalfSurfaceArea(m_nodes[m_root].m_fatBounds);
+	float totalArea = 0.f;
+	for (AABBTreeNode3D const& node : m_nodes)
+	{
+		if (node.m_height >= 0)
+		{
+			totalArea += GetHalfSurfaceArea(node.m_fatBounds);
+		}
+	}
+	return rootArea > 0.f ? totalArea / rootArea : 0.f;
+}
+
+bool DynamicAABBTree3D::IsValid() const
+{
+	int numLeaves = 0;
+	if (m_root != AABB_TREE_NULL_NODE && GetValidatedHeight(m_root, AABB_TREE_NULL_NODE, numLeaves) < 0)
+	{
+		return false;
+	}
+
+	int numFreeNodes = 0;
+	for (int freeIndex = m_freeList; freeIndex != AABB_TREE_NULL_NODE; freeIndex = m_nodes[freeIndex].m_parentOrNextFree)
+	{
+		if (m_nodes[freeIndex].m_height != -1 || ++numFreeNodes > (int)m_nodes.size())
+		{
+			return false;
+		}
+	}
+
+	int numTreeNodes = numLeaves == 0 ? 0 : 2 * numLeaves - 1;
+	return numLeaves == m_numProxies && numTreeNodes + numFreeNodes == (int)m_nodes.size();
+}
+
+// Height of the subtree, or -1 when something under it is broken
+int DynamicAABBTree3D::GetValidatedHeight(int nodeIndex, int parentIndex, int& inout_numLeaves) const
+{
+	AABBTreeNode3D const& node = m_nodes[nodeIndex];
+	if (node.m_parentOrNextFree != parentIndex)
+	{
+		return -1;
+	}
+
+	if (node.IsLeaf())
+	{
+		inout_numLeaves++;
+		return node.m_height == 0 && node.m_secondChild == AABB_TREE_NULL_NODE ? 0 : -1;
+	}
+
+	AABBTreeNode3D const& firstChild = m_nodes[node.m_firstChild];
+	AABBTreeNode3D const& secondChild = m_nodes[node.m_secondChild];
+	if (!DoesContain(node.m_fatBounds, firstChild.m_fatBounds) || !DoesContain(node.m_fatBounds, secondChild.m_fatBounds))
+	{
+		return -1;
+	}
+
+	int firstHeight = GetValidatedHeight(node.m_firstChild, nodeIndex, inout_numLeaves);
+	int secondHeight = GetValidatedHeight(node.m_secondChild, nodeIndex, inout_numLeaves);
+	int height = 1 + std::max(firstHeight, secondHeight);
+	if (firstHeight < 0 || secondHeight < 0 || height != node.m_height)
+	{
+		return -1;
+	}
+	return height;
+}
+
+//-----------------------------------------------------------------------------------
+int DynamicAABBTree3D::AllocateNode()
+{
+	if (m_freeList == AABB_TREE_NULL_NODE)
+	{
+		m_nodes.emplace_back();
+		return (int)m_nodes.size() - 1;
+	}
+
+	int nodeIndex = m_freeList;
+	m_freeList = m_nodes[nodeIndex].m_parentOrNextFree;
+	m_nodes[nodeIndex] = AABBTreeNode3D();
+	return nodeIndex;
+}
+
+void DynamicAABBTree3D::FreeNode(int nodeIndex)
+{
+	AABBTreeNode3D& node = m_nodes[nodeIndex];
+	node.m_parentOrNextFree = m_freeList;
+	node.m_firstChild = AABB_TREE_NULL_NODE;
+	node.m_secondChild = AABB_TREE_NULL_NODE;
+	node.m_height = -1;
+	node.m_userData = -1;
+	m_freeList = nodeIndex;
+}
+
+void DynamicAABBTree3D::RefreshNode(int nodeIndex)
+{
+	AABBTreeNode3D& node = m_nodes[nodeIndex];
+	AABBTreeNode3D const& firstChild = m_nodes[node.m_firstChild];
+	AABBTreeNode3D const& secondChild = m_nodes[node.m_secondChild];
+	node.m_height = 1 + std::max(firstChild.m_height, secondChild.m_height);
+	node.m_fatBounds = GetUnion(firstChild.m_fatBounds, secondChild.m_fatBounds);
+}
+
+void DynamicAABBTree3D::InsertLeaf(int leaf)
+{
+	if (m_root == AABB_TREE_NULL_NODE)
+	{
+		m_root = leaf;
+		m_nodes[leaf].m_parentOrNextFree = AABB_TREE_NULL_NODE;
+		return;
+	}
+
+	// Walk down to the cheapest sibling. Going into a child costs the area the parent grows by,
+	// plus what the child costs; stopping here costs a new parent over this whole node.
+	AABB3 leafBounds = m_nodes[leaf].m_fatBounds;
+	int nodeIndex = m_root;
+	while (!m_nodes[nodeIndex].IsLeaf())
+	{
+		AABBTreeNode3D const& node = m_nodes[nodeIndex];
+		float area = GetHalfSurfaceArea(node.m_fatBounds);
+		float combinedArea = GetHalfSurfaceArea(GetUnion(node.m_fatBounds, leafBounds));
+		float cost = 2.f * combinedArea;
+		float inheritanceCost = 2.f * (combinedArea - area);
+
+		float childCosts[2] = {};
+		int children[2] = { node.m_firstChild, node.m_secondChild };
+		for (int childNumber = 0; childNumber < 2; ++childNumber)
+		{
+			AABBTreeNode3D const& child = m_nodes[children[childNumber]];
+			float grownArea = GetHalfSurfaceArea(GetUnion(leafBounds, child.m_fatBounds));
+			childCosts[childNumber] = (child.IsLeaf() ? grownArea : grownArea - GetHalfSurfaceArea(child.m_fatBounds)) + inheritanceCost;
+		}
+
+		if (cost < childCosts[0] && cost < childCosts[1])
+		{
+			break;
+		}
+		nodeIndex = childCosts[0] < childCosts[1] ? children[0] : children[1];
+	}
+
+	int sibling = nodeIndex;
+	int oldParent = m_nodes[sibling].m_parentOrNextFree;
+	int newParent = AllocateNode();
+	AABBTreeNode3D& parentNode = m_nodes[newParent];
+	parentNode.m_parentOrNextFree = oldParent;
+	parentNode.m_fatBounds = GetUnion(leafBounds, m_nodes[sibling].m_fatBounds);
+	parentNode.m_height = m_nodes[sibling].m_height + 1;
+	parentNode.m_firstChild = sibling;
+	parentNode.m_secondChild = leaf;
+	m_nodes[sibling].m_parentOrNextFree = newParent;
+	m_nodes[leaf].m_parentOrNextFree = newParent;
+
+	if (oldParent == AABB_TREE_NULL_NODE)
+	{
+		m_root = newParent;
+	}
+	else if (m_nodes[oldParent].m_firstChild == sibling)
+	{
+		m_nodes[oldParent].m_firstChild = newParent;
+	}
+	else
+	{
+		m_nodes[oldParent].m_secondChild = newParent;
+	}
+
+	for (nodeIndex = m_nodes[leaf].m_parentOrNextFree; nodeIndex != AABB_TREE_NULL_NODE; nodeIndex = m_nodes[nodeIndex].m_parentOrNextFree)
+	{
+		nodeIndex = Balance(nodeIndex);
+		RefreshNode(nodeIndex);
+	}
+}
+
+void DynamicAABBTree3D::RemoveLeaf(int leaf)
+{
+	if (leaf == m_root)
+	{
+		m_root = AABB_TREE_NULL_NODE;
+		return;
+	}
+
+	int parent = m_nodes[leaf].m_parentOrNextFree;
+	int grandParent = m_nodes[parent].m_parentOrNextFree;
+	int sibling = m_nodes[parent].m_firstChild == leaf ? m_nodes[parent].m_secondChild : m_nodes[parent].m_firstChild;
+	FreeNode(parent);
+	m_nodes[sibling].m_parentOrNextFree = grandParent;
+
+	if (grandParent == AABB_TREE_NULL_NODE)
+	{
+		m_root = sibling;
+		return;
+	}
+
+	if (m_nodes[grandParent].m_firstChild == parent)
+	{
+		m_nodes[grandParent].m_firstChild = sibling;
+	}
+	else
+	{
+		m_nodes[grandParent].m_secondChild = sibling;
+	}
+
+	for (int nodeIndex = grandParent; nodeIndex != AABB_TREE_NULL_NODE; nodeIndex = m_nodes[nodeIndex].m_parentOrNextFree)
+	{
+		nodeIndex = Balance(nodeIndex);
+		RefreshNode(nodeIndex);
+	}
+}
+
+// When one child of nodeA is two levels taller than the other, rotates the taller child up in
+// place of nodeA and returns the index of the node now at nodeA's place
+int DynamicAABBTree3D::Balance(int indexA)
+{
+	AABBTreeNode3D& nodeA = m_nodes[indexA];
+	if (nodeA.IsLeaf() || nodeA.m_height < 2)
+	{
+		return indexA;
+	}
+
+	int indexB = nodeA.m_firstChild;
+	int indexC = nodeA.m_secondChild;
+	int balance = m_nodes[indexC].m_height - m_nodes[indexB].m_height;
+	if (balance >= -1 && balance <= 1)
+	{
+		return indexA;
+	}
+
+	// Rotate the taller child up, it keeps its own taller child and hands its shorter one to nodeA
+	bool isSecondTaller = balance > 1;
+	int indexUp = isSecondTaller ? indexC : indexB;
+	AABBTreeNode3D& nodeUp = m_nodes[indexUp];
+	int indexF = nodeUp.m_firstChild;
+	int indexG = nodeUp.m_secondChild;
+
+	nodeUp.m_firstChild = indexA;
+	nodeUp.m_parentOrNextFree = nodeA.m_parentOrNextFree;
+	nodeA.m_parentOrNextFree = indexUp;
+	if (nodeUp.m_parentOrNextFree == AABB_TREE_NULL_NODE)
+	{
+		m_root = indexUp;
+	}
+	else if (m_nodes[nodeUp.m_parentOrNextFree].m_firstChild == indexA)
+	{
+		m_nodes[nodeUp.m_parentOrNextFree].m_firstChild = indexUp;
+	}
+	else
+	{
+		m_nodes[nodeUp.m_parentOrNextFree].m_secondChild = indexUp;
+	}
+
+	int indexKept = m_nodes[indexF].m_height > m_nodes[indexG].m_height ? indexF : indexG;
+	int indexGiven = indexKept == indexF ? indexG : indexF;
+	nodeUp.m_secondChild = indexKept;
+	if (isSecondTaller)
+	{
+		nodeA.m_secondChild = indexGiven;
+	}
+	else
+	{
+		nodeA.m_firstChild = indexGiven;
+	}
+	m_nodes[indexGiven].m_parentOrNextFree = indexA;
+
+	RefreshNode(indexA);
+	RefreshNode(indexUp);
+	return indexUp;
+}
@@ -0,0 +1,207 @@
+#pragma once
+#include "Engine/Math/AABB3.hpp"
+#include "Engine/Math/Vec3.hpp"
+#include <algorithm>
+#include <vector>
+
+//-----------------------------------------------------------------------------------
+// Dynamic bounding volume tree over fat AABB3s, the acceleration structure under Broadphase3D.
+// Proxies are stored with their bounds grown by a margin, plus a few frames of their motion when
+// moved, so most moves stay inside the fat bounds and cost nothing. A proxy that leaves them is
+// removed and inserted again.
+//
+// Insertion walks down to the sibling with the lowest surface area cost, then AVL style rotations
+// keep the tree balanced on the way back up. Proxy ids are leaf node indexes: they stay valid until
+// DestroyProxy and get reused afterwards. Nodes live in one pooled array, so ids stay small and
+// per proxy data can live in plain arrays sized with GetNodeCapacity.
+//
+constexpr int	AABB_TREE_NULL_NODE = -1;
+constexpr float	AABB_TREE_DEFAULT_FAT_MARGIN = 0.1f;
+constexpr float	AABB_TREE_DISPLACEMENT_MULTIPLIER = 4.f;	// Fat bounds reach this many moves ahead
+constexpr int	AABB_TREE_MAX_QUERY_DEPTH = 256;			// Balanced, so even 2^31 proxies stay far from it
+
+struct AABBTreeNode3D
+{
+	bool	IsLeaf() const { return m_firstChild == AABB_TREE_NULL_NODE; }
+
+	AABB3	m_fatBounds;
+	int		m_parentOrNextFree = AABB_TREE_NULL_NODE;
+	int		m_firstChild = AABB_TREE_NULL_NODE;
+	int		m_secondChild = AABB_TREE_NULL_NODE;
+	int		m_height = -1;				// 0 for leaves, -1 for free nodes
+	int		m_userData = -1;
+};
+
+class DynamicAABBTree3D
+{
+public:
+	explicit DynamicAABBTree3D(float fatMargin = AABB_TREE_DEFAULT_FAT_MARGIN);
+
+	int		CreateProxy(AABB3 const& bounds, int userData);
+	void	DestroyProxy(int proxyId);
+	// Returns true when the new bounds left the fat bounds (or the fat bounds got too loose) and the
+	// proxy was inserted again. displacement is how far the proxy moved this time, to predict the next moves.
+	bool	MoveProxy(int proxyId, AABB3 const& bounds, Vec3 const& displacement);
+	void	Clear();
+
+	bool			IsProxy(int proxyId) const			{ return proxyId >= 0 && proxyId < (int)m_nodes.size() && m_nodes[proxyId].m_height == 0; }
+	AABB3 const&	GetFatBounds(int proxyId) const		{ return m_nodes[proxyId].m_fatBounds; }
+	int				GetUserData(int proxyId) const		{ return m_nodes[proxyId].m_userData; }
+	int				GetNodeCapacity() const				{ return (int)m_nodes.size(); }
+	int				GetNumProxies() const				{ return m_numProxies; }
+	int				GetHeight() const;
+	float			GetAreaRatio() const;				// Surface area of every node over the root's, lower is a better tree
+	bool			IsValid() const;					// Walks the whole tree checking links, heights and bounds, for debugging
+
+	// visitProxy(int proxyId) -> bool for every proxy whose fat bounds touch bounds, false stops the query
+	template<typename ProxyVisitor>
+	void	QueryAABB3(AABB3 const& bounds, ProxyVisitor const& visitProxy) const;
+
+	// raycastProxy(int proxyId, float maxLength) -> float for every proxy whose fat bounds the ray
+	// touches within maxLength. It returns the new max length: a closer hit clips the ray, maxLength
+	// keeps going unchanged and 0 stops.
+	template<typename ProxyRaycaster>
+	void	Raycast(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, ProxyRaycaster const& raycastProxy) const;
+
+private:
+	int		AllocateNode();
+	void	FreeNode(int nodeIndex);
+	void	InsertLeaf(int leaf);
+	void	RemoveLeaf(int leaf);
+	int		Balance(int nodeIndex);
+	void	RefreshNode(int nodeIndex);
+	int		GetValidatedHeight(int nodeIndex, int parentIndex, int& inout_numLeaves) const;
+
+	static bool	DoFatBoundsOverlap(AABB3 const& first, AABB3 const& second);
+	static bool	ClipRayToSlab(float start, float forward, float oneOverForward, float mins, float maxs, float& inout_enterDistance, float& inout_exitDistance);
+
+private:
+	std::vector<AABBTreeNode3D>		m_nodes;
+	int								m_root = AABB_TREE_NULL_NODE;
+	int								m_freeList = AABB_TREE_NULL_NODE;
+	int								m_numProxies = 0;
+	float							m_fatMargin = AABB_TREE_DEFAULT_FAT_MARGIN;
+};
+
+//-----------------------------------------------------------------------------------
+inline bool DynamicAABBTree3D::DoFatBoundsOverlap(AABB3 const& first, AABB3 const& second)
+{
+	return first.m_mins.x <= second.m_maxs.x && first.m_maxs.x >= second.m_mins.x &&
+		first.m_mins.y <= second.m_maxs.y && first.m_maxs.y >= second.m_mins.y &&
+		first.m_mins.z <= second.m_maxs.z && first.m_maxs.z >= second.m_mins.z;
+}
+
+// A ray parallel to the slab is inside it or misses, so 0 * infinity never makes a NaN that drops
+// hits starting on a face plane
+inline bool DynamicAABBTree3D::ClipRayToSlab(float start, float forward, float oneOverForward, float mins, float maxs, float& inout_enterDistance, float& inout_exitDistance)
+{
+	if (forward == 0.f)
+	{
+		return start >= mins && start <= maxs;
+	}
+	float minsDistance = (mins - start) * oneOverForward;
+	float maxsDistance = (maxs - start) * oneOverForward;
+	inout_enterDistance = std::max(inout_enterDistance, std::min(minsDistance, maxsDistance));
+	inout_exitDistance = std::min(inout_exitDistance, std::max(minsDistance, maxsDistance));
+	return true;
+}
+
+template<typename ProxyVisitor>
+void DynamicAABBTree3D::QueryAABB3(AABB3 const& bounds, ProxyVisitor const& visitProxy) const
+{
+	if (m_root == AABB_TREE_NULL_NODE)
+	{
+		return;
+	}
+
+	int stack[AABB_TREE_MAX_QUERY_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = m_root;
+	while (stackSize > 0)
+	{
+		AABBTreeNode3D const& node = m_nodes[stack[--stackSize]];
+		if (!DoFatBoundsOverlap(node.m_fatBounds, bounds))
+		{
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			if (!visitProxy((int)(&node - m_nodes.data())))
+			{
+				return;
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.m_secondChild;
+			stack[stackSize++] = node.m_firstChild;
+		}
+	}
+}
+
+template<typename ProxyRaycaster>
+void DynamicAABBTree3D::Raycast(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, ProxyRaycaster const& raycastProxy) const
+{
+	if (m_root == AABB_TREE_NULL_NODE)
+	{
+		return;
+	}
+
+	// Infinite for axis aligned rays, which take the ClipRayToSlab path instead
+	float oneOverForwardX = 1.f / rayForwardNormal.x;
+	float oneOverForwardY = 1.f / rayForwardNormal.y;
+	float oneOverForwardZ = 1.f / rayForwardNormal.z;
+	bool isAxisAligned = rayForwardNormal.x == 0.f || rayForwardNormal.y == 0.f || rayForwardNormal.z == 0.f;
+	float maxLength = rayLength;
+
+	int stack[AABB_TREE_MAX_QUERY_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = m_root;
+	while (stackSize > 0)
+	{
+		int nodeIndex = stack[--stackSize];
+		AABBTreeNode3D const& node = m_nodes[nodeIndex];
+		AABB3 const& bounds = node.m_fatBounds;
+		float enterDistance = 0.f;
+		float exitDistance = maxLength;
+		if (isAxisAligned)
+		{
+			if (!ClipRayToSlab(rayStart.x, rayForwardNormal.x, oneOverForwardX, bounds.m_mins.x, bounds.m_maxs.x, enterDistance, exitDistance) ||
+				!ClipRayToSlab(rayStart.y, rayForwardNormal.y, oneOverForwardY, bounds.m_mins.y, bounds.m_maxs.y, enterDistance, exitDistance) ||
+				!ClipRayToSlab(rayStart.z, rayForwardNormal.z, oneOverForwardZ, bounds.m_mins.z, bounds.m_maxs.z, enterDistance, exitDistance))
+			{
+				continue;
+			}
+		}
+		else
+		{
+			float minX = (bounds.m_mins.x - rayStart.x) * oneOverForwardX;
+			float maxX = (bounds.m_maxs.x - rayStart.x) * oneOverForwardX;
+			float minY = (bounds.m_mins.y - rayStart.y) * oneOverForwardY;
+			float maxY = (bounds.m_maxs.y - rayStart.y) * oneOverForwardY;
+			float minZ = (bounds.m_mins.z - rayStart.z) * oneOverForwardZ;
+			float maxZ = (bounds.m_maxs.z - rayStart.z) * oneOverForwardZ;
+			enterDistance = std::max(std::max(std::min(minX, maxX), std::min(minY, maxY)), std::max(std::min(minZ, maxZ), enterDistance));
+			exitDistance = std::min(std::min(std::max(minX, maxX), std::max(minY, maxY)), std::min(std::max(minZ, maxZ), exitDistance));
+		}
+		if (enterDistance > exitDistance)
+		{
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			maxLength = raycastProxy(nodeIndex, maxLength);
+			if (maxLength <= 0.f)
+			{
+				return;
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.m_secondChild;
+			stack[stackSize++] = node.m_firstChild;
+		}
+	}
+}
@@ -0,0 +1,1089 @@
+#include "Engine/Physics/MeshBVH.hpp"
+#include "Engine/Core/CPUMesh.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Core/ParallelAlgorithms.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Math/MathUtils.hpp"
+#include "Engine/Math/OBB3.hpp"
+#include "Engine/Math/RandomNumberGenerator.hpp"
+#include "Engine/Math/Triangle3.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+constexpr float	MESH_BVH_TRAVERSAL_COST = 1.f;					// Cost of visiting a node, one triangle test being 1
+constexpr int	MESH_BVH_MAX_SAH_DEPTH = 64;
+constexpr int	MIN_TRIANGLES_FOR_PARALLEL_BINNING = 32768;
+constexpr int	MIN_TRIANGLES_PER_SUBTREE_JOB = 2048;
+constexpr int	SUBTREE_JOBS_PER_THREAD = 4;
+constexpr int	TRIANGLES_PER_PREPARE_CHUNK = 4096;
+
+// Keeps the optimizer from dropping the work being timed
+static volatile int s_benchmarkSink = 0;
+
+//-----------------------------------------------------------------------------------
+static AABB3 MakeEmptyBounds()
+{
+	return AABB3(FLT_MAX, FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX);
+}
+
+static void GrowBounds(AABB3& bounds, Vec3 const& point)
+{
+	bounds.m_mins = Vec3(std::min(bounds.m_mins.x, point.x), std::min(bounds.m_mins.y, point.y), std::min(bounds.m_mins.z, point.z));
+	bounds.m_maxs = Vec3(std::max(bounds.m_maxs.x, point.x), std::max(bounds.m_maxs.y, point.y), std::max(bounds.m_maxs.z, point.z));
+}
+
+static void GrowBounds(AABB3& bounds, AABB3 const& other)
+{
+	bounds.m_mins = Vec3(std::min(bounds.m_mins.x, other.m_mins.x), std::min(bounds.m_mins.y, other.m_mins.y), std::min(bounds.m_mins.z, other.m_mins.z));
+	bounds.m_maxs = Vec3(std::max(bounds.m_maxs.x, other.m_maxs.x), std::max(bounds.m_maxs.y, other.m_maxs.y), std::max(bounds.m_maxs.z, other.m_maxs.z));
+}
+
+static MeshBVHTriangle MakeBVHTriangle(CPUMesh const& mesh, int triangleIndex)
+{
+	Vec3 const& pointA = mesh.m_vertexes[mesh.m_indexes[3 * triangleIndex + 0]].m_position;
+	Vec3 const& pointB = mesh.m_vertexes[mesh.m_indexes[3 * triangleIndex + 1]].m_position;
+	Vec3 const& pointC = mesh.m_vertexes[mesh.m_indexes[3 * triangleIndex + 2]].m_position;
+	MeshBVHTriangle triangle;
+	triangle.m_pointA = pointA;
+	triangle.m_edgeAB = pointB - pointA;
+	triangle.m_edgeAC = pointC - pointA;
+	return triangle;
+}
+
+static AABB3 GetBVHTriangleBounds(MeshBVHTriangle const& triangle)
+{
+	AABB3 bounds = AABB3(triangle.m_pointA, triangle.m_pointA);
+	GrowBounds(bounds, triangle.m_pointA + triangle.m_edgeAB);
+	GrowBounds(bounds, triangle.m_pointA + triangle.m_edgeAC);
+	return bounds;
+}
+
+static Triangle3 GetTriangle3(MeshBVHTriangle const& triangle)
+{
+	return Triangle3(triangle.m_pointA, triangle.m_pointA + triangle.m_edgeAB, triangle.m_pointA + triangle.m_edgeAC);
+}
+
+//-----------------------------------------------------------------------------------
+// Build
+//
+// The build works on plain float bounds, it grows boxes a few hundred times per triangle. Most
+// nodes are small, so they only bin into as many bins as they have triangles and only those bins
+// get cleared.
+struct MeshBVHBuildBounds
+{
+	float	m_mins[3];
+	float	m_maxs[3];
+};
+
+static inline MeshBVHBuildBounds MakeEmptyBuildBounds()
+{
+	return { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+}
+
+static inline void GrowBuildBounds(MeshBVHBuildBounds& bounds, float const* point)
+{
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		bounds.m_mins[axis] = std::min(bounds.m_mins[axis], point[axis]);
+		bounds.m_maxs[axis] = std::max(bounds.m_maxs[axis], point[axis]);
+	}
+}
+
+static inline void GrowBuildBounds(MeshBVHBuildBounds& bounds, MeshBVHBuildBounds const& other)
+{
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		bounds.m_mins[axis] = std::min(bounds.m_mins[axis], other.m_mins[axis]);
+		bounds.m_maxs[axis] = std::max(bounds.m_maxs[axis], other.m_maxs[axis]);
+	}
+}
+
+// Half the surface area is enough to compare SAH costs, empty bounds cost nothing
+static inline float GetHalfSurfaceArea(MeshBVHBuildBounds const& bounds)
+{
+	float dimensionX = bounds.m_maxs[0] - bounds.m_mins[0];
+	float dimensionY = bounds.m_maxs[1] - bounds.m_mins[1];
+	float dimensionZ = bounds.m_maxs[2] - bounds.m_mins[2];
+	if (dimensionX < 0.f || dimensionY < 0.f || dimensionZ < 0.f)
+	{
+		return 0.f;
+	}
+	return dimensionX * dimensionY + dimensionY * dimensionZ + dimensionZ * dimensionX;
+}
+
+struct MeshBVHBuildTriangle
+{
+	MeshBVHBuildBounds	m_bounds = MakeEmptyBuildBounds();
+	float				m_centroid[3] = {};		// Of the bounds
+};
+
+struct MeshBVHBuildContext
+{
+	std::vector<MeshBVHBuildTriangle>	m_triangles;		// By mesh triangle
+	int*								m_triangleIndexes = nullptr;
+	JobSystem*							m_jobSystem = nullptr;
+};
+
+struct MeshBVHRangeBounds
+{
+	MeshBVHBuildBounds	m_bounds = MakeEmptyBuildBounds();
+	MeshBVHBuildBounds	m_centroidBounds = MakeEmptyBuildBounds();
+};
+
+struct MeshBVHBin
+{
+	MeshBVHBuildBounds	m_bounds;
+	int					m_numTriangles;
+};
+
+struct MeshBVHBinning
+{
+	int				m_numBins = 0;
+	float			m_centroidMins[3] = {};
+	float			m_binsPerUnit[3] = {};				// 0 on axes where every centroid is the same
+	MeshBVHBin		m_bins[3][MESH_BVH_NUM_BINS];		// Only the first m_numBins of each axis are cleared and used
+};
+
+struct MeshBVHNodeSplit
+{
+	MeshBVHBuildBounds	m_bounds = MakeEmptyBuildBounds();
+	int					m_splitIndex = -1;		// Triangles [begin, split) go to the first child, -1 for a leaf
+};
+
+static MeshBVHRangeBounds GetRangeBounds(MeshBVHBuildContext const& context, int begin, int end, bool isParallel)
+{
+	auto growRange = [&context](int rangeBegin, int rangeEnd, MeshBVHRangeBounds partial)
+	{
+		for (int index = rangeBegin; index < rangeEnd; ++index)
+		{
+			MeshBVHBuildTriangle const& triangle = context.m_triangles[context.m_triangleIndexes[index]];
+			GrowBuildBounds(partial.m_bounds, triangle.m_bounds);
+			GrowBuildBounds(partial.m_centroidBounds, triangle.m_centroid);
+		}
+		return partial;
+	};
+	if (!isParallel)
+	{
+		return growRange(begin, end, MeshBVHRangeBounds());
+	}
+	return ParallelReduce(context.m_jobSystem, begin, end, 0, MeshBVHRangeBounds(), growRange, [](MeshBVHRangeBounds lhs, MeshBVHRangeBounds const& rhs)
+	{
+		GrowBuildBounds(lhs.m_bounds, rhs.m_bounds);
+		GrowBuildBounds(lhs.m_centroidBounds, rhs.m_centroidBounds);
+		return lhs;
+	});
+}
+
+static MeshBVHBinning MakeEmptyBinning(int numBins, MeshBVHBuildBounds const& centroidBounds)
+{
+	MeshBVHBinning binning;
+	binning.m_numBins = numBins;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		float extent = centroidBounds.m_maxs[axis] - centroidBounds.m_mins[axis];
+		binning.m_centroidMins[axis] = centroidBounds.m_mins[axis];
+		binning.m_binsPerUnit[axis] = extent > 0.f ? (float)numBins / extent : 0.f;
+		for (int binIndex = 0; binIndex < numBins; ++binIndex)
+		{
+			binning.m_bins[axis][binIndex].m_bounds = MakeEmptyBuildBounds();
+			binning.m_bins[axis][binIndex].m_numTriangles = 0;
+		}
+	}
+	return binning;
+}
+
+static inline int GetBinIndex(MeshBVHBinning const& binning, int axis, float centroid)
+{
+	int binIndex = (int)((centroid - binning.m_centroidMins[axis]) * binning.m_binsPerUnit[axis]);
+	return std::min(std::max(binIndex, 0), binning.m_numBins - 1);
+}
+
+static void BinTriangleRange(MeshBVHBuildContext const& context, int begin, int end, MeshBVHBinning& binning)
+{
+	for (int index = begin; index < end; ++index)
+	{
+		MeshBVHBuildTriangle const& triangle = context.m_triangles[context.m_triangleIndexes[index]];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			MeshBVHBin& bin = binning.m_bins[axis][GetBinIndex(binning, axis, triangle.m_centroid[axis])];
+			GrowBuildBounds(bin.m_bounds, triangle.m_bounds);
+			bin.m_numTriangles++;
+		}
+	}
+}
+
+static MeshBVHBinning BinTriangles(MeshBVHBuildContext const& context, int begin, int end, MeshBVHBuildBounds const& centroidBounds, bool isParallel)
+{
+	int numBins = std::min(MESH_BVH_NUM_BINS, end - begin);
+	MeshBVHBinning binning = MakeEmptyBinning(numBins, centroidBounds);
+	if (!isParallel)
+	{
+		BinTriangleRange(context, begin, end, binning);
+		return binning;
+	}
+
+	return ParallelReduce(context.m_jobSystem, begin, end, 0, binning, [&context](int rangeBegin, int rangeEnd, MeshBVHBinning partial)
+	{
+		BinTriangleRange(context, rangeBegin, rangeEnd, partial);
+		return partial;
+	},
+	[](MeshBVHBinning lhs, MeshBVHBinning const& rhs)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			for (int binIndex = 0; binIndex < lhs.m_numBins; ++binIndex)
+			{
+				GrowBuildBounds(lhs.m_bins[axis][binIndex].m_bounds, rhs.m_bins[axis][binIndex].m_bounds);
+				lhs.m_bins[axis][binIndex].m_numTriangles += rhs.m_bins[axis][binIndex].m_numTriangles;
+			}
+		}
+		return lhs;
+	});
+}
+
+static int SplitAtCentroidMedian(MeshBVHBuildContext const& context, int begin, int end, MeshBVHBuildBounds const& centroidBounds)
+{
+	int axis = 0;
+	for (int otherAxis = 1; otherAxis < 3; ++otherAxis)
+	{
+		if (centroidBounds.m_maxs[otherAxis] - centroidBounds.m_mins[otherAxis] > centroidBounds.m_maxs[axis] - centroidBounds.m_mins[axis])
+		{
+			axis = otherAxis;
+		}
+	}
+	int middle = begin + (end - begin) / 2;
+	std::nth_element(context.m_triangleIndexes + begin, context.m_triangleIndexes + middle, context.m_triangleIndexes + end, [&context, axis](int lhs, int rhs)
+	{
+		return context.m_triangles[lhs].m_centroid[axis] < context.m_triangles[rhs].m_centroid[axis];
+	});
+	return middle;
+}
+
+// Finds the bounds of the node holding triangles [begin, end) and where to split it, partitioning the
+// triangle indexes so the first child's triangles come first
+static MeshBVHNodeSplit FindNodeSplit(MeshBVHBuildContext const& context, int begin, int end, int depth)
+{
+	int numTriangles = end - begin;
+	bool isParallel = context.m_jobSystem != nullptr && numTriangles >= MIN_TRIANGLES_FOR_PARALLEL_BINNING;
+	MeshBVHRangeBounds rangeBounds = GetRangeBounds(context, begin, end, isParallel);
+
+	MeshBVHNodeSplit split;
+	split.m_bounds = rangeBounds.m_bounds;
+	if (numTriangles <= 1)
+	{
+		return split;
+	}
+
+	if (depth >= MESH_BVH_MAX_SAH_DEPTH)
+	{
+		split.m_splitIndex = SplitAtCentroidMedian(context, begin, end, rangeBounds.m_centroidBounds);
+		return split;
+	}
+
+	MeshBVHBinning binning = BinTriangles(context, begin, end, rangeBounds.m_centroidBounds, isParallel);
+	int numBins = binning.m_numBins;
+
+	// Sweep the bins from both ends, a split after bin n costs area * count of both sides
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	int bestBin = -1;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (binning.m_binsPerUnit[axis] == 0.f)
+		{
+			continue;
+		}
+
+		float secondSideCosts[MESH_BVH_NUM_BINS];
+		MeshBVHBuildBounds secondSideBounds = MakeEmptyBuildBounds();
+		int secondSideCount = 0;
+		for (int binIndex = numBins - 1; binIndex > 0; --binIndex)
+		{
+			GrowBuildBounds(secondSideBounds, binning.m_bins[axis][binIndex].m_bounds);
+			secondSideCount += binning.m_bins[axis][binIndex].m_numTriangles;
+			secondSideCosts[binIndex] = secondSideCount > 0 ? GetHalfSurfaceArea(secondSideBounds) * (float)secondSideCount : -1.f;
+		}
+
+		MeshBVHBuildBounds firstSideBounds = MakeEmptyBuildBounds();
+		int firstSideCount = 0;
+		for (int binIndex = 0; binIndex < numBins - 1; ++binIndex)
+		{
+			GrowBuildBounds(firstSideBounds, binning.m_bins[axis][binIndex].m_bounds);
+			firstSideCount += binning.m_bins[axis][binIndex].m_numTriangles;
+			if (firstSideCount == 0 || secondSideCosts[binIndex + 1] < 0.f)
+			{
+				continue;
+			}
+
+			float cost = GetHalfSurfaceArea(firstSideBounds) * (float)firstSideCount + secondSideCosts[binIndex + 1];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = binIndex;
+			}
+		}
+	}
+
+	float nodeArea = GetHalfSurfaceArea(rangeBounds.m_bounds);
+	float splitCost = nodeArea > 0.f ? MESH_BVH_TRAVERSAL_COST + bestCost / nodeArea : FLT_MAX;
+	if (bestAxis < 0 || splitCost >= (float)numTriangles)
+	{
+		if (numTriangles > MESH_BVH_MAX_LEAF_TRIANGLES)
+		{
+			split.m_splitIndex = SplitAtCentroidMedian(context, begin, end, rangeBounds.m_centroidBounds);
+		}
+		return split;
+	}
+
+	int* splitPosition = std::partition(context.m_triangleIndexes + begin, context.m_triangleIndexes + end, [&](int triangleIndex)
+	{
+		return GetBinIndex(binning, bestAxis, context.m_triangles[triangleIndex].m_centroid[bestAxis]) <= bestBin;
+	});
+	split.m_splitIndex = (int)(splitPosition - context.m_triangleIndexes);
+	return split;
+}
+
+static MeshBVHNode MakeNode(MeshBVHBuildBounds const& bounds)
+{
+	MeshBVHNode node;
+	node.m_boundsMins = Vec3(bounds.m_mins[0], bounds.m_mins[1], bounds.m_mins[2]);
+	node.m_boundsMaxs = Vec3(bounds.m_maxs[0], bounds.m_maxs[1], bounds.m_maxs[2]);
+	return node;
+}
+
+// Appends the subtree depth first, second child indexes are relative to the start of out_nodes
+static void BuildSubtree(MeshBVHBuildContext const& context, int begin, int end, int depth, std::vector<MeshBVHNode>& out_nodes)
+{
+	MeshBVHNodeSplit split = FindNodeSplit(context, begin, end, depth);
+	int nodeIndex = (int)out_nodes.size();
+	out_nodes.push_back(MakeNode(split.m_bounds));
+	if (split.m_splitIndex < 0)
+	{
+		out_nodes[nodeIndex].m_firstTriangleOrSecondChild = begin;
+		out_nodes[nodeIndex].m_numTriangles = end - begin;
+		return;
+	}
+
+	BuildSubtree(context, begin, split.m_splitIndex, depth + 1, out_nodes);
+	out_nodes[nodeIndex].m_firstTriangleOrSecondChild = (int)out_nodes.size();
+	BuildSubtree(context, split.m_splitIndex, end, depth + 1, out_nodes);
+}
+
+// Nodes above the subtrees, split on the calling thread before the subtrees get built in parallel
+struct MeshBVHTopNode
+{
+	MeshBVHBuildBounds	m_bounds = MakeEmptyBuildBounds();
+	int					m_firstChild = -1;
+	int					m_secondChild = -1;
+	int					m_subtreeIndex = -1;	// Whole subtree built by one job instead of children
+};
+
+struct MeshBVHSubtree
+{
+	int							m_begin = 0;
+	int							m_end = 0;
+	int							m_depth = 0;
+	std::vector<MeshBVHNode>	m_nodes;
+};
+
+static int SplitTopNodes(MeshBVHBuildContext const& context, int begin, int end, int depth, int maxSubtreeTriangles,
+	std::vector<MeshBVHTopNode>& out_topNodes, std::vector<MeshBVHSubtree>& out_subtrees)
+{
+	int topNodeIndex = (int)out_topNodes.size();
+	out_topNodes.emplace_back();
+
+	MeshBVHNodeSplit split;
+	if (end - begin > maxSubtreeTriangles)
+	{
+		split = FindNodeSplit(context, begin, end, depth);
+	}
+
+	if (split.m_splitIndex < 0)
+	{
+		// Small enough for one job, or a leaf which the job finds again
+		out_topNodes[topNodeIndex].m_subtreeIndex = (int)out_subtrees.size();
+		MeshBVHSubtree subtree;
+		subtree.m_begin = begin;
+		subtree.m_end = end;
+		subtree.m_depth = depth;
+		out_subtrees.push_back(subtree);
+		return topNodeIndex;
+	}
+
+	out_topNodes[topNodeIndex].m_bounds = split.m_bounds;
+	int firstChild = SplitTopNodes(context, begin, split.m_splitIndex, depth + 1, maxSubtreeTriangles, out_topNodes, out_subtrees);
+	int secondChild = SplitTopNodes(context, split.m_splitIndex, end, depth + 1, maxSubtreeTriangles, out_topNodes, out_subtrees);
+	out_topNodes[topNodeIndex].m_firstChild = firstChild;
+	out_topNodes[topNodeIndex].m_secondChild = secondChild;
+	return topNodeIndex;
+}
+
+static void StitchNodes(std::vector<MeshBVHTopNode> const& topNodes, std::vector<MeshBVHSubtree> const& subtrees, int topNodeIndex, std::vector<MeshBVHNode>& out_nodes)
+{
+	MeshBVHTopNode const& topNode = topNodes[topNodeIndex];
+	if (topNode.m_subtreeIndex >= 0)
+	{
+		int offset = (int)out_nodes.size();
+		for (MeshBVHNode node : subtrees[topNode.m_subtreeIndex].m_nodes)
+		{
+			if (!node.IsLeaf())
+			{
+				node.m_firstTriangleOrSecondChild += offset;
+			}
+			out_nodes.push_back(node);
+		}
+		return;
+	}
+
+	int nodeIndex = (int)out_nodes.size();
+	out_nodes.push_back(MakeNode(topNode.m_bounds));
+	StitchNodes(topNodes, subtrees, topNode.m_firstChild, out_nodes);
+	out_nodes[nodeIndex].m_firstTriangleOrSecondChild = (int)out_nodes.size();
+	StitchNodes(topNodes, subtrees, topNode.m_secondChild, out_nodes);
+}
+
+//-----------------------------------------------------------------------------------
+MeshBVH::MeshBVH(CPUMesh const& mesh)
+{
+	Build(mesh);
+}
+
+void MeshBVH::Build(CPUMesh const& mesh)
+{
+	Build(mesh, g_theJobSystem);
+}
+
+void MeshBVH::Build(CPUMesh const& mesh, JobSystem* jobSystem)
+{
+	GUARANTEE_OR_DIE(mesh.m_indexes.size() % 3 == 0, "MeshBVH::Build needs a triangle list, the index count is not a multiple of 3");
+	Clear();
+	int numTriangles = (int)(mesh.m_indexes.size() / 3);
+	if (numTriangles == 0)
+	{
+		return;
+	}
+
+	MeshBVHBuildContext context;
+	context.m_jobSystem = jobSystem;
+	context.m_triangles.resize((size_t)numTriangles);
+	m_triangleIndexes.resize((size_t)numTriangles);
+	context.m_triangleIndexes = m_triangleIndexes.data();
+	ParallelForRange(jobSystem, 0, numTriangles, TRIANGLES_PER_PREPARE_CHUNK, [&](int rangeBegin, int rangeEnd)
+	{
+		for (int triangleIndex = rangeBegin; triangleIndex < rangeEnd; ++triangleIndex)
+		{
+			AABB3 bounds = GetBVHTriangleBounds(MakeBVHTriangle(mesh, triangleIndex));
+			MeshBVHBuildTriangle& buildTriangle = context.m_triangles[triangleIndex];
+			buildTriangle.m_bounds = { { bounds.m_mins.x, bounds.m_mins.y, bounds.m_mins.z }, { bounds.m_maxs.x, bounds.m_maxs.y, bounds.m_maxs.z } };
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				buildTriangle.m_centroid[axis] = 0.5f * (buildTriangle.m_bounds.m_mins[axis] + buildTriangle.m_bounds.m_maxs[axis]);
+			}
+			m_triangleIndexes[triangleIndex] = triangleIndex;
+		}
+	});
+
+	int numThreads = (jobSystem ? jobSystem->GetNumWorkers() : 0) + 1;
+	int maxSubtreeTriangles = numTriangles;
+	if (numThreads > 1)
+	{
+		maxSubtreeTriangles = std::max(MIN_TRIANGLES_PER_SUBTREE_JOB, numTriangles / (numThreads * SUBTREE_JOBS_PER_THREAD));
+	}
+
+	std::vector<MeshBVHTopNode> topNodes;
+	std::vector<MeshBVHSubtree> subtrees;
+	SplitTopNodes(context, 0, numTriangles, 0, maxSubtreeTriangles, topNodes, subtrees);
+	ParallelFor(jobSystem, 0, (int)subtrees.size(), 1, [&](int subtreeIndex)
+	{
+		MeshBVHSubtree& subtree = subtrees[subtreeIndex];
+		subtree.m_nodes.reserve((size_t)(2 * (subtree.m_end - subtree.m_begin)));
+		BuildSubtree(context, subtree.m_begin, subtree.m_end, subtree.m_depth, subtree.m_nodes);
+	});
+
+	m_nodes.reserve((size_t)(2 * numTriangles));
+	StitchNodes(topNodes, subtrees, 0, m_nodes);
+	m_nodes.shrink_to_fit();
+
+	m_triangles.resize((size_t)numTriangles);
+	ParallelForRange(jobSystem, 0, numTriangles, TRIANGLES_PER_PREPARE_CHUNK, [&](int rangeBegin, int rangeEnd)
+	{
+		for (int leafTriangle = rangeBegin; leafTriangle < rangeEnd; ++leafTriangle)
+		{
+			m_triangles[leafTriangle] = MakeBVHTriangle(mesh, m_triangleIndexes[leafTriangle]);
+		}
+	});
+}
+
+void MeshBVH::Clear()
+{
+	m_nodes.clear();
+	m_triangles.clear();
+	m_triangleIndexes.clear();
+}
+
+void MeshBVH::Refit(CPUMesh const& mesh)
+{
+	GUARANTEE_OR_DIE(mesh.m_indexes.size() == m_triangles.size() * 3, "MeshBVH::Refit needs the indexes the tree was built from");
+	int numTriangles = (int)m_triangles.size();
+	ParallelForRange(0, numTriangles, TRIANGLES_PER_PREPARE_CHUNK, [&](int rangeBegin, int rangeEnd)
+	{
+		for (int leafTriangle = rangeBegin; leafTriangle < rangeEnd; ++leafTriangle)
+		{
+			m_triangles[leafTriangle] = MakeBVHTriangle(mesh, m_triangleIndexes[leafTriangle]);
+		}
+	});
+
+	// Children always come after their parent, so walking backwards refits them first
+	for (int nodeIndex = (int)m_nodes.size() - 1; nodeIndex >= 0; --nodeIndex)
+	{
+		MeshBVHNode& node = m_nodes[nodeIndex];
+		AABB3 bounds = MakeEmptyBounds();
+		if (node.IsLeaf())
+		{
+			for (int leafTriangle = node.m_firstTriangleOrSecondChild; leafTriangle < node.m_firstTriangleOrSecondChild + node.m_numTriangles; ++leafTriangle)
+			{
+				GrowBounds(bounds, GetBVHTriangleBounds(m_triangles[leafTriangle]));
+			}
+		}
+		else
+		{
+			MeshBVHNode const& firstChild = m_nodes[nodeIndex + 1];
+			MeshBVHNode const& secondChild = m_nodes[node.m_firstTriangleOrSecondChild];
+			GrowBounds(bounds, AABB3(firstChild.m_boundsMins, firstChild.m_boundsMaxs));
+			GrowBounds(bounds, AABB3(secondChild.m_boundsMins, secondChild.m_boundsMaxs));
+		}
+		node.m_boundsMins = bounds.m_mins;
+		node.m_boundsMaxs = bounds.m_maxs;
+	}
+}
+
+AABB3 MeshBVH::GetBounds() const
+{
+	if (m_nodes.empty())
+	{
+		return AABB3(0.f, 0.f, 0.f, 0.f, 0.f, 0.f);
+	}
+	return AABB3(m_nodes[0].m_boundsMins, m_nodes[0].m_boundsMaxs);
+}
+
+//-----------------------------------------------------------------------------------
+// Queries
+//
+struct MeshBVHRay
+{
+	Vec3	m_start;
+	Vec3	m_forward;
+	Vec3	m_oneOverForward;
+	bool	m_isAxisAligned = false;		// A zero forward component, its slabs need care
+};
+
+static MeshBVHRay MakeBVHRay(Vec3 const& rayStart, Vec3 const& rayForwardNormal)
+{
+	MeshBVHRay ray;
+	ray.m_start = rayStart;
+	ray.m_forward = rayForwardNormal;
+	// Infinite for axis aligned rays, the slab test checks for a zero component before using it
+	ray.m_oneOverForward = Vec3(1.f / rayForwardNormal.x, 1.f / rayForwardNormal.y, 1.f / rayForwardNormal.z);
+	ray.m_isAxisAligned = rayForwardNormal.x == 0.f || rayForwardNormal.y == 0.f || rayForwardNormal.z == 0.f;
+	return ray;
+}
+
+// Narrows [enter, exit] to one slab. A ray parallel to the slab would get 0 * inf = NaN when it
+// starts on a face, so it keeps the whole slab when the start is between the faces, faces included,
+// and misses otherwise.
+static bool ClipRayToSlab(float start, float forward, float oneOverForward, float mins, float maxs, float& inout_enterDistance, float& inout_exitDistance)
+{
+	if (forward == 0.f)
+	{
+		return start >= mins && start <= maxs;
+	}
+	float minsDistance = (mins - start) * oneOverForward;
+	float maxsDistance = (maxs - start) * oneOverForward;
+	inout_enterDistance = std::max(inout_enterDistance, std::min(minsDistance, maxsDistance));
+	inout_exitDistance = std::min(inout_exitDistance, std::max(minsDistance, maxsDistance));
+	return true;
+}
+
+// Slab test, out_enterDistance is 0 when the ray starts inside. Axis aligned rays take the slower
+// path that never divides by their zero components, the others can't make a NaN.
+static bool RaycastVsNodeBounds(MeshBVHRay const& ray, MeshBVHNode const& node, float maxDistance, float& out_enterDistance)
+{
+	float enterDistance = 0.f;
+	float exitDistance = maxDistance;
+	if (ray.m_isAxisAligned)
+	{
+		if (!ClipRayToSlab(ray.m_start.x, ray.m_forward.x, ray.m_oneOverForward.x, node.m_boundsMins.x, node.m_boundsMaxs.x, enterDistance, exitDistance) ||
+			!ClipRayToSlab(ray.m_start.y, ray.m_forward.y, ray.m_oneOverForward.y, node.m_boundsMins.y, node.m_boundsMaxs.y, enterDistance, exitDistance) ||
+			!ClipRayToSlab(ray.m_start.z, ray.m_forward.z, ray.m_oneOverForward.z, node.m_boundsMins.z, node.m_boundsMaxs.z, enterDistance, exitDistance))
+		{
+			return false;
+		}
+		out_enterDistance = enterDistance;
+		return enterDistance <= exitDistance;
+	}
+
+	float minX = (node.m_boundsMins.x - ray.m_start.x) * ray.m_oneOverForward.x;
+	float maxX = (node.m_boundsMaxs.x - ray.m_start.x) * ray.m_oneOverForward.x;
+	float minY = (node.m_boundsMins.y - ray.m_start.y) * ray.m_oneOverForward.y;
+	float maxY = (node.m_boundsMaxs.y - ray.m_start.y) * ray.m_oneOverForward.y;
+	float minZ = (node.m_boundsMins.z - ray.m_start.z) * ray.m_oneOverForward.z;
+	float maxZ = (node.m_boundsMaxs.z - ray.m_start.z) * ray.m_oneOverForward.z;
+	enterDistance = std::max(std::max(std::min(minX, maxX), std::min(minY, maxY)), std::max(std::min(minZ, maxZ), enterDistance));
+	exitDistance = std::min(std::min(std::max(minX, maxX), std::max(minY, maxY)), std::min(std::max(minZ, maxZ), exitDistance));
+	out_enterDistance = enterDistance;
+	return enterDistance <= exitDistance;
+}
+
+// Moller-Trumbore, the scalar twin of the RaycastPacketUtils triangle kernel
+static bool RaycastVsBVHTriangle(MeshBVHRay const& ray, MeshBVHTriangle const& triangle, float maxDistance, bool doubleSided, float& out_impactDistance)
+{
+	Vec3 p = CrossProduct3D(ray.m_forward, triangle.m_edgeAC);
+	float determinant = DotProduct3D(triangle.m_edgeAB, p);
+	bool isFacing = doubleSided ? (determinant > 1e-8f || determinant < -1e-8f) : (determinant > 1e-8f);
+	if (!isFacing)
+	{
+		return false;
+	}
+
+	float oneOverDeterminant = 1.f / determinant;
+	Vec3 aToStart = ray.m_start - triangle.m_pointA;
+	float u = DotProduct3D(aToStart, p) * oneOverDeterminant;
+	if (u < 0.f || u > 1.f)
+	{
+		return false;
+	}
+
+	Vec3 q = CrossProduct3D(aToStart, triangle.m_edgeAB);
+	float v = DotProduct3D(ray.m_forward, q) * oneOverDeterminant;
+	if (v < 0.f || u + v > 1.f)
+	{
+		return false;
+	}
+
+	float impactDistance = DotProduct3D(triangle.m_edgeAC, q) * oneOverDeterminant;
+	if (impactDistance < 0.f || impactDistance > maxDistance)
+	{
+		return false;
+	}
+	out_impactDistance = impactDistance;
+	return true;
+}
+
+static RaycastResult3D MakeTriangleRaycastResult(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, MeshBVHTriangle const* triangle, float impactDistance)
+{
+	RaycastResult3D result;
+	result.m_rayStartPostion = rayStart;
+	result.m_rayDirection = rayForwardNormal;
+	result.m_rayLength = rayLength;
+	if (triangle == nullptr)
+	{
+		return result;
+	}
+
+	result.m_didImpact = true;
+	result.m_impactDistance = impactDistance;
+	result.m_impactPosition = rayStart + rayForwardNormal * impactDistance;
+	result.m_impactNormal = CrossProduct3D(triangle->m_edgeAB, triangle->m_edgeAC).GetNormalized();
+	if (DotProduct3D(result.m_impactNormal, rayForwardNormal) > 0.f)
+	{
+		result.m_impactNormal *= -1.f;
+	}
+	return result;
+}
+
+RaycastResult3D MeshBVH::Raycast(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, bool doubleSided, int* out_triangleIndex) const
+{
+	MeshBVHRay ray = MakeBVHRay(rayStart, rayForwardNormal);
+	float closestDistance = rayLength;
+	int closestTriangle = -1;
+
+	// Far children wait on the stack with their enter distance, so they are skipped once a closer hit is found
+	int stackNodes[MESH_BVH_MAX_DEPTH];
+	float stackDistances[MESH_BVH_MAX_DEPTH];
+	int stackSize = 0;
+
+	float enterDistance = 0.f;
+	int nodeIndex = (!m_nodes.empty() && RaycastVsNodeBounds(ray, m_nodes[0], closestDistance, enterDistance)) ? 0 : -1;
+	while (nodeIndex >= 0)
+	{
+		MeshBVHNode const& node = m_nodes[nodeIndex];
+		if (node.IsLeaf())
+		{
+			for (int leafTriangle = node.m_firstTriangleOrSecondChild; leafTriangle < node.m_firstTriangleOrSecondChild + node.m_numTriangles; ++leafTriangle)
+			{
+				float impactDistance = 0.f;
+				if (RaycastVsBVHTriangle(ray, m_triangles[leafTriangle], closestDistance, doubleSided, impactDistance))
+				{
+					closestDistance = impactDistance;
+					closestTriangle = leafTriangle;
+				}
+			}
+			nodeIndex = -1;
+		}
+		else
+		{
+			float firstDistance = 0.f;
+			float secondDistance = 0.f;
+			bool hitsFirst = RaycastVsNodeBounds(ray, m_nodes[nodeIndex + 1], closestDistance, firstDistance);
+			bool hitsSecond = RaycastVsNodeBounds(ray, m_nodes[node.m_firstTriangleOrSecondChild], closestDistance, secondDistance);
+			if (hitsFirst && hitsSecond)
+			{
+				bool isSecondNearer = secondDistance < firstDistance;
+				stackNodes[stackSize] = isSecondNearer ? nodeIndex + 1 : node.m_firstTriangleOrSecondChild;
+				stackDistances[stackSize] = isSecondNearer ? firstDistance : secondDistance;
+				stackSize++;
+				nodeIndex = isSecondNearer ? node.m_firstTriangleOrSecondChild : nodeIndex + 1;
+				continue;
+			}
+			nodeIndex = hitsFirst ? nodeIndex + 1 : (hitsSecond ? node.m_firstTriangleOrSecondChild : -1);
+		}
+
+		while (nodeIndex < 0 && stackSize > 0)
+		{
+			stackSize--;
+			if (stackDistances[stackSize] <= closestDistance)
+			{
+				nodeIndex = stackNodes[stackSize];
+			}
+		}
+	}
+
+	if (out_triangleIndex)
+	{
+		*out_triangleIndex = closestTriangle >= 0 ? m_triangleIndexes[closestTriangle] : -1;
+	}
+	return MakeTriangleRaycastResult(rayStart, rayForwardNormal, rayLength, closestTriangle >= 0 ? &m_triangles[closestTriangle] : nullptr, closestDistance);
+}
+
+bool MeshBVH::RaycastAny(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, bool doubleSided) const
+{
+	if (m_nodes.empty())
+	{
+		return false;
+	}
+
+	MeshBVHRay ray = MakeBVHRay(rayStart, rayForwardNormal);
+	int stackNodes[MESH_BVH_MAX_DEPTH];
+	int stackSize = 0;
+	stackNodes[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		MeshBVHNode const& node = m_nodes[stackNodes[--stackSize]];
+		float enterDistance = 0.f;
+		if (!RaycastVsNodeBounds(ray, node, rayLength, enterDistance))
+		{
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			for (int leafTriangle = node.m_firstTriangleOrSecondChild; leafTriangle < node.m_firstTriangleOrSecondChild + node.m_numTriangles; ++leafTriangle)
+			{
+				float impactDistance = 0.f;
+				if (RaycastVsBVHTriangle(ray, m_triangles[leafTriangle], rayLength, doubleSided, impactDistance))
+				{
+					return true;
+				}
+			}
+		}
+		else
+		{
+			stackNodes[stackSize++] = node.m_firstTriangleOrSecondChild;
+			stackNodes[stackSize++] = (int)(&node - m_nodes.data()) + 1;
+		}
+	}
+	return false;
+}
+
+// Visits every leaf triangle whose node bounds pass nodeTest, leaf order
+template<typename NodeTest, typename TriangleVisitor>
+static void ForEachTriangleInOverlappingNodes(std::vector<MeshBVHNode> const& nodes, NodeTest const& nodeTest, TriangleVisitor const& visitTriangle)
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	int stackNodes[MESH_BVH_MAX_DEPTH];
+	int stackSize = 0;
+	stackNodes[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		int nodeIndex = stackNodes[--stackSize];
+		MeshBVHNode const& node = nodes[nodeIndex];
+		if (!nodeTest(AABB3(node.m_boundsMins, node.m_boundsMaxs)))
+		{
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			for (int leafTriangle = node.m_firstTriangleOrSecondChild; leafTriangle < node.m_firstTriangleOrSecondChild + node.m_numTriangles; ++leafTriangle)
+			{
+				visitTriangle(leafTriangle);
+			}
+		}
+		else
+		{
+			stackNodes[stackSize++] = node.m_firstTriangleOrSecondChild;
+			stackNodes[stackSize++] = nodeIndex + 1;
+		}
+	}
+}
+
+int MeshBVH::GetTrianglesOverlappingAABB3(AABB3 const& box, std::vector<int>& out_triangleIndexes) const
+{
+	size_t numIndexesBefore = out_triangleIndexes.size();
+	Vec3 halfDimensions = box.GetDimensions() * 0.5f;
+	OBB3 boxAsOBB = OBB3(box.GetCenter(), Vec3(1.f, 0.f, 0.f), Vec3(0.f, 1.f, 0.f), Vec3(0.f, 0.f, 1.f), halfDimensions);
+	ForEachTriangleInOverlappingNodes(m_nodes, [&box](AABB3 const& nodeBounds)
+	{
+		return DoAABBsOverlap3D(box, nodeBounds);
+	},
+	[&](int leafTriangle)
+	{
+		MeshBVHTriangle const& triangle = m_triangles[leafTriangle];
+		if (DoAABBsOverlap3D(box, GetBVHTriangleBounds(triangle)) && DoOBBAndTriangleOverlap3D(boxAsOBB, GetTriangle3(triangle)))
+		{
+			out_triangleIndexes.push_back(m_triangleIndexes[leafTriangle]);
+		}
+	});
+	return (int)(out_triangleIndexes.size() - numIndexesBefore);
+}
+
+int MeshBVH::GetTrianglesOverlappingSphere(Vec3 const& sphereCenter, float sphereRadius, std::vector<int>& out_triangleIndexes) const
+{
+	size_t numIndexesBefore = out_triangleIndexes.size();
+	float sphereRadiusSquared = sphereRadius * sphereRadius;
+	ForEachTriangleInOverlappingNodes(m_nodes, [&](AABB3 const& nodeBounds)
+	{
+		return GetDistanceSquared3D(GetNearestPointOnAABB3D(sphereCenter, nodeBounds), sphereCenter) <= sphereRadiusSquared;
+	},
+	[&](int leafTriangle)
+	{
+		Vec3 nearestPoint = GetNearestPointOnTriangle3D(sphereCenter, GetTriangle3(m_triangles[leafTriangle]));
+		if (GetDistanceSquared3D(nearestPoint, sphereCenter) <= sphereRadiusSquared)
+		{
+			out_triangleIndexes.push_back(m_triangleIndexes[leafTriangle]);
+		}
+	});
+	return (int)(out_triangleIndexes.size() - numIndexesBefore);
+}
+
+//-----------------------------------------------------------------------------------
+// Benchmark
+//
+template<typename Work>
+static double TimeSeconds(Work const& work)
+{
+	double startSeconds = GetCurrentTimeSeconds();
+	work();
+	return GetCurrentTimeSeconds() - startSeconds;
+}
+
+static float GetBenchmarkHeight(float x, float y, float phase)
+{
+	return 2.f * sinf(0.31f * x + phase) * cosf(0.27f * y) + 0.5f * sinf(1.7f * x + 1.3f * y - phase);
+}
+
+static void MakeBenchmarkHeightField(int gridSize, float phase, CPUMesh& out_mesh)
+{
+	out_mesh.m_vertexes.resize((size_t)((gridSize + 1) * (gridSize + 1)));
+	for (int y = 0; y <= gridSize; ++y)
+	{
+		for (int x = 0; x <= gridSize; ++x)
+		{
+			out_mesh.m_vertexes[y * (gridSize + 1) + x].m_position = Vec3((float)x, (float)y, GetBenchmarkHeight((float)x, (float)y, phase));
+		}
+	}
+
+	if (!out_mesh.m_indexes.empty())
+	{
+		return;
+	}
+	out_mesh.m_indexes.reserve((size_t)(6 * gridSize * gridSize));
+	for (int y = 0; y < gridSize; ++y)
+	{
+		for (int x = 0; x < gridSize; ++x)
+		{
+			unsigned int bottomLeft = (unsigned int)(y * (gridSize + 1) + x);
+			unsigned int topLeft = bottomLeft + (unsigned int)(gridSize + 1);
+			out_mesh.m_indexes.insert(out_mesh.m_indexes.end(), { bottomLeft, bottomLeft + 1, topLeft + 1, bottomLeft, topLeft + 1, topLeft });
+		}
+	}
+}
+
+static float RaycastEveryTriangle(CPUMesh const& mesh, Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength)
+{
+	MeshBVHRay ray = MakeBVHRay(rayStart, rayForwardNormal);
+	float closestDistance = rayLength;
+	bool didImpact = false;
+	int numTriangles = (int)(mesh.m_indexes.size() / 3);
+	for (int triangleIndex = 0; triangleIndex < numTriangles; ++triangleIndex)
+	{
+		float impactDistance = 0.f;
+		if (RaycastVsBVHTriangle(ray, MakeBVHTriangle(mesh, triangleIndex), closestDistance, true, impactDistance))
+		{
+			closestDistance = impactDistance;
+			didImpact = true;
+		}
+	}
+	return didImpact ? closestDistance : -1.f;
+}
+
+static int CountMismatches(MeshBVH const& bvh, CPUMesh const& mesh, std::vector<Vec3> const& starts, std::vector<Vec3> const& forwards, float rayLength, RandomNumberGenerator& rng, int gridSize)
+{
+	int numMismatches = 0;
+	for (int rayIndex = 0; rayIndex < (int)starts.size(); ++rayIndex)
+	{
+		float expectedDistance = RaycastEveryTriangle(mesh, starts[rayIndex], forwards[rayIndex], rayLength);
+		RaycastResult3D result = bvh.Raycast(starts[rayIndex], forwards[rayIndex], rayLength, true);
+		bool isAnyHit = bvh.RaycastAny(starts[rayIndex], forwards[rayIndex], rayLength, true);
+		bool isMatching = result.m_didImpact ? (result.m_impactDistance == expectedDistance) : (expectedDistance < 0.f);
+		if (!isMatching || isAnyHit != result.m_didImpact)
+		{
+			numMismatches++;
+		}
+	}
+
+	int numTriangles = (int)(mesh.m_indexes.size() / 3);
+	std::vector<MeshBVHTriangle> triangles((size_t)numTriangles);
+	for (int triangleIndex = 0; triangleIndex < numTriangles; ++triangleIndex)
+	{
+		triangles[triangleIndex] = MakeBVHTriangle(mesh, triangleIndex);
+	}
+	std::vector<int> found;
+	std::vector<int> expected;
+	for (int queryIndex = 0; queryIndex < 64; ++queryIndex)
+	{
+		Vec3 center(rng.RollRandomFloatInRange(0.f, (float)gridSize), rng.RollRandomFloatInRange(0.f, (float)gridSize), rng.RollRandomFloatInRange(-3.f, 3.f));
+		float size = rng.RollRandomFloatInRange(0.2f, 6.f);
+
+		AABB3 box(center - Vec3(size, size, 0.5f * size), center + Vec3(size, size, 0.5f * size));
+		OBB3 boxAsOBB = OBB3(box.GetCenter(), Vec3(1.f, 0.f, 0.f), Vec3(0.f, 1.f, 0.f), Vec3(0.f, 0.f, 1.f), box.GetDimensions() * 0.5f);
+		found.clear();
+		expected.clear();
+		bvh.GetTrianglesOverlappingAABB3(box, found);
+		for (int triangleIndex = 0; triangleIndex < numTriangles; ++triangleIndex)
+		{
+			if (DoAABBsOverlap3D(box, GetBVHTriangleBounds(triangles[triangleIndex])) && DoOBBAndTriangleOverlap3D(boxAsOBB, GetTriangle3(triangles[triangleIndex])))
+			{
+				expected.push_back(triangleIndex);
+			}
+		}
+		std::sort(found.begin(), found.end());
+		numMismatches += found != expected ? 1 : 0;
+
+		found.clear();
+		expected.clear();
+		bvh.GetTrianglesOverlappingSphere(center, size, found);
+		for (int triangleIndex = 0; triangleIndex < numTriangles; ++triangleIndex)
+		{
+			if (GetDistanceSquared3D(GetNearestPointOnTriangle3D(center, GetTriangle3(triangles[triangleIndex])), center) <= size * size)
+			{
+				expected.push_back(triangleIndex);
+			}
+		}
+		std::sort(found.begin(), found.end());
+		numMismatches += found != expected ? 1 : 0;
+	}
+	return numMismatches;
+}
+
+MeshBVHBenchmarkResult RunMeshBVHBenchmark(int gridSize, int numRays)
+{
+	MeshBVHBenchmarkResult result;
+	CPUMesh mesh;
+	MakeBenchmarkHeightField(gridSize, 0.f, mesh);
+	result.m_numTriangles = (int)(mesh.m_indexes.size() / 3);
+
+	MeshBVH bvh;
+	result.m_buildMs = 1000.0 * TimeSeconds([&]() { bvh.Build(mesh, nullptr); });
+	result.m_parallelBuildMs = 1000.0 * TimeSeconds([&]() { bvh.Build(mesh, g_theJobSystem); });
+	result.m_numNodes = (int)bvh.GetNodes().size();
+
+	// Rays from above the height field heading down at a slant, plus grazing ones skimming across it
+	RandomNumberGenerator rng(11);
+	float rayLength = 2.f * (float)gridSize;
+	std::vector<Vec3> starts;
+	std::vector<Vec3> forwards;
+	for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+	{
+		Vec3 start(rng.RollRandomFloatInRange(0.f, (float)gridSize), rng.RollRandomFloatInRange(0.f, (float)gridSize), rng.RollRandomFloatInRange(2.f, 6.f));
+		float downward = (rayIndex % 2 == 0) ? rng.RollRandomFloatInRange(-1.f, -0.2f) : rng.RollRandomFloatInRange(-0.05f, 0.05f);
+		starts.push_back(start);
+		forwards.push_back(Vec3(rng.RollRandomFloatInRange(-1.f, 1.f), rng.RollRandomFloatInRange(-1.f, 1.f), downward).GetNormalized());
+	}
+
+	// Testing every triangle is slow, so it only runs a slice of the rays
+	int numBruteForceRays = std::max(1, std::min(numRays, 20000000 / std::max(result.m_numTriangles, 1)));
+	double bruteForceSeconds = TimeSeconds([&]()
+	{
+		for (int rayIndex = 0; rayIndex < numBruteForceRays; ++rayIndex)
+		{
+			s_benchmarkSink = s_benchmarkSink + (int)RaycastEveryTriangle(mesh, starts[rayIndex], forwards[rayIndex], rayLength);
+		}
+	});
+	double closestHitSeconds = TimeSeconds([&]()
+	{
+		for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+		{
+			s_benchmarkSink = s_benchmarkSink + (int)bvh.Raycast(starts[rayIndex], forwards[rayIndex], rayLength, true).m_impactDistance;
+		}
+	});
+	double anyHitSeconds = TimeSeconds([&]()
+	{
+		for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+		{
+			s_benchmarkSink = s_benchmarkSink + (bvh.RaycastAny(starts[rayIndex], forwards[rayIndex], rayLength, true) ? 1 : 0);
+		}
+	});
+	result.m_bruteForceRaysPerSecond = numBruteForceRays / bruteForceSeconds;
+	result.m_closestHitRaysPerSecond = numRays / closestHitSeconds;
+	result.m_anyHitRaysPerSecond = numRays / anyHitSeconds;
+
+	std::vector<Vec3> checkedStarts(starts.begin(), starts.begin() + numBruteForceRays);
+	std::vector<Vec3> checkedForwards(forwards.begin(), forwards.begin() + numBruteForceRays);
+
+	// Axis aligned rays starting on grid lines, so exactly on the bounds planes of many nodes
+	int gridStep = std::max(1, gridSize / 8);
+	for (int y = 0; y <= gridSize; y += gridStep)
+	{
+		for (int x = 0; x <= gridSize; x += gridStep)
+		{
+			checkedStarts.push_back(Vec3((float)x, (float)y, 6.f));
+			checkedForwards.push_back(Vec3(0.f, 0.f, -1.f));
+		}
+		checkedStarts.push_back(Vec3(0.f, (float)y, 0.f));
+		checkedForwards.push_back(Vec3(1.f, 0.f, 0.f));
+		checkedStarts.push_back(Vec3((float)y, 0.f, 0.f));
+		checkedForwards.push_back(Vec3(0.f, 1.f, 0.f));
+	}
+	result.m_numMismatches = CountMismatches(bvh, mesh, checkedStarts, checkedForwards, rayLength, rng, gridSize);
+
+	// Move the waves along and refit the tree to them
+	MakeBenchmarkHeightField(gridSize, 1.f, mesh);
+	result.m_refitMs = 1000.0 * TimeSeconds([&]() { bvh.Refit(mesh); });
+	result.m_numMismatches += CountMismatches(bvh, mesh, checkedStarts, checkedForwards, rayLength, rng, gridSize);
+	return result;
+}
+
+bool Command_MeshBVHBenchmark(EventArgs const& args)
+{
+	int gridSize = args.GetValue(std::string("grid"), 300);
+	int numRays = args.GetValue(std::string("rays"), 100000);
+	MeshBVHBenchmarkResult result = RunMeshBVHBenchmark(gridSize, numRays);
+	if (g_theConsole)
+	{
+		g_theConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("MeshBVHBenchmark, %i triangles, %i nodes", result.m_numTriangles, result.m_numNodes));
+		g_theConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Build %.2f ms, %.2f ms on the job system, refit %.2f ms", result.m_buildMs, result.m_parallelBuildMs, result.m_refitMs));
+		g_theConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Every triangle %.4f Mrays/s, closest hit %.3f Mrays/s, any hit %.3f Mrays/s",
+			result.m_bruteForceRaysPerSecond * 1e-6, result.m_closestHitRaysPerSecond * 1e-6, result.m_anyHitRaysPerSecond * 1e-6));
+		g_theConsole->AddLine(result.m_numMismatches == 0 ? DevConsole::INFO_MINOR : DevConsole::ERROR,
+			Stringf("%i queries disagree with testing every triangle", result.m_numMismatches));
+	}
+	return true;
+}
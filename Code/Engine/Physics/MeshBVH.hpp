@@ -0,0 +1,103 @@
+#pragma once
+#include "Engine/Math/AABB3.hpp"
+#include "Engine/Math/Vec3.hpp"
+#include "Engine/Physics/RaycastUtils.hpp"
+#include <vector>
+
+class CPUMesh;
+class JobSystem;
+class NamedProperties;
+typedef NamedProperties EventArgs;
+
+//-----------------------------------------------------------------------------------
+// Bounding volume hierarchy over the triangles of a CPUMesh (m_indexes taken three at a time), so
+// raycasts and overlap queries against a mesh cost O(log N) instead of one test per triangle.
+//
+// Built top down with binned SAH: the triangle centroids of a node are dropped into
+// MESH_BVH_NUM_BINS bins per axis and the split with the lowest surface area cost wins, unless
+// testing the node's triangles is cheaper, then it becomes a leaf. The top of the tree is split on
+// the calling thread (binning big nodes with ParallelReduce) and the subtrees under it are built in
+// parallel on the job system, then stitched together.
+//
+// Nodes are 32 bytes and stored depth first: a node's first child is the next node, only the index
+// of its second child is stored. Triangles are copied in leaf order as a point and two edges so a
+// leaf reads one contiguous run. Triangle indexes handed back by queries are mesh triangles, the
+// first of their three indexes being at m_indexes[3 * triangleIndex].
+//
+// Raycasts use the same Moller-Trumbore test as RaycastPacketUtils: hits only within the ray length,
+// normalized normals facing the ray, back faces skipped unless doubleSided.
+//
+constexpr int	MESH_BVH_NUM_BINS = 16;
+constexpr int	MESH_BVH_MAX_LEAF_TRIANGLES = 8;	// Bigger nodes are always split, even when SAH would rather not
+constexpr int	MESH_BVH_MAX_DEPTH = 96;			// Splits switch to the centroid median below depth 64 so no tree gets deeper
+
+struct MeshBVHNode
+{
+	bool	IsLeaf() const { return m_numTriangles > 0; }
+
+	Vec3	m_boundsMins;
+	int		m_firstTriangleOrSecondChild = 0;	// Leaf: first triangle in leaf order. Interior: index of the second child
+	Vec3	m_boundsMaxs;
+	int		m_numTriangles = 0;					// 0 for interior nodes
+};
+static_assert(sizeof(MeshBVHNode) == 32, "MeshBVHNode is meant to be 32 bytes, two per cache line");
+
+struct MeshBVHTriangle
+{
+	Vec3	m_pointA;
+	Vec3	m_edgeAB;
+	Vec3	m_edgeAC;
+};
+
+class MeshBVH
+{
+public:
+	MeshBVH() = default;
+	explicit MeshBVH(CPUMesh const& mesh);
+
+	void	Build(CPUMesh const& mesh);							// Subtrees built on g_theJobSystem
+	void	Build(CPUMesh const& mesh, JobSystem* jobSystem);	// nullptr builds everything on the calling thread
+	void	Clear();
+
+	// For meshes whose vertexes moved but whose indexes did not: reloads the triangles and recomputes
+	// every node's bounds bottom up, keeping the tree. Much cheaper than Build, but the tree gets worse
+	// the further the mesh deforms from the pose it was built in, rebuild once in a while.
+	void	Refit(CPUMesh const& mesh);
+
+	// Closest hit, out_triangleIndex gets the mesh triangle hit or -1
+	RaycastResult3D	Raycast(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, bool doubleSided = false, int* out_triangleIndex = nullptr) const;
+	// Stops at the first hit found, for line of sight checks
+	bool			RaycastAny(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, bool doubleSided = false) const;
+
+	// Append the mesh triangle index of every triangle touching the volume, in no particular order,
+	// and return how many were appended
+	int		GetTrianglesOverlappingAABB3(AABB3 const& box, std::vector<int>& out_triangleIndexes) const;
+	int		GetTrianglesOverlappingSphere(Vec3 const& sphereCenter, float sphereRadius, std::vector<int>& out_triangleIndexes) const;
+
+	bool								IsEmpty() const { return m_nodes.empty(); }
+	AABB3								GetBounds() const;
+	int									GetNumTriangles() const { return (int)m_triangles.size(); }
+	std::vector<MeshBVHNode> const&		GetNodes() const { return m_nodes; }
+
+private:
+	std::vector<MeshBVHNode>		m_nodes;
+	std::vector<MeshBVHTriangle>	m_triangles;			// Leaf order
+	std::vector<int>				m_triangleIndexes;		// Leaf order to mesh triangle
+};
+
+struct MeshBVHBenchmarkResult
+{
+	int		m_numTriangles = 0;
+	int		m_numNodes = 0;
+	double	m_buildMs = 0.0;					// Calling thread only
+	double	m_parallelBuildMs = 0.0;			// Subtrees on g_theJobSystem
+	double	m_refitMs = 0.0;
+	double	m_bruteForceRaysPerSecond = 0.0;	// Same triangle test against every triangle
+	double	m_closestHitRaysPerSecond = 0.0;
+	double	m_anyHitRaysPerSecond = 0.0;
+	int		m_numMismatches = 0;				// Queries that disagree with testing every triangle, before and after a refit
+};
+
+// Raycasts and overlap queries against a bumpy gridSize x gridSize height field (2 triangles per cell)
+MeshBVHBenchmarkResult	RunMeshBVHBenchmark(int gridSize, int numRays);
+bool					Command_MeshBVHBenchmark(EventArgs const& args);
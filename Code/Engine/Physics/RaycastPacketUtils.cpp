@@ -0,0 +1,640 @@
+#include "Engine/Physics/RaycastPacketUtils.hpp"
+#include "Engine/Physics/RaycastUtils.hpp"
+#include "Engine/Math/AABB3.hpp"
+#include "Engine/Math/Triangle3.hpp"
+#include "Engine/Math/RandomNumberGenerator.hpp"
+#include "Engine/Math/SIMDUtils.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/NamedProperties.hpp"
+#include "Engine/Core/Time.hpp"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+// Keeps the optimizer from dropping the work being timed
+static volatile int s_benchmarkSink = 0;
+
+//-----------------------------------------------------------------------------------
+// The kernels below are written once against FloatLanes, a float per lane with the handful of
+// operations they need. Comparisons give all bits set or clear per lane, like SSE and AVX do.
+// Lanes are always passed by const reference, 32 bit MSVC cannot pass 16 or 32 byte aligned types
+// by value (C2719). Everything is inlined, so it costs nothing on x64.
+//
+#if defined(ENGINE_SIMD_AVX)
+struct FloatLanes
+{
+	static constexpr int WIDTH = 8;
+	__m256 m_lanes;
+};
+
+static inline FloatLanes LoadLanes(float const* values)							{ return { _mm256_load_ps(values) }; }
+static inline FloatLanes SplatLanes(float value)								{ return { _mm256_set1_ps(value) }; }
+static inline void StoreLanes(float* out_values, FloatLanes const& a)			{ _mm256_store_ps(out_values, a.m_lanes); }
+static inline FloatLanes operator+(FloatLanes const& a, FloatLanes const& b)	{ return { _mm256_add_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator-(FloatLanes const& a, FloatLanes const& b)	{ return { _mm256_sub_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator*(FloatLanes const& a, FloatLanes const& b)	{ return { _mm256_mul_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator/(FloatLanes const& a, FloatLanes const& b)	{ return { _mm256_div_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator&(FloatLanes const& a, FloatLanes const& b)	{ return { _mm256_and_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator|(FloatLanes const& a, FloatLanes const& b)	{ return { _mm256_or_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator<(FloatLanes const& a, FloatLanes const& b)	{ return { _mm256_cmp_ps(a.m_lanes, b.m_lanes, _CMP_LT_OQ) }; }
+static inline FloatLanes operator<=(FloatLanes const& a, FloatLanes const& b)	{ return { _mm256_cmp_ps(a.m_lanes, b.m_lanes, _CMP_LE_OQ) }; }
+static inline FloatLanes operator>(FloatLanes const& a, FloatLanes const& b)	{ return { _mm256_cmp_ps(a.m_lanes, b.m_lanes, _CMP_GT_OQ) }; }
+static inline FloatLanes operator>=(FloatLanes const& a, FloatLanes const& b)	{ return { _mm256_cmp_ps(a.m_lanes, b.m_lanes, _CMP_GE_OQ) }; }
+static inline FloatLanes operator==(FloatLanes const& a, FloatLanes const& b)	{ return { _mm256_cmp_ps(a.m_lanes, b.m_lanes, _CMP_EQ_OQ) }; }
+static inline FloatLanes MinLanes(FloatLanes const& a, FloatLanes const& b)		{ return { _mm256_min_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes MaxLanes(FloatLanes const& a, FloatLanes const& b)		{ return { _mm256_max_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes SqrtLanes(FloatLanes const& a)							{ return { _mm256_sqrt_ps(a.m_lanes) }; }
+static inline FloatLanes SelectLanes(FloatLanes const& mask, FloatLanes const& ifTrue, FloatLanes const& ifFalse)	{ return { _mm256_blendv_ps(ifFalse.m_lanes, ifTrue.m_lanes, mask.m_lanes) }; }
+static inline unsigned int GetLaneBits(FloatLanes const& mask)					{ return (unsigned int)_mm256_movemask_ps(mask.m_lanes); }
+#elif defined(ENGINE_SIMD_SSE)
+struct FloatLanes
+{
+	static constexpr int WIDTH = 4;
+	__m128 m_lanes;
+};
+
+static inline FloatLanes LoadLanes(float const* values)							{ return { _mm_load_ps(values) }; }
+static inline FloatLanes SplatLanes(float value)								{ return { _mm_set1_ps(value) }; }
+static inline void StoreLanes(float* out_values, FloatLanes const& a)			{ _mm_store_ps(out_values, a.m_lanes); }
+static inline FloatLanes operator+(FloatLanes const& a, FloatLanes const& b)	{ return { _mm_add_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator-(FloatLanes const& a, FloatLanes const& b)	{ return { _mm_sub_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator*(FloatLanes const& a, FloatLanes const& b)	{ return { _mm_mul_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator/(FloatLanes const& a, FloatLanes const& b)	{ return { _mm_div_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator&(FloatLanes const& a, FloatLanes const& b)	{ return { _mm_and_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator|(FloatLanes const& a, FloatLanes const& b)	{ return { _mm_or_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator<(FloatLanes const& a, FloatLanes const& b)	{ return { _mm_cmplt_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator<=(FloatLanes const& a, FloatLanes const& b)	{ return { _mm_cmple_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator>(FloatLanes const& a, FloatLanes const& b)	{ return { _mm_cmpgt_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator>=(FloatLanes const& a, FloatLanes const& b)	{ return { _mm_cmpge_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes operator==(FloatLanes const& a, FloatLanes const& b)	{ return { _mm_cmpeq_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes MinLanes(FloatLanes const& a, FloatLanes const& b)		{ return { _mm_min_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes MaxLanes(FloatLanes const& a, FloatLanes const& b)		{ return { _mm_max_ps(a.m_lanes, b.m_lanes) }; }
+static inline FloatLanes SqrtLanes(FloatLanes const& a)							{ return { _mm_sqrt_ps(a.m_lanes) }; }
+static inline FloatLanes SelectLanes(FloatLanes const& mask, FloatLanes const& ifTrue, FloatLanes const& ifFalse)	{ return { _mm_or_ps(_mm_and_ps(mask.m_lanes, ifTrue.m_lanes), _mm_andnot_ps(mask.m_lanes, ifFalse.m_lanes)) }; }
+static inline unsigned int GetLaneBits(FloatLanes const& mask)					{ return (unsigned int)_mm_movemask_ps(mask.m_lanes); }
+#else
+struct FloatLanes
+{
+	static constexpr int WIDTH = 1;
+	float m_lanes;
+};
+
+static inline unsigned int GetFloatBits(float value)							{ unsigned int bits; memcpy(&bits, &value, sizeof(bits)); return bits; }
+static inline FloatLanes MakeLaneFromBits(unsigned int bits)					{ FloatLanes lane; memcpy(&lane.m_lanes, &bits, sizeof(bits)); return lane; }
+static inline FloatLanes MakeMaskLane(bool isSet)								{ return MakeLaneFromBits(isSet ? 0xFFFFFFFFu : 0u); }
+
+static inline FloatLanes LoadLanes(float const* values)							{ return { *values }; }
+static inline FloatLanes SplatLanes(float value)								{ return { value }; }
+static inline void StoreLanes(float* out_values, FloatLanes const& a)			{ *out_values = a.m_lanes; }
+static inline FloatLanes operator+(FloatLanes const& a, FloatLanes const& b)	{ return { a.m_lanes + b.m_lanes }; }
+static inline FloatLanes operator-(FloatLanes const& a, FloatLanes const& b)	{ return { a.m_lanes - b.m_lanes }; }
+static inline FloatLanes operator*(FloatLanes const& a, FloatLanes const& b)	{ return { a.m_lanes * b.m_lanes }; }
+static inline FloatLanes operator/(FloatLanes const& a, FloatLanes const& b)	{ return { a.m_lanes / b.m_lanes }; }
+static inline FloatLanes operator&(FloatLanes const& a, FloatLanes const& b)	{ return MakeLaneFromBits(GetFloatBits(a.m_lanes) & GetFloatBits(b.m_lanes)); }
+static inline FloatLanes operator|(FloatLanes const& a, FloatLanes const& b)	{ return MakeLaneFromBits(GetFloatBits(a.m_lanes) | GetFloatBits(b.m_lanes)); }
+static inline FloatLanes operator<(FloatLanes const& a, FloatLanes const& b)	{ return MakeMaskLane(a.m_lanes < b.m_lanes); }
+static inline FloatLanes operator<=(FloatLanes const& a, FloatLanes const& b)	{ return MakeMaskLane(a.m_lanes <= b.m_lanes); }
+static inline FloatLanes operator>(FloatLanes const& a, FloatLanes const& b)	{ return MakeMaskLane(a.m_lanes > b.m_lanes); }
+static inline FloatLanes operator>=(FloatLanes const& a, FloatLanes const& b)	{ return MakeMaskLane(a.m_lanes >= b.m_lanes); }
+static inline FloatLanes operator==(FloatLanes const& a, FloatLanes const& b)	{ return MakeMaskLane(a.m_lanes == b.m_lanes); }
+static inline FloatLanes MinLanes(FloatLanes const& a, FloatLanes const& b)		{ return { a.m_lanes < b.m_lanes ? a.m_lanes : b.m_lanes }; }
+static inline FloatLanes MaxLanes(FloatLanes const& a, FloatLanes const& b)		{ return { a.m_lanes > b.m_lanes ? a.m_lanes : b.m_lanes }; }
+static inline FloatLanes SqrtLanes(FloatLanes const& a)							{ return { sqrtf(a.m_lanes) }; }
+static inline FloatLanes SelectLanes(FloatLanes const& mask, FloatLanes const& ifTrue, FloatLanes const& ifFalse)	{ return GetFloatBits(mask.m_lanes) != 0 ? ifTrue : ifFalse; }
+static inline unsigned int GetLaneBits(FloatLanes const& mask)					{ return GetFloatBits(mask.m_lanes) >> 31; }
+#endif
+
+struct RayLanes
+{
+	FloatLanes	m_startX, m_startY, m_startZ;
+	FloatLanes	m_forwardX, m_forwardY, m_forwardZ;
+	FloatLanes	m_length;
+};
+
+struct HitLanes
+{
+	FloatLanes	m_didImpact;
+	FloatLanes	m_impactDistance;
+	FloatLanes	m_normalX, m_normalY, m_normalZ;
+};
+
+static RayLanes LoadRayLanes(RayPacket3D const& rays, int firstLane)
+{
+	return { LoadLanes(&rays.m_startX[firstLane]), LoadLanes(&rays.m_startY[firstLane]), LoadLanes(&rays.m_startZ[firstLane]),
+		LoadLanes(&rays.m_forwardX[firstLane]), LoadLanes(&rays.m_forwardY[firstLane]), LoadLanes(&rays.m_forwardZ[firstLane]),
+		LoadLanes(&rays.m_length[firstLane]) };
+}
+
+static RayLanes SplatRayLanes(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength)
+{
+	return { SplatLanes(rayStart.x), SplatLanes(rayStart.y), SplatLanes(rayStart.z),
+		SplatLanes(rayForwardNormal.x), SplatLanes(rayForwardNormal.y), SplatLanes(rayForwardNormal.z),
+		SplatLanes(rayLength) };
+}
+
+static void StoreHitLanes(HitLanes const& hits, int firstLane, int numLanes, RaycastPacketResult3D& out_result)
+{
+	FloatLanes zero = SplatLanes(0.f);
+	StoreLanes(&out_result.m_impactDistance[firstLane], SelectLanes(hits.m_didImpact, hits.m_impactDistance, zero));
+	StoreLanes(&out_result.m_impactNormalX[firstLane], SelectLanes(hits.m_didImpact, hits.m_normalX, zero));
+	StoreLanes(&out_result.m_impactNormalY[firstLane], SelectLanes(hits.m_didImpact, hits.m_normalY, zero));
+	StoreLanes(&out_result.m_impactNormalZ[firstLane], SelectLanes(hits.m_didImpact, hits.m_normalZ, zero));
+
+	unsigned int usedLaneBits = numLanes - firstLane >= FloatLanes::WIDTH ? (1u << FloatLanes::WIDTH) - 1u : (1u << (numLanes - firstLane)) - 1u;
+	out_result.m_impactMask |= (GetLaneBits(hits.m_didImpact) & usedLaneBits) << firstLane;
+}
+
+//-----------------------------------------------------------------------------------
+// Distances along the ray to one pair of faces. A ray parallel to them would get 0 * inf = NaN when
+// it starts on a face, so the parallel case never goes through the division: the slab holds the
+// whole ray when the start is between the faces, face included, and none of it otherwise.
+//
+static void GetSlabLanes(FloatLanes const& start, FloatLanes const& forward, FloatLanes const& mins, FloatLanes const& maxs, FloatLanes& out_enter, FloatLanes& out_exit, FloatLanes& out_isOutside)
+{
+	FloatLanes zero = SplatLanes(0.f);
+	FloatLanes oneOverForward = SplatLanes(1.f) / forward;
+	FloatLanes minsDistance = (mins - start) * oneOverForward;
+	FloatLanes maxsDistance = (maxs - start) * oneOverForward;
+
+	FloatLanes isParallel = forward == zero;
+	out_enter = SelectLanes(isParallel, SplatLanes(-FLT_MAX), MinLanes(minsDistance, maxsDistance));
+	out_exit = SelectLanes(isParallel, SplatLanes(FLT_MAX), MaxLanes(minsDistance, maxsDistance));
+	out_isOutside = isParallel & ((start < mins) | (start > maxs));
+}
+
+//-----------------------------------------------------------------------------------
+// Slab test. Ties between slabs pick the z face over the y face over the x face, like RaycastVsAABB3D.
+//
+static HitLanes RaycastLanesVsAABB3D(RayLanes const& ray, FloatLanes const& minsX, FloatLanes const& minsY, FloatLanes const& minsZ, FloatLanes const& maxsX, FloatLanes const& maxsY, FloatLanes const& maxsZ)
+{
+	FloatLanes one = SplatLanes(1.f);
+	FloatLanes minusOne = SplatLanes(-1.f);
+	FloatLanes zero = SplatLanes(0.f);
+
+	FloatLanes enterX, enterY, enterZ;
+	FloatLanes exitX, exitY, exitZ;
+	FloatLanes isOutsideX, isOutsideY, isOutsideZ;
+	GetSlabLanes(ray.m_startX, ray.m_forwardX, minsX, maxsX, enterX, exitX, isOutsideX);
+	GetSlabLanes(ray.m_startY, ray.m_forwardY, minsY, maxsY, enterY, exitY, isOutsideY);
+	GetSlabLanes(ray.m_startZ, ray.m_forwardZ, minsZ, maxsZ, enterZ, exitZ, isOutsideZ);
+	FloatLanes enter = MaxLanes(enterX, MaxLanes(enterY, enterZ));
+	FloatLanes exit = MinLanes(exitX, MinLanes(exitY, exitZ));
+
+	HitLanes hits;
+	hits.m_didImpact = SelectLanes(isOutsideX | isOutsideY | isOutsideZ, zero, (enter <= exit) & (exit >= zero) & (enter <= ray.m_length));
+	FloatLanes isStartInside = enter < zero;
+	hits.m_impactDistance = SelectLanes(isStartInside, zero, enter);
+
+	FloatLanes isXFace = enterX == enter;
+	FloatLanes isYFace = enterY == enter;
+	FloatLanes isZFace = enterZ == enter;
+	hits.m_normalX = SelectLanes(isXFace, SelectLanes(ray.m_forwardX > zero, minusOne, one), zero);
+	hits.m_normalY = SelectLanes(isYFace, SelectLanes(ray.m_forwardY > zero, minusOne, one), zero);
+	hits.m_normalZ = SelectLanes(isZFace, SelectLanes(ray.m_forwardZ > zero, minusOne, one), zero);
+	hits.m_normalX = SelectLanes(isYFace | isZFace, zero, hits.m_normalX);
+	hits.m_normalY = SelectLanes(isZFace, zero, hits.m_normalY);
+
+	hits.m_normalX = SelectLanes(isStartInside, zero - ray.m_forwardX, hits.m_normalX);
+	hits.m_normalY = SelectLanes(isStartInside, zero - ray.m_forwardY, hits.m_normalY);
+	hits.m_normalZ = SelectLanes(isStartInside, zero - ray.m_forwardZ, hits.m_normalZ);
+	return hits;
+}
+
+//-----------------------------------------------------------------------------------
+// A ray starting inside the sphere hits at distance 0 with its own forward as the normal, like
+// RaycastVsSphere3D does for rays pointing toward the center.
+//
+static HitLanes RaycastLanesVsSphere3D(RayLanes const& ray, FloatLanes const& centerX, FloatLanes const& centerY, FloatLanes const& centerZ, FloatLanes const& radius)
+{
+	FloatLanes zero = SplatLanes(0.f);
+
+	FloatLanes startToCenterX = centerX - ray.m_startX;
+	FloatLanes startToCenterY = centerY - ray.m_startY;
+	FloatLanes startToCenterZ = centerZ - ray.m_startZ;
+	FloatLanes startToCenterLengthOnFwd = startToCenterX * ray.m_forwardX + startToCenterY * ray.m_forwardY + startToCenterZ * ray.m_forwardZ;
+	FloatLanes startToCenterLengthSquared = startToCenterX * startToCenterX + startToCenterY * startToCenterY + startToCenterZ * startToCenterZ;
+	FloatLanes radiusSquared = radius * radius;
+	FloatLanes discriminant = startToCenterLengthOnFwd * startToCenterLengthOnFwd - (startToCenterLengthSquared - radiusSquared);
+	FloatLanes impactDistance = startToCenterLengthOnFwd - SqrtLanes(MaxLanes(discriminant, zero));
+
+	HitLanes hits;
+	FloatLanes isStartInside = startToCenterLengthSquared < radiusSquared;
+	hits.m_didImpact = isStartInside | ((discriminant > zero) & (startToCenterLengthOnFwd > zero) & (impactDistance < ray.m_length));
+	hits.m_impactDistance = SelectLanes(isStartInside, zero, impactDistance);
+
+	FloatLanes oneOverRadius = SplatLanes(1.f) / radius;
+	hits.m_normalX = SelectLanes(isStartInside, ray.m_forwardX, (ray.m_forwardX * impactDistance - startToCenterX) * oneOverRadius);
+	hits.m_normalY = SelectLanes(isStartInside, ray.m_forwardY, (ray.m_forwardY * impactDistance - startToCenterY) * oneOverRadius);
+	hits.m_normalZ = SelectLanes(isStartInside, ray.m_forwardZ, (ray.m_forwardZ * impactDistance - startToCenterZ) * oneOverRadius);
+	return hits;
+}
+
+//-----------------------------------------------------------------------------------
+// Moller-Trumbore. One sided triangles are hit from the side their normal (AB x AC) faces, the same
+// side RaycastVsTriangle accepts, and the normal always faces back along the ray.
+//
+static HitLanes RaycastLanesVsTriangle(RayLanes const& ray, FloatLanes const& pointAX, FloatLanes const& pointAY, FloatLanes const& pointAZ,
+	FloatLanes const& edgeABX, FloatLanes const& edgeABY, FloatLanes const& edgeABZ, FloatLanes const& edgeACX, FloatLanes const& edgeACY, FloatLanes const& edgeACZ, bool doubleSided)
+{
+	FloatLanes zero = SplatLanes(0.f);
+	FloatLanes one = SplatLanes(1.f);
+	FloatLanes epsilon = SplatLanes(1e-8f);
+
+	// forward x AC
+	FloatLanes pX = ray.m_forwardY * edgeACZ - ray.m_forwardZ * edgeACY;
+	FloatLanes pY = ray.m_forwardZ * edgeACX - ray.m_forwardX * edgeACZ;
+	FloatLanes pZ = ray.m_forwardX * edgeACY - ray.m_forwardY * edgeACX;
+	FloatLanes determinant = edgeABX * pX + edgeABY * pY + edgeABZ * pZ;
+	FloatLanes isFacing = doubleSided ? ((determinant > epsilon) | (determinant < zero - epsilon)) : (determinant > epsilon);
+	FloatLanes oneOverDeterminant = one / determinant;
+
+	FloatLanes aToStartX = ray.m_startX - pointAX;
+	FloatLanes aToStartY = ray.m_startY - pointAY;
+	FloatLanes aToStartZ = ray.m_startZ - pointAZ;
+	FloatLanes u = (aToStartX * pX + aToStartY * pY + aToStartZ * pZ) * oneOverDeterminant;
+
+	// aToStart x AB
+	FloatLanes qX = aToStartY * edgeABZ - aToStartZ * edgeABY;
+	FloatLanes qY = aToStartZ * edgeABX - aToStartX * edgeABZ;
+	FloatLanes qZ = aToStartX * edgeABY - aToStartY * edgeABX;
+	FloatLanes v = (ray.m_forwardX * qX + ray.m_forwardY * qY + ray.m_forwardZ * qZ) * oneOverDeterminant;
+	FloatLanes impactDistance = (edgeACX * qX + edgeACY * qY + edgeACZ * qZ) * oneOverDeterminant;
+
+	HitLanes hits;
+	hits.m_didImpact = isFacing & (u >= zero) & (v >= zero) & ((u + v) <= one) & (impactDistance >= zero) & (impactDistance <= ray.m_length);
+	hits.m_impactDistance = impactDistance;
+
+	// AB x AC, normalized and turned to face the ray
+	FloatLanes normalX = edgeABY * edgeACZ - edgeABZ * edgeACY;
+	FloatLanes normalY = edgeABZ * edgeACX - edgeABX * edgeACZ;
+	FloatLanes normalZ = edgeABX * edgeACY - edgeABY * edgeACX;
+	FloatLanes oneOverLength = one / SqrtLanes(normalX * normalX + normalY * normalY + normalZ * normalZ);
+	FloatLanes isFacingAway = (normalX * ray.m_forwardX + normalY * ray.m_forwardY + normalZ * ray.m_forwardZ) > zero;
+	oneOverLength = SelectLanes(isFacingAway, zero - oneOverLength, oneOverLength);
+	hits.m_normalX = normalX * oneOverLength;
+	hits.m_normalY = normalY * oneOverLength;
+	hits.m_normalZ = normalZ * oneOverLength;
+	return hits;
+}
+
+//-----------------------------------------------------------------------------------
+void RayPacket3D::Clear()
+{
+	m_numRays = 0;
+}
+
+void RayPacket3D::AddRay(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength)
+{
+	GUARANTEE_OR_DIE(m_numRays < RAY_PACKET_SIZE, "RayPacket3D is full");
+	m_startX[m_numRays] = rayStart.x;
+	m_startY[m_numRays] = rayStart.y;
+	m_startZ[m_numRays] = rayStart.z;
+	m_forwardX[m_numRays] = rayForwardNormal.x;
+	m_forwardY[m_numRays] = rayForwardNormal.y;
+	m_forwardZ[m_numRays] = rayForwardNormal.z;
+	m_length[m_numRays] = rayLength;
+	m_numRays++;
+}
+
+void AABB3Packet::Clear()
+{
+	m_numBoxes = 0;
+}
+
+void AABB3Packet::AddBox(AABB3 const& box)
+{
+	GUARANTEE_OR_DIE(m_numBoxes < RAY_PACKET_SIZE, "AABB3Packet is full");
+	m_minsX[m_numBoxes] = box.m_mins.x;
+	m_minsY[m_numBoxes] = box.m_mins.y;
+	m_minsZ[m_numBoxes] = box.m_mins.z;
+	m_maxsX[m_numBoxes] = box.m_maxs.x;
+	m_maxsY[m_numBoxes] = box.m_maxs.y;
+	m_maxsZ[m_numBoxes] = box.m_maxs.z;
+	m_numBoxes++;
+}
+
+void SpherePacket::Clear()
+{
+	m_numSpheres = 0;
+}
+
+void SpherePacket::AddSphere(Vec3 const& sphereCenter, float sphereRadius)
+{
+	GUARANTEE_OR_DIE(m_numSpheres < RAY_PACKET_SIZE, "SpherePacket is full");
+	m_centerX[m_numSpheres] = sphereCenter.x;
+	m_centerY[m_numSpheres] = sphereCenter.y;
+	m_centerZ[m_numSpheres] = sphereCenter.z;
+	m_radius[m_numSpheres] = sphereRadius;
+	m_numSpheres++;
+}
+
+void TrianglePacket::Clear()
+{
+	m_numTriangles = 0;
+}
+
+void TrianglePacket::AddTriangle(Triangle3 const& triangle)
+{
+	GUARANTEE_OR_DIE(m_numTriangles < RAY_PACKET_SIZE, "TrianglePacket is full");
+	Vec3 edgeAB = triangle.EdgeAB();
+	Vec3 edgeAC = triangle.EdgeAC();
+	m_pointAX[m_numTriangles] = triangle.m_PointA.x;
+	m_pointAY[m_numTriangles] = triangle.m_PointA.y;
+	m_pointAZ[m_numTriangles] = triangle.m_PointA.z;
+	m_edgeABX[m_numTriangles] = edgeAB.x;
+	m_edgeABY[m_numTriangles] = edgeAB.y;
+	m_edgeABZ[m_numTriangles] = edgeAB.z;
+	m_edgeACX[m_numTriangles] = edgeAC.x;
+	m_edgeACY[m_numTriangles] = edgeAC.y;
+	m_edgeACZ[m_numTriangles] = edgeAC.z;
+	m_numTriangles++;
+}
+
+int RaycastPacketResult3D::GetClosestImpactLane() const
+{
+	int closestLane = -1;
+	for (int lane = 0; lane < RAY_PACKET_SIZE; ++lane)
+	{
+		if (DidImpact(lane) && (closestLane < 0 || m_impactDistance[lane] < m_impactDistance[closestLane]))
+		{
+			closestLane = lane;
+		}
+	}
+	return closestLane;
+}
+
+//-----------------------------------------------------------------------------------
+void RaycastPacketVsAABB3D(RayPacket3D const& rays, AABB3 const& box, RaycastPacketResult3D& out_result)
+{
+	out_result.m_impactMask = 0;
+	for (int firstLane = 0; firstLane < rays.m_numRays; firstLane += FloatLanes::WIDTH)
+	{
+		HitLanes hits = RaycastLanesVsAABB3D(LoadRayLanes(rays, firstLane), SplatLanes(box.m_mins.x), SplatLanes(box.m_mins.y), SplatLanes(box.m_mins.z),
+			SplatLanes(box.m_maxs.x), SplatLanes(box.m_maxs.y), SplatLanes(box.m_maxs.z));
+		StoreHitLanes(hits, firstLane, rays.m_numRays, out_result);
+	}
+}
+
+void RaycastPacketVsSphere3D(RayPacket3D const& rays, Vec3 const& sphereCenter, float sphereRadius, RaycastPacketResult3D& out_result)
+{
+	out_result.m_impactMask = 0;
+	for (int firstLane = 0; firstLane < rays.m_numRays; firstLane += FloatLanes::WIDTH)
+	{
+		HitLanes hits = RaycastLanesVsSphere3D(LoadRayLanes(rays, firstLane), SplatLanes(sphereCenter.x), SplatLanes(sphereCenter.y), SplatLanes(sphereCenter.z), SplatLanes(sphereRadius));
+		StoreHitLanes(hits, firstLane, rays.m_numRays, out_result);
+	}
+}
+
+void RaycastPacketVsTriangle(RayPacket3D const& rays, Triangle3 const& triangle, RaycastPacketResult3D& out_result, bool doubleSided)
+{
+	out_result.m_impactMask = 0;
+	Vec3 edgeAB = triangle.EdgeAB();
+	Vec3 edgeAC = triangle.EdgeAC();
+	for (int firstLane = 0; firstLane < rays.m_numRays; firstLane += FloatLanes::WIDTH)
+	{
+		HitLanes hits = RaycastLanesVsTriangle(LoadRayLanes(rays, firstLane), SplatLanes(triangle.m_PointA.x), SplatLanes(triangle.m_PointA.y), SplatLanes(triangle.m_PointA.z),
+			SplatLanes(edgeAB.x), SplatLanes(edgeAB.y), SplatLanes(edgeAB.z), SplatLanes(edgeAC.x), SplatLanes(edgeAC.y), SplatLanes(edgeAC.z), doubleSided);
+		StoreHitLanes(hits, firstLane, rays.m_numRays, out_result);
+	}
+}
+
+void RaycastVsAABB3Packet(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, AABB3Packet const& boxes, RaycastPacketResult3D& out_result)
+{
+	out_result.m_impactMask = 0;
+	RayLanes ray = SplatRayLanes(rayStart, rayForwardNormal, rayLength);
+	for (int firstLane = 0; firstLane < boxes.m_numBoxes; firstLane += FloatLanes::WIDTH)
+	{
+		HitLanes hits = RaycastLanesVsAABB3D(ray, LoadLanes(&boxes.m_minsX[firstLane]), LoadLanes(&boxes.m_minsY[firstLane]), LoadLanes(&boxes.m_minsZ[firstLane]),
+			LoadLanes(&boxes.m_maxsX[firstLane]), LoadLanes(&boxes.m_maxsY[firstLane]), LoadLanes(&boxes.m_maxsZ[firstLane]));
+		StoreHitLanes(hits, firstLane, boxes.m_numBoxes, out_result);
+	}
+}
+
+void RaycastVsSpherePacket(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, SpherePacket const& spheres, RaycastPacketResult3D& out_result)
+{
+	out_result.m_impactMask = 0;
+	RayLanes ray = SplatRayLanes(rayStart, rayForwardNormal, rayLength);
+	for (int firstLane = 0; firstLane < spheres.m_numSpheres; firstLane += FloatLanes::WIDTH)
+	{
+		HitLanes hits = RaycastLanesVsSphere3D(ray, LoadLanes(&spheres.m_centerX[firstLane]), LoadLanes(&spheres.m_centerY[firstLane]), LoadLanes(&spheres.m_centerZ[firstLane]),
+			LoadLanes(&spheres.m_radius[firstLane]));
+		StoreHitLanes(hits, firstLane, spheres.m_numSpheres, out_result);
+	}
+}
+
+void RaycastVsTrianglePacket(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, TrianglePacket const& triangles, RaycastPacketResult3D& out_result, bool doubleSided)
+{
+	out_result.m_impactMask = 0;
+	RayLanes ray = SplatRayLanes(rayStart, rayForwardNormal, rayLength);
+	for (int firstLane = 0; firstLane < triangles.m_numTriangles; firstLane += FloatLanes::WIDTH)
+	{
+		HitLanes hits = RaycastLanesVsTriangle(ray, LoadLanes(&triangles.m_pointAX[firstLane]), LoadLanes(&triangles.m_pointAY[firstLane]), LoadLanes(&triangles.m_pointAZ[firstLane]),
+			LoadLanes(&triangles.m_edgeABX[firstLane]), LoadLanes(&triangles.m_edgeABY[firstLane]), LoadLanes(&triangles.m_edgeABZ[firstLane]),
+			LoadLanes(&triangles.m_edgeACX[firstLane]), LoadLanes(&triangles.m_edgeACY[firstLane]), LoadLanes(&triangles.m_edgeACZ[firstLane]), doubleSided);
+		StoreHitLanes(hits, firstLane, triangles.m_numTriangles, out_result);
+	}
+}
+
+//-----------------------------------------------------------------------------------
+template<typename Work>
+static double TimeSeconds(Work const& work)
+{
+	double startSeconds = GetCurrentTimeSeconds();
+	work();
+	return GetCurrentTimeSeconds() - startSeconds;
+}
+
+std::vector<RaycastBenchmarkResult> RunRaycastPacketBenchmark(int numRays)
+{
+	// Coherent rays, like a line of sight fan: starts near each other, all heading roughly +x
+	RandomNumberGenerator rng(7);
+	int numPackets = (numRays + RAY_PACKET_SIZE - 1) / RAY_PACKET_SIZE;
+	std::vector<RayPacket3D> packets((size_t)numPackets);
+	std::vector<Vec3> starts;
+	std::vector<Vec3> forwards;
+	for (RayPacket3D& packet : packets)
+	{
+		for (int rayIndex = 0; rayIndex < RAY_PACKET_SIZE; ++rayIndex)
+		{
+			Vec3 start(rng.RollRandomFloatInRange(-1.f, 1.f), rng.RollRandomFloatInRange(-1.f, 1.f), rng.RollRandomFloatInRange(-1.f, 1.f));
+			Vec3 forward = Vec3(1.f, rng.RollRandomFloatInRange(-0.5f, 0.5f), rng.RollRandomFloatInRange(-0.5f, 0.5f)).GetNormalized();
+			packet.AddRay(start, forward, 20.f);
+			starts.push_back(start);
+			forwards.push_back(forward);
+		}
+	}
+	numRays = numPackets * RAY_PACKET_SIZE;
+
+	AABB3Packet boxes;
+	SpherePacket spheres;
+	TrianglePacket triangles;
+	std::vector<AABB3> boxList;
+	std::vector<Vec3> sphereCenters;
+	std::vector<Triangle3> triangleList;
+	for (int primitiveIndex = 0; primitiveIndex < RAY_PACKET_SIZE; ++primitiveIndex)
+	{
+		Vec3 center(rng.RollRandomFloatInRange(5.f, 15.f), rng.RollRandomFloatInRange(-4.f, 4.f), rng.RollRandomFloatInRange(-4.f, 4.f));
+		boxList.push_back(AABB3(center - Vec3(1.f, 1.f, 1.f), center + Vec3(1.f, 1.f, 1.f)));
+		boxes.AddBox(boxList.back());
+		sphereCenters.push_back(center);
+		spheres.AddSphere(center, 1.5f);
+		triangleList.push_back(Triangle3(center + Vec3(0.f, -3.f, -3.f), center + Vec3(0.f, 0.f, 3.f), center + Vec3(0.f, 3.f, -3.f)));
+		triangles.AddTriangle(triangleList.back());
+	}
+
+	std::vector<RaycastBenchmarkResult> results;
+	double numRayTests = (double)numRays * RAY_PACKET_SIZE;
+	RaycastPacketResult3D packetResult;
+	{
+		RaycastBenchmarkResult result;
+		result.m_name = "8 rays vs AABB3";
+		double scalarSeconds = TimeSeconds([&]()
+		{
+			for (AABB3 const& box : boxList)
+			{
+				for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+				{
+					s_benchmarkSink = s_benchmarkSink + (int)RaycastVsAABB3D(starts[rayIndex], forwards[rayIndex], 20.f, box).m_didImpact;
+				}
+			}
+		});
+		double packetSeconds = TimeSeconds([&]()
+		{
+			for (AABB3 const& box : boxList)
+			{
+				for (RayPacket3D const& packet : packets)
+				{
+					RaycastPacketVsAABB3D(packet, box, packetResult);
+					s_benchmarkSink = s_benchmarkSink + (int)packetResult.m_impactMask;
+				}
+			}
+		});
+		result.m_scalarRaysPerSecond = numRayTests / scalarSeconds;
+		result.m_packetRaysPerSecond = numRayTests / packetSeconds;
+		results.push_back(result);
+	}
+
+	{
+		RaycastBenchmarkResult result;
+		result.m_name = "8 rays vs sphere";
+		double scalarSeconds = TimeSeconds([&]()
+		{
+			for (Vec3 const& center : sphereCenters)
+			{
+				for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+				{
+					s_benchmarkSink = s_benchmarkSink + (int)RaycastVsSphere3D(starts[rayIndex], forwards[rayIndex], 20.f, center, 1.5f).m_didImpact;
+				}
+			}
+		});
+		double packetSeconds = TimeSeconds([&]()
+		{
+			for (Vec3 const& center : sphereCenters)
+			{
+				for (RayPacket3D const& packet : packets)
+				{
+					RaycastPacketVsSphere3D(packet, center, 1.5f, packetResult);
+					s_benchmarkSink = s_benchmarkSink + (int)packetResult.m_impactMask;
+				}
+			}
+		});
+		result.m_scalarRaysPerSecond = numRayTests / scalarSeconds;
+		result.m_packetRaysPerSecond = numRayTests / packetSeconds;
+		results.push_back(result);
+	}
+
+	{
+		RaycastBenchmarkResult result;
+		result.m_name = "8 rays vs triangle";
+		double scalarSeconds = TimeSeconds([&]()
+		{
+			for (Triangle3 const& triangle : triangleList)
+			{
+				for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+				{
+					s_benchmarkSink = s_benchmarkSink + (int)RaycastVsTriangle(starts[rayIndex], forwards[rayIndex], 20.f, triangle, true).m_didImpact;
+				}
+			}
+		});
+		double packetSeconds = TimeSeconds([&]()
+		{
+			for (Triangle3 const& triangle : triangleList)
+			{
+				for (RayPacket3D const& packet : packets)
+				{
+					RaycastPacketVsTriangle(packet, triangle, packetResult, true);
+					s_benchmarkSink = s_benchmarkSink + (int)packetResult.m_impactMask;
+				}
+			}
+		});
+		result.m_scalarRaysPerSecond = numRayTests / scalarSeconds;
+		result.m_packetRaysPerSecond = numRayTests / packetSeconds;
+		results.push_back(result);
+	}
+
+	{
+		// The scalar side is the same loop as above, so only the packet side is timed again
+		RaycastBenchmarkResult result;
+		result.m_name = "1 ray vs 8 AABB3s";
+		result.m_scalarRaysPerSecond = results[0].m_scalarRaysPerSecond;
+		double packetSeconds = TimeSeconds([&]()
+		{
+			for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+			{
+				RaycastVsAABB3Packet(starts[rayIndex], forwards[rayIndex], 20.f, boxes, packetResult);
+				s_benchmarkSink = s_benchmarkSink + packetResult.GetClosestImpactLane();
+			}
+		});
+		result.m_packetRaysPerSecond = numRayTests / packetSeconds;
+		results.push_back(result);
+	}
+
+	{
+		RaycastBenchmarkResult result;
+		result.m_name = "1 ray vs 8 spheres";
+		result.m_scalarRaysPerSecond = results[1].m_scalarRaysPerSecond;
+		double packetSeconds = TimeSeconds([&]()
+		{
+			for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+			{
+				RaycastVsSpherePacket(starts[rayIndex], forwards[rayIndex], 20.f, spheres, packetResult);
+				s_benchmarkSink = s_benchmarkSink + packetResult.GetClosestImpactLane();
+			}
+		});
+		result.m_packetRaysPerSecond = numRayTests / packetSeconds;
+		results.push_back(result);
+	}
+
+	{
+		RaycastBenchmarkResult result;
+		result.m_name = "1 ray vs 8 triangles";
+		result.m_scalarRaysPerSecond = results[2].m_scalarRaysPerSecond;
+		double packetSeconds = TimeSeconds([&]()
+		{
+			for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+			{
+				RaycastVsTrianglePacket(starts[rayIndex], forwards[rayIndex], 20.f, triangles, packetResult, true);
+				s_benchmarkSink = s_benchmarkSink + packetResult.GetClosestImpactLane();
+			}
+		});
+		result.m_packetRaysPerSecond = numRayTests / packetSeconds;
+		results.push_back(result);
+	}
+	return results;
+}
+
+bool Command_RaycastBenchmark(EventArgs const& args)
+{
+	int numRays = args.GetValue(std::string("rays"), 100000);
+	std::vector<RaycastBenchmarkResult> results = RunRaycastPacketBenchmark(numRays);
+	if (g_theConsole)
+	{
+		g_theConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("RaycastBenchmark, %i rays against 8 primitives, %i lanes per kernel", numRays, FloatLanes::WIDTH));
+		for (RaycastBenchmarkResult const& result : results)
+		{
+			g_theConsole->AddLine(DevConsole::INFO_MINOR, Stringf("%-24s %8.1f -> %8.1f Mrays/s", result.m_name.c_str(),
+				result.m_scalarRaysPerSecond * 1e-6, result.m_packetRaysPerSecond * 1e-6));
+		}
+	}
+	return true;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "Engine/Math/Vec3.hpp"
+#include <string>
+#include <vector>
+
+struct AABB3;
+struct Triangle3;
+class NamedProperties;
+typedef NamedProperties EventArgs;
+
+//-----------------------------------------------------------------------------------
+// Raycasts for many coherent rays at once. A packet holds up to 8 rays (or 8 primitives) in
+// structure of arrays form so one SIMD lane handles one ray: 8 lanes at a time with AVX, two
+// groups of 4 with SSE, one at a time with ENGINE_DISABLE_SIMD (see SIMDUtils.hpp).
+//
+// Results come back as a hit mask plus impact distances and normals, all indexed by lane. Impact
+// positions are start + forward * distance and are not stored. Differences from RaycastUtils:
+//	- a ray starting inside a box or sphere hits at distance 0, whichever way it points
+//	- triangles are tested with Moller-Trumbore and only hit within the ray length
+//	- triangle normals are normalized
+//
+constexpr int RAY_PACKET_SIZE = 8;
+
+struct RayPacket3D
+{
+	void	Clear();
+	void	AddRay(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength);	// Up to RAY_PACKET_SIZE rays
+
+	alignas(32) float	m_startX[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_startY[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_startZ[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_forwardX[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_forwardY[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_forwardZ[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_length[RAY_PACKET_SIZE] = {};
+	int					m_numRays = 0;
+};
+
+struct AABB3Packet
+{
+	void	Clear();
+	void	AddBox(AABB3 const& box);
+
+	alignas(32) float	m_minsX[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_minsY[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_minsZ[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_maxsX[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_maxsY[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_maxsZ[RAY_PACKET_SIZE] = {};
+	int					m_numBoxes = 0;
+};
+
+struct SpherePacket
+{
+	void	Clear();
+	void	AddSphere(Vec3 const& sphereCenter, float sphereRadius);
+
+	alignas(32) float	m_centerX[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_centerY[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_centerZ[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_radius[RAY_PACKET_SIZE] = {};
+	int					m_numSpheres = 0;
+};
+
+struct TrianglePacket
+{
+	void	Clear();
+	void	AddTriangle(Triangle3 const& triangle);
+
+	alignas(32) float	m_pointAX[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_pointAY[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_pointAZ[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_edgeABX[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_edgeABY[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_edgeABZ[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_edgeACX[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_edgeACY[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_edgeACZ[RAY_PACKET_SIZE] = {};
+	int					m_numTriangles = 0;
+};
+
+struct RaycastPacketResult3D
+{
+	bool	DidImpact(int lane) const { return (m_impactMask & (1u << lane)) != 0; }
+	Vec3	GetImpactNormal(int lane) const { return Vec3(m_impactNormalX[lane], m_impactNormalY[lane], m_impactNormalZ[lane]); }
+	int		GetClosestImpactLane() const;		// -1 when nothing was hit
+
+	unsigned int		m_impactMask = 0;		// Bit n set when lane n hit, lanes past the packet size are never set
+	alignas(32) float	m_impactDistance[RAY_PACKET_SIZE] = {};	// 0 for lanes that missed, like the normals
+	alignas(32) float	m_impactNormalX[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_impactNormalY[RAY_PACKET_SIZE] = {};
+	alignas(32) float	m_impactNormalZ[RAY_PACKET_SIZE] = {};
+};
+
+// Every ray of the packet against one primitive, lanes are rays
+void	RaycastPacketVsAABB3D(RayPacket3D const& rays, AABB3 const& box, RaycastPacketResult3D& out_result);
+void	RaycastPacketVsSphere3D(RayPacket3D const& rays, Vec3 const& sphereCenter, float sphereRadius, RaycastPacketResult3D& out_result);
+void	RaycastPacketVsTriangle(RayPacket3D const& rays, Triangle3 const& triangle, RaycastPacketResult3D& out_result, bool doubleSided = false);
+
+// One ray against every primitive of the packet, lanes are primitives
+void	RaycastVsAABB3Packet(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, AABB3Packet const& boxes, RaycastPacketResult3D& out_result);
+void	RaycastVsSpherePacket(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, SpherePacket const& spheres, RaycastPacketResult3D& out_result);
+void	RaycastVsTrianglePacket(Vec3 const& rayStart, Vec3 const& rayForwardNormal, float rayLength, TrianglePacket const& triangles, RaycastPacketResult3D& out_result, bool doubleSided = false);
+
+struct RaycastBenchmarkResult
+{
+	std::string		m_name;
+	double			m_scalarRaysPerSecond = 0.0;	// One RaycastUtils call per ray and primitive
+	double			m_packetRaysPerSecond = 0.0;
+};
+
+// Rays per second against boxes, spheres and triangles, counting a ray once per primitive it is tested against
+std::vector<RaycastBenchmarkResult>	RunRaycastPacketBenchmark(int numRays);
+bool								Command_RaycastBenchmark(EventArgs const& args);
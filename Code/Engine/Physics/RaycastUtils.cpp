@@ -634,7 +634,7 @@ RaycastResult3D RaycastVsCylinderZ3D(Vec3 rayStart, Vec3 rayForwardNormal, float
 	Vec2 startToCenter = centerXY - rayStartXY;
 
 	float scProjectedOnUpNormal = DotProduct2D(startToCenter, upNormal); // altitude on vector
-	if (scProjectedOnUpNormal >= radiusXY)
+	if (fabsf(scProjectedOnUpNormal) >= radiusXY)
 	{
 		return result;
 	}
@@ -652,16 +652,15 @@ RaycastResult3D RaycastVsCylinderZ3D(Vec3 rayStart, Vec3 rayForwardNormal, float
 	float rayFwdNormalZDividedByOne = 1.0f / (rayEnd.z - rayStart.z);
 	float rayTValueAtCylinderMinZ = (minMaxZ.m_min - rayStart.z) * rayFwdNormalZDividedByOne;
 	float rayTValueAtCylinderMaxZ = (minMaxZ.m_max - rayStart.z) * rayFwdNormalZDividedByOne;
-	FloatRange impactRangeZ = FloatRange(rayTValueAtCylinderMinZ, rayTValueAtCylinderMaxZ);
+	FloatRange impactRangeZ = FloatRange(fminf(rayTValueAtCylinderMinZ, rayTValueAtCylinderMaxZ), fmaxf(rayTValueAtCylinderMinZ, rayTValueAtCylinderMaxZ));
 
-	// Check if these two foat range is overlap with each other
-	if (!impactRangeXY.IsOverlappingWith(impactRangeZ))
+	// Check if these two foat range is overlap with each other, somewhere along the ray
+	float commonImpactMinValue = impactRangeXY.m_min > impactRangeZ.m_min ? impactRangeXY.m_min : impactRangeZ.m_min;
+	float commonImpactMaxValue = impactRangeXY.m_max < impactRangeZ.m_max ? impactRangeXY.m_max : impactRangeZ.m_max;
+	if (commonImpactMinValue > commonImpactMaxValue || commonImpactMinValue < 0.0f || commonImpactMinValue > 1.0f)
 	{
 		return result;
 	}
-	
-	float commonImpactMinValue = impactRangeXY.m_min > impactRangeZ.m_min ? impactRangeXY.m_min : impactRangeZ.m_min;
-	//float commonImpactMaxValue = impactRangeXY.m_max < impactRangeZ.m_max ? impactRangeXY.m_max : impactRangeZ.m_max;
 
 	result.m_didImpact = true;
 	result.m_impactDistance = commonImpactMinValue * rayLength;